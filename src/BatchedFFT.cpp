@@ -0,0 +1,281 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "BatchedFFT.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FFT_USE_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+    #define FFT_USE_AVX
+    #include <immintrin.h>
+#endif
+
+namespace
+{
+    //Transpose is done in square blocks of this size, so both the rows and columns being swapped stay in cache
+    const irr::u32 TRANSPOSE_BLOCK_SIZE = 16;
+
+    //Radix-4 butterfly for one k, combining two radix-2 passes.
+    //a, b, c, d are at k, k+half, k+2*half, k+3*half within the block. w1 = exp(2*pi*i*k/(2*half)), w2 = exp(2*pi*i*k/(4*half))
+    inline void butterflyScalar(irr::f32* re, irr::f32* im, irr::u32 half, irr::f32 w1r, irr::f32 w1i, irr::f32 w2r, irr::f32 w2i)
+    {
+        irr::f32 ar = re[0], ai = im[0];
+        irr::f32 br = re[half], bi = im[half];
+        irr::f32 cr = re[2*half], ci = im[2*half];
+        irr::f32 dr = re[3*half], di = im[3*half];
+
+        //First radix-2 pass
+        irr::f32 tbr = br*w1r - bi*w1i, tbi = br*w1i + bi*w1r;
+        irr::f32 tdr = dr*w1r - di*w1i, tdi = dr*w1i + di*w1r;
+        irr::f32 a0r = ar + tbr, a0i = ai + tbi;
+        irr::f32 a1r = ar - tbr, a1i = ai - tbi;
+        irr::f32 c0r = cr + tdr, c0i = ci + tdi;
+        irr::f32 c1r = cr - tdr, c1i = ci - tdi;
+
+        //Second radix-2 pass. The twiddle factor for k+half is i*w2.
+        irr::f32 t0r = c0r*w2r - c0i*w2i, t0i = c0r*w2i + c0i*w2r;
+        irr::f32 t1r = -(c1r*w2i + c1i*w2r), t1i = c1r*w2r - c1i*w2i;
+        re[0] = a0r + t0r; im[0] = a0i + t0i;
+        re[2*half] = a0r - t0r; im[2*half] = a0i - t0i;
+        re[half] = a1r + t1r; im[half] = a1i + t1i;
+        re[3*half] = a1r - t1r; im[3*half] = a1i - t1i;
+    }
+
+    #ifdef FFT_USE_AVX
+    //As butterflyScalar, for 8 consecutive values of k
+    inline void butterflyAVX(irr::f32* re, irr::f32* im, irr::u32 half, __m256 w1r, __m256 w1i, __m256 w2r, __m256 w2i)
+    {
+        __m256 ar = _mm256_loadu_ps(re), ai = _mm256_loadu_ps(im);
+        __m256 br = _mm256_loadu_ps(re + half), bi = _mm256_loadu_ps(im + half);
+        __m256 cr = _mm256_loadu_ps(re + 2*half), ci = _mm256_loadu_ps(im + 2*half);
+        __m256 dr = _mm256_loadu_ps(re + 3*half), di = _mm256_loadu_ps(im + 3*half);
+
+        __m256 tbr = _mm256_sub_ps(_mm256_mul_ps(br, w1r), _mm256_mul_ps(bi, w1i));
+        __m256 tbi = _mm256_add_ps(_mm256_mul_ps(br, w1i), _mm256_mul_ps(bi, w1r));
+        __m256 tdr = _mm256_sub_ps(_mm256_mul_ps(dr, w1r), _mm256_mul_ps(di, w1i));
+        __m256 tdi = _mm256_add_ps(_mm256_mul_ps(dr, w1i), _mm256_mul_ps(di, w1r));
+        __m256 a0r = _mm256_add_ps(ar, tbr), a0i = _mm256_add_ps(ai, tbi);
+        __m256 a1r = _mm256_sub_ps(ar, tbr), a1i = _mm256_sub_ps(ai, tbi);
+        __m256 c0r = _mm256_add_ps(cr, tdr), c0i = _mm256_add_ps(ci, tdi);
+        __m256 c1r = _mm256_sub_ps(cr, tdr), c1i = _mm256_sub_ps(ci, tdi);
+
+        __m256 t0r = _mm256_sub_ps(_mm256_mul_ps(c0r, w2r), _mm256_mul_ps(c0i, w2i));
+        __m256 t0i = _mm256_add_ps(_mm256_mul_ps(c0r, w2i), _mm256_mul_ps(c0i, w2r));
+        __m256 t1r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_add_ps(_mm256_mul_ps(c1r, w2i), _mm256_mul_ps(c1i, w2r)));
+        __m256 t1i = _mm256_sub_ps(_mm256_mul_ps(c1r, w2r), _mm256_mul_ps(c1i, w2i));
+        _mm256_storeu_ps(re, _mm256_add_ps(a0r, t0r)); _mm256_storeu_ps(im, _mm256_add_ps(a0i, t0i));
+        _mm256_storeu_ps(re + 2*half, _mm256_sub_ps(a0r, t0r)); _mm256_storeu_ps(im + 2*half, _mm256_sub_ps(a0i, t0i));
+        _mm256_storeu_ps(re + half, _mm256_add_ps(a1r, t1r)); _mm256_storeu_ps(im + half, _mm256_add_ps(a1i, t1i));
+        _mm256_storeu_ps(re + 3*half, _mm256_sub_ps(a1r, t1r)); _mm256_storeu_ps(im + 3*half, _mm256_sub_ps(a1i, t1i));
+    }
+    #endif
+
+    #ifdef FFT_USE_SSE2
+    //As butterflyScalar, for 4 consecutive values of k
+    inline void butterflySSE2(irr::f32* re, irr::f32* im, irr::u32 half, __m128 w1r, __m128 w1i, __m128 w2r, __m128 w2i)
+    {
+        __m128 ar = _mm_loadu_ps(re), ai = _mm_loadu_ps(im);
+        __m128 br = _mm_loadu_ps(re + half), bi = _mm_loadu_ps(im + half);
+        __m128 cr = _mm_loadu_ps(re + 2*half), ci = _mm_loadu_ps(im + 2*half);
+        __m128 dr = _mm_loadu_ps(re + 3*half), di = _mm_loadu_ps(im + 3*half);
+
+        __m128 tbr = _mm_sub_ps(_mm_mul_ps(br, w1r), _mm_mul_ps(bi, w1i));
+        __m128 tbi = _mm_add_ps(_mm_mul_ps(br, w1i), _mm_mul_ps(bi, w1r));
+        __m128 tdr = _mm_sub_ps(_mm_mul_ps(dr, w1r), _mm_mul_ps(di, w1i));
+        __m128 tdi = _mm_add_ps(_mm_mul_ps(dr, w1i), _mm_mul_ps(di, w1r));
+        __m128 a0r = _mm_add_ps(ar, tbr), a0i = _mm_add_ps(ai, tbi);
+        __m128 a1r = _mm_sub_ps(ar, tbr), a1i = _mm_sub_ps(ai, tbi);
+        __m128 c0r = _mm_add_ps(cr, tdr), c0i = _mm_add_ps(ci, tdi);
+        __m128 c1r = _mm_sub_ps(cr, tdr), c1i = _mm_sub_ps(ci, tdi);
+
+        __m128 t0r = _mm_sub_ps(_mm_mul_ps(c0r, w2r), _mm_mul_ps(c0i, w2i));
+        __m128 t0i = _mm_add_ps(_mm_mul_ps(c0r, w2i), _mm_mul_ps(c0i, w2r));
+        __m128 t1r = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_mul_ps(c1r, w2i), _mm_mul_ps(c1i, w2r)));
+        __m128 t1i = _mm_sub_ps(_mm_mul_ps(c1r, w2r), _mm_mul_ps(c1i, w2i));
+        _mm_storeu_ps(re, _mm_add_ps(a0r, t0r)); _mm_storeu_ps(im, _mm_add_ps(a0i, t0i));
+        _mm_storeu_ps(re + 2*half, _mm_sub_ps(a0r, t0r)); _mm_storeu_ps(im + 2*half, _mm_sub_ps(a0i, t0i));
+        _mm_storeu_ps(re + half, _mm_add_ps(a1r, t1r)); _mm_storeu_ps(im + half, _mm_add_ps(a1i, t1i));
+        _mm_storeu_ps(re + 3*half, _mm_sub_ps(a1r, t1r)); _mm_storeu_ps(im + 3*half, _mm_sub_ps(a1i, t1i));
+    }
+    #endif
+}
+
+BatchedFFT::BatchedFFT(irr::u32 size, irr::u32 numberOfFields)
+{
+    this->size = size;
+    this->numberOfFields = numberOfFields;
+    real.assign(size*size*numberOfFields, 0);
+    imag.assign(size*size*numberOfFields, 0);
+
+    irr::u32 log2Size = 0;
+    while ((1u << log2Size) < size) {
+        log2Size++;
+    }
+
+    //Bit reversal permutation, as pairs to swap
+    for (irr::u32 i = 0; i < size; i++) {
+        irr::u32 reversed = 0;
+        for (irr::u32 bit = 0; bit < log2Size; bit++) {
+            reversed |= ((i >> bit) & 1) << (log2Size - 1 - bit);
+        }
+        if (i < reversed) {
+            swapFirst.push_back(i);
+            swapSecond.push_back(reversed);
+        }
+    }
+
+    //A single radix-2 pass first if needed, then radix-4 passes
+    irr::u32 half = 1;
+    if (log2Size % 2 == 1) {
+        Pass pass;
+        pass.half = 1;
+        pass.radix4 = false;
+        pass.twiddleStart = 0;
+        passes.push_back(pass);
+        half = 2;
+    }
+    for (; half < size; half *= 4) {
+        Pass pass;
+        pass.half = half;
+        pass.radix4 = true;
+        pass.twiddleStart = twiddle1Real.size();
+        for (irr::u32 k = 0; k < half; k++) {
+            double angle1 = 2.0*irr::core::PI64*k/(2.0*half);
+            double angle2 = 2.0*irr::core::PI64*k/(4.0*half);
+            twiddle1Real.push_back(std::cos(angle1));
+            twiddle1Imag.push_back(std::sin(angle1));
+            twiddle2Real.push_back(std::cos(angle2));
+            twiddle2Imag.push_back(std::sin(angle2));
+        }
+        passes.push_back(pass);
+    }
+}
+
+irr::u32 BatchedFFT::getSize() const
+{
+    return size;
+}
+
+irr::u32 BatchedFFT::getNumberOfFields() const
+{
+    return numberOfFields;
+}
+
+irr::f32* BatchedFFT::getReal(irr::u32 field)
+{
+    return &real[field*size*size];
+}
+
+irr::f32* BatchedFFT::getImag(irr::u32 field)
+{
+    return &imag[field*size*size];
+}
+
+void BatchedFFT::transform()
+{
+    for (irr::u32 field = 0; field < numberOfFields; field++) {
+        irr::f32* fieldReal = getReal(field);
+        irr::f32* fieldImag = getImag(field);
+
+        //Rows, then columns (as rows of the transpose)
+        transformRows(fieldReal, fieldImag);
+        transpose(fieldReal);
+        transpose(fieldImag);
+        transformRows(fieldReal, fieldImag);
+    }
+}
+
+void BatchedFFT::transformRows(irr::f32* fieldReal, irr::f32* fieldImag)
+{
+    for (irr::u32 row = 0; row < size; row++) {
+        transformLine(fieldReal + row*size, fieldImag + row*size);
+    }
+}
+
+void BatchedFFT::transformLine(irr::f32* lineReal, irr::f32* lineImag)
+{
+    for (std::vector<irr::u32>::size_type i = 0; i < swapFirst.size(); i++) {
+        std::swap(lineReal[swapFirst[i]], lineReal[swapSecond[i]]);
+        std::swap(lineImag[swapFirst[i]], lineImag[swapSecond[i]]);
+    }
+
+    for (std::vector<Pass>::size_type p = 0; p < passes.size(); p++) {
+        const Pass& pass = passes[p];
+        const irr::u32 half = pass.half;
+
+        if (!pass.radix4) {
+            //Radix-2 pass on pairs, where the twiddle factor is 1
+            for (irr::u32 j = 0; j < size; j += 2) {
+                irr::f32 ar = lineReal[j], ai = lineImag[j];
+                irr::f32 br = lineReal[j+1], bi = lineImag[j+1];
+                lineReal[j] = ar + br; lineImag[j] = ai + bi;
+                lineReal[j+1] = ar - br; lineImag[j+1] = ai - bi;
+            }
+            continue;
+        }
+
+        const irr::f32* w1r = &twiddle1Real[pass.twiddleStart];
+        const irr::f32* w1i = &twiddle1Imag[pass.twiddleStart];
+        const irr::f32* w2r = &twiddle2Real[pass.twiddleStart];
+        const irr::f32* w2i = &twiddle2Imag[pass.twiddleStart];
+
+        for (irr::u32 j = 0; j < size; j += 4*half) {
+            irr::f32* blockReal = lineReal + j;
+            irr::f32* blockImag = lineImag + j;
+            irr::u32 k = 0;
+
+            #ifdef FFT_USE_AVX
+            for (; k + 8 <= half; k += 8) {
+                butterflyAVX(blockReal + k, blockImag + k, half, _mm256_loadu_ps(w1r + k), _mm256_loadu_ps(w1i + k), _mm256_loadu_ps(w2r + k), _mm256_loadu_ps(w2i + k));
+            }
+            #endif
+
+            #ifdef FFT_USE_SSE2
+            for (; k + 4 <= half; k += 4) {
+                butterflySSE2(blockReal + k, blockImag + k, half, _mm_loadu_ps(w1r + k), _mm_loadu_ps(w1i + k), _mm_loadu_ps(w2r + k), _mm_loadu_ps(w2i + k));
+            }
+            #endif
+
+            //Remainder, or all if no SIMD available (or the first pass, where half is small)
+            for (; k < half; k++) {
+                butterflyScalar(blockReal + k, blockImag + k, half, w1r[k], w1i[k], w2r[k], w2i[k]);
+            }
+        }
+    }
+}
+
+void BatchedFFT::transpose(irr::f32* data)
+{
+    //In place, swapping each block above the diagonal with the matching block below
+    for (irr::u32 blockRow = 0; blockRow < size; blockRow += TRANSPOSE_BLOCK_SIZE) {
+        irr::u32 blockRowEnd = std::min(blockRow + TRANSPOSE_BLOCK_SIZE, size);
+        for (irr::u32 blockColumn = blockRow; blockColumn < size; blockColumn += TRANSPOSE_BLOCK_SIZE) {
+            irr::u32 blockColumnEnd = std::min(blockColumn + TRANSPOSE_BLOCK_SIZE, size);
+            for (irr::u32 row = blockRow; row < blockRowEnd; row++) {
+                //On the diagonal block, only swap above the diagonal
+                irr::u32 firstColumn = (blockColumn == blockRow) ? row + 1 : blockColumn;
+                for (irr::u32 column = firstColumn; column < blockColumnEnd; column++) {
+                    std::swap(data[row*size + column], data[column*size + row]);
+                }
+            }
+        }
+    }
+}
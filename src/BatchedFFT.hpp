@@ -0,0 +1,66 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __BATCHEDFFT_HPP_INCLUDED__
+#define __BATCHEDFFT_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <vector>
+
+//Two dimensional FFT of several N x N complex fields together, as used for the FFT waves.
+//Each field is held as separate real and imaginary arrays, and transformed in place, with radix-4 passes (plus one radix-2 pass if log2(N) is odd).
+//Columns are transformed by transposing (in cache sized blocks) and transforming rows again, so the result is left transposed.
+//Uses SSE2 or AVX where available at compile time, with a scalar fallback.
+//The transform uses exp(+2*pi*i*n*k/N), and is not normalised, as for the inverse transform of a wave spectrum.
+class BatchedFFT
+{
+    public:
+        BatchedFFT(irr::u32 size, irr::u32 numberOfFields); //size must be a power of 2
+        irr::u32 getSize() const;
+        irr::u32 getNumberOfFields() const;
+        //Real and imaginary parts of a field, indexed [row*size + column]. Set these before transform().
+        irr::f32* getReal(irr::u32 field);
+        irr::f32* getImag(irr::u32 field);
+        //Transform all fields. Afterwards, the value for original row m, column n is at [n*size + m].
+        void transform();
+
+    private:
+        struct Pass {
+            irr::u32 half; //Length of each sub-transform before this pass (the output is 4 times this, or 2 times for a radix-2 pass)
+            bool radix4;
+            irr::u32 twiddleStart; //Start of this pass's twiddle factors
+        };
+
+        irr::u32 size;
+        irr::u32 numberOfFields;
+        std::vector<irr::f32> real; //All fields, one after another
+        std::vector<irr::f32> imag;
+        std::vector<irr::u32> swapFirst; //Pairs of positions to swap for the bit reversal permutation
+        std::vector<irr::u32> swapSecond;
+        std::vector<Pass> passes;
+        //For each radix-4 pass, twiddle factors for k = 0 to half-1: exp(2*pi*i*k/(2*half)) and exp(2*pi*i*k/(4*half))
+        std::vector<irr::f32> twiddle1Real;
+        std::vector<irr::f32> twiddle1Imag;
+        std::vector<irr::f32> twiddle2Real;
+        std::vector<irr::f32> twiddle2Imag;
+
+        void transformRows(irr::f32* fieldReal, irr::f32* fieldImag);
+        void transformLine(irr::f32* lineReal, irr::f32* lineImag);
+        void transpose(irr::f32* data);
+};
+
+#endif // __BATCHEDFFT_HPP_INCLUDED__
@@ -157,7 +157,7 @@ irr::scene::ISceneNode* Buoy::getSceneNode() const
 
 RadarData Buoy::getRadarData(irr::core::vector3df scannerPosition) const
 //Get data relative to scannerPosition
-//Similar code in OtherShip.cpp
+//Similar code in OtherShips.cpp
 {
     RadarData radarData;
 
@@ -23,6 +23,8 @@
 #include "RadarData.hpp"
 #include "SimulationModel.hpp"
 
+#include <algorithm>
+
 //using namespace irr;
 
 Buoys::Buoys()
@@ -111,14 +113,30 @@ void Buoys::load(const std::string& worldName, irr::scene::ISceneManager* smgr,
     }
 }
 
-void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength)
+void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength, SpatialIndex& spatialIndex)
 {
+    //Find wave heights and normals for all buoys together
+    waveXs.resize(buoys.size());
+    waveZs.resize(buoys.size());
+    waveHeights.resize(buoys.size());
+    waveNormalXs.resize(buoys.size());
+    waveNormalZs.resize(buoys.size());
+    for (std::vector<Buoy>::size_type i = 0; i < buoys.size(); i++) {
+        irr::core::vector3df pos = buoys.at(i).getPosition();
+        waveXs.at(i) = pos.X;
+        waveZs.at(i) = pos.Z;
+    }
+    if (!buoys.empty()) {
+        model->getWaveData(&waveXs[0], &waveZs[0], &waveHeights[0], &waveNormalXs[0], &waveNormalZs[0], buoys.size());
+    }
+
     for(std::vector<Buoy>::iterator it = buoys.begin(); it != buoys.end(); ++it) {
+        std::vector<Buoy>::size_type i = it - buoys.begin();
         irr::f32 xPos, yPos, zPos;
         irr::core::vector3df pos = it->getPosition();
         xPos = pos.X;
         if (it->getFloating()) {
-            yPos = tideHeight + model->getWaveHeight(pos.X,pos.Z) + it->getHeightCorrection();
+            yPos = tideHeight + waveHeights.at(i) + it->getHeightCorrection();
         } else {
             yPos = 0 + it->getHeightCorrection();
         }
@@ -127,23 +145,36 @@ void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeigh
 
         if (it->getFloating()) {
             irr::f32 angleX, angleZ;
-            irr::core::vector2df normals = model->getLocalNormals(pos.X,pos.Z);
-            angleX = normals.X * irr::core::RADTODEG;//Assume small angle, so just convert rad to deg
-            angleZ = normals.Y * irr::core::RADTODEG;//Assume small angle, so just convert rad to deg
+            angleX = waveNormalXs.at(i) * irr::core::RADTODEG;//Assume small angle, so just convert rad to deg
+            angleZ = waveNormalZs.at(i) * irr::core::RADTODEG;//Assume small angle, so just convert rad to deg
             it->setRotation(irr::core::vector3df(angleX,0,angleZ));
         } else {
             it->setRotation(irr::core::vector3df(0,0,0));
         }
 
-        //Set or clear triangle selector depending on distance from own ship
-        if (it->getSceneNode()->getAbsolutePosition().getDistanceFrom(ownShipPosition) < 2*ownShipLength) {
-            it->enableTriangleSelector(true);
-        } else {
-            it->enableTriangleSelector(false);
-        }
+        spatialIndex.setPosition(E_SPATIAL_BUOY, i, xPos, zPos, 0.5*it->getLength());
 
     }
 
+    //Set or clear triangle selectors depending on distance from own ship, only checking buoys that are nearby, or were last time
+    spatialIndex.findInRange(ownShipPosition.X, ownShipPosition.Z, 2*ownShipLength, nearbyObjects);
+    newSelectorBuoys.clear();
+    for (std::vector<SpatialIndex::Object>::size_type i = 0; i < nearbyObjects.size(); i++) {
+        if (nearbyObjects.at(i).type == E_SPATIAL_BUOY &&
+            buoys.at(nearbyObjects.at(i).number).getPosition().getDistanceFrom(ownShipPosition) < 2*ownShipLength) {
+            newSelectorBuoys.push_back(nearbyObjects.at(i).number); //In order, as returned from the spatial index
+        }
+    }
+    for (std::vector<irr::u32>::size_type i = 0; i < selectorBuoys.size(); i++) {
+        if (!std::binary_search(newSelectorBuoys.begin(), newSelectorBuoys.end(), selectorBuoys.at(i))) {
+            buoys.at(selectorBuoys.at(i)).enableTriangleSelector(false);
+        }
+    }
+    for (std::vector<irr::u32>::size_type i = 0; i < newSelectorBuoys.size(); i++) {
+        buoys.at(newSelectorBuoys.at(i)).enableTriangleSelector(true);
+    }
+    selectorBuoys.swap(newSelectorBuoys);
+
     for(std::vector<NavLight*>::iterator it = buoysLights.begin(); it != buoysLights.end(); ++it) {
 
         //Update light size/visibility etc
@@ -155,9 +186,11 @@ void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeigh
 
 void Buoys::enableAllTriangleSelectors()
 {
+    selectorBuoys.clear();
     for(std::vector<Buoy>::iterator it = buoys.begin(); it != buoys.end(); ++it) {
         // This will return to normal the next time Buoys::update is called.
         it->enableTriangleSelector(true);
+        selectorBuoys.push_back(it - buoys.begin());
     }
 }
 
@@ -22,6 +22,8 @@
 #include <vector>
 #include <string>
 
+#include "SpatialIndex.hpp"
+
 //Forward declarations
 class SimulationModel;
 class Buoy;
@@ -34,7 +36,7 @@ class Buoys
         Buoys();
         virtual ~Buoys();
         void load(const std::string& worldName, irr::scene::ISceneManager* smgr, SimulationModel* model, irr::IrrlichtDevice* dev);
-        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength);
+        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength, SpatialIndex& spatialIndex); //Also updates the buoys' positions in spatialIndex
         RadarData getRadarData(irr::u32 number, irr::core::vector3df scannerPosition) const;
         irr::u32 getNumber() const;
         irr::core::vector3df getPosition(int number) const;
@@ -46,6 +48,18 @@ class Buoys
         std::vector<Buoy> buoys;
         std::vector<NavLight*> buoysLights;
         SimulationModel* model; //Store reference to model
+        std::vector<irr::u32> selectorBuoys; //Buoys with their triangle selector enabled, in order
+
+        //Working storage for finding wave data for all buoys together
+        std::vector<irr::f32> waveXs;
+        std::vector<irr::f32> waveZs;
+        std::vector<irr::f32> waveHeights;
+        std::vector<irr::f32> waveNormalXs;
+        std::vector<irr::f32> waveNormalZs;
+
+        //Working storage for finding which buoys are near own ship
+        std::vector<SpatialIndex::Object> nearbyObjects;
+        std::vector<irr::u32> newSelectorBuoys;
 };
 
 #endif
@@ -0,0 +1,181 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "ContactPointCache.hpp"
+
+#include "OwnShip.hpp"
+#include "Utilities.hpp"
+
+#include <cstdio> //for remove()
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h> //for windows _mkdir
+#else
+#include <sys/stat.h>
+#endif // _WIN32
+
+//Identifies the file, and changes if the layout changes (or the way contact points are found)
+const std::string CONTACT_POINT_CACHE_MAGIC = "BCCONTACT1";
+
+ContactPointCache::ContactPointCache(const std::string& shipName, const std::string& modelPath, const std::string& shipIniPath)
+{
+    filename = Utilities::getUserDir() + "ContactPoints/" + shipName + ".bcc";
+    modelHash = 0;
+    shipIniHash = 0;
+    filesHashed = hashFile(modelPath, modelHash) && hashFile(shipIniPath, shipIniHash);
+}
+
+void ContactPointCache::setParameters(irr::f32 scaleFactor, irr::f32 heightCorrection, irr::core::vector3di numberOfContactPoints, const irr::core::aabbox3df& boundingBox)
+{
+    key.clear();
+    key.push_back(scaleFactor);
+    key.push_back(heightCorrection);
+    key.push_back(numberOfContactPoints.X);
+    key.push_back(numberOfContactPoints.Y);
+    key.push_back(numberOfContactPoints.Z);
+    key.push_back(boundingBox.MinEdge.X);
+    key.push_back(boundingBox.MinEdge.Y);
+    key.push_back(boundingBox.MinEdge.Z);
+    key.push_back(boundingBox.MaxEdge.X);
+    key.push_back(boundingBox.MaxEdge.Y);
+    key.push_back(boundingBox.MaxEdge.Z);
+}
+
+bool ContactPointCache::load(std::vector<ContactPoint>& contactPoints) const
+{
+    if (!filesHashed) {
+        return false;
+    }
+
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    //Check this cache is for the current files and parameters. The file is only read on the machine that wrote it, so values are in native format.
+    std::string magic(CONTACT_POINT_CACHE_MAGIC.size(), ' ');
+    file.read(&magic[0], magic.size());
+    uint64_t fileModelHash = 0;
+    uint64_t fileShipIniHash = 0;
+    file.read((char*)&fileModelHash, sizeof(fileModelHash));
+    file.read((char*)&fileShipIniHash, sizeof(fileShipIniHash));
+    irr::u32 keySize = 0;
+    file.read((char*)&keySize, sizeof(keySize));
+    if (!file || magic != CONTACT_POINT_CACHE_MAGIC || fileModelHash != modelHash || fileShipIniHash != shipIniHash || keySize != key.size()) {
+        return false;
+    }
+    for (irr::u32 i = 0; i < keySize; i++) {
+        irr::f32 value = 0;
+        file.read((char*)&value, sizeof(value));
+        if (!file || value != key.at(i)) {
+            return false;
+        }
+    }
+
+    irr::u32 numberOfPoints = 0;
+    file.read((char*)&numberOfPoints, sizeof(numberOfPoints));
+    if (!file) {
+        return false;
+    }
+    std::vector<ContactPoint> loadedPoints(numberOfPoints);
+    for (irr::u32 i = 0; i < numberOfPoints; i++) {
+        ContactPoint& contactPoint = loadedPoints.at(i);
+        irr::f32 values[11];
+        file.read((char*)values, sizeof(values));
+        contactPoint.position = irr::core::vector3df(values[0], values[1], values[2]);
+        contactPoint.normal = irr::core::vector3df(values[3], values[4], values[5]);
+        contactPoint.internalPosition = irr::core::vector3df(values[6], values[7], values[8]);
+        contactPoint.torqueEffect = values[9];
+        contactPoint.effectiveArea = values[10];
+    }
+    if (!file) {
+        return false;
+    }
+
+    contactPoints.insert(contactPoints.end(), loadedPoints.begin(), loadedPoints.end());
+    return true;
+}
+
+void ContactPointCache::save(const std::vector<ContactPoint>& contactPoints) const
+{
+    if (!filesHashed) {
+        return;
+    }
+
+    //Make the cache folder if needed
+    std::string cacheFolder = Utilities::getUserDir() + "ContactPoints";
+    if (!Utilities::pathExists(cacheFolder)) {
+        #ifdef _WIN32
+        _mkdir(cacheFolder.c_str());
+        #else
+        mkdir(cacheFolder.c_str(),0755);
+        #endif // _WIN32
+    }
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return;
+    }
+
+    file.write(CONTACT_POINT_CACHE_MAGIC.data(), CONTACT_POINT_CACHE_MAGIC.size());
+    file.write((const char*)&modelHash, sizeof(modelHash));
+    file.write((const char*)&shipIniHash, sizeof(shipIniHash));
+    irr::u32 keySize = key.size();
+    file.write((const char*)&keySize, sizeof(keySize));
+    for (irr::u32 i = 0; i < keySize; i++) {
+        irr::f32 value = key.at(i);
+        file.write((const char*)&value, sizeof(value));
+    }
+
+    irr::u32 numberOfPoints = contactPoints.size();
+    file.write((const char*)&numberOfPoints, sizeof(numberOfPoints));
+    for (irr::u32 i = 0; i < numberOfPoints; i++) {
+        const ContactPoint& contactPoint = contactPoints.at(i);
+        irr::f32 values[11] = {contactPoint.position.X, contactPoint.position.Y, contactPoint.position.Z,
+                               contactPoint.normal.X, contactPoint.normal.Y, contactPoint.normal.Z,
+                               contactPoint.internalPosition.X, contactPoint.internalPosition.Y, contactPoint.internalPosition.Z,
+                               contactPoint.torqueEffect, contactPoint.effectiveArea};
+        file.write((const char*)values, sizeof(values));
+    }
+
+    if (!file) {
+        //Don't leave a partial file
+        file.close();
+        remove(filename.c_str());
+    }
+}
+
+bool ContactPointCache::hashFile(const std::string& path, uint64_t& hash)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    //FNV-1a, 64 bit
+    hash = 14695981039346656037ULL;
+    char buffer[65536];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        std::streamsize bytesRead = file.gcount();
+        for (std::streamsize i = 0; i < bytesRead; i++) {
+            hash ^= (unsigned char)buffer[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __CONTACTPOINTCACHE_HPP_INCLUDED__
+#define __CONTACTPOINTCACHE_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h> //for uint64_t
+
+struct ContactPoint;
+
+//Stores own ship contact points in the user directory, so they don't need to be found again by ray checks against the model each time the ship is loaded.
+//The cached points are only used if the model and boat.ini files, and the parameters used to place the rays, are all unchanged.
+class ContactPointCache
+{
+    public:
+        ContactPointCache(const std::string& shipName, const std::string& modelPath, const std::string& shipIniPath);
+        //Everything else that affects the contact points found
+        void setParameters(irr::f32 scaleFactor, irr::f32 heightCorrection, irr::core::vector3di numberOfContactPoints, const irr::core::aabbox3df& boundingBox);
+        bool load(std::vector<ContactPoint>& contactPoints) const; //Returns false if there's no cache for the current files and parameters
+        void save(const std::vector<ContactPoint>& contactPoints) const;
+
+    private:
+        std::string filename;
+        bool filesHashed; //False if either file can't be read, in which case the cache isn't used
+        std::vector<irr::f32> key; //Parameters, and the file hashes, as written at the start of the cache file
+        uint64_t modelHash;
+        uint64_t shipIniHash;
+
+        static bool hashFile(const std::string& path, uint64_t& hash);
+};
+
+#endif // __CONTACTPOINTCACHE_HPP_INCLUDED__
@@ -0,0 +1,259 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "ContactQuery.hpp"
+
+#include <algorithm>
+
+//Maximum triangles in each leaf of the tree
+const irr::u32 CONTACT_TREE_LEAF_SIZE = 4;
+//Tree depth is about log2(triangles/leaf size), so this allows for far more triangles than any model will have
+const irr::u32 CONTACT_TREE_MAX_DEPTH = 64;
+
+//For sorting triangles by their centre along one axis
+class TriangleCentreLess
+{
+    public:
+        TriangleCentreLess(irr::u32 axis):axis(axis){}
+        bool operator()(const irr::core::triangle3df& first, const irr::core::triangle3df& second) const
+        {
+            return centre(first) < centre(second);
+        }
+    private:
+        irr::u32 axis;
+        irr::f32 centre(const irr::core::triangle3df& triangle) const
+        {
+            if (axis == 0) {return triangle.pointA.X + triangle.pointB.X + triangle.pointC.X;}
+            if (axis == 1) {return triangle.pointA.Y + triangle.pointB.Y + triangle.pointC.Y;}
+            return triangle.pointA.Z + triangle.pointB.Z + triangle.pointC.Z;
+        }
+};
+
+ContactQuery::ContactQuery()
+{
+
+}
+
+void ContactQuery::findNearbyNodes(irr::scene::ISceneManager* smgr, const irr::core::vector3df& centre, irr::f32 radius, irr::s32 idBitMask, irr::scene::ISceneNode* ignoreNode)
+{
+    nearbyNodes.clear();
+    addNearbyNodes(smgr->getRootSceneNode(), centre, radius, idBitMask, ignoreNode);
+}
+
+void ContactQuery::getCollisionPoints(const std::vector<irr::core::line3df>& rays, std::vector<Hit>& hits)
+{
+    hits.resize(rays.size());
+    nearestFractions.assign(rays.size(), 1.0f);
+    for (std::vector<Hit>::size_type i = 0; i < hits.size(); i++) {
+        hits.at(i).node = 0;
+    }
+
+    for (std::vector<NearbyNode>::size_type n = 0; n < nearbyNodes.size(); n++) {
+        const NearbyNode& nearbyNode = nearbyNodes.at(n);
+        if (nearbyNode.tree->nodes.empty()) {
+            continue;
+        }
+
+        for (std::vector<irr::core::line3df>::size_type i = 0; i < rays.size(); i++) {
+            //Work in model coordinates. The proportion along the ray is the same in either coordinate system, so can be compared between nodes.
+            irr::core::line3df modelRay = rays.at(i);
+            nearbyNode.worldToModel.transformVect(modelRay.start);
+            nearbyNode.worldToModel.transformVect(modelRay.end);
+
+            irr::u32 hitTriangle;
+            if (intersectTree(*nearbyNode.tree, modelRay, nearestFractions.at(i), hitTriangle)) {
+                Hit& hit = hits.at(i);
+                hit.node = nearbyNode.node;
+                hit.intersection = rays.at(i).start + rays.at(i).getVector()*nearestFractions.at(i);
+                hit.triangle = nearbyNode.tree->triangles.at(hitTriangle);
+                nearbyNode.modelToWorld.transformVect(hit.triangle.pointA);
+                nearbyNode.modelToWorld.transformVect(hit.triangle.pointB);
+                nearbyNode.modelToWorld.transformVect(hit.triangle.pointC);
+            }
+        }
+    }
+}
+
+void ContactQuery::addNearbyNodes(irr::scene::ISceneNode* parent, const irr::core::vector3df& centre, irr::f32 radius, irr::s32 idBitMask, irr::scene::ISceneNode* ignoreNode)
+{
+    //Follows the same rules as ISceneCollisionManager for which nodes are checked
+    const irr::scene::ISceneNodeList& children = parent->getChildren();
+    for (irr::scene::ISceneNodeList::ConstIterator it = children.begin(); it != children.end(); ++it) {
+        irr::scene::ISceneNode* current = *it;
+        if (current == ignoreNode) {
+            continue;
+        }
+
+        irr::scene::ITriangleSelector* selector = current->getTriangleSelector();
+        if (selector && current->isVisible() && (idBitMask == 0 || (current->getID() & idBitMask))) {
+            //Broad phase: Is the closest point of the node's bounding box within the sphere
+            irr::core::aabbox3df box = current->getTransformedBoundingBox();
+            irr::core::vector3df closest(irr::core::clamp(centre.X, box.MinEdge.X, box.MaxEdge.X),
+                                         irr::core::clamp(centre.Y, box.MinEdge.Y, box.MaxEdge.Y),
+                                         irr::core::clamp(centre.Z, box.MinEdge.Z, box.MaxEdge.Z));
+            NearbyNode nearbyNode;
+            if (closest.getDistanceFromSQ(centre) <= radius*radius &&
+                current->getAbsoluteTransformation().getInverse(nearbyNode.worldToModel)) {
+                nearbyNode.node = current;
+                nearbyNode.tree = &getTree(selector);
+                nearbyNode.modelToWorld = current->getAbsoluteTransformation();
+                nearbyNodes.push_back(nearbyNode);
+            }
+        }
+
+        addNearbyNodes(current, centre, radius, idBitMask, ignoreNode);
+    }
+}
+
+const ContactQuery::TriangleTree& ContactQuery::getTree(irr::scene::ITriangleSelector* selector)
+{
+    std::unordered_map<irr::scene::ITriangleSelector*, TriangleTree>::iterator found = trees.find(selector);
+    if (found != trees.end()) {
+        return found->second;
+    }
+
+    TriangleTree& tree = trees[selector];
+
+    //Get the triangles without the node's transformation, so the tree stays valid as the node moves
+    irr::s32 triangleCount = selector->getTriangleCount();
+    if (triangleCount > 0) {
+        tree.triangles.resize(triangleCount);
+        irr::s32 trianglesFound = 0;
+        selector->getTriangles(&tree.triangles[0], triangleCount, trianglesFound, 0, false);
+        tree.triangles.resize(trianglesFound);
+    }
+
+    if (!tree.triangles.empty()) {
+        tree.nodes.reserve(2*tree.triangles.size()/CONTACT_TREE_LEAF_SIZE + 1);
+        tree.nodes.push_back(TreeNode());
+        buildTree(tree, 0, 0, tree.triangles.size());
+    }
+
+    return tree;
+}
+
+void ContactQuery::buildTree(TriangleTree& tree, irr::u32 nodeIndex, irr::u32 first, irr::u32 count)
+{
+    irr::core::aabbox3df box(tree.triangles.at(first).pointA);
+    irr::core::aabbox3df centreBox(tree.triangles.at(first).pointA);
+    for (irr::u32 i = first; i < first + count; i++) {
+        const irr::core::triangle3df& triangle = tree.triangles.at(i);
+        box.addInternalPoint(triangle.pointA);
+        box.addInternalPoint(triangle.pointB);
+        box.addInternalPoint(triangle.pointC);
+        centreBox.addInternalPoint((triangle.pointA + triangle.pointB + triangle.pointC)/3.0f);
+    }
+    tree.nodes.at(nodeIndex).box = box;
+
+    //Split along the longest axis of the triangle centres, unless few enough to be a leaf
+    irr::core::vector3df extent = centreBox.getExtent();
+    irr::u32 axis = 0;
+    if (extent.Y > extent.X && extent.Y >= extent.Z) {axis = 1;}
+    if (extent.Z > extent.X && extent.Z > extent.Y) {axis = 2;}
+    irr::f32 longestExtent = (axis == 0) ? extent.X : ((axis == 1) ? extent.Y : extent.Z);
+
+    if (count <= CONTACT_TREE_LEAF_SIZE || longestExtent <= 0) {
+        tree.nodes.at(nodeIndex).first = first;
+        tree.nodes.at(nodeIndex).count = count;
+        return;
+    }
+
+    irr::u32 half = count/2;
+    std::nth_element(tree.triangles.begin() + first, tree.triangles.begin() + first + half, tree.triangles.begin() + first + count, TriangleCentreLess(axis));
+
+    irr::u32 childIndex = tree.nodes.size();
+    tree.nodes.push_back(TreeNode());
+    tree.nodes.push_back(TreeNode());
+    tree.nodes.at(nodeIndex).first = childIndex;
+    tree.nodes.at(nodeIndex).count = 0;
+
+    buildTree(tree, childIndex, first, half);
+    buildTree(tree, childIndex + 1, first + half, count - half);
+}
+
+bool ContactQuery::intersectTree(const TriangleTree& tree, const irr::core::line3df& ray, irr::f32& nearestFraction, irr::u32& hitTriangle)
+{
+    const irr::core::vector3df vector = ray.getVector();
+    const irr::f32 lengthSQ = vector.getLengthSQ();
+    if (lengthSQ <= 0) {
+        return false;
+    }
+
+    bool hit = false;
+    irr::u32 stack[CONTACT_TREE_MAX_DEPTH];
+    irr::u32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const TreeNode& node = tree.nodes[stack[--stackSize]];
+        if (!rayHitsBox(node.box, ray.start, vector, nearestFraction)) {
+            continue;
+        }
+
+        if (node.count == 0) {
+            if (stackSize + 2 <= CONTACT_TREE_MAX_DEPTH) {
+                stack[stackSize++] = node.first;
+                stack[stackSize++] = node.first + 1;
+            }
+            continue;
+        }
+
+        for (irr::u32 i = node.first; i < node.first + node.count; i++) {
+            irr::core::vector3df intersection;
+            if (tree.triangles[i].getIntersectionWithLine(ray.start, vector, intersection)) {
+                //Only count hits within the ray, and nearer than any found so far
+                irr::f32 fraction = (intersection - ray.start).dotProduct(vector)/lengthSQ;
+                if (fraction > 0 && fraction < nearestFraction) {
+                    nearestFraction = fraction;
+                    hitTriangle = i;
+                    hit = true;
+                }
+            }
+        }
+    }
+
+    return hit;
+}
+
+bool ContactQuery::rayHitsBox(const irr::core::aabbox3df& box, const irr::core::vector3df& start, const irr::core::vector3df& vector, irr::f32 maxFraction)
+{
+    //Slab test, for the part of the ray from start to maxFraction along it
+    irr::f32 minFraction = 0;
+    const irr::f32 starts[3] = {start.X, start.Y, start.Z};
+    const irr::f32 vectors[3] = {vector.X, vector.Y, vector.Z};
+    const irr::f32 mins[3] = {box.MinEdge.X, box.MinEdge.Y, box.MinEdge.Z};
+    const irr::f32 maxs[3] = {box.MaxEdge.X, box.MaxEdge.Y, box.MaxEdge.Z};
+
+    for (irr::u32 axis = 0; axis < 3; axis++) {
+        if (vectors[axis] == 0) {
+            if (starts[axis] < mins[axis] || starts[axis] > maxs[axis]) {
+                return false;
+            }
+        } else {
+            irr::f32 entry = (mins[axis] - starts[axis])/vectors[axis];
+            irr::f32 exit = (maxs[axis] - starts[axis])/vectors[axis];
+            if (entry > exit) {
+                std::swap(entry, exit);
+            }
+            minFraction = std::max(minFraction, entry);
+            maxFraction = std::min(maxFraction, exit);
+            if (minFraction > maxFraction) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __CONTACTQUERY_HPP_INCLUDED__
+#define __CONTACTQUERY_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <unordered_map>
+#include <vector>
+
+//Finds where a batch of short rays (e.g. from own ship's hull contact points) first hit pickable scene nodes.
+//Gives the same results as ISceneCollisionManager::getSceneNodeAndCollisionPointFromRay, but:
+//The scene is searched once per batch, keeping only nodes whose bounds are within a given sphere, and
+//each node's triangles are held in a bounding volume hierarchy in model space, built the first time the node is near, and then reused.
+//This relies on the triangle selectors' geometry not changing once created, which is the case for the ships, buoys and land objects.
+class ContactQuery
+{
+    public:
+        struct Hit {
+            irr::scene::ISceneNode* node; //0 if nothing hit
+            irr::core::vector3df intersection; //World coordinates
+            irr::core::triangle3df triangle; //World coordinates
+        };
+
+        ContactQuery();
+        //Find pickable nodes (matching idBitMask, as for getSceneNodeAndCollisionPointFromRay) with bounds within radius of centre. ignoreNode and its children are not included.
+        void findNearbyNodes(irr::scene::ISceneManager* smgr, const irr::core::vector3df& centre, irr::f32 radius, irr::s32 idBitMask, irr::scene::ISceneNode* ignoreNode);
+        //Find the nearest hit along each ray (start to end), from the nodes found by the last call to findNearbyNodes. hits is resized to match rays.
+        void getCollisionPoints(const std::vector<irr::core::line3df>& rays, std::vector<Hit>& hits);
+
+    private:
+        struct TreeNode {
+            irr::core::aabbox3df box;
+            irr::u32 first; //Leaf: first triangle. Otherwise: index of the first child (the second follows it)
+            irr::u32 count; //Number of triangles if a leaf, 0 otherwise
+        };
+        struct TriangleTree {
+            std::vector<irr::core::triangle3df> triangles; //Model coordinates
+            std::vector<TreeNode> nodes; //nodes[0] is the root
+        };
+        struct NearbyNode {
+            irr::scene::ISceneNode* node;
+            const TriangleTree* tree;
+            irr::core::matrix4 worldToModel;
+            irr::core::matrix4 modelToWorld;
+        };
+
+        std::unordered_map<irr::scene::ITriangleSelector*, TriangleTree> trees; //Cached, by selector
+        std::vector<NearbyNode> nearbyNodes;
+        std::vector<irr::f32> nearestFractions; //For each ray, the proportion along it of the nearest hit so far
+
+        void addNearbyNodes(irr::scene::ISceneNode* parent, const irr::core::vector3df& centre, irr::f32 radius, irr::s32 idBitMask, irr::scene::ISceneNode* ignoreNode);
+        const TriangleTree& getTree(irr::scene::ITriangleSelector* selector);
+        static void buildTree(TriangleTree& tree, irr::u32 nodeIndex, irr::u32 first, irr::u32 count);
+        static bool intersectTree(const TriangleTree& tree, const irr::core::line3df& ray, irr::f32& nearestFraction, irr::u32& hitTriangle);
+        static bool rayHitsBox(const irr::core::aabbox3df& box, const irr::core::vector3df& start, const irr::core::vector3df& vector, irr::f32 maxFraction);
+};
+
+#endif // __CONTACTQUERY_HPP_INCLUDED__
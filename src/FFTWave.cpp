@@ -52,25 +52,19 @@ double cTimer::elapsed(bool frame) {
 	return elapsed;
 }
 */
-unsigned int complex::additions = 0;
-unsigned int complex::multiplications = 0;
-
 complex::complex() : a(0.0f), b(0.0f) { }
 complex::complex(float a, float b) : a(a), b(b) { }
 complex complex::conj() { return complex(this->a, -this->b); }
 
 complex complex::operator*(const complex& c) const {
-	complex::multiplications++;
 	return complex(this->a*c.a - this->b*c.b, this->a*c.b + this->b*c.a);
 }
 
 complex complex::operator+(const complex& c) const {
-	complex::additions++;
 	return complex(this->a + c.a, this->b + c.b);
 }
 
 complex complex::operator-(const complex& c) const {
-	complex::additions++;
 	return complex(this->a - c.a, this->b - c.b);
 }
 
@@ -87,11 +81,6 @@ complex& complex::operator=(const complex& c) {
 	return *this;
 }
 
-void complex::reset() {
-	complex::additions = 0;
-	complex::multiplications = 0;
-}
-
 vector3::vector3() : x(0.0f), y(0.0f), z(0.0f) { }
 vector3::vector3(float x, float y, float z) : x(x), y(y), z(z) { }
 
@@ -164,79 +153,6 @@ vector2 vector2::unit() {
 	return vector2(this->x/l, this->y/l);
 }
 
-cFFT::cFFT(unsigned int N) : N(N), reversed(0), T(0), pi2(2 * M_PI) {
-	c[0] = c[1] = 0;
-
-	log_2_N = log(N)/log(2);
-
-	reversed = new unsigned int[N];		// prep bit reversals
-	for (unsigned int i = 0; i < N; i++) reversed[i] = reverse(i);
-
-	int pow2 = 1;
-	T = new complex*[log_2_N];		// prep T
-	for (unsigned int i = 0; i < log_2_N; i++) {
-		T[i] = new complex[pow2];
-		for (int j = 0; j < pow2; j++) T[i][j] = t(j, pow2 * 2);
-		pow2 *= 2;
-	}
-
-	c[0] = new complex[N];
-	c[1] = new complex[N];
-	which = 0;
-}
-
-cFFT::~cFFT() {
-	if (c[0]) delete [] c[0];
-	if (c[1]) delete [] c[1];
-	if (T) {
-		for (unsigned int i = 0; i < log_2_N; i++) if (T[i]) delete [] T[i];
-		delete [] T;
-	}
-	if (reversed) delete [] reversed;
-}
-
-unsigned int cFFT::reverse(unsigned int i) {
-	unsigned int res = 0;
-	for (unsigned int j = 0; j < log_2_N; j++) {
-		res = (res << 1) + (i & 1);
-		i >>= 1;
-	}
-	return res;
-}
-
-complex cFFT::t(unsigned int x, unsigned int N) {
-	return complex(cos(pi2 * x / N), sin(pi2 * x / N));
-}
-
-void cFFT::fft(complex* input, complex* output, int stride, int offset) {
-	for (unsigned int i = 0; i < N; i++) c[which][i] = input[reversed[i] * stride + offset];
-
-	int loops       = N>>1;
-	int size        = 1<<1;
-	int size_over_2 = 1;
-	int w_          = 0;
-	for (unsigned int i = 1; i <= log_2_N; i++) {
-		which ^= 1;
-		for (int j = 0; j < loops; j++) {
-			for (int k = 0; k < size_over_2; k++) {
-				c[which][size * j + k] =  c[which^1][size * j + k] +
-							  c[which^1][size * j + size_over_2 + k] * T[w_][k];
-			}
-
-			for (int k = size_over_2; k < size; k++) {
-				c[which][size * j + k] =  c[which^1][size * j - size_over_2 + k] -
-							  c[which^1][size * j + k] * T[w_][k - size_over_2];
-			}
-		}
-		loops       >>= 1;
-		size        <<= 1;
-		size_over_2 <<= 1;
-		w_++;
-	}
-
-	for (unsigned int i = 0; i < N; i++) output[i * stride + offset] = c[which][i];
-}
-
 //MAIN WAVE CODE:
 
 float cOcean::uniformRandomVariable() {
@@ -256,22 +172,55 @@ complex cOcean::gaussianRandomVariable() {
 
 cOcean::cOcean(const int N, const float A, const vector2 w, const float length) :
 	g(9.81), N(N), Nplus1(N+1), A(A), w(w), length(length),
-	vertices(0), h_tilde(0), h_tilde_slopex(0), h_tilde_slopez(0), h_tilde_dx(0), h_tilde_dz(0), fft(0)
+	vertices(0), fft(0)
 {
-	h_tilde        = new complex[N*N];
-	h_tilde_slopex = new complex[N*N];
-	h_tilde_slopez = new complex[N*N];
-	h_tilde_dx     = new complex[N*N];
-	h_tilde_dz     = new complex[N*N];
-	fft            = new cFFT(N);
+	fft            = new BatchedFFT(N, 5);
 	vertices       = new vertex_ocean[Nplus1*Nplus1];
 
-	int index;
+	// wave vectors and dispersion for each frequency bin, which don't depend on A or w
+	dispersionStep = 2.0f * M_PI / 200.0f;
+	maxDispersionSteps = 0;
+	binKx.resize(N*N);
+	binKz.resize(N*N);
+	binKxUnit.resize(N*N);
+	binKzUnit.resize(N*N);
+	binDispersionSteps.resize(N*N);
+	for (int m_prime = 0; m_prime < N; m_prime++) {
+		float kz = M_PI * (2.0f * m_prime - N) / length;
+		for (int n_prime = 0; n_prime < N; n_prime++) {
+			float kx = M_PI*(2 * n_prime - N) / length;
+			float len = sqrt(kx * kx + kz * kz);
+			int index = m_prime * N + n_prime;
+			binKx[index] = kx;
+			binKz[index] = kz;
+			if (len < 0.000001f) {
+				binKxUnit[index] = binKzUnit[index] = 0.0f;
+			} else {
+				binKxUnit[index] = kx / len;
+				binKzUnit[index] = kz / len;
+			}
+			binDispersionSteps[index] = dispersionSteps(n_prime, m_prime);
+			if (binDispersionSteps[index] > maxDispersionSteps) {
+				maxDispersionSteps = binDispersionSteps[index];
+			}
+		}
+	}
+	phaseCos.resize(maxDispersionSteps + 1);
+	phaseSin.resize(maxDispersionSteps + 1);
 
 	//seed random number generator with srand, so we get repeatable random waves
     srand(10);
+	initialiseWaves();
+}
 
-	//NOTE: Code from here duplicated in hTilde()
+cOcean::~cOcean() {
+	if (fft)		delete fft;
+	if (vertices)		delete [] vertices;
+}
+
+void cOcean::initialiseWaves() {
+	//Set the initial wave amplitudes and the undisplaced vertex positions, from A and w
+	int index;
 	complex htilde0, htilde0mk_conj;
 	for (int m_prime = 0; m_prime < Nplus1; m_prime++) {
 		for (int n_prime = 0; n_prime < Nplus1; n_prime++) {
@@ -295,24 +244,31 @@ cOcean::cOcean(const int N, const float A, const vector2 w, const float length)
 		}
 	}
 
-	reInitialiseWaves = false;
+	// htilde0 * exp(i w t) + htilde0mk_conj * exp(-i w t), collected into terms in cos(w t) and sin(w t)
+	h0SumA.resize(N*N);
+	h0DiffB.resize(N*N);
+	h0SumB.resize(N*N);
+	h0DiffA.resize(N*N);
+	for (int m_prime = 0; m_prime < N; m_prime++) {
+		for (int n_prime = 0; n_prime < N; n_prime++) {
+			index = m_prime * Nplus1 + n_prime;
+			int binIndex = m_prime * N + n_prime;
+			h0SumA[binIndex]  = vertices[index].a + vertices[index]._a;
+			h0DiffB[binIndex] = vertices[index]._b - vertices[index].b;
+			h0SumB[binIndex]  = vertices[index].b + vertices[index]._b;
+			h0DiffA[binIndex] = vertices[index].a - vertices[index]._a;
+		}
+	}
 }
 
-cOcean::~cOcean() {
-	if (h_tilde)		delete [] h_tilde;
-	if (h_tilde_slopex)	delete [] h_tilde_slopex;
-	if (h_tilde_slopez)	delete [] h_tilde_slopez;
-	if (h_tilde_dx)		delete [] h_tilde_dx;
-	if (h_tilde_dz)		delete [] h_tilde_dz;
-	if (fft)		delete fft;
-	if (vertices)		delete [] vertices;
+int cOcean::dispersionSteps(int n_prime, int m_prime) {
+	float kx = M_PI * (2 * n_prime - N) / length;
+	float kz = M_PI * (2 * m_prime - N) / length;
+	return (int)floor(sqrt(g * sqrt(kx * kx + kz * kz)) / dispersionStep);
 }
 
 float cOcean::dispersion(int n_prime, int m_prime) {
-	float w_0 = 2.0f * M_PI / 200.0f;
-	float kx = M_PI * (2 * n_prime - N) / length;
-	float kz = M_PI * (2 * m_prime - N) / length;
-	return floor(sqrt(g * sqrt(kx * kx + kz * kz)) / w_0) * w_0;
+	return dispersionSteps(n_prime, m_prime) * dispersionStep;
 }
 
 float cOcean::phillips(int n_prime, int m_prime) {
@@ -354,46 +310,6 @@ complex cOcean::hTilde_0(int n_prime, int m_prime) {
 	return r;
 }
 
-complex cOcean::hTilde(float t, int n_prime, int m_prime) {
-	int index = m_prime * Nplus1 + n_prime;
-
-	if (reInitialiseWaves) { //NOTE: Code duplication from constructor here
-
-        complex htilde0, htilde0mk_conj;
-        htilde0        = hTilde_0( n_prime,  m_prime);
-        htilde0mk_conj = hTilde_0(-n_prime, -m_prime).conj();
-        
-        //std::cout << htilde0.a << " " << htilde0.b << std::endl;
-
-        vertices[index].a  = htilde0.a;
-        vertices[index].b  = htilde0.b;
-        vertices[index]._a = htilde0mk_conj.a;
-        vertices[index]._b = htilde0mk_conj.b;
-
-        vertices[index].ox = vertices[index].x =  (n_prime - N / 2.0f) * length / N;
-        vertices[index].oy = vertices[index].y =  0.0f;
-        vertices[index].oz = vertices[index].z =  (m_prime - N / 2.0f) * length / N;
-
-        vertices[index].nx = 0.0f;
-        vertices[index].ny = 1.0f;
-        vertices[index].nz = 0.0f;
-	}
-
-	complex htilde0(vertices[index].a,  vertices[index].b);
-	complex htilde0mkconj(vertices[index]._a, vertices[index]._b);
-
-	float omegat = dispersion(n_prime, m_prime) * t;
-
-	float cos_ = cos(omegat);
-	float sin_ = sin(omegat);
-
-	complex c0(cos_,  sin_);
-	complex c1(cos_, -sin_);
-
-	//complex res = htilde0 * c0 + htilde0mkconj * c1;
-
-	return htilde0 * c0 + htilde0mkconj*c1;
-}
 /*
 complex_vector_normal cOcean::h_D_and_n(vector2 x, float t) {
 	complex h(0.0f, 0.0f);
@@ -443,9 +359,9 @@ void cOcean::resetParameters(float A, vector2 w)
 
     this->A = A;
     this->w = w;
-    reInitialiseWaves = true;
     //seed random number generator with srand, so we get repeatable random waves
     srand(10);
+    initialiseWaves();
 }
 
 //From OpenCV via http://stackoverflow.com/a/20723890
@@ -468,66 +384,75 @@ int cOcean::localisnan(double x) const
 
 void cOcean::evaluateWavesFFT(float t) {
 
-	float kx, kz, len, lambda = -1.0f;
+	float lambda = -1.0f;
 	int index, index1;
 
-	for (int m_prime = 0; m_prime < N; m_prime++) {
-		kz = M_PI * (2.0f * m_prime - N) / length;
-		for (int n_prime = 0; n_prime < N; n_prime++) {
-			kx = M_PI*(2 * n_prime - N) / length;
-			len = sqrt(kx * kx + kz * kz);
-			index = m_prime * N + n_prime;
-
-			h_tilde[index] = hTilde(t, n_prime, m_prime);
-			h_tilde_slopex[index] = h_tilde[index] * complex(0, kx);
-			h_tilde_slopez[index] = h_tilde[index] * complex(0, kz);
-			if (len < 0.000001f) {
-				h_tilde_dx[index]     = complex(0.0f, 0.0f);
-				h_tilde_dz[index]     = complex(0.0f, 0.0f);
-			} else {
-				h_tilde_dx[index]     = h_tilde[index] * complex(0, -kx/len);
-				h_tilde_dz[index]     = h_tilde[index] * complex(0, -kz/len);
-			}
-		}
+	// fields for the fast fourier transform, as separate real and imaginary arrays
+	float *h_tilde_a        = fft->getReal(0), *h_tilde_b        = fft->getImag(0);
+	float *h_tilde_slopex_a = fft->getReal(1), *h_tilde_slopex_b = fft->getImag(1);
+	float *h_tilde_slopez_a = fft->getReal(2), *h_tilde_slopez_b = fft->getImag(2);
+	float *h_tilde_dx_a     = fft->getReal(3), *h_tilde_dx_b     = fft->getImag(3);
+	float *h_tilde_dz_a     = fft->getReal(4), *h_tilde_dz_b     = fft->getImag(4);
+
+	// the dispersion of every bin is a whole number of steps, so the phase for each number of steps is found by repeated rotation.
+	// done in double precision, so the error stays negligible, and recalculated from t each time, so evaluation only depends on t.
+	double stepCos = cos((double)dispersionStep * t);
+	double stepSin = sin((double)dispersionStep * t);
+	double phaseC = 1.0, phaseS = 0.0, nextC;
+	for (int steps = 0; steps <= maxDispersionSteps; steps++) {
+		phaseCos[steps] = phaseC;
+		phaseSin[steps] = phaseS;
+		nextC  = phaseC * stepCos - phaseS * stepSin;
+		phaseS = phaseC * stepSin + phaseS * stepCos;
+		phaseC = nextC;
 	}
 
-	reInitialiseWaves = false; //If we had to re-initialise, this is done in hTilde, so should now be complete for all vertexes
-
-	for (int m_prime = 0; m_prime < N; m_prime++) {
-		fft->fft(h_tilde, h_tilde, 1, m_prime * N);
-		fft->fft(h_tilde_slopex, h_tilde_slopex, 1, m_prime * N);
-		fft->fft(h_tilde_slopez, h_tilde_slopez, 1, m_prime * N);
-		fft->fft(h_tilde_dx, h_tilde_dx, 1, m_prime * N);
-		fft->fft(h_tilde_dz, h_tilde_dz, 1, m_prime * N);
+	const int bins = N * N;
+	float cos_, sin_;
+	for (index = 0; index < bins; index++) {
+		cos_ = phaseCos[binDispersionSteps[index]];
+		sin_ = phaseSin[binDispersionSteps[index]];
+		h_tilde_a[index] = h0SumA[index] * cos_ + h0DiffB[index] * sin_;
+		h_tilde_b[index] = h0SumB[index] * cos_ + h0DiffA[index] * sin_;
 	}
-	for (int n_prime = 0; n_prime < N; n_prime++) {
-		fft->fft(h_tilde, h_tilde, N, n_prime);
-		fft->fft(h_tilde_slopex, h_tilde_slopex, N, n_prime);
-		fft->fft(h_tilde_slopez, h_tilde_slopez, N, n_prime);
-		fft->fft(h_tilde_dx, h_tilde_dx, N, n_prime);
-		fft->fft(h_tilde_dz, h_tilde_dz, N, n_prime);
+
+	const float *kx = &binKx[0], *kz = &binKz[0], *kx_unit = &binKxUnit[0], *kz_unit = &binKzUnit[0];
+	for (index = 0; index < bins; index++) {
+		// h * (0, kx) and h * (0, kz)
+		h_tilde_slopex_a[index] = -kx[index] * h_tilde_b[index];
+		h_tilde_slopex_b[index] =  kx[index] * h_tilde_a[index];
+		h_tilde_slopez_a[index] = -kz[index] * h_tilde_b[index];
+		h_tilde_slopez_b[index] =  kz[index] * h_tilde_a[index];
+		// h * (0, -kx/len) and h * (0, -kz/len)
+		h_tilde_dx_a[index] =  kx_unit[index] * h_tilde_b[index];
+		h_tilde_dx_b[index] = -kx_unit[index] * h_tilde_a[index];
+		h_tilde_dz_a[index] =  kz_unit[index] * h_tilde_b[index];
+		h_tilde_dz_b[index] = -kz_unit[index] * h_tilde_a[index];
 	}
 
+	// rows then columns, for all fields together. Only the real parts of the results are used.
+	fft->transform();
+
 	int sign;
 	float signs[] = { 1.0f, -1.0f };
 	vector3 n;
 	for (int m_prime = 0; m_prime < N; m_prime++) {
 		for (int n_prime = 0; n_prime < N; n_prime++) {
-			index  = m_prime * N + n_prime;		// index into h_tilde..
+			index  = n_prime * N + m_prime;		// index into h_tilde.. (transposed by the fft)
 			index1 = m_prime * Nplus1 + n_prime;	// index into vertices
 
 			sign = signs[(n_prime + m_prime) & 1];
 
-			h_tilde[index]     = h_tilde[index] * sign;
+			h_tilde_a[index]   = h_tilde_a[index] * sign;
 
 			// height
-			vertices[index1].y = h_tilde[index].a;
+			vertices[index1].y = h_tilde_a[index];
 
 			// displacement
-			h_tilde_dx[index] = h_tilde_dx[index] * sign;
-			h_tilde_dz[index] = h_tilde_dz[index] * sign;
-			vertices[index1].x = vertices[index1].ox + h_tilde_dx[index].a * lambda;
-			vertices[index1].z = vertices[index1].oz + h_tilde_dz[index].a * lambda;
+			h_tilde_dx_a[index] = h_tilde_dx_a[index] * sign;
+			h_tilde_dz_a[index] = h_tilde_dz_a[index] * sign;
+			vertices[index1].x = vertices[index1].ox + h_tilde_dx_a[index] * lambda;
+			vertices[index1].z = vertices[index1].oz + h_tilde_dz_a[index] * lambda;
 			
 			//Checking - Bug workaround for NaNs on OSX
 			if (localisinf(vertices[index1].y) || localisnan(vertices[index1].y)) {
@@ -539,19 +464,19 @@ void cOcean::evaluateWavesFFT(float t) {
 			}
 
 			// normal
-			h_tilde_slopex[index] = h_tilde_slopex[index] * sign;
-			h_tilde_slopez[index] = h_tilde_slopez[index] * sign;
-			n = vector3(0.0f - h_tilde_slopex[index].a, 1.0f, 0.0f - h_tilde_slopez[index].a).unit();
+			h_tilde_slopex_a[index] = h_tilde_slopex_a[index] * sign;
+			h_tilde_slopez_a[index] = h_tilde_slopez_a[index] * sign;
+			n = vector3(0.0f - h_tilde_slopex_a[index], 1.0f, 0.0f - h_tilde_slopez_a[index]).unit();
 			vertices[index1].nx =  n.x;
 			vertices[index1].ny =  n.y;
 			vertices[index1].nz =  n.z;
 
 			// for tiling
 			if (n_prime == 0 && m_prime == 0) {
-				vertices[index1 + N + Nplus1 * N].y = h_tilde[index].a;
+				vertices[index1 + N + Nplus1 * N].y = h_tilde_a[index];
 
-				vertices[index1 + N + Nplus1 * N].x = vertices[index1 + N + Nplus1 * N].ox + h_tilde_dx[index].a * lambda;
-				vertices[index1 + N + Nplus1 * N].z = vertices[index1 + N + Nplus1 * N].oz + h_tilde_dz[index].a * lambda;
+				vertices[index1 + N + Nplus1 * N].x = vertices[index1 + N + Nplus1 * N].ox + h_tilde_dx_a[index] * lambda;
+				vertices[index1 + N + Nplus1 * N].z = vertices[index1 + N + Nplus1 * N].oz + h_tilde_dz_a[index] * lambda;
 
 				vertices[index1 + N + Nplus1 * N].nx =  n.x;
 				vertices[index1 + N + Nplus1 * N].ny =  n.y;
@@ -570,10 +495,10 @@ void cOcean::evaluateWavesFFT(float t) {
 
 			}
 			if (n_prime == 0) {
-				vertices[index1 + N].y = h_tilde[index].a;
+				vertices[index1 + N].y = h_tilde_a[index];
 
-				vertices[index1 + N].x = vertices[index1 + N].ox + h_tilde_dx[index].a * lambda;
-				vertices[index1 + N].z = vertices[index1 + N].oz + h_tilde_dz[index].a * lambda;
+				vertices[index1 + N].x = vertices[index1 + N].ox + h_tilde_dx_a[index] * lambda;
+				vertices[index1 + N].z = vertices[index1 + N].oz + h_tilde_dz_a[index] * lambda;
 
 				vertices[index1 + N].nx =  n.x;
 				vertices[index1 + N].ny =  n.y;
@@ -590,10 +515,10 @@ void cOcean::evaluateWavesFFT(float t) {
 				
 			}
 			if (m_prime == 0) {
-				vertices[index1 + Nplus1 * N].y = h_tilde[index].a;
+				vertices[index1 + Nplus1 * N].y = h_tilde_a[index];
 
-				vertices[index1 + Nplus1 * N].x = vertices[index1 + Nplus1 * N].ox + h_tilde_dx[index].a * lambda;
-				vertices[index1 + Nplus1 * N].z = vertices[index1 + Nplus1 * N].oz + h_tilde_dz[index].a * lambda;
+				vertices[index1 + Nplus1 * N].x = vertices[index1 + Nplus1 * N].ox + h_tilde_dx_a[index] * lambda;
+				vertices[index1 + Nplus1 * N].z = vertices[index1 + Nplus1 * N].oz + h_tilde_dz_a[index] * lambda;
 
 				vertices[index1 + Nplus1 * N].nx =  n.x;
 				vertices[index1 + Nplus1 * N].ny =  n.y;
@@ -23,6 +23,7 @@ SOFTWARE.
 */
 
 #ifndef __FFTWAVE_HPP_INCLUDED__
+#define __FFTWAVE_HPP_INCLUDED__
 /*
 #include <time.h>
 class cTimer {
@@ -40,7 +41,6 @@ class complex {
   protected:
   public:
     float a, b;
-    static unsigned int additions, multiplications;
     complex();
     complex(float a, float b);
     complex conj();
@@ -50,11 +50,14 @@ class complex {
     complex operator-() const;
     complex operator*(const float c) const;
     complex& operator=(const complex& c);
-    static void reset();
 };
 
 #include <math.h>
 
+#include "BatchedFFT.hpp"
+
+#include <vector>
+
 class vector3 {
   private:
   protected:
@@ -88,23 +91,6 @@ class vector2 {
     vector2 unit();
 };
 
-class cFFT {
-  private:
-	unsigned int N, which;
-	unsigned int *reversed;
-	complex **T;
-	float pi2;
-	unsigned int log_2_N;
-	complex *c[2];
-  protected:
-  public:
-	cFFT(unsigned int N);
-	~cFFT();
-	unsigned int reverse(unsigned int i);
-	complex t(unsigned int x, unsigned int N);
-	void fft(complex* input, complex* output, int stride, int offset);
-};
-
 struct vertex_ocean {
 	float   x,   y,   z; // vertex
 	float  nx,  ny,  nz; // normal
@@ -128,12 +114,18 @@ class cOcean {
 	vector2 w;				// wind parameter
 	float length;				// length parameter
 	vertex_ocean *vertices;			// vertices for vertex buffer object
-	bool reInitialiseWaves; // If waves should be re-created (as new A or w?)
 
-	complex *h_tilde,			// for fast fourier transform
-		*h_tilde_slopex, *h_tilde_slopez,
-		*h_tilde_dx, *h_tilde_dz;
-	cFFT *fft;				// fast fourier transform
+	BatchedFFT *fft;			// fast fourier transform of h_tilde, the two slopes and the two displacements together
+
+	// per frequency bin tables, indexed m_prime * N + n_prime
+	std::vector<float> binKx, binKz;		// wave vector
+	std::vector<float> binKxUnit, binKzUnit;	// wave vector / its length, or 0 for k = 0
+	std::vector<int> binDispersionSteps;		// dispersion, as a multiple of dispersionStep
+	std::vector<float> h0SumA, h0DiffB;		// htilde0 + htilde0mk_conj, split for h_tilde = sum * cos + diff * sin
+	std::vector<float> h0SumB, h0DiffA;
+	float dispersionStep;				// dispersion is quantised to multiples of this, so the waves repeat
+	int maxDispersionSteps;
+	std::vector<float> phaseCos, phaseSin;		// cos and sin of (steps * dispersionStep * t), for each number of steps
 
 	//unsigned int *indices;			// indicies for vertex buffer object
 	//unsigned int indices_count;		// number of indices to render
@@ -143,10 +135,11 @@ class cOcean {
 	complex gaussianRandomVariable();
 
 	//Main internal methods
+	int dispersionSteps(int n_prime, int m_prime);		// deep water, as a multiple of dispersionStep
 	float dispersion(int n_prime, int m_prime);		// deep water
 	float phillips(int n_prime, int m_prime);		// phillips spectrum
 	complex hTilde_0(int n_prime, int m_prime);
-	complex hTilde(float t, int n_prime, int m_prime);
+	void initialiseWaves();				// set h_tilde_0 for all vertices, from A and w
 	//complex_vector_normal h_D_and_n(vector2 x, float t);
 	
 	int localisinf(double x) const;
@@ -42,6 +42,9 @@ Line::Line(SimulationModel* model)
     startNodeID = 0;
     endNodeID = 0;
 
+    lineValid = false;
+    solverTerms = LineSolverTerms();
+
     this->model = model;
 }
 
@@ -304,12 +307,14 @@ void Line::setLineNominalShipMass(irr::f32 shipNominalMass)
     this->shipNominalMass=shipNominalMass;
 }
 
-void Line::update(irr::f32 deltaTime) // Calculate the force and torque acting on the ownship in the local coordinate system
+void Line::update(irr::f32 deltaTime) // Find the line's geometry and stiffness, ready for getSolverTerms(), and update its visualisation
 {
     
     // Initially assume no force and torque
     localForceVector = irr::core::vector3df(0.0, 0.0, 0.0);
     localTorqueVector = irr::core::vector3df(0.0, 0.0, 0.0);
+    lineValid = false;
+    solverTerms = LineSolverTerms();
     
     if (lineStart && lineEnd && lineStart->getParent()) {
         
@@ -340,18 +345,20 @@ void Line::update(irr::f32 deltaTime) // Calculate the force and torque acting o
         lineExtension = lineActualLength - lineNominalLength;
         irr::f32 lineExtensionChange = lineExtension - lineExtensionPrevious;
 
-        // Find force in local coordinate system (i.e. force magnitude * local unit vector)
-        irr::f32 forceMagnitude = 0;
+        solverTerms.extension = lineExtension;
+        solverTerms.breakingTension = lineBreakingTension;
+        if (deltaTime > 0) {
+            solverTerms.extensionSpeed = lineExtensionChange / deltaTime;
+        }
+
+        // Find stiffness and damping. The tension itself is found by Lines::update, solving for all lines together.
         if (lineActualLength > 0 && lineNominalLength > 0 && lineBreakingStrain > 0 && lineBreakingTension > 0) {
             // Valid line parameters
+            lineValid = true;
             
             if (lineExtension > 0) {
+                // Full line stiffness can be used, as the tension is found implicitly, so stays stable for stiff (short) lines
                 irr::f32 lineStiffness = lineBreakingTension / (lineNominalLength * lineBreakingStrain);
-                
-                // Upper limit to stiffness for stability (based on 10m length) - Todo, could be improved?
-                if (lineStiffness > (lineBreakingTension / (10 * lineBreakingStrain))) {
-                    lineStiffness = lineBreakingTension / (10 * lineBreakingStrain);
-                }
 
                 // Ramp in line stiffness for low extensions
                 irr::f32 strainProportion = lineExtension / (lineNominalLength * lineBreakingStrain); // Ratio of actual strain to breaking strain
@@ -360,53 +367,20 @@ void Line::update(irr::f32 deltaTime) // Calculate the force and torque acting o
                     lineStiffness = lineStiffness * strainProportion / 0.1;
                 }
 
-                // Calculate the stiffness based force
-                forceMagnitude = lineExtension * lineStiffness * model->getLineStiffnessFactor();;
+                solverTerms.stiffness = lineStiffness * model->getLineStiffnessFactor();
 
                 // Add damping (50% of critical) here
-                if (deltaTime > 0 && shipNominalMass > 0 && lineStiffness > 0) {
+                if (shipNominalMass > 0 && lineStiffness > 0) {
                     if ((model->getModelParameters().mode != OperatingMode::Multiplayer) || 
                         (startNodeType != 2 && endNodeType !=2)) { 
                         // Do not add damping if in multiplayer mode, and line is attached to another ship
-                        irr::f32 lineExtensionSpeed = lineExtensionChange / deltaTime;
                         irr::f32 criticalDamping = 2*sqrt(lineStiffness * shipNominalMass);
-                        forceMagnitude += lineExtensionSpeed * 0.5 * criticalDamping * model->getLineDampingFactor();
+                        solverTerms.damping = 0.5 * criticalDamping * model->getLineDampingFactor();
                     }
                 }
-
-                // Avoid force magnitude going negative with damping
-                if (forceMagnitude < 0) {
-                    forceMagnitude = 0;
-                }
-
-                // Limit tension to line breaking tension
-                if (forceMagnitude > lineBreakingTension) {
-                    forceMagnitude = lineBreakingTension;
-                }
             }
-            // Reduce line length for next time if 'heave in' is active
-            if (!keepSlack && heaveIn) {
-                irr::f32 haulInSpeed = 0;
-                if (forceMagnitude <= 0) {
-                    // 1m/s heave in speed if unloaded
-                    haulInSpeed = 1.0;
-                } else if (forceMagnitude < 0.1 * lineBreakingTension) {
-                    // linear reduction in speed up to zero speed at 10% of line breaking tension
-                    haulInSpeed = 1.0 - forceMagnitude/(0.1*lineBreakingTension);
-                }
-                
-                // Don't allow length to get shorter than 1m while hauling in
-                if (lineNominalLength > 1.0 + haulInSpeed * deltaTime) {
-                    lineNominalLength -= haulInSpeed * deltaTime;
-                }
-
-            }  
-
         }
 
-        // Debugging output
-        //std::cout << "Line tension: " << forceMagnitude << " Nominal length: " << lineNominalLength << " Actual distance: " << lineActualLength << std::endl;
-        
         // Transform positions to the own ship (start) local coordinate system
         irr::core::vector3df lineStartLocal;
         irr::core::vector3df lineEndLocal;
@@ -427,14 +401,10 @@ void Line::update(irr::f32 deltaTime) // Calculate the force and torque acting o
             worldToLocal.transformVect(lineEndLocal);
             irr::core::vector3df lineVectorUnitLocal = lineEndLocal - lineStartLocal;
             lineVectorUnitLocal.normalize();
-            localForceVector = lineVectorUnitLocal * forceMagnitude;
-            // Find torque in local coordinate system (i.e. cross product of local start position vector with local force vector)
-            localTorqueVector = lineStartLocal.crossProduct(localForceVector);
-        } else {
-            // Not connected to own ship, no force or torque
-            localForceVector = irr::core::vector3df(0.0, 0.0, 0.0);
-            localTorqueVector = irr::core::vector3df(0.0, 0.0, 0.0);
+            solverTerms.directionLocal = lineVectorUnitLocal;
+            solverTerms.attachmentLocal = lineStartLocal;
         }
+        // Otherwise not connected to own ship, so no force or torque on it, and directionLocal stays zero
 
         // Visualisation: Update 3d drawing of the line: Vey simple initially.
         if (lineVisualisation1 && lineVisualisation2) {
@@ -494,12 +464,45 @@ void Line::update(irr::f32 deltaTime) // Calculate the force and torque acting o
     }
 }
 
-irr::core::vector3df Line::getLocalForceVector() // Call after update() to retrieve result
+bool Line::getSolverTerms(LineSolverTerms& terms) const // Call after update(). Returns false if the line can't be in tension (e.g. it's slack)
+{
+    terms = solverTerms;
+    return lineValid && solverTerms.extension > 0 && solverTerms.stiffness > 0;
+}
+
+void Line::setTension(irr::f32 tension, irr::f32 deltaTime) // Calculate the force and torque acting on the ownship in the local coordinate system, from the solved tension
+{
+    // Debugging output
+    //std::cout << "Line tension: " << tension << " Nominal length: " << lineNominalLength << " Extension: " << lineExtension << std::endl;
+
+    localForceVector = solverTerms.directionLocal * tension;
+    // Find torque in local coordinate system (i.e. cross product of local start position vector with local force vector)
+    localTorqueVector = solverTerms.attachmentLocal.crossProduct(localForceVector);
+
+    // Reduce line length for next time if 'heave in' is active
+    if (lineValid && !keepSlack && heaveIn) {
+        irr::f32 haulInSpeed = 0;
+        if (tension <= 0) {
+            // 1m/s heave in speed if unloaded
+            haulInSpeed = 1.0;
+        } else if (tension < 0.1 * lineBreakingTension) {
+            // linear reduction in speed up to zero speed at 10% of line breaking tension
+            haulInSpeed = 1.0 - tension/(0.1*lineBreakingTension);
+        }
+        
+        // Don't allow length to get shorter than 1m while hauling in
+        if (lineNominalLength > 1.0 + haulInSpeed * deltaTime) {
+            lineNominalLength -= haulInSpeed * deltaTime;
+        }
+    }
+}
+
+irr::core::vector3df Line::getLocalForceVector() // Call after setTension() to retrieve result
 {
     return localForceVector;
 }
 
-irr::core::vector3df Line::getLocalTorqueVector() // Call after update() to retrieve result
+irr::core::vector3df Line::getLocalTorqueVector() // Call after setTension() to retrieve result
 {
     return localTorqueVector;
 }
@@ -23,6 +23,18 @@
 //Forward declarations
 class SimulationModel;
 
+//What's needed to find a line's tension, by solving for all lines together (see Lines::update)
+struct LineSolverTerms
+{
+    irr::f32 stiffness; // N/m, at the current extension
+    irr::f32 damping; // N/(m/s)
+    irr::f32 extension; // m
+    irr::f32 extensionSpeed; // m/s
+    irr::f32 breakingTension; // N
+    irr::core::vector3df directionLocal; // Unit vector from the own ship end towards the other end, in own ship local coordinates. Zero if not attached to own ship.
+    irr::core::vector3df attachmentLocal; // Position of the own ship end, in own ship local coordinates
+};
+
 class Line
 {
     public:
@@ -62,9 +74,11 @@ class Line
         void setLineNominalShipMass(irr::f32 shipNominalMass);
 
 
-        void update(irr::f32 deltaTime); // Calculate the force and torque acting on the ownship in the local coordinate system
-        irr::core::vector3df getLocalForceVector(); // Call after update() to retrieve result
-        irr::core::vector3df getLocalTorqueVector(); // Call after update() to retrieve result
+        void update(irr::f32 deltaTime); // Find the line's geometry and stiffness, ready for getSolverTerms(), and update its visualisation
+        bool getSolverTerms(LineSolverTerms& terms) const; // Call after update(). Returns false if the line can't be in tension (e.g. it's slack)
+        void setTension(irr::f32 tension, irr::f32 deltaTime); // Calculate the force and torque acting on the ownship in the local coordinate system, from the solved tension
+        irr::core::vector3df getLocalForceVector(); // Call after setTension() to retrieve result
+        irr::core::vector3df getLocalTorqueVector(); // Call after setTension() to retrieve result
         
     private:
         SimulationModel* model;
@@ -87,6 +101,8 @@ class Line
         int endNodeID;
         irr::core::vector3df localForceVector;
         irr::core::vector3df localTorqueVector;
+        bool lineValid; // Line has valid parameters, from the last update()
+        LineSolverTerms solverTerms; // From the last update()
         
 };
 
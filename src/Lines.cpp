@@ -540,7 +540,7 @@ void Lines::setLineNominalShipMass(int lineID, irr::f32 lineNominalShipMass, boo
     }
 }
 
-void Lines::update(irr::f32 deltaTime) {
+void Lines::update(irr::f32 deltaTime, irr::f32 shipMass, irr::f32 shipInertia) {
     for(std::vector<Line>::iterator it = lines.begin(); it != lines.end(); ++it) {
         it->update(deltaTime);
     }
@@ -548,6 +548,66 @@ void Lines::update(irr::f32 deltaTime) {
     for(std::vector<Line>::iterator it = networkLines.begin(); it != networkLines.end(); ++it) {
         it->update(deltaTime);
     }
+
+    // Find the tension in all lines together, semi-implicitly (backward Euler) against the own ship's motion.
+    // Each line's tension depends on its extension and extension speed at the end of the time step, which depend on
+    // how the own ship moves in response to the tensions in all lines. This stays stable for stiff lines and large time steps,
+    // where finding each tension from the current extension would oscillate and grow.
+    // For each line i: T_i = k_i*x_i + b_i*v_i', where b_i = k_i*dt + c_i, and v_i' = v_i - dt * sum_j(A_ij*T_j)
+    // A_ij is the rate of change of extension speed of line i per unit tension in line j, from the own ship's surge, sway and yaw.
+    // This is solved by projected Gauss-Seidel iteration, keeping each tension between zero and breaking tension.
+    const irr::u32 numberOfLines = lines.size() + networkLines.size();
+    solverTerms.resize(numberOfLines);
+    inTension.resize(numberOfLines);
+    tensions.assign(numberOfLines, 0);
+    for (irr::u32 i = 0; i < numberOfLines; i++) {
+        const Line& line = (i < lines.size()) ? lines.at(i) : networkLines.at(i - lines.size());
+        inTension.at(i) = line.getSolverTerms(solverTerms.at(i));
+    }
+
+    coupling.assign(numberOfLines * numberOfLines, 0);
+    if (shipMass > 0 && shipInertia > 0) {
+        for (irr::u32 i = 0; i < numberOfLines; i++) {
+            const LineSolverTerms& termsI = solverTerms.at(i);
+            irr::f32 leverI = termsI.attachmentLocal.crossProduct(termsI.directionLocal).Y;
+            for (irr::u32 j = 0; j < numberOfLines; j++) {
+                const LineSolverTerms& termsJ = solverTerms.at(j);
+                irr::f32 leverJ = termsJ.attachmentLocal.crossProduct(termsJ.directionLocal).Y;
+                // Own ship only moves in surge, sway and yaw
+                coupling.at(i * numberOfLines + j) = (termsI.directionLocal.X * termsJ.directionLocal.X + termsI.directionLocal.Z * termsJ.directionLocal.Z) / shipMass +
+                                                     leverI * leverJ / shipInertia;
+            }
+        }
+    }
+
+    const irr::u32 solverIterations = (numberOfLines > 1) ? 20 : 1; // A single line is solved exactly in one iteration
+    for (irr::u32 iteration = 0; iteration < solverIterations; iteration++) {
+        for (irr::u32 i = 0; i < numberOfLines; i++) {
+            if (!inTension.at(i)) {
+                continue;
+            }
+            const LineSolverTerms& terms = solverTerms.at(i);
+            irr::f32 responseDamping = terms.stiffness * deltaTime + terms.damping;
+
+            irr::f32 otherLinesEffect = 0;
+            for (irr::u32 j = 0; j < numberOfLines; j++) {
+                if (j != i) {
+                    otherLinesEffect += coupling.at(i * numberOfLines + j) * tensions.at(j);
+                }
+            }
+
+            irr::f32 tension = (terms.stiffness * terms.extension + responseDamping * (terms.extensionSpeed - deltaTime * otherLinesEffect)) /
+                               (1 + responseDamping * deltaTime * coupling.at(i * numberOfLines + i));
+
+            // Avoid tension going negative with damping, and limit to line breaking tension
+            tensions.at(i) = irr::core::clamp(tension, 0.0f, terms.breakingTension);
+        }
+    }
+
+    for (irr::u32 i = 0; i < numberOfLines; i++) {
+        Line& line = (i < lines.size()) ? lines.at(i) : networkLines.at(i - lines.size());
+        line.setTension(tensions.at(i), deltaTime);
+    }
 }
 
 irr::core::vector3df Lines::getOverallForceLocal() {
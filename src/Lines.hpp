@@ -21,9 +21,10 @@
 #include <string>
 #include <vector>
 
+#include "Line.hpp"
+
 //Forward declarations
 class SimulationModel;
-class Line;
 
 class Lines
 {
@@ -64,7 +65,7 @@ class Lines
         irr::f32 getLineNominalShipMass(int lineID, bool networkLine = false);
         void setLineNominalShipMass(int lineID, irr::f32 lineNominalShipMass, bool networkLine = false);
         
-        void update(irr::f32 deltaTime);
+        void update(irr::f32 deltaTime, irr::f32 shipMass, irr::f32 shipInertia); // Find all line tensions, using own ship's mass and inertia about the vertical axis
         irr::core::vector3df getOverallForceLocal(); // Find sum of forces on own ship in local coordinate system, call after update()
         irr::core::vector3df getOverallTorqueLocal(); // Find sum of torques on own ship in local coordinate system, call after update()
 
@@ -72,6 +73,12 @@ class Lines
         std::vector<Line> lines;
         std::vector<Line> networkLines;
         int selectedLine;
+
+        // Working storage for the line tension solution, for lines then networkLines
+        std::vector<LineSolverTerms> solverTerms;
+        std::vector<bool> inTension;
+        std::vector<irr::f32> tensions;
+        std::vector<irr::f32> coupling; // How much the tension in each line changes the extension speed of each other line, through the own ship's motion
 };
 
 #endif
\ No newline at end of file
@@ -19,7 +19,7 @@ Message::Message(SimulationModel* aModel)
 
 Message::Message()
 {
- 
+  mModel = 0;
 }
 
 Message::~Message()
@@ -657,6 +657,10 @@ eCmdMsg Message::ParseMasterCommand(std::string& aMsg, void** aCmdData)
 eCmdMsg Message::Parse(const char *aData, size_t aDataSize, void** aCmdData)
 {
   std::string inRawData(aData, aDataSize);
+
+  /*Keep a copy if the session is being recorded*/
+  if(mModel)
+    mModel->recordNetworkMessage(inRawData);
   unsigned int nbrMsg = 1;
   std::string message = inRawData;
   unsigned int idMessage = 0;
@@ -32,7 +32,7 @@ namespace scene
 {
 
 //! constructor
-MovingWaterSceneNode::MovingWaterSceneNode(ISceneNode* parent, ISceneManager* mgr, ISceneNode* ownShip, irr::s32 id, irr::u32 disableShaders, bool withReflection, irr::u32 segments,
+MovingWaterSceneNode::MovingWaterSceneNode(ISceneNode* parent, ISceneManager* mgr, ISceneNode* ownShip, irr::s32 id, irr::u32 disableShaders, bool withReflection, bool threadedWaves, irr::u32 segments,
 		const irr::core::vector3df& position, const irr::core::vector3df& rotation)
 	//: IMeshSceneNode(mesh, parent, mgr, id, position, rotation, scale),
 	: IMeshSceneNode(parent, mgr, id, position, rotation, irr::core::vector3df(1.0f,1.0f,1.0f)), lightLevel(0.7), seaState(0.5), disableShaders(disableShaders), withReflection(withReflection), segments(segments)
@@ -93,7 +93,8 @@ MovingWaterSceneNode::MovingWaterSceneNode(ISceneNode* parent, ISceneManager* mg
 	tileWidth = 100; //Width in metres - Note this is used in Simulation model normalisation as 100, so visible jumps in water are minimised
     irr::f32 segmentSize = tileWidth / segments;
 
-    ocean = new cOcean(segments, 0.00005f, vector2(32.0f,32.0f), tileWidth); //Note that the A and w parameters will get overwritten by ocean->resetParameters() dependent on the model's weather
+    oceanWorker = new OceanWorker(segments, tileWidth, threadedWaves);
+    updateWaveData(oceanWorker->getVertices());
 
 	mesh = mgr->addHillPlaneMesh( "myHill",
                            irr::core::dimension2d<irr::f32>(segmentSize,segmentSize),
@@ -103,6 +104,11 @@ MovingWaterSceneNode::MovingWaterSceneNode(ISceneNode* parent, ISceneManager* mg
                            irr::core::dimension2d<irr::f32>(0,0),
                            irr::core::dimension2d<irr::f32>(tileWidth/(irr::f32)(segments),tileWidth/(irr::f32)(segments)));
 
+    //The vertices change every frame, but the indices never do. The buffer is drawn many times per frame, so keep both on the GPU.
+    mesh->setHardwareMappingHint(irr::scene::EHM_STREAM, irr::scene::EBT_VERTEX);
+    mesh->setHardwareMappingHint(irr::scene::EHM_STATIC, irr::scene::EBT_INDEX);
+    waterTiles.load(mesh->getMeshBuffer(0), segments, tileWidth);
+
 
     flatMesh = mgr->getMesh("media/flatsea.x");
     if (!flatMesh) {
@@ -198,7 +204,7 @@ MovingWaterSceneNode::MovingWaterSceneNode(ISceneNode* parent, ISceneManager* mg
 MovingWaterSceneNode::~MovingWaterSceneNode()
 {
 	// Mesh is dropped in IMeshSceneNode destructor (??? FIXME: Probably not true!)
-    delete ocean;
+    delete oceanWorker;
 
     if (_camera)
 	{
@@ -235,10 +241,15 @@ int MovingWaterSceneNode::localisnan(double x) const
 
 void MovingWaterSceneNode::resetParameters(float A, vector2 w, float seaState)
 {
-    ocean->resetParameters(A,w);
+    oceanWorker->resetParameters(A,w);
     this->seaState = seaState;
 }
 
+void MovingWaterSceneNode::setThreadedWaves(bool threadedWaves)
+{
+    oceanWorker->setThreaded(threadedWaves);
+}
+
 void MovingWaterSceneNode::OnSetConstants(video::IMaterialRendererServices* services, irr::s32 userData)
 {
     //From Mel's cubemap demo
@@ -343,30 +354,38 @@ void MovingWaterSceneNode::OnAnimate(irr::u32 timeMs)
 
 		const irr::f32 time = timeMs / 1000.f;
 
-		//Update the FFT Calculation
-		ocean->evaluateWavesFFT(time);
-		vertex_ocean* vertices = ocean->getVertices();
+		//Update the FFT Calculation (if threaded, this was done in advance)
+		vertex_ocean* vertices = oceanWorker->update(time);
+		updateWaveData(vertices);
 
 		const irr::u32 meshBufferCount = mesh->getMeshBufferCount();
+		const irr::u32 numberOfVertices = (segments+1)*(segments+1);
 
 		for (irr::u32 b=0; b<meshBufferCount; ++b)
 		{
-			const irr::u32 vtxCnt = mesh->getMeshBuffer(b)->getVertexCount();
-
-			for (irr::u32 i=0; i<vtxCnt; ++i) {
-				mesh->getMeshBuffer(b)->getPosition(i).X = -1*vertices[i].x; //Swap sign to maintain correct rotation order of vertices: TODO: Look at basic definition of X and Z coordinate system between water and FFTWave
-				mesh->getMeshBuffer(b)->getPosition(i).Y = vertices[i].y;
-				mesh->getMeshBuffer(b)->getPosition(i).Z = vertices[i].z;
-
-				//Set normals (TODO: Disable normal calculation in FFT for speed)
-				//mesh->getMeshBuffer(b)->getNormal(i).X = -1*vertices[i].nx;
-				//mesh->getMeshBuffer(b)->getNormal(i).Y = vertices[i].ny;
-				//mesh->getMeshBuffer(b)->getNormal(i).Z = vertices[i].nz;
-            }
-            //Manually recalculate normals
-            SceneManager->getMeshManipulator()->recalculateNormals(mesh->getMeshBuffer(b));
+			scene::IMeshBuffer* mb = mesh->getMeshBuffer(b);
+			const irr::u32 vtxCnt = mb->getVertexCount();
+
+			if (mb->getVertexType() == video::EVT_STANDARD && vtxCnt == numberOfVertices) {
+				//Usual case: Write positions and the FFT's normals straight into the vertex array
+				video::S3DVertex* meshVertices = static_cast<video::S3DVertex*>(mb->getVertices());
+				for (irr::u32 i=0; i<vtxCnt; ++i) {
+					//Swap sign of X to maintain correct rotation order of vertices (as below), so the normal's X also changes sign
+					meshVertices[i].Pos.set(-1*vertices[i].x, vertices[i].y, vertices[i].z);
+					meshVertices[i].Normal.set(-1*vertices[i].nx, vertices[i].ny, vertices[i].nz);
+				}
+			} else {
+				//Otherwise, set each position in turn, and recalculate the normals
+				for (irr::u32 i=0; i<vtxCnt; ++i) {
+					mb->getPosition(i).X = -1*vertices[i].x; //Swap sign to maintain correct rotation order of vertices: TODO: Look at basic definition of X and Z coordinate system between water and FFTWave
+					mb->getPosition(i).Y = vertices[i].y;
+					mb->getPosition(i).Z = vertices[i].z;
+				}
+				SceneManager->getMeshManipulator()->recalculateNormals(mb);
+			}
         }// end for all mesh buffers
 		mesh->setDirty(scene::EBT_VERTEX);
+		waterTiles.update();
 	}
 
 	IMeshSceneNode::OnAnimate(timeMs);
@@ -451,128 +470,86 @@ void MovingWaterSceneNode::OnAnimate(irr::u32 timeMs)
 
 irr::f32 MovingWaterSceneNode::getWaveHeight(irr::f32 relPosX, irr::f32 relPosZ) const
 {
-
-    //Adjust relative position by 1/2 tile width
-
-
     //Get the wave height (not including tide height) at this position relative to the origin of the water
-    irr::f32 relPosXInternal = fmod(relPosX+tileWidth/2,tileWidth);
-    irr::f32 relPosZInternal = fmod(relPosZ+tileWidth/2,tileWidth);
-
-    //TODO: Probably not needed?
-    while (relPosXInternal < 0)
-        relPosXInternal+=tileWidth;
-    while (relPosZInternal < 0)
-        relPosZInternal+=tileWidth;
-
-    irr::f32 xIndexFloat = (irr::f32)(segments+1)*relPosXInternal/tileWidth;
-    irr::f32 zIndexFloat = (irr::f32)(segments+1)*relPosZInternal/tileWidth;
-    xIndexFloat = (segments+1) - xIndexFloat; //Sign of x is flipped when heights are applied!
-
-    //std::cout << "xIndexF:" << xIndexFloat << " zIndexF:" << zIndexFloat << " segments+1:" << segments+1 << std::endl;
-
-    //Bilinear interpolation
-    unsigned int xIndex0 = floor(xIndexFloat);
-    unsigned int zIndex0 = floor(zIndexFloat);
-    unsigned int xIndex1 = ceil(xIndexFloat);
-    unsigned int zIndex1 = ceil(zIndexFloat);
-
-    //If any indexes are equal to segments+1, set to 0 (as sea tiles)
-    if (xIndex0 == (segments+1)) {xIndex0=0;}
-    if (zIndex0 == (segments+1)) {zIndex0=0;}
-    if (xIndex1 == (segments+1)) {xIndex1=0;}
-    if (zIndex1 == (segments+1)) {zIndex1=0;}
-
-    irr::f32 interpX = xIndexFloat - xIndex0;
-    irr::f32 interpZ = zIndexFloat - zIndex0;
-
-    unsigned int index00 = (segments+1) * zIndex0 + xIndex0;
-    unsigned int index01 = (segments+1) * zIndex1 + xIndex0;
-    unsigned int index10 = (segments+1) * zIndex0 + xIndex1;
-    unsigned int index11 = (segments+1) * zIndex1 + xIndex1;
-
-    vertex_ocean* vertices = ocean->getVertices();
-
-    //Error checking here?
-    irr::f32 height00 = vertices[index00].y;
-    irr::f32 height01 = vertices[index01].y;
-    irr::f32 height10 = vertices[index10].y;
-    irr::f32 height11 = vertices[index11].y;
-
-
-    irr::f32 localHeight = height00*(1-interpX)*(1-interpZ) + height10*interpX*(1-interpZ) + height01*(1-interpX)*interpZ + height11*interpX*interpZ;
-
-    if (localisnan(localHeight) || localisinf(localHeight)) {
-        return 0;
-    } else {
-        return localHeight;
-    }
-
+    irr::f32 localHeight;
+    getWaveData(&relPosX, &relPosZ, &localHeight, 0, 0, 1);
+    return localHeight;
 }
 
 irr::core::vector2df MovingWaterSceneNode::getLocalNormals(irr::f32 relPosX, irr::f32 relPosZ) const
 {
-
-    //Adjust relative position by 1/2 tile width
-
     //Get the wave normal
-    irr::f32 relPosXInternal = fmod(relPosX+tileWidth/2,tileWidth);
-    irr::f32 relPosZInternal = fmod(relPosZ+tileWidth/2,tileWidth);
-
-    //TODO: Probably not needed?
-    while (relPosXInternal < 0)
-        relPosXInternal+=tileWidth;
-    while (relPosZInternal < 0)
-        relPosZInternal+=tileWidth;
-
-    irr::f32 xIndexFloat = (irr::f32)(segments+1)*relPosXInternal/tileWidth;
-    irr::f32 zIndexFloat = (irr::f32)(segments+1)*relPosZInternal/tileWidth;
-    xIndexFloat = (segments+1) - xIndexFloat; //Sign of x is flipped when heights are applied!
-
-    //std::cout << "xIndexF:" << xIndexFloat << " zIndexF:" << zIndexFloat << " segments+1:" << segments+1 << std::endl;
-
-    //Bilinear interpolation
-    unsigned int xIndex0 = floor(xIndexFloat);
-    unsigned int zIndex0 = floor(zIndexFloat);
-    unsigned int xIndex1 = ceil(xIndexFloat);
-    unsigned int zIndex1 = ceil(zIndexFloat);
-
-    //If any indexes are equal to segments+1, set to 0 (as sea tiles)
-    if (xIndex0 == (segments+1)) {xIndex0=0;}
-    if (zIndex0 == (segments+1)) {zIndex0=0;}
-    if (xIndex1 == (segments+1)) {xIndex1=0;}
-    if (zIndex1 == (segments+1)) {zIndex1=0;}
-
-    irr::f32 interpX = xIndexFloat - xIndex0;
-    irr::f32 interpZ = zIndexFloat - zIndex0;
-
-    unsigned int index00 = (segments+1) * zIndex0 + xIndex0;
-    unsigned int index01 = (segments+1) * zIndex1 + xIndex0;
-    unsigned int index10 = (segments+1) * zIndex0 + xIndex1;
-    unsigned int index11 = (segments+1) * zIndex1 + xIndex1;
-
-    vertex_ocean* vertices = ocean->getVertices();
-
-    //Error checking here?
-    irr::f32 nx00 = vertices[index00].nx;
-    irr::f32 nx01 = vertices[index01].nx;
-    irr::f32 nx10 = vertices[index10].nx;
-    irr::f32 nx11 = vertices[index11].nx;
-
-    irr::f32 nz00 = vertices[index00].nz;
-    irr::f32 nz01 = vertices[index01].nz;
-    irr::f32 nz10 = vertices[index10].nz;
-    irr::f32 nz11 = vertices[index11].nz;
-
-    irr::f32 localNx = nx00*(1-interpX)*(1-interpZ) + nx10*interpX*(1-interpZ) + nx01*(1-interpX)*interpZ + nx11*interpX*interpZ;
-    irr::f32 localNz = nz00*(1-interpX)*(1-interpZ) + nz10*interpX*(1-interpZ) + nz01*(1-interpX)*interpZ + nz11*interpX*interpZ;
-
-    if (localisnan(localNx) || localisinf(localNx) || localisnan(localNz) || localisinf(localNz)) {
-        return irr::core::vector2df(0,0);
-    } else {
-        return irr::core::vector2df(localNx,localNz);
+    irr::f32 localNx;
+    irr::f32 localNz;
+    getWaveData(&relPosX, &relPosZ, 0, &localNx, &localNz, 1);
+    return irr::core::vector2df(localNx,localNz);
+}
+
+void MovingWaterSceneNode::getWaveData(const irr::f32* relPosXs, const irr::f32* relPosZs, irr::f32* heights, irr::f32* normalXs, irr::f32* normalZs, irr::u32 n) const
+{
+    //Bilinear interpolation in the copy of the FFT grid, which repeats every tileWidth
+    const irr::u32 gridPoints = segments + 1; //Grid points along each side of the tile
+    const irr::u32 rowLength = segments + 2; //Including the repeated column
+    const irr::f32 pointsPerMetre = (irr::f32)gridPoints / tileWidth;
+
+    for (irr::u32 i = 0; i < n; i++) {
+        //Adjust relative position by 1/2 tile width, and find position within the tile
+        irr::f32 relPosXInternal = relPosXs[i] + tileWidth/2;
+        irr::f32 relPosZInternal = relPosZs[i] + tileWidth/2;
+        relPosXInternal -= tileWidth * floor(relPosXInternal / tileWidth);
+        relPosZInternal -= tileWidth * floor(relPosZInternal / tileWidth);
+
+        irr::f32 xIndexFloat = gridPoints - pointsPerMetre * relPosXInternal; //Sign of x is flipped when heights are applied!
+        irr::f32 zIndexFloat = pointsPerMetre * relPosZInternal;
+        irr::f32 xIndexFloor = floor(xIndexFloat);
+        irr::f32 zIndexFloor = floor(zIndexFloat);
+        irr::f32 interpX = xIndexFloat - xIndexFloor;
+        irr::f32 interpZ = zIndexFloat - zIndexFloor;
+
+        //Index of gridPoints is the same as 0 (as sea tiles)
+        irr::u32 xIndex0 = (irr::u32)xIndexFloor % gridPoints;
+        irr::u32 zIndex0 = (irr::u32)zIndexFloor % gridPoints;
+        irr::u32 index00 = rowLength * zIndex0 + xIndex0;
+        irr::u32 index10 = index00 + 1;
+        irr::u32 index01 = index00 + rowLength;
+        irr::u32 index11 = index01 + 1;
+
+        irr::f32 weight00 = (1-interpX)*(1-interpZ);
+        irr::f32 weight10 = interpX*(1-interpZ);
+        irr::f32 weight01 = (1-interpX)*interpZ;
+        irr::f32 weight11 = interpX*interpZ;
+
+        if (heights) {
+            heights[i] = waveHeights[index00]*weight00 + waveHeights[index10]*weight10 + waveHeights[index01]*weight01 + waveHeights[index11]*weight11;
+        }
+        if (normalXs) {
+            normalXs[i] = waveNormalXs[index00]*weight00 + waveNormalXs[index10]*weight10 + waveNormalXs[index01]*weight01 + waveNormalXs[index11]*weight11;
+        }
+        if (normalZs) {
+            normalZs[i] = waveNormalZs[index00]*weight00 + waveNormalZs[index10]*weight10 + waveNormalZs[index01]*weight01 + waveNormalZs[index11]*weight11;
+        }
     }
+}
 
+void MovingWaterSceneNode::updateWaveData(const vertex_ocean* vertices)
+{
+    //Copy the heights and normals from the FFT vertices being shown, once per evaluation, into flat arrays with the first row and column repeated.
+    //Invalid values are set to 0 here, so they don't need checking on each query.
+    const irr::u32 gridPoints = segments + 1;
+    const irr::u32 rowLength = segments + 2;
+    waveHeights.resize(rowLength * rowLength);
+    waveNormalXs.resize(rowLength * rowLength);
+    waveNormalZs.resize(rowLength * rowLength);
+
+    for (irr::u32 z = 0; z < rowLength; z++) {
+        for (irr::u32 x = 0; x < rowLength; x++) {
+            const vertex_ocean& vertex = vertices[gridPoints * (z % gridPoints) + (x % gridPoints)];
+            irr::u32 index = rowLength * z + x;
+            waveHeights[index] = (localisnan(vertex.y) || localisinf(vertex.y)) ? 0 : vertex.y;
+            waveNormalXs[index] = (localisnan(vertex.nx) || localisinf(vertex.nx)) ? 0 : vertex.nx;
+            waveNormalZs[index] = (localisnan(vertex.nz) || localisinf(vertex.nz)) ? 0 : vertex.nz;
+        }
+    }
 }
 
 void MovingWaterSceneNode::setMesh(IMesh* mesh)
@@ -594,7 +571,14 @@ void MovingWaterSceneNode::render()
 	//driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
 
 	//Draw main water
-	for (irr::u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+	if (waterTiles.isLoaded()) {
+		//Only the tiles in view of this pass's camera, with less detail further away
+		driver->setMaterial(mesh->getMeshBuffer(0)->getMaterial());
+		waterTiles.render(driver, SceneManager->getActiveCamera(), AbsoluteTransformation);
+	}
+
+	//Otherwise draw every copy at full detail
+	for (irr::u32 i=0; !waterTiles.isLoaded() && i<mesh->getMeshBufferCount(); ++i)
     {
         scene::IMeshBuffer* mb = mesh->getMeshBuffer(i);
         if (mb)
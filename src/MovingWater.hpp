@@ -25,6 +25,10 @@
 #include "irrlicht.h"
 
 #include "FFTWave.hpp"
+#include "OceanWorker.hpp"
+#include "WaterTileScheduler.hpp"
+
+#include <vector>
 
 namespace irr
 {
@@ -39,6 +43,7 @@ namespace scene
 		MovingWaterSceneNode(ISceneNode* parent, ISceneManager* mgr, ISceneNode* ownShip,	s32 id,
 			irr::u32 disableShaders,
 			bool withReflection,
+			bool threadedWaves,
 			irr::u32 segments = 32,
 			const core::vector3df& position = core::vector3df(0,0,0),
 			const core::vector3df& rotation = core::vector3df(0,0,0)
@@ -77,9 +82,12 @@ namespace scene
 
 		//void setVerticalScale(f32 scale);
 		void resetParameters(float A, vector2 w, float seaState);
+		void setThreadedWaves(bool threadedWaves); //If false, the waves are evaluated for exactly the time of each frame, so the physics doesn't depend on thread timing
 
 		f32 getWaveHeight(f32 relPosX, f32 relPosZ) const;
 		irr::core::vector2df getLocalNormals(irr::f32 relPosX, irr::f32 relPosZ) const;
+		//Wave height and normals at n points in one call. Any of heights, normalXs and normalZs can be 0 if not needed.
+		void getWaveData(const irr::f32* relPosXs, const irr::f32* relPosZs, irr::f32* heights, irr::f32* normalXs, irr::f32* normalZs, irr::u32 n) const;
 
 
 	private:
@@ -111,10 +119,18 @@ namespace scene
 		//f32 scaleFactorVertical;
 		IMesh* mesh;
 		IMesh* flatMesh;
-		cOcean* ocean;
+		WaterTileScheduler waterTiles; //Draws the copies of mesh
+		OceanWorker* oceanWorker;
 
 		ISceneNode* ownShipSceneNode;
 
+		//Copy of the wave heights and normals from the latest FFT evaluation, for getWaveData().
+		//Indexed [(segments+2)*z + x], with an extra row and column repeating the first, so interpolation doesn't need to wrap.
+		std::vector<irr::f32> waveHeights;
+		std::vector<irr::f32> waveNormalXs;
+		std::vector<irr::f32> waveNormalZs;
+		void updateWaveData(const vertex_ocean* vertices);
+
 		core::aabbox3d<f32> boundingBox;
 
 		int localisnan(double x) const;
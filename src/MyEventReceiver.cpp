@@ -1103,6 +1103,14 @@ bool MyEventReceiver::OnEvent(const irr::SEvent &event)
                     model->releaseManOverboard();
                     break;
 
+                // Jump back or forward a minute, when replaying a recorded session
+                case irr::KEY_PRIOR:
+                    model->seekSession(-60);
+                    break;
+                case irr::KEY_NEXT:
+                    model->seekSession(60);
+                    break;
+
                 // Keyboard control of engines
                 case irr::KEY_KEY_A:
                     // DEE_NOV22 vvvv
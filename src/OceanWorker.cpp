@@ -0,0 +1,187 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "OceanWorker.hpp"
+
+#include <algorithm>
+
+//Don't predict more than this far ahead (s), e.g. after a pause between frames
+const irr::f32 OCEAN_MAX_PREDICTION = 0.5;
+
+OceanWorker::OceanWorker(irr::u32 segments, irr::f32 tileWidth, bool threaded)
+{
+    A = 0.00005f;
+    w = vector2(32.0f,32.0f);
+    ocean = new cOcean(segments, A, w, tileWidth); //Note that the A and w parameters will get overwritten by resetParameters() dependent on the model's weather
+
+    this->threaded = threaded;
+    lastTime = 0;
+    firstUpdate = true;
+
+    workerStop = false;
+    requestReady = false;
+    requestedTime = 0;
+    resultReady = false;
+
+    numberOfVertices = (segments+1)*(segments+1);
+
+    if (threaded) {
+        startWorker();
+    }
+}
+
+OceanWorker::~OceanWorker()
+{
+    stopWorker();
+    delete ocean;
+}
+
+void OceanWorker::setThreaded(bool threaded)
+{
+    if (this->threaded == threaded) {
+        return;
+    }
+    if (threaded) {
+        startWorker();
+    } else {
+        //Once stopped, the worker isn't using ocean, so update() can evaluate directly
+        stopWorker();
+    }
+    this->threaded = threaded;
+}
+
+void OceanWorker::resetParameters(irr::f32 A, vector2 w)
+{
+    //Called every frame, so only wait for the worker if the parameters have changed
+    if (this->A == A && this->w.x == w.x && this->w.y == w.y) {
+        return;
+    }
+    this->A = A;
+    this->w = w;
+
+    std::lock_guard<std::mutex> lock(oceanMutex);
+    ocean->resetParameters(A, w);
+}
+
+vertex_ocean* OceanWorker::update(irr::f32 time)
+{
+    if (!threaded) {
+        ocean->evaluateWavesFFT(time);
+        return ocean->getVertices();
+    }
+
+    //Predict the next frame's time from the interval since the last one
+    irr::f32 nextTime = time;
+    if (!firstUpdate && time > lastTime && time - lastTime < OCEAN_MAX_PREDICTION) {
+        nextTime = time + (time - lastTime);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(workerMutex);
+
+        if (firstUpdate) {
+            //Nothing has been evaluated in advance yet, so wait for this frame's waves
+            requestedTime = time;
+            requestReady = true;
+            workerCondition.notify_all();
+            while (!resultReady) {
+                workerCondition.wait(lock);
+            }
+        }
+
+        //Show the latest completed evaluation. If the worker hasn't finished, keep showing the previous one.
+        if (resultReady) {
+            std::swap(frontVertices, publishedVertices);
+            resultReady = false;
+        }
+
+        requestedTime = nextTime;
+        requestReady = true;
+    }
+    workerCondition.notify_all();
+
+    lastTime = time;
+    firstUpdate = false;
+    return &frontVertices[0];
+}
+
+vertex_ocean* OceanWorker::getVertices()
+{
+    if (!threaded) {
+        return ocean->getVertices();
+    }
+    return &frontVertices[0];
+}
+
+void OceanWorker::oceanWorker()
+{
+    //Ocean worker thread: Evaluate the waves for the latest requested time, and publish them for update() to swap in
+    while (true) {
+        irr::f32 time;
+        {
+            //Wait for a request
+            std::unique_lock<std::mutex> lock(workerMutex);
+            while (!requestReady && !workerStop) {
+                workerCondition.wait(lock);
+            }
+            if (workerStop) {
+                return;
+            }
+            time = requestedTime;
+            requestReady = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(oceanMutex);
+            ocean->evaluateWavesFFT(time);
+            std::copy(ocean->getVertices(), ocean->getVertices() + backVertices.size(), backVertices.begin());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            std::swap(backVertices, publishedVertices);
+            resultReady = true;
+        }
+        workerCondition.notify_all();
+    }
+}
+
+void OceanWorker::startWorker()
+{
+    //All buffers start with the current waves, and nothing is evaluated in advance yet
+    frontVertices.assign(ocean->getVertices(), ocean->getVertices() + numberOfVertices);
+    publishedVertices = frontVertices;
+    backVertices = frontVertices;
+
+    firstUpdate = true;
+    workerStop = false;
+    requestReady = false;
+    resultReady = false;
+    workerThread = std::thread(&OceanWorker::oceanWorker, this);
+}
+
+void OceanWorker::stopWorker()
+{
+    //Stop the worker thread, if running
+    if (workerThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            workerStop = true;
+        }
+        workerCondition.notify_all();
+        workerThread.join();
+    }
+}
@@ -0,0 +1,73 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __OCEANWORKER_HPP_INCLUDED__
+#define __OCEANWORKER_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include "FFTWave.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Runs the FFT wave evaluation for the water.
+//If threaded, the waves for the predicted time of the next frame are evaluated on a worker thread while the current frame is drawn, into a back buffer.
+//Each call to update() then swaps in the latest completed buffer, so the render thread doesn't wait for the FFT (except on the first frame).
+//Otherwise, the waves are evaluated in update() as they are needed.
+class OceanWorker
+{
+    public:
+        OceanWorker(irr::u32 segments, irr::f32 tileWidth, bool threaded);
+        ~OceanWorker();
+        void resetParameters(irr::f32 A, vector2 w);
+        //Start or stop the worker thread. When not threaded, the waves returned by update() are for exactly the time given.
+        void setThreaded(bool threaded);
+        //Get the vertices to show at this time, and if threaded, start evaluating those for the next frame. (segments+1)^2 vertices, valid until the next call.
+        vertex_ocean* update(irr::f32 time);
+        vertex_ocean* getVertices(); //As returned by the last call to update()
+
+    private:
+        cOcean* ocean;
+        bool threaded;
+        irr::f32 A; //Parameters last set, to check for changes without waiting for the worker
+        vector2 w;
+        irr::u32 numberOfVertices;
+        irr::f32 lastTime;
+        bool firstUpdate;
+
+        //Only used if threaded
+        std::vector<vertex_ocean> frontVertices; //Being shown
+        std::vector<vertex_ocean> publishedVertices; //Latest completed by the worker, protected by workerMutex
+        std::vector<vertex_ocean> backVertices; //Being filled by the worker
+
+        std::thread workerThread;
+        std::mutex workerMutex; //Protects the request and result flags, and publishedVertices
+        std::mutex oceanMutex; //Held by the worker while using ocean
+        std::condition_variable workerCondition;
+        bool workerStop;
+        bool requestReady;
+        irr::f32 requestedTime;
+        bool resultReady;
+
+        void startWorker();
+        void stopWorker();
+        void oceanWorker();
+};
+
+#endif // __OCEANWORKER_HPP_INCLUDED__
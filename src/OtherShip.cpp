@@ -17,7 +17,6 @@
 //Extends from the general 'Ship' class
 #include "IniFile.hpp"
 #include "Angles.hpp"
-#include "RadarData.hpp"
 #include "Constants.hpp"
 #include "OtherShip.hpp"
 #include "Utilities.hpp"
@@ -27,16 +26,26 @@
 
 //using namespace irr;
 
-OtherShip::OtherShip (const std::string& name, const std::string& internalName, const irr::u32& mmsi, const irr::core::vector3df& location, std::vector<Leg> legsLoaded, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev)
+OtherShip::OtherShip (const std::string& name, const std::string& internalName, const irr::u32& mmsi, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev)
 {
 
-    //Initialise speed and heading, normally updated from leg information
+    //Initialise speed and heading, set from OtherShipFleet in update()
     spd = 0;
     hdg = 0;
-    rateOfTurn = 0; // Not normally used, but used to smooth behaviour in multiplayer
+    xPos = 0;
+    yPos = 0;
+    zPos = 0;
 
     this->name = name;
+    this->internalName = internalName;
     this->mmsi = mmsi;
+    this->smgr = smgr;
+
+    //Scene node is created later, when needed
+    ship = 0;
+    selector = 0;
+    triangleSelectorEnabled = false;
+    visible = false;
 
     std::string basePath = "Models/Othership/" + name + "/";
     std::string userFolder = Utilities::getUserDir();
@@ -61,7 +70,7 @@ OtherShip::OtherShip (const std::string& name, const std::string& internalName,
     std::string shipFileName = IniFile::iniFileToString(iniFilename,"FileName");
 
     //get scale factor from ini file (or zero if not set - assume 1)
-    irr::f32 scaleFactor = IniFile::iniFileTof32(iniFilename,"Scalefactor", 1.f);
+    scaleFactor = IniFile::iniFileTof32(iniFilename,"Scalefactor", 1.f);
 
     irr::f32 yCorrection = IniFile::iniFileTof32(iniFilename,"YCorrection");
     angleCorrection = IniFile::iniFileTof32(iniFilename,"AngleCorrection");
@@ -74,33 +83,30 @@ OtherShip::OtherShip (const std::string& name, const std::string& internalName,
     std::string shipFullPath = basePath + shipFileName;
 
     //load mesh
-    irr::scene::IAnimatedMesh* shipMesh = smgr->getMesh(shipFullPath.c_str());
+    shipMesh = smgr->getMesh(shipFullPath.c_str());
 
     //Set mesh vertical correction (world units)
     heightCorrection = yCorrection*scaleFactor;
 
-    //add to scene node
 	if (shipMesh==0) {
         //Failed to load mesh - load with dummy and continue
         dev->getLogger()->log("Failed to load other ship model:");
         dev->getLogger()->log(shipFullPath.c_str());
         shipMesh = smgr->addSphereMesh("Dummy");
     }
-    ship = smgr->addAnimatedMeshSceneNode( shipMesh, 0, -1);
-    ship->setScale(irr::core::vector3df(scaleFactor,scaleFactor,scaleFactor));
-    ship->setPosition(irr::core::vector3df(0,heightCorrection,0));
-
-	ship->setMaterialFlag(irr::video::EMF_FOG_ENABLE, true);
-	ship->setMaterialFlag(irr::video::EMF_NORMALIZE_NORMALS, true); //Normalise normals on scaled meshes, for correct lighting
 
     //store length and RCS information for radar etc
-    ship->updateAbsolutePosition();
-    length = ship->getTransformedBoundingBox().getExtent().Z;
-    breadth = ship->getTransformedBoundingBox().getExtent().X;
-    height = ship->getTransformedBoundingBox().getExtent().Y * 0.75; //Assume 3/4 of the mesh is above water
-    draught = -1 * ship->getTransformedBoundingBox().MinEdge.Y;
-    airDraught = ship->getTransformedBoundingBox().MaxEdge.Y;
-    
+    //Use the mesh's bounding box as it would be transformed by the scene node (scaled, and moved up by heightCorrection), as the node may not exist yet
+    irr::core::aabbox3df boundingBox = shipMesh->getBoundingBox();
+    boundingBox.MinEdge = boundingBox.MinEdge*scaleFactor + irr::core::vector3df(0,heightCorrection,0);
+    boundingBox.MaxEdge = boundingBox.MaxEdge*scaleFactor + irr::core::vector3df(0,heightCorrection,0);
+    boundingBox.repair();
+    length = boundingBox.getExtent().Z;
+    breadth = boundingBox.getExtent().X;
+    height = boundingBox.getExtent().Y * 0.75; //Assume 3/4 of the mesh is above water
+    draught = -1 * boundingBox.MinEdge.Y;
+    airDraught = boundingBox.MaxEdge.Y;
+
     rcs = 0.005*std::pow(length,3); //Default RCS, base radar cross section on length^3 (following RCS table Ship_RCS_table.pdf)
     std::string logMessage = "Loading '";
     logMessage.append(shipFullPath);
@@ -108,36 +114,10 @@ OtherShip::OtherShip (const std::string& name, const std::string& internalName,
     logMessage.append(std::to_string(length));
     dev->getLogger()->log(logMessage.c_str());
 
-    //Add triangle selector and make pickable
-    ship->setID(IDFlag_IsPickable);
-    selector=smgr->createTriangleSelector(shipMesh,ship);
-    //This is applied depending on distance to own ship, for speed
-    triangleSelectorEnabled=false;
-    
-    ship->setName(internalName.c_str());
-
     // Todo: Note in documentation that to avoid blocking, use a value of 0.1, as 0 will go to default
     //FIXME: Note in documentation that this is height above waterline in model units
     solidHeight = scaleFactor * IniFile::iniFileTof32(iniFilename,"SolidHeight", .5f * height);
 
-    //store initial x,y,z positions
-    xPos = location.X;
-    yPos = location.Y;
-    zPos = location.Z;
-    //speed and heading will come from leg data
-
-    //Set lighting to use diffuse and ambient, so lighting of untextured models works
-	if(ship->getMaterialCount()>0) {
-        for(irr::u32 mat=0;mat<ship->getMaterialCount();mat++) {
-            if (ship->getMaterial(mat).AmbientColor.getAlpha() != 255 || 
-                ship->getMaterial(mat).DiffuseColor.getAlpha() != 255) {
-                // Only allow rendering with transparency if required to avoid Z order problems
-                ship->getMaterial(mat).MaterialType = irr::video::EMT_TRANSPARENT_VERTEX_ALPHA;
-            }
-            ship->getMaterial(mat).ColorMaterial = irr::video::ECM_DIFFUSE_AND_AMBIENT;
-        }
-    }
-
     //get light locations:
     irr::u32 numberOfLights = IniFile::iniFileTou32(iniFilename,"NumberOfLights");
     if (numberOfLights>0) {
@@ -162,13 +142,16 @@ OtherShip::OtherShip (const std::string& name, const std::string& internalName,
             lightZ *= scaleFactor;
             */ //Whole entity scaled, so not needed
 
-            //add this Nav light into array
-            navLights.push_back(new NavLight (ship,smgr,irr::core::vector3df(lightX,lightY,lightZ),irr::video::SColor(255,lightR,lightG,lightB),lightStartAngle,lightEndAngle,lightRange));
+            //store, to add this Nav light when the scene node is created
+            LightDefinition lightDefinition;
+            lightDefinition.position = irr::core::vector3df(lightX,lightY,lightZ);
+            lightDefinition.colour = irr::video::SColor(255,lightR,lightG,lightB);
+            lightDefinition.startAngle = lightStartAngle;
+            lightDefinition.endAngle = lightEndAngle;
+            lightDefinition.range = lightRange;
+            lightDefinitions.push_back(lightDefinition);
         }
     }
-
-    //store leg information
-    legs=legsLoaded;
 }
 
 OtherShip::~OtherShip()
@@ -180,274 +163,120 @@ OtherShip::~OtherShip()
     navLights.clear();
 }
 
-void OtherShip::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel)
+bool OtherShip::hasSceneNode() const
 {
+    return ship != 0;
+}
 
-    //move according to leg information
-    if (legs.empty()) {
-        //Don't change speed and hdg - may be in secondary mode, where these are set externally
-        //Except, use rateOfTurn to update hdg
-        hdg += deltaTime * rateOfTurn; // rateOfTurn in deg/s
-    } else {
-        //Work out which leg we're on
-        std::vector<Leg>::size_type currentLeg = findCurrentLeg(scenarioTime);
-
-        spd = legs[currentLeg].speed*KTS_TO_MPS;
-        hdg = legs[currentLeg].bearing;
-    }
-
-    if (!positionManuallyUpdated) { //If the position has already been updated, skip (for this loop only)
-        xPos = xPos + sin(hdg*irr::core::DEGTORAD)*spd*deltaTime;
-        zPos = zPos + cos(hdg*irr::core::DEGTORAD)*spd*deltaTime;
-    } else {
-        positionManuallyUpdated = false;
+void OtherShip::createSceneNode()
+{
+    if (ship) {
+        return;
     }
-    yPos = tideHeight+heightCorrection;
 
-    //Set position & speed by calling ship methods
-    //setPosition(irr::core::vector3df(xPos,yPos,zPos));
+    //add to scene node
+    ship = smgr->addAnimatedMeshSceneNode( shipMesh, 0, -1);
+    ship->setScale(irr::core::vector3df(scaleFactor,scaleFactor,scaleFactor));
     ship->setPosition(irr::core::vector3df(xPos,yPos,zPos));
-    // DEE_DEC22 vvvv allows modelling of trim , list and models derived from other coordinate systems
-    //ship->setRotation(irr::core::vector3df(angleCorrectionPitch, hdg+angleCorrection, angleCorrectionRoll)); //Global vectors
-    ship->setRotation(irr::core::vector3df(angleCorrectionPitch, hdg+angleCorrection, angleCorrectionRoll)); //Global vectors
-    // DEE_DEC22 ^^^^
+    ship->setRotation(irr::core::vector3df(angleCorrectionPitch, hdg+angleCorrection, angleCorrectionRoll));
 
-    //for each light, find range and angle
-    for(std::vector<NavLight*>::size_type currentLight = 0; currentLight<navLights.size(); currentLight++) {
-        navLights[currentLight]->update(scenarioTime, lightLevel);
-    }
+	ship->setMaterialFlag(irr::video::EMF_FOG_ENABLE, true);
+	ship->setMaterialFlag(irr::video::EMF_NORMALIZE_NORMALS, true); //Normalise normals on scaled meshes, for correct lighting
 
-}
+    //Add triangle selector and make pickable
+    ship->setID(IDFlag_IsPickable);
+    selector=smgr->createTriangleSelector(shipMesh,ship);
+    //This is applied depending on distance to own ship, for speed
+    triangleSelectorEnabled=false;
 
-irr::f32 OtherShip::getHeight() const
-{
-    return height;
-}
+    ship->setName(internalName.c_str());
 
-irr::f32 OtherShip::getRCS() const
-{
-    return rcs;
-}
+    //Set lighting to use diffuse and ambient, so lighting of untextured models works
+	if(ship->getMaterialCount()>0) {
+        for(irr::u32 mat=0;mat<ship->getMaterialCount();mat++) {
+            if (ship->getMaterial(mat).AmbientColor.getAlpha() != 255 ||
+                ship->getMaterial(mat).DiffuseColor.getAlpha() != 255) {
+                // Only allow rendering with transparency if required to avoid Z order problems
+                ship->getMaterial(mat).MaterialType = irr::video::EMT_TRANSPARENT_VERTEX_ALPHA;
+            }
+            ship->getMaterial(mat).ColorMaterial = irr::video::ECM_DIFFUSE_AND_AMBIENT;
+        }
+    }
 
-std::string OtherShip::getName() const
-{
-    return name;
-}
+    //add the Nav lights
+    for (std::vector<LightDefinition>::size_type currentLight = 0; currentLight < lightDefinitions.size(); currentLight++) {
+        const LightDefinition& lightDefinition = lightDefinitions.at(currentLight);
+        navLights.push_back(new NavLight (ship,smgr,lightDefinition.position,lightDefinition.colour,lightDefinition.startAngle,lightDefinition.endAngle,lightDefinition.range));
+    }
 
-std::vector<Leg> OtherShip::getLegs() const
-{
-    return legs;
+    visible = true;
 }
 
-void OtherShip::changeLeg(int legNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime)
+void OtherShip::setVisible(bool visible)
 {
+    if (!ship || visible == this->visible) {
+        return;
+    }
 
-    //Check if leg exists, then if we are allowed to change this leg (current or future leg), and not the final 'stop' leg (hence legs.size()-1)
-    if (legNumber >=0 && legNumber < ((int)legs.size() - 1) && legNumber >= (int)findCurrentLeg(scenarioTime)) {
-
-        //Store old information temporarily
-        irr::f32 oldSpeed = legs.at(legNumber).speed;
-
-        //Recalculate subsequent start times, only changing from the current point.
-        //We can guarantee that there is a next leg, as we checked (legNumber < legs.size() - 1)
-
-        irr::f32 newTimeRemaining;
-        if ( legNumber == (int)findCurrentLeg(scenarioTime) ) {
-            //On current leg - calculate from current point only
-            irr::f32 oldTimeRemaining = legs.at(legNumber+1).startTime - scenarioTime;
-            if (distance < 0) {distance = fabs(oldSpeed)*oldTimeRemaining/SECONDS_IN_HOUR;} //If leg length is negative, ensure overall leg length doesn't change
-            newTimeRemaining = SECONDS_IN_HOUR * distance / fabs(speed); //The adjusted leg distance starts from now
-            legs.at(legNumber).startTime = scenarioTime; // New leg effectively starts now
-        } else {
-            //On subsequent leg - calculate for whole leg
-            irr::f32 oldTimeRemaining = legs.at(legNumber+1).startTime - legs.at(legNumber).startTime;
-            if (distance < 0) {distance = fabs(oldSpeed)*oldTimeRemaining/SECONDS_IN_HOUR;} //If leg length is negative, ensure overall leg length doesn't change
-            newTimeRemaining = SECONDS_IN_HOUR * distance / fabs(speed);
-            //No need to change start time.
-        }
-
-        //Change this leg
-        legs.at(legNumber).bearing = bearing;
-        legs.at(legNumber).speed = speed;
-        legs.at(legNumber).distance = distance; //Store for later reference
-
-        //Set start time of the next leg (guaranteed to exist)
-        legs.at(legNumber + 1).startTime = legs.at(legNumber).startTime + newTimeRemaining;
-        //For the remaining legs (which may not exist)
-        for (int i = legNumber + 2; i < (int)legs.size(); i++) {
-            legs.at(i).startTime = legs.at(i-1).startTime + SECONDS_IN_HOUR*legs.at(i-1).distance/legs.at(i-1).speed;
-        }
-
-    } //Check leg exists & can be changed
-
+    ship->setVisible(visible);
+    this->visible = visible;
 }
 
-void OtherShip::addLeg(int afterLegNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime)
+bool OtherShip::isVisible() const
 {
-
-    //Check if leg is reasonable, and is before the 'stop leg'
-    //A special case allows afterLegNumber to equal -1, for when only a single 'stop leg' exists
-    if (afterLegNumber >= -1 && afterLegNumber < ((int)legs.size() - 1)) {
-
-        //if we're on the stop leg
-        if (findCurrentLeg(scenarioTime) == (legs.size()-1)) {
-
-            //If the 'after' leg is the penultimate, add a leg before the stop one, starting now
-            if (afterLegNumber == ((int)legs.size()-2))  { //This also catches the special case where there is only the 'stop' leg, so the 'afterLegNumber value is -1
-
-                Leg newLeg;
-                newLeg.bearing = bearing;
-                newLeg.speed = speed;
-                newLeg.distance = distance;
-                newLeg.startTime = scenarioTime;
-
-                legs.insert(legs.end()-1, newLeg); //Insert before final leg
-            }
-        //else check that the 'after' leg is current or future
-        } else if (afterLegNumber >=0 && afterLegNumber >= (int)findCurrentLeg(scenarioTime)) { //First check only required in case findCurrentLeg does not return a valid result (>=0)
-            Leg newLeg;
-            newLeg.bearing = bearing;
-            newLeg.speed = speed;
-            newLeg.distance = distance;
-            newLeg.startTime = legs.at(afterLegNumber + 1).startTime; //This leg starts when the next leg would have started
-
-            legs.insert(legs.begin()+afterLegNumber+1, newLeg); //Insert leg
-        }
-
-        //set start time of subsequent legs
-        //For the remaining legs (which may not exist)
-        for (int i = afterLegNumber + 2; i < (int)legs.size(); i++) {
-            legs.at(i).startTime = legs.at(i-1).startTime + SECONDS_IN_HOUR*legs.at(i-1).distance/legs.at(i-1).speed;
-        }
-
-
-    } //Check leg exists & can be changed
-
+    return ship && visible;
 }
 
-void OtherShip::deleteLeg(int legNumber, irr::f32 scenarioTime)
+void OtherShip::update(irr::f32 positionX, irr::f32 positionY, irr::f32 positionZ, irr::f32 heading, irr::f32 speed, irr::f32 scenarioTime, irr::u32 lightLevel)
 {
+    xPos = positionX;
+    yPos = positionY;
+    zPos = positionZ;
+    hdg = heading;
+    spd = speed;
 
-    //Check if leg exists, then if we are allowed to change this leg (current or future leg), and not the final 'stop' leg (hence legs.size()-1)
-    if (legNumber >=0 && legNumber < ((int)legs.size() - 1) && legNumber >= (int)findCurrentLeg(scenarioTime)) {
-
-        //We can guarantee that there is a next leg, as we checked (legNumber < legs.size() - 1)
-
-        //Current or future leg?
-        if (legNumber == (int)findCurrentLeg(scenarioTime)) {
-            //Current leg
-            //Set next leg start time to now: Set start time of the next leg (guaranteed to exist)
-            legs.at(legNumber + 1).startTime = scenarioTime;
-
-        } else {
-            //Future leg
-            //Set next leg start time to the start time of the leg we're removing
-            legs.at(legNumber + 1).startTime = legs.at(legNumber).startTime;
-        }
+    //Set position & rotation of the scene node
+    ship->setPosition(irr::core::vector3df(xPos,yPos,zPos));
+    // DEE_DEC22 vvvv allows modelling of trim , list and models derived from other coordinate systems
+    //ship->setRotation(irr::core::vector3df(angleCorrectionPitch, hdg+angleCorrection, angleCorrectionRoll)); //Global vectors
+    ship->setRotation(irr::core::vector3df(angleCorrectionPitch, hdg+angleCorrection, angleCorrectionRoll)); //Global vectors
+    // DEE_DEC22 ^^^^
 
-        //adjust start time of subsequent legs
-        //For the remaining legs (which may not exist)
-        for (int i = legNumber + 2; i < (int)legs.size(); i++) {
-            legs.at(i).startTime = legs.at(i-1).startTime + SECONDS_IN_HOUR*legs.at(i-1).distance/legs.at(i-1).speed;
+    //for each light, find range and angle. Not needed if the ship can't be seen.
+    if (visible) {
+        for(std::vector<NavLight*>::size_type currentLight = 0; currentLight<navLights.size(); currentLight++) {
+            navLights[currentLight]->update(scenarioTime, lightLevel);
         }
-
-        //Remove this leg
-        legs.erase(legs.begin() + legNumber);
-
-    } //Check leg exists & can be changed
+    }
 
 }
 
-void OtherShip::resetLegs(irr::f32 course, irr::f32 speedKts, irr::f32 distanceNm, irr::f32 scenarioTime)
+irr::f32 OtherShip::getHeight() const
 {
-    legs.clear();
-
-    Leg currentLeg;
-    currentLeg.bearing = course;
-    currentLeg.speed = speedKts;
-    currentLeg.startTime = scenarioTime;
-    currentLeg.distance = distanceNm;
-
-    //Use distance to calculate startTime of next leg, and stored for later reference.
-    currentLeg.distance = distanceNm;
-    irr::f32 mainLegEndTime = scenarioTime + SECONDS_IN_HOUR*(distanceNm/fabs(speedKts)); // nm/kts -> hours, so convert to seconds
-
-    legs.push_back(currentLeg);
-
-    //Add a stop leg here
-    Leg stopLeg;
-    stopLeg.bearing=course;
-    stopLeg.speed=0;
-    stopLeg.distance=0;
-    stopLeg.startTime = mainLegEndTime;
-    legs.push_back(stopLeg);
+    return height;
 }
 
-void OtherShip::setRateOfTurn(irr::f32 rateOfTurn) //Sets the rate of turn (only used in multiplayer mode)
+irr::f32 OtherShip::getSolidHeight() const
 {
-    this->rateOfTurn = rateOfTurn;
+    return solidHeight;
 }
 
-RadarData OtherShip::getRadarData(irr::core::vector3df scannerPosition) const
-//Get data for OtherShip (number) relative to scannerPosition
-//Similar code in Buoy.cpp
+irr::f32 OtherShip::getRCS() const
 {
-    RadarData radarData;
-
-    irr::core::vector3df contactPosition = getPosition();
-    irr::core::vector3df relativePosition = contactPosition-scannerPosition;
-
-    radarData.relX = relativePosition.X;
-    radarData.relZ = relativePosition.Z;
-    radarData.angle = relativePosition.getHorizontalAngle().Y;
-    radarData.range = relativePosition.getLength();
-    radarData.heading = getHeading();
-
-    radarData.height=getHeight();
-    radarData.solidHeight=solidHeight;
-    //radarData.radarHorizon=99999; //ToDo: Implement when ARPA is implemented
-    radarData.length=getLength();
-    radarData.width=getBreadth();
-    radarData.rcs=getRCS();
-
-    //Calculate angles and ranges to each end of the contact
-    irr::f32 relAngle1 = Angles::normaliseAngle(irr::core::RADTODEG*std::atan2( radarData.relX + 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading), radarData.relZ + 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading) ));
-    irr::f32 relAngle2 = Angles::normaliseAngle(irr::core::RADTODEG*std::atan2( radarData.relX - 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading), radarData.relZ - 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading) ));
-    irr::f32 range1 = std::sqrt(std::pow(radarData.relX + 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading),2) + std::pow(radarData.relZ + 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading),2));
-    irr::f32 range2 = std::sqrt(std::pow(radarData.relX - 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading),2) + std::pow(radarData.relZ - 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading),2));
-    radarData.minRange=std::min(range1,range2);
-    radarData.maxRange=std::max(range1,range2);
-    radarData.minAngle=std::min(relAngle1,relAngle2);
-    radarData.maxAngle=std::max(relAngle1,relAngle2);
-
-    //Initial defaults: Fixme: Will need changing with full implementation
-    radarData.hidden=false;
-    radarData.racon=""; //Racon code if set
-    radarData.raconOffsetTime=0.0;
-    radarData.SART=false;
-
-    radarData.contact = (void*)this;
-
-    return radarData;
+    return rcs;
 }
 
-std::vector<Leg>::size_type OtherShip::findCurrentLeg(irr::f32 scenarioTime)
+std::string OtherShip::getName() const
 {
-    std::vector<Leg>::size_type currentLeg;
-
-    for(currentLeg = 0; currentLeg<legs.size()-1; currentLeg++) {
-        if (legs[currentLeg].startTime <=scenarioTime && legs[currentLeg+1].startTime > scenarioTime ) {
-            break;
-        }
-    }
-    //currentLeg is now the correct leg, or the last leg, which is a 'stopped' leg. (true as we run currentLeg++ once after the check (currentLeg<legs.size()-1) if the 'break' isn't reached
-
-    return currentLeg;
+    return name;
 }
 
 void OtherShip::enableTriangleSelector(bool selectorEnabled)
 {
-    
+    if (!ship) {
+        return;
+    }
+
     //Only re-set if we need to change the state
     
     if (selectorEnabled && !triangleSelectorEnabled) {
@@ -22,45 +22,53 @@
 #include "Ship.hpp"
 
 #include "NavLight.hpp"
-#include "Leg.hpp"
 
 #include <cmath>
 #include <vector>
 
-struct RadarData;
-
+//Scene node, model and lights for an other ship. The ship's motion is in OtherShipFleet, which sets the node's pose through update().
+//The scene node is only created when it's needed (when the ship is close enough to be seen), so that large numbers of distant ships are cheap.
 class OtherShip : public Ship
 {
     public:
-        OtherShip (const std::string& name, const std::string& internalName, const irr::u32& mmsi, const irr::core::vector3df& location, std::vector<Leg> legsLoaded, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev);
+        OtherShip (const std::string& name, const std::string& internalName, const irr::u32& mmsi, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev);
         ~OtherShip();
 
         irr::f32 getHeight() const;
+        irr::f32 getSolidHeight() const;
         irr::f32 getRCS() const;
         std::string getName() const;
-        std::vector<Leg> getLegs() const;
-        void changeLeg(int legNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime);
-        void addLeg(int afterLegNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime);
-        void deleteLeg(int legNumber, irr::f32 scenarioTime);
-        void resetLegs(irr::f32 course, irr::f32 speedKts, irr::f32 distanceNm, irr::f32 scenarioTime);
-        RadarData getRadarData(irr::core::vector3df scannerPosition) const;
-        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel);
+        bool hasSceneNode() const;
+        void createSceneNode();
+        void setVisible(bool visible);
+        bool isVisible() const;
+        void update(irr::f32 positionX, irr::f32 positionY, irr::f32 positionZ, irr::f32 heading, irr::f32 speed, irr::f32 scenarioTime, irr::u32 lightLevel); //Set the scene node to the simulated state. Only call once the scene node exists.
         void enableTriangleSelector(bool selectorEnabled);
-        void setRateOfTurn(irr::f32 rateOfTurn); // This could be moved to Ship.hpp
 
     protected:
     private:
 
+        struct LightDefinition {
+            irr::core::vector3df position;
+            irr::video::SColor colour;
+            irr::f32 startAngle;
+            irr::f32 endAngle;
+            irr::f32 range;
+        };
+
         std::string name;
-        std::vector<Leg> legs;
+        std::string internalName;
+        irr::scene::ISceneManager* smgr;
+        irr::scene::IAnimatedMesh* shipMesh;
+        irr::f32 scaleFactor;
+        std::vector<LightDefinition> lightDefinitions; //Used to create the nav lights with the scene node
         std::vector<NavLight*> navLights;
         irr::f32 height; //For radar
         irr::f32 solidHeight; //For radar
         irr::f32 rcs;
-        irr::f32 rateOfTurn;
-        std::vector<Leg>::size_type findCurrentLeg(irr::f32 scenarioTime);
         irr::scene::ITriangleSelector* selector;
         bool triangleSelectorEnabled;
+        bool visible;
 };
 
 #endif
@@ -0,0 +1,403 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "OtherShipFleet.hpp"
+
+#include "Constants.hpp"
+
+#include <cfloat>
+#include <cmath>
+
+OtherShipFleet::OtherShipFleet()
+{
+
+}
+
+irr::u32 OtherShipFleet::addShip(const irr::core::vector3df& location, const std::vector<Leg>& legs, irr::f32 length, irr::f32 breadth, irr::f32 height, irr::f32 solidHeight, irr::f32 rcs, irr::f32 heightCorrection)
+{
+    //Speed and heading will come from leg data
+    positionX.push_back(location.X);
+    positionY.push_back(location.Y);
+    positionZ.push_back(location.Z);
+    heading.push_back(0);
+    speed.push_back(0);
+    rateOfTurn.push_back(0); // Not normally used, but used to smooth behaviour in multiplayer
+    positionManuallyUpdated.push_back(false);
+
+    hasLegs.push_back(false);
+    currentLeg.push_back(0);
+    currentLegStartTime.push_back(0);
+    currentLegEndTime.push_back(0);
+    currentLegBearing.push_back(0);
+    currentLegSpeed.push_back(0);
+
+    this->length.push_back(length);
+    this->breadth.push_back(breadth);
+    this->height.push_back(height);
+    this->solidHeight.push_back(solidHeight);
+    this->rcs.push_back(rcs);
+    this->heightCorrection.push_back(heightCorrection);
+
+    this->legs.push_back(legs);
+
+    irr::u32 ship = positionX.size() - 1;
+    legsChanged(ship);
+    return ship;
+}
+
+irr::u32 OtherShipFleet::getNumber() const
+{
+    return positionX.size();
+}
+
+void OtherShipFleet::update(irr::f32 deltaTime, irr::f32 scenarioTime)
+{
+    const irr::u32 numberOfShips = positionX.size();
+
+    //Set speed and heading from the current leg. The leg is only looked up again when the scenario time leaves the current leg.
+    for (irr::u32 i = 0; i < numberOfShips; i++) {
+        if (hasLegs[i]) {
+            if (scenarioTime < currentLegStartTime[i] || scenarioTime >= currentLegEndTime[i]) {
+                updateCurrentLeg(i, scenarioTime);
+            }
+            speed[i] = currentLegSpeed[i];
+            heading[i] = currentLegBearing[i];
+        } else {
+            //Don't change speed and hdg - may be in secondary mode, where these are set externally
+            //Except, use rateOfTurn to update hdg
+            heading[i] += deltaTime * rateOfTurn[i]; // rateOfTurn in deg/s
+        }
+    }
+
+    //Move all ships. If the position has already been updated, skip (for this step only)
+    for (irr::u32 i = 0; i < numberOfShips; i++) {
+        irr::f32 distance = positionManuallyUpdated[i] ? 0 : speed[i]*deltaTime;
+        irr::f32 headingRad = heading[i]*irr::core::DEGTORAD;
+        positionX[i] += std::sin(headingRad)*distance;
+        positionZ[i] += std::cos(headingRad)*distance;
+        positionManuallyUpdated[i] = false;
+    }
+}
+
+void OtherShipFleet::moveAll(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
+{
+    for (irr::u32 i = 0; i < positionX.size(); i++) {
+        positionX[i] += deltaX;
+        positionY[i] += deltaY;
+        positionZ[i] += deltaZ;
+    }
+}
+
+const irr::f32* OtherShipFleet::getPositionXs() const
+{
+    return positionX.empty() ? 0 : &positionX[0];
+}
+
+const irr::f32* OtherShipFleet::getPositionZs() const
+{
+    return positionZ.empty() ? 0 : &positionZ[0];
+}
+
+irr::core::vector3df OtherShipFleet::getPosition(irr::u32 ship) const
+{
+    return irr::core::vector3df(positionX.at(ship), positionY.at(ship), positionZ.at(ship));
+}
+
+void OtherShipFleet::setPosition(irr::u32 ship, irr::f32 positionX, irr::f32 positionZ)
+{
+    //Update the position used, ready for next update
+    this->positionX.at(ship) = positionX;
+    this->positionZ.at(ship) = positionZ;
+    positionManuallyUpdated.at(ship) = true;
+}
+
+void OtherShipFleet::setPositionY(irr::u32 ship, irr::f32 positionY)
+{
+    this->positionY.at(ship) = positionY;
+}
+
+irr::f32 OtherShipFleet::getHeading(irr::u32 ship) const
+{
+    return heading.at(ship);
+}
+
+void OtherShipFleet::setHeading(irr::u32 ship, irr::f32 heading)
+{
+    this->heading.at(ship) = heading;
+}
+
+irr::f32 OtherShipFleet::getSpeed(irr::u32 ship) const
+{
+    return speed.at(ship);
+}
+
+void OtherShipFleet::setSpeed(irr::u32 ship, irr::f32 speed)
+{
+    this->speed.at(ship) = speed;
+}
+
+void OtherShipFleet::setRateOfTurn(irr::u32 ship, irr::f32 rateOfTurn)
+{
+    this->rateOfTurn.at(ship) = rateOfTurn;
+}
+
+irr::f32 OtherShipFleet::getLength(irr::u32 ship) const
+{
+    return length.at(ship);
+}
+
+irr::f32 OtherShipFleet::getBreadth(irr::u32 ship) const
+{
+    return breadth.at(ship);
+}
+
+irr::f32 OtherShipFleet::getHeight(irr::u32 ship) const
+{
+    return height.at(ship);
+}
+
+irr::f32 OtherShipFleet::getSolidHeight(irr::u32 ship) const
+{
+    return solidHeight.at(ship);
+}
+
+irr::f32 OtherShipFleet::getRCS(irr::u32 ship) const
+{
+    return rcs.at(ship);
+}
+
+irr::f32 OtherShipFleet::getHeightCorrection(irr::u32 ship) const
+{
+    return heightCorrection.at(ship);
+}
+
+std::vector<Leg> OtherShipFleet::getLegs(irr::u32 ship) const
+{
+    return legs.at(ship);
+}
+
+void OtherShipFleet::setLegs(irr::u32 ship, const std::vector<Leg>& legs)
+{
+    this->legs.at(ship) = legs;
+    legsChanged(ship);
+}
+
+irr::f32 OtherShipFleet::getRateOfTurn(irr::u32 ship) const
+{
+    return rateOfTurn.at(ship);
+}
+
+void OtherShipFleet::changeLeg(irr::u32 ship, int legNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime)
+{
+    std::vector<Leg>& legs = this->legs.at(ship);
+
+    //Check if leg exists, then if we are allowed to change this leg (current or future leg), and not the final 'stop' leg (hence legs.size()-1)
+    if (legNumber >=0 && legNumber < ((int)legs.size() - 1) && legNumber >= (int)findCurrentLeg(ship, scenarioTime)) {
+
+        //Store old information temporarily
+        irr::f32 oldSpeed = legs.at(legNumber).speed;
+
+        //Recalculate subsequent start times, only changing from the current point.
+        //We can guarantee that there is a next leg, as we checked (legNumber < legs.size() - 1)
+
+        irr::f32 newTimeRemaining;
+        if ( legNumber == (int)findCurrentLeg(ship, scenarioTime) ) {
+            //On current leg - calculate from current point only
+            irr::f32 oldTimeRemaining = legs.at(legNumber+1).startTime - scenarioTime;
+            if (distance < 0) {distance = fabs(oldSpeed)*oldTimeRemaining/SECONDS_IN_HOUR;} //If leg length is negative, ensure overall leg length doesn't change
+            newTimeRemaining = SECONDS_IN_HOUR * distance / fabs(speed); //The adjusted leg distance starts from now
+            legs.at(legNumber).startTime = scenarioTime; // New leg effectively starts now
+        } else {
+            //On subsequent leg - calculate for whole leg
+            irr::f32 oldTimeRemaining = legs.at(legNumber+1).startTime - legs.at(legNumber).startTime;
+            if (distance < 0) {distance = fabs(oldSpeed)*oldTimeRemaining/SECONDS_IN_HOUR;} //If leg length is negative, ensure overall leg length doesn't change
+            newTimeRemaining = SECONDS_IN_HOUR * distance / fabs(speed);
+            //No need to change start time.
+        }
+
+        //Change this leg
+        legs.at(legNumber).bearing = bearing;
+        legs.at(legNumber).speed = speed;
+        legs.at(legNumber).distance = distance; //Store for later reference
+
+        //Set start time of the next leg (guaranteed to exist)
+        legs.at(legNumber + 1).startTime = legs.at(legNumber).startTime + newTimeRemaining;
+        //For the remaining legs (which may not exist)
+        for (int i = legNumber + 2; i < (int)legs.size(); i++) {
+            legs.at(i).startTime = legs.at(i-1).startTime + SECONDS_IN_HOUR*legs.at(i-1).distance/legs.at(i-1).speed;
+        }
+
+    } //Check leg exists & can be changed
+
+    legsChanged(ship);
+}
+
+void OtherShipFleet::addLeg(irr::u32 ship, int afterLegNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime)
+{
+    std::vector<Leg>& legs = this->legs.at(ship);
+
+    //Check if leg is reasonable, and is before the 'stop leg'
+    //A special case allows afterLegNumber to equal -1, for when only a single 'stop leg' exists
+    if (afterLegNumber >= -1 && afterLegNumber < ((int)legs.size() - 1)) {
+
+        //if we're on the stop leg
+        if (findCurrentLeg(ship, scenarioTime) == (legs.size()-1)) {
+
+            //If the 'after' leg is the penultimate, add a leg before the stop one, starting now
+            if (afterLegNumber == ((int)legs.size()-2))  { //This also catches the special case where there is only the 'stop' leg, so the 'afterLegNumber value is -1
+
+                Leg newLeg;
+                newLeg.bearing = bearing;
+                newLeg.speed = speed;
+                newLeg.distance = distance;
+                newLeg.startTime = scenarioTime;
+
+                legs.insert(legs.end()-1, newLeg); //Insert before final leg
+            }
+        //else check that the 'after' leg is current or future
+        } else if (afterLegNumber >=0 && afterLegNumber >= (int)findCurrentLeg(ship, scenarioTime)) { //First check only required in case findCurrentLeg does not return a valid result (>=0)
+            Leg newLeg;
+            newLeg.bearing = bearing;
+            newLeg.speed = speed;
+            newLeg.distance = distance;
+            newLeg.startTime = legs.at(afterLegNumber + 1).startTime; //This leg starts when the next leg would have started
+
+            legs.insert(legs.begin()+afterLegNumber+1, newLeg); //Insert leg
+        }
+
+        //set start time of subsequent legs
+        //For the remaining legs (which may not exist)
+        for (int i = afterLegNumber + 2; i < (int)legs.size(); i++) {
+            legs.at(i).startTime = legs.at(i-1).startTime + SECONDS_IN_HOUR*legs.at(i-1).distance/legs.at(i-1).speed;
+        }
+
+
+    } //Check leg exists & can be changed
+
+    legsChanged(ship);
+}
+
+void OtherShipFleet::deleteLeg(irr::u32 ship, int legNumber, irr::f32 scenarioTime)
+{
+    std::vector<Leg>& legs = this->legs.at(ship);
+
+    //Check if leg exists, then if we are allowed to change this leg (current or future leg), and not the final 'stop' leg (hence legs.size()-1)
+    if (legNumber >=0 && legNumber < ((int)legs.size() - 1) && legNumber >= (int)findCurrentLeg(ship, scenarioTime)) {
+
+        //We can guarantee that there is a next leg, as we checked (legNumber < legs.size() - 1)
+
+        //Current or future leg?
+        if (legNumber == (int)findCurrentLeg(ship, scenarioTime)) {
+            //Current leg
+            //Set next leg start time to now: Set start time of the next leg (guaranteed to exist)
+            legs.at(legNumber + 1).startTime = scenarioTime;
+
+        } else {
+            //Future leg
+            //Set next leg start time to the start time of the leg we're removing
+            legs.at(legNumber + 1).startTime = legs.at(legNumber).startTime;
+        }
+
+        //adjust start time of subsequent legs
+        //For the remaining legs (which may not exist)
+        for (int i = legNumber + 2; i < (int)legs.size(); i++) {
+            legs.at(i).startTime = legs.at(i-1).startTime + SECONDS_IN_HOUR*legs.at(i-1).distance/legs.at(i-1).speed;
+        }
+
+        //Remove this leg
+        legs.erase(legs.begin() + legNumber);
+
+    } //Check leg exists & can be changed
+
+    legsChanged(ship);
+}
+
+void OtherShipFleet::resetLegs(irr::u32 ship, irr::f32 course, irr::f32 speedKts, irr::f32 distanceNm, irr::f32 scenarioTime)
+{
+    std::vector<Leg>& legs = this->legs.at(ship);
+    legs.clear();
+
+    Leg currentLeg;
+    currentLeg.bearing = course;
+    currentLeg.speed = speedKts;
+    currentLeg.startTime = scenarioTime;
+    currentLeg.distance = distanceNm;
+
+    //Use distance to calculate startTime of next leg, and stored for later reference.
+    currentLeg.distance = distanceNm;
+    irr::f32 mainLegEndTime = scenarioTime + SECONDS_IN_HOUR*(distanceNm/fabs(speedKts)); // nm/kts -> hours, so convert to seconds
+
+    legs.push_back(currentLeg);
+
+    //Add a stop leg here
+    Leg stopLeg;
+    stopLeg.bearing=course;
+    stopLeg.speed=0;
+    stopLeg.distance=0;
+    stopLeg.startTime = mainLegEndTime;
+    legs.push_back(stopLeg);
+
+    legsChanged(ship);
+}
+
+std::vector<Leg>::size_type OtherShipFleet::findCurrentLeg(irr::u32 ship, irr::f32 scenarioTime) const
+{
+    const std::vector<Leg>& legs = this->legs.at(ship);
+    std::vector<Leg>::size_type currentLeg;
+
+    if (legs.empty()) {
+        return 0;
+    }
+
+    for(currentLeg = 0; currentLeg<legs.size()-1; currentLeg++) {
+        if (legs[currentLeg].startTime <=scenarioTime && legs[currentLeg+1].startTime > scenarioTime ) {
+            break;
+        }
+    }
+    //currentLeg is now the correct leg, or the last leg, which is a 'stopped' leg. (true as we run currentLeg++ once after the check (currentLeg<legs.size()-1) if the 'break' isn't reached
+
+    return currentLeg;
+}
+
+void OtherShipFleet::updateCurrentLeg(irr::u32 ship, irr::f32 scenarioTime)
+{
+    const std::vector<Leg>& legs = this->legs.at(ship);
+    if (legs.empty()) {
+        return;
+    }
+
+    std::vector<Leg>::size_type leg = findCurrentLeg(ship, scenarioTime);
+    currentLeg.at(ship) = leg;
+    currentLegBearing.at(ship) = legs.at(leg).bearing;
+    currentLegSpeed.at(ship) = legs.at(leg).speed*KTS_TO_MPS;
+
+    //Time range where this stays the current leg. The final 'stop' leg continues indefinitely.
+    if (leg + 1 < legs.size()) {
+        currentLegStartTime.at(ship) = legs.at(leg).startTime;
+        currentLegEndTime.at(ship) = legs.at(leg + 1).startTime;
+    } else {
+        currentLegStartTime.at(ship) = legs.at(leg).startTime;
+        currentLegEndTime.at(ship) = FLT_MAX;
+    }
+}
+
+void OtherShipFleet::legsChanged(irr::u32 ship)
+{
+    hasLegs.at(ship) = !legs.at(ship).empty();
+    //Make sure the current leg is found again on the next update
+    currentLegStartTime.at(ship) = FLT_MAX;
+    currentLegEndTime.at(ship) = -FLT_MAX;
+}
@@ -0,0 +1,97 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __OTHERSHIPFLEET_HPP_INCLUDED__
+#define __OTHERSHIPFLEET_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include "Leg.hpp"
+
+#include <vector>
+
+//Motion of all other ships, with each property held in its own array (indexed by ship number), so all ships can be moved together in one pass.
+//Scene nodes, lights and models are held separately, in OtherShip, and only needed for ships close enough to be seen.
+class OtherShipFleet
+{
+    public:
+        OtherShipFleet();
+        irr::u32 addShip(const irr::core::vector3df& location, const std::vector<Leg>& legs, irr::f32 length, irr::f32 breadth, irr::f32 height, irr::f32 solidHeight, irr::f32 rcs, irr::f32 heightCorrection); //Returns the ship number
+        irr::u32 getNumber() const;
+        void update(irr::f32 deltaTime, irr::f32 scenarioTime); //Move all ships, following their legs (or rate of turn if there are no legs)
+        void moveAll(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
+
+        //Positions of all ships, for batched queries
+        const irr::f32* getPositionXs() const;
+        const irr::f32* getPositionZs() const;
+
+        irr::core::vector3df getPosition(irr::u32 ship) const;
+        void setPosition(irr::u32 ship, irr::f32 positionX, irr::f32 positionZ); //Set externally, so the next update doesn't move the ship
+        void setPositionY(irr::u32 ship, irr::f32 positionY);
+        irr::f32 getHeading(irr::u32 ship) const;
+        void setHeading(irr::u32 ship, irr::f32 heading);
+        irr::f32 getSpeed(irr::u32 ship) const; //m/s
+        void setSpeed(irr::u32 ship, irr::f32 speed); //m/s
+        void setRateOfTurn(irr::u32 ship, irr::f32 rateOfTurn); //deg/s, only used without legs (e.g. in multiplayer)
+        irr::f32 getLength(irr::u32 ship) const;
+        irr::f32 getBreadth(irr::u32 ship) const;
+        irr::f32 getHeight(irr::u32 ship) const;
+        irr::f32 getSolidHeight(irr::u32 ship) const;
+        irr::f32 getRCS(irr::u32 ship) const;
+        irr::f32 getHeightCorrection(irr::u32 ship) const;
+
+        std::vector<Leg> getLegs(irr::u32 ship) const;
+        void setLegs(irr::u32 ship, const std::vector<Leg>& legs); //Replace all legs, e.g. when restoring a saved state
+        irr::f32 getRateOfTurn(irr::u32 ship) const; //deg/s
+        void changeLeg(irr::u32 ship, int legNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime);
+        void addLeg(irr::u32 ship, int afterLegNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime);
+        void deleteLeg(irr::u32 ship, int legNumber, irr::f32 scenarioTime);
+        void resetLegs(irr::u32 ship, irr::f32 course, irr::f32 speedKts, irr::f32 distanceNm, irr::f32 scenarioTime);
+
+    private:
+        //Motion
+        std::vector<irr::f32> positionX;
+        std::vector<irr::f32> positionY;
+        std::vector<irr::f32> positionZ;
+        std::vector<irr::f32> heading; //deg
+        std::vector<irr::f32> speed; //m/s
+        std::vector<irr::f32> rateOfTurn; //deg/s
+        std::vector<irr::u8> positionManuallyUpdated; //If position has been set externally, and shouldn't be updated again this step
+
+        //Current leg, stored so the legs only need to be searched when the leg changes
+        std::vector<irr::u8> hasLegs;
+        std::vector<irr::u32> currentLeg;
+        std::vector<irr::f32> currentLegStartTime;
+        std::vector<irr::f32> currentLegEndTime;
+        std::vector<irr::f32> currentLegBearing; //deg
+        std::vector<irr::f32> currentLegSpeed; //m/s
+
+        //Dimensions
+        std::vector<irr::f32> length;
+        std::vector<irr::f32> breadth;
+        std::vector<irr::f32> height; //For radar
+        std::vector<irr::f32> solidHeight; //For radar
+        std::vector<irr::f32> rcs;
+        std::vector<irr::f32> heightCorrection;
+
+        std::vector<std::vector<Leg>> legs;
+
+        std::vector<Leg>::size_type findCurrentLeg(irr::u32 ship, irr::f32 scenarioTime) const;
+        void updateCurrentLeg(irr::u32 ship, irr::f32 scenarioTime);
+        void legsChanged(irr::u32 ship); //Call after changing a ship's legs, so the current leg is found again
+};
+
+#endif // __OTHERSHIPFLEET_HPP_INCLUDED__
@@ -16,6 +16,7 @@
 
 #include "OtherShips.hpp"
 
+#include "Angles.hpp"
 #include "Constants.hpp"
 #include "OtherShip.hpp"
 #include "IniFile.hpp"
@@ -23,6 +24,8 @@
 #include "SimulationModel.hpp"
 #include "ScenarioDataStructure.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream> //debugging
 
 //using namespace irr;
@@ -46,6 +49,9 @@ void OtherShips::load(std::vector<OtherShipData> otherShipsData, irr::f32 scenar
     //Store reference to model
     this->model = model;
 
+    //Ships can't be seen beyond the camera's far plane
+    visualRange = model->getModelParameters().cameraMaxDistance;
+
     for(irr::u32 i=0;i<otherShipsData.size();i++)
     {
         //Get ship type and construct filename
@@ -89,36 +95,90 @@ void OtherShips::load(std::vector<OtherShipData> otherShipsData, irr::f32 scenar
         //Create otherShip and load into vector
         std::string internalName = "OtherShip_";
         internalName.append(std::to_string(i));
-        otherShips.push_back(new OtherShip (otherShipName,internalName,mmsi,irr::core::vector3df(shipX,0.0f,shipZ),legs,smgr, dev));
+        OtherShip* otherShip = new OtherShip (otherShipName,internalName,mmsi,smgr,dev);
+        otherShips.push_back(otherShip);
+        fleet.addShip(irr::core::vector3df(shipX,0.0f,shipZ),legs,otherShip->getLength(),otherShip->getBreadth(),otherShip->getHeight(),otherShip->getSolidHeight(),otherShip->getRCS(),otherShip->getHeightCorrection());
     }
 
 }
 
-void OtherShips::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength)
+void OtherShips::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength, SpatialIndex& spatialIndex)
 {
-    for(std::vector<OtherShip*>::iterator it = otherShips.begin(); it != otherShips.end(); ++it) {
+    const irr::u32 numberOfShips = fleet.getNumber();
+
+    //Find wave heights at all ships together, at their positions before this step
+    waveHeights.resize(numberOfShips);
+    if (numberOfShips > 0) {
+        model->getWaveData(fleet.getPositionXs(), fleet.getPositionZs(), &waveHeights[0], 0, 0, numberOfShips);
+    }
+
+    //Move all ships
+    fleet.update(deltaTime, scenarioTime);
+
+    for (irr::u32 i = 0; i < numberOfShips; i++) {
 
         //Find local wave height
-        irr::core::vector3df prevPosition = (*it)->getPosition();
-        irr::f32 waveHeightFiltered = prevPosition.Y - tideHeight - (*it)->getHeightCorrection(); //Calculate the previous wave height:
+        irr::core::vector3df position = fleet.getPosition(i);
+        irr::f32 waveHeightFiltered = position.Y - tideHeight - fleet.getHeightCorrection(i); //Calculate the previous wave height:
 
         //Apply up/down motion from waves, with some filtering
         irr::f32 timeConstant = 0.5;//Time constant in s; TODO: Make dependent on vessel size
         irr::f32 factor = deltaTime/(timeConstant+deltaTime);
-        waveHeightFiltered = (1-factor) * waveHeightFiltered + factor*model->getWaveHeight(prevPosition.X,prevPosition.Z); //TODO: Check implementation of simple filter!
+        waveHeightFiltered = (1-factor) * waveHeightFiltered + factor*waveHeights.at(i); //TODO: Check implementation of simple filter!
 
         //Special case, if paused, just use the actual wave height. A bit of a bodge, but avoids having to store the previous filter value
         if (deltaTime == 0) {
-            waveHeightFiltered = model->getWaveHeight(prevPosition.X,prevPosition.Z);
+            waveHeightFiltered = waveHeights.at(i);
         }
 
-        (*it)->update(deltaTime, scenarioTime, tideHeight+waveHeightFiltered, lightLevel);
+        fleet.setPositionY(i, tideHeight + waveHeightFiltered + fleet.getHeightCorrection(i));
 
-        //Set or clear triangle selector depending on distance from own ship
-        if ((*it)->getSceneNode()->getAbsolutePosition().getDistanceFrom(ownShipPosition) < (ownShipLength + (*it)->getLength())) {
-            (*it)->enableTriangleSelector(true);
+        spatialIndex.setPosition(E_SPATIAL_OTHER_SHIP, i, position.X, position.Z, 0.5*std::max(fleet.getLength(i), fleet.getBreadth(i)));
+    }
+
+    //Only ships that can be seen need a visible scene node. Allow some hysteresis, so ships near the limit aren't shown and hidden repeatedly.
+    spatialIndex.findInRange(ownShipPosition.X, ownShipPosition.Z, 1.1*visualRange, nearbyObjects);
+    newVisibleShips.clear();
+    for (std::vector<SpatialIndex::Object>::size_type i = 0; i < nearbyObjects.size(); i++) {
+        if (nearbyObjects.at(i).type != E_SPATIAL_OTHER_SHIP) {
+            continue;
+        }
+        irr::u32 number = nearbyObjects.at(i).number;
+        irr::f32 distanceFromOwnShip = fleet.getPosition(number).getDistanceFrom(ownShipPosition);
+        if (otherShips.at(number)->isVisible() || distanceFromOwnShip < visualRange + fleet.getLength(number)) {
+            newVisibleShips.push_back(number); //In order, as returned from the spatial index
+        }
+    }
+    for (std::vector<irr::u32>::size_type i = 0; i < visibleShips.size(); i++) {
+        if (!std::binary_search(newVisibleShips.begin(), newVisibleShips.end(), visibleShips.at(i))) {
+            otherShips.at(visibleShips.at(i))->enableTriangleSelector(false);
+            otherShips.at(visibleShips.at(i))->setVisible(false);
+        }
+    }
+    for (std::vector<irr::u32>::size_type i = 0; i < newVisibleShips.size(); i++) {
+        OtherShip* otherShip = otherShips.at(newVisibleShips.at(i));
+        if (!otherShip->hasSceneNode()) {
+            otherShip->createSceneNode();
+            shipsWithSceneNodes.push_back(newVisibleShips.at(i));
+        }
+        otherShip->setVisible(true);
+    }
+    visibleShips.swap(newVisibleShips);
+
+    //Update the scene nodes that exist (they may be hidden, but used as an attachment point for lines)
+    for (std::vector<irr::u32>::size_type i = 0; i < shipsWithSceneNodes.size(); i++) {
+        irr::u32 number = shipsWithSceneNodes.at(i);
+        irr::core::vector3df position = fleet.getPosition(number);
+        otherShips.at(number)->update(position.X, position.Y, position.Z, fleet.getHeading(number), fleet.getSpeed(number), scenarioTime, lightLevel);
+    }
+
+    //Set or clear triangle selector depending on distance from own ship. Only visible ships can be close enough.
+    for (std::vector<irr::u32>::size_type i = 0; i < visibleShips.size(); i++) {
+        irr::u32 number = visibleShips.at(i);
+        if (fleet.getPosition(number).getDistanceFrom(ownShipPosition) < (ownShipLength + fleet.getLength(number))) {
+            otherShips.at(number)->enableTriangleSelector(true);
         } else {
-            (*it)->enableTriangleSelector(false);
+            otherShips.at(number)->enableTriangleSelector(false);
         }
     }
 
@@ -128,14 +188,25 @@ void OtherShips::enableAllTriangleSelectors()
 {
     for(std::vector<OtherShip*>::iterator it = otherShips.begin(); it != otherShips.end(); ++it) {
         // This will return to normal the next time OtherShips::update is called.
-        (*it)->enableTriangleSelector(true);
+        if ((*it)->isVisible()) {
+            (*it)->enableTriangleSelector(true);
+        }
     }
 }
 
 irr::scene::ISceneNode* OtherShips::getSceneNode(int number)
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getSceneNode();
+        //Create the scene node if it isn't already there (e.g. to attach a line), at the ship's current position
+        OtherShip* otherShip = otherShips.at(number);
+        if (!otherShip->hasSceneNode()) {
+            irr::core::vector3df position = fleet.getPosition(number);
+            otherShip->createSceneNode();
+            otherShip->setVisible(false); //Until it is within visual range
+            otherShip->update(position.X, position.Y, position.Z, fleet.getHeading(number), fleet.getSpeed(number), 0, 0);
+            shipsWithSceneNodes.push_back(number);
+        }
+        return otherShip->getSceneNode();
     } else {
         return 0;
     }
@@ -143,11 +214,46 @@ irr::scene::ISceneNode* OtherShips::getSceneNode(int number)
 
 RadarData OtherShips::getRadarData(irr::u32 number, irr::core::vector3df scannerPosition) const
 //Get data for OtherShip (number) relative to scannerPosition
+//Similar code in Buoy.cpp
 {
     RadarData radarData;
 
     if (number<=otherShips.size()) {
-        radarData = otherShips[number-1]->getRadarData(scannerPosition);
+        irr::u32 ship = number-1;
+
+        irr::core::vector3df contactPosition = fleet.getPosition(ship);
+        irr::core::vector3df relativePosition = contactPosition-scannerPosition;
+
+        radarData.relX = relativePosition.X;
+        radarData.relZ = relativePosition.Z;
+        radarData.angle = relativePosition.getHorizontalAngle().Y;
+        radarData.range = relativePosition.getLength();
+        radarData.heading = fleet.getHeading(ship);
+
+        radarData.height=fleet.getHeight(ship);
+        radarData.solidHeight=fleet.getSolidHeight(ship);
+        //radarData.radarHorizon=99999; //ToDo: Implement when ARPA is implemented
+        radarData.length=fleet.getLength(ship);
+        radarData.width=fleet.getBreadth(ship);
+        radarData.rcs=fleet.getRCS(ship);
+
+        //Calculate angles and ranges to each end of the contact
+        irr::f32 relAngle1 = Angles::normaliseAngle(irr::core::RADTODEG*std::atan2( radarData.relX + 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading), radarData.relZ + 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading) ));
+        irr::f32 relAngle2 = Angles::normaliseAngle(irr::core::RADTODEG*std::atan2( radarData.relX - 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading), radarData.relZ - 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading) ));
+        irr::f32 range1 = std::sqrt(std::pow(radarData.relX + 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading),2) + std::pow(radarData.relZ + 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading),2));
+        irr::f32 range2 = std::sqrt(std::pow(radarData.relX - 0.5*radarData.length*std::sin(irr::core::DEGTORAD*radarData.heading),2) + std::pow(radarData.relZ - 0.5*radarData.length*std::cos(irr::core::DEGTORAD*radarData.heading),2));
+        radarData.minRange=std::min(range1,range2);
+        radarData.maxRange=std::max(range1,range2);
+        radarData.minAngle=std::min(relAngle1,relAngle2);
+        radarData.maxAngle=std::max(relAngle1,relAngle2);
+
+        //Initial defaults: Fixme: Will need changing with full implementation
+        radarData.hidden=false;
+        radarData.racon=""; //Racon code if set
+        radarData.raconOffsetTime=0.0;
+        radarData.SART=false;
+
+        radarData.contact = (void*)otherShips.at(ship);
     }
     return radarData;
 }
@@ -160,7 +266,7 @@ irr::u32 OtherShips::getNumber() const
 irr::core::vector3df OtherShips::getPosition(int number) const
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getPosition();
+        return fleet.getPosition(number);
     } else {
         return irr::core::vector3df(0,0,0);
     }
@@ -169,7 +275,7 @@ irr::core::vector3df OtherShips::getPosition(int number) const
 irr::f32 OtherShips::getLength(int number) const
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getLength();
+        return fleet.getLength(number);
     } else {
         return 0.0;
     }
@@ -178,7 +284,7 @@ irr::f32 OtherShips::getLength(int number) const
 irr::f32 OtherShips::getBreadth(int number) const
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getBreadth();
+        return fleet.getBreadth(number);
     } else {
         return 0.0;
     }
@@ -187,7 +293,7 @@ irr::f32 OtherShips::getBreadth(int number) const
 irr::f32 OtherShips::getHeading(int number) const
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getHeading();
+        return fleet.getHeading(number);
     } else {
         return 0;
     }
@@ -196,7 +302,7 @@ irr::f32 OtherShips::getHeading(int number) const
 irr::f32 OtherShips::getSpeed(int number) const
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getSpeed();
+        return fleet.getSpeed(number);
     } else {
         return 0;
     }
@@ -214,7 +320,7 @@ irr::f32 OtherShips::getEstimatedDisplacement(int number) const
 void OtherShips::setSpeed(int number, irr::f32 speed)
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        otherShips.at(number)->setSpeed(speed);
+        fleet.setSpeed(number, speed);
     }
 }
 
@@ -237,28 +343,28 @@ void OtherShips::setMMSI(int number, irr::u32 mmsi)
 void OtherShips::setPos(int number, irr::f32 positionX, irr::f32 positionZ)
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        otherShips.at(number)->setPosition(positionX,positionZ);
+        fleet.setPosition(number, positionX, positionZ);
     }
 }
 
 void OtherShips::setHeading(int number, irr::f32 hdg)
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        otherShips.at(number)->setHeading(hdg);
+        fleet.setHeading(number, hdg);
     }
 }
 
 void OtherShips::setRateOfTurn(int number, irr::f32 rateOfTurn)
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        otherShips.at(number)->setRateOfTurn(rateOfTurn);
+        fleet.setRateOfTurn(number, rateOfTurn);
     }
 }
 
 std::vector<Leg> OtherShips::getLegs(int number) const
 {
     if (number < (int)otherShips.size() && number >= 0) {
-        return otherShips.at(number)->getLegs();
+        return fleet.getLegs(number);
     } else {
         //Return an empty vector
         std::vector<Leg> legs;
@@ -266,11 +372,27 @@ std::vector<Leg> OtherShips::getLegs(int number) const
     }
 }
 
+void OtherShips::setLegs(int number, const std::vector<Leg>& legs)
+{
+    if (number < (int)otherShips.size() && number >= 0) {
+        fleet.setLegs(number, legs);
+    }
+}
+
+irr::f32 OtherShips::getRateOfTurn(int number) const
+{
+    if (number < (int)otherShips.size() && number >= 0) {
+        return fleet.getRateOfTurn(number);
+    } else {
+        return 0;
+    }
+}
+
 void OtherShips::changeLeg(int shipNumber, int legNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime)
 {
     //Check if ship exists
     if (shipNumber < (int)otherShips.size() && shipNumber >= 0) {
-        otherShips.at(shipNumber)->changeLeg(legNumber, bearing, speed, distance, scenarioTime);
+        fleet.changeLeg(shipNumber, legNumber, bearing, speed, distance, scenarioTime);
     }
 }
 
@@ -278,7 +400,7 @@ void OtherShips::addLeg(int shipNumber, int afterLegNumber, irr::f32 bearing, ir
 {
     //Check if ship exists
     if (shipNumber < (int)otherShips.size() && shipNumber >= 0) {
-        otherShips.at(shipNumber)->addLeg(afterLegNumber, bearing, speed, distance, scenarioTime);
+        fleet.addLeg(shipNumber, afterLegNumber, bearing, speed, distance, scenarioTime);
     }
 }
 
@@ -286,7 +408,7 @@ void OtherShips::deleteLeg(int shipNumber, int legNumber, irr::f32 scenarioTime)
 {
     //Check if ship exists
     if (shipNumber < (int)otherShips.size() && shipNumber >= 0) {
-        otherShips.at(shipNumber)->deleteLeg(legNumber, scenarioTime);
+        fleet.deleteLeg(shipNumber, legNumber, scenarioTime);
     }
 }
 
@@ -294,7 +416,7 @@ void OtherShips::resetLegs(int shipNumber, irr::f32 course, irr::f32 speedKts, i
 {
     //Check if ship exists
     if (shipNumber < (int)otherShips.size() && shipNumber >= 0) {
-        otherShips.at(shipNumber)->resetLegs(course, speedKts, distanceNm, scenarioTime);
+        fleet.resetLegs(shipNumber, course, speedKts, distanceNm, scenarioTime);
     }
 }
 
@@ -309,7 +431,25 @@ std::string OtherShips::getName(int number) const
 
 void OtherShips::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
 {
+    fleet.moveAll(deltaX,deltaY,deltaZ);
     for(std::vector<OtherShip*>::iterator it = otherShips.begin(); it != otherShips.end(); ++it) {
-        (*it)->moveNode(deltaX,deltaY,deltaZ);
+        if ((*it)->hasSceneNode()) {
+            (*it)->moveNode(deltaX,deltaY,deltaZ);
+        }
+    }
+}
+
+void OtherShips::beginSimulationStep()
+{
+    //All scene nodes, including hidden ones, as these are still updated, and their stored states must stay current for when they are shown again
+    for (std::vector<irr::u32>::size_type i = 0; i < shipsWithSceneNodes.size(); i++) {
+        otherShips.at(shipsWithSceneNodes.at(i))->beginSimulationStep();
+    }
+}
+
+void OtherShips::interpolateNodes(irr::f32 fraction)
+{
+    for (std::vector<irr::u32>::size_type i = 0; i < shipsWithSceneNodes.size(); i++) {
+        otherShips.at(shipsWithSceneNodes.at(i))->interpolateNode(fraction);
     }
 }
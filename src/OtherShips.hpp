@@ -24,6 +24,8 @@
 
 #include "Leg.hpp"
 #include "OperatingModeEnum.hpp"
+#include "OtherShipFleet.hpp"
+#include "SpatialIndex.hpp"
 
 //Forward declarations
 class SimulationModel;
@@ -37,7 +39,7 @@ class OtherShips
         OtherShips();
         ~OtherShips();
         void load(std::vector<OtherShipData> otherShipsData, irr::f32 scenarioStartTime, OperatingMode::Mode mode, irr::scene::ISceneManager* smgr, SimulationModel* model, irr::IrrlichtDevice* dev);
-        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength);
+        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength, SpatialIndex& spatialIndex); //Also updates the other ships' positions in spatialIndex
         RadarData getRadarData(irr::u32 number, irr::core::vector3df scannerPosition) const;
         irr::u32 getNumber() const;
         irr::core::vector3df getPosition(int number) const;
@@ -53,18 +55,33 @@ class OtherShips
         void setHeading(int number, irr::f32 hdg);
         void setRateOfTurn(int number, irr::f32 rateOfTurn);
         std::vector<Leg> getLegs(int number) const;
+        void setLegs(int number, const std::vector<Leg>& legs);
+        irr::f32 getRateOfTurn(int number) const;
         void changeLeg(int shipNumber, int legNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime);
         void addLeg(int shipNumber, int afterLegNumber, irr::f32 bearing, irr::f32 speed, irr::f32 distance, irr::f32 scenarioTime);
         void deleteLeg(int shipNumber, int legNumber, irr::f32 scenarioTime);
         void resetLegs(int shipNumber, irr::f32 course, irr::f32 speedKts, irr::f32 distanceNm, irr::f32 scenarioTime);
         std::string getName(int number) const;
         void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
+        void beginSimulationStep(); //Return all scene nodes to their simulated state, ready for a simulation step
+        void interpolateNodes(irr::f32 fraction); //Show all ships between their previous (0) and latest (1) simulated states
         void enableAllTriangleSelectors();
         irr::scene::ISceneNode* getSceneNode(int number);
 
     private:
-        std::vector<OtherShip*> otherShips;
+        std::vector<OtherShip*> otherShips; //Scene nodes and models, with the same numbering as fleet
+        OtherShipFleet fleet; //Motion of all ships
         SimulationModel* model;
+        irr::f32 visualRange; //Ships further than this (plus their length) from own ship don't need a visible scene node
+        std::vector<irr::u32> visibleShips; //Ships with a visible scene node, in order
+        std::vector<irr::u32> shipsWithSceneNodes;
+
+        //Working storage for finding which ships are visible
+        std::vector<SpatialIndex::Object> nearbyObjects;
+        std::vector<irr::u32> newVisibleShips;
+
+        //Working storage for finding wave heights for all ships together
+        std::vector<irr::f32> waveHeights;
 };
 
 #endif
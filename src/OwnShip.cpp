@@ -17,6 +17,8 @@
 // Extends from the general 'Ship' class
 #include "OwnShip.hpp"
 
+#include "ContactPointCache.hpp"
+
 #include "Constants.hpp"
 #include "SimulationModel.hpp"
 #include "ScenarioDataStructure.hpp"
@@ -699,84 +701,96 @@ void OwnShip::load(OwnShipData ownShipData, irr::core::vector3di numberOfContact
       numberOfContactPoints.Z = std::max(numberOfContactPoints.Z, (int)ceil((maxZ - minZ) / minContactPointSpacing));
     }
 
-    // Grid from below looking up
-    for (int i = 0; i < numberOfContactPoints.X; i++)
+    // Use the contact points found last time this ship was loaded, if nothing has changed. Otherwise find them with ray checks on the model, and store them for next time.
+    ContactPointCache contactPointCache(ownShipName, ownShipFullPath, shipIniFilename);
+    contactPointCache.setParameters(scaleFactor, heightCorrection, numberOfContactPoints, boundingBox);
+    if (contactPointCache.load(contactPoints))
     {
-        for (int j = 0; j < numberOfContactPoints.Z; j++)
-        {
-
-            irr::f32 xSpacing = (maxX - minX) / (irr::f32)(numberOfContactPoints.X - 1);
-            irr::f32 zSpacing = (maxZ - minZ) / (irr::f32)(numberOfContactPoints.Z - 1);
-
-            irr::f32 xTestPos = minX + (irr::f32)i * xSpacing;
-            irr::f32 zTestPos = minZ + (irr::f32)j * zSpacing;
-
-            irr::core::line3df ray; // Make a ray. This will start outside the mesh, looking in
-            ray.start.X = xTestPos;
-            ray.start.Y = minY - 0.1;
-            ray.start.Z = zTestPos;
-            ray.end = ray.start;
-            ray.end.Y = maxY + 0.1;
-
-            // Check the ray and add the contact point if it exists
-            addContactPointFromRay(ray, xSpacing * zSpacing);
-        }
+        device->getLogger()->log("Own ship points loaded from cache");
     }
-
-    // Grid from ahead/astern
-    for (int i = 0; i < numberOfContactPoints.X; i++)
+    else
     {
-        for (int j = 0; j < numberOfContactPoints.Y; j++)
+        // Grid from below looking up
+        for (int i = 0; i < numberOfContactPoints.X; i++)
         {
+            for (int j = 0; j < numberOfContactPoints.Z; j++)
+            {
 
-            irr::f32 xSpacing = (maxX - minX) / (irr::f32)(numberOfContactPoints.X - 1);
-            irr::f32 ySpacing = (maxY - minY) / (irr::f32)(numberOfContactPoints.Y - 1);
+                irr::f32 xSpacing = (maxX - minX) / (irr::f32)(numberOfContactPoints.X - 1);
+                irr::f32 zSpacing = (maxZ - minZ) / (irr::f32)(numberOfContactPoints.Z - 1);
 
-            irr::f32 xTestPos = minX + (irr::f32)i * xSpacing;
-            irr::f32 yTestPos = minY + (irr::f32)j * ySpacing;
+                irr::f32 xTestPos = minX + (irr::f32)i * xSpacing;
+                irr::f32 zTestPos = minZ + (irr::f32)j * zSpacing;
 
-            irr::core::line3df ray; // Make a ray. This will start outside the mesh, looking in
-            ray.start.X = xTestPos;
-            ray.start.Y = yTestPos;
-            ray.start.Z = maxZ + 0.1;
-            ray.end = ray.start;
-            ray.end.Z = minZ - 0.1;
+                irr::core::line3df ray; // Make a ray. This will start outside the mesh, looking in
+                ray.start.X = xTestPos;
+                ray.start.Y = minY - 0.1;
+                ray.start.Z = zTestPos;
+                ray.end = ray.start;
+                ray.end.Y = maxY + 0.1;
 
-            // Check the ray and add the contact point if it exists
-            addContactPointFromRay(ray, xSpacing * ySpacing);
-            // swap ray direction and check again
-            ray.start.Z = minZ - 0.1;
-            ray.end.Z = maxZ + 0.1;
-            addContactPointFromRay(ray, xSpacing * ySpacing);
+                // Check the ray and add the contact point if it exists
+                addContactPointFromRay(ray, xSpacing * zSpacing);
+            }
         }
-    }
 
-    // Grid from side to side
-    for (int i = 0; i < numberOfContactPoints.Z; i++)
-    {
-        for (int j = 0; j < numberOfContactPoints.Y; j++)
+        // Grid from ahead/astern
+        for (int i = 0; i < numberOfContactPoints.X; i++)
         {
+            for (int j = 0; j < numberOfContactPoints.Y; j++)
+            {
 
-            irr::f32 zSpacing = (maxZ - minZ) / (irr::f32)(numberOfContactPoints.Z - 1);
-            irr::f32 ySpacing = (maxY - minY) / (irr::f32)(numberOfContactPoints.Y - 1);
-
-            irr::f32 zTestPos = minZ + (irr::f32)i * zSpacing;
-            irr::f32 yTestPos = minY + (irr::f32)j * ySpacing;
+                irr::f32 xSpacing = (maxX - minX) / (irr::f32)(numberOfContactPoints.X - 1);
+                irr::f32 ySpacing = (maxY - minY) / (irr::f32)(numberOfContactPoints.Y - 1);
+
+                irr::f32 xTestPos = minX + (irr::f32)i * xSpacing;
+                irr::f32 yTestPos = minY + (irr::f32)j * ySpacing;
+
+                irr::core::line3df ray; // Make a ray. This will start outside the mesh, looking in
+                ray.start.X = xTestPos;
+                ray.start.Y = yTestPos;
+                ray.start.Z = maxZ + 0.1;
+                ray.end = ray.start;
+                ray.end.Z = minZ - 0.1;
+
+                // Check the ray and add the contact point if it exists
+                addContactPointFromRay(ray, xSpacing * ySpacing);
+                // swap ray direction and check again
+                ray.start.Z = minZ - 0.1;
+                ray.end.Z = maxZ + 0.1;
+                addContactPointFromRay(ray, xSpacing * ySpacing);
+            }
+        }
 
-            irr::core::line3df ray; // Make a ray. This will start outside the mesh, looking in
-            ray.start.X = maxX + 0.1;
-            ray.start.Y = yTestPos;
-            ray.start.Z = zTestPos;
-            ray.end = ray.start;
-            ray.end.X = minX - 0.1;
+        // Grid from side to side
+        for (int i = 0; i < numberOfContactPoints.Z; i++)
+        {
+            for (int j = 0; j < numberOfContactPoints.Y; j++)
+            {
 
-            // Check the ray and add the contact point if it exists
-            addContactPointFromRay(ray, ySpacing * zSpacing);
-            // swap ray direction and check again
-            ray.start.X = minX - 0.1;
-            ray.end.X = maxX + 0.1;
-            addContactPointFromRay(ray, ySpacing * zSpacing);
+                irr::f32 zSpacing = (maxZ - minZ) / (irr::f32)(numberOfContactPoints.Z - 1);
+                irr::f32 ySpacing = (maxY - minY) / (irr::f32)(numberOfContactPoints.Y - 1);
+
+                irr::f32 zTestPos = minZ + (irr::f32)i * zSpacing;
+                irr::f32 yTestPos = minY + (irr::f32)j * ySpacing;
+
+                irr::core::line3df ray; // Make a ray. This will start outside the mesh, looking in
+                ray.start.X = maxX + 0.1;
+                ray.start.Y = yTestPos;
+                ray.start.Z = zTestPos;
+                ray.end = ray.start;
+                ray.end.X = minX - 0.1;
+
+                // Check the ray and add the contact point if it exists
+                addContactPointFromRay(ray, ySpacing * zSpacing);
+                // swap ray direction and check again
+                ray.start.X = minX - 0.1;
+                ray.end.X = maxX + 0.1;
+                addContactPointFromRay(ray, ySpacing * zSpacing);
+            }
         }
+
+        contactPointCache.save(contactPoints);
     }
 
     // We don't want to do further triangle selection with the ship, so set the selector to null
@@ -852,6 +866,31 @@ void OwnShip::setRateOfTurn(irr::f32 rateOfTurn) // Sets the rate of turn (used
     this->rateOfTurn = rateOfTurn;
 }
 
+void OwnShip::setMotionState(irr::f32 heading, irr::f32 axialSpeed, irr::f32 lateralSpeed, irr::f32 rateOfTurn)
+{
+    hdg = heading;
+    axialSpd = axialSpeed;
+    spd = axialSpeed;
+    lateralSpd = lateralSpeed;
+    this->rateOfTurn = rateOfTurn;
+}
+
+void OwnShip::setActuatorState(irr::f32 rudder, irr::f32 portEngine, irr::f32 stbdEngine, irr::f32 portAzimuthAngle, irr::f32 stbdAzimuthAngle)
+{
+    this->rudder = rudder;
+    this->portEngine = portEngine;
+    this->stbdEngine = stbdEngine;
+    this->portAzimuthAngle = portAzimuthAngle;
+    this->stbdAzimuthAngle = stbdAzimuthAngle;
+}
+
+void OwnShip::setAttitudeState(irr::f32 pitch, irr::f32 roll, irr::f32 waveHeightFiltered)
+{
+    this->pitch = pitch;
+    this->roll = roll;
+    this->waveHeightFiltered = waveHeightFiltered;
+}
+
 irr::f32 OwnShip::getRateOfTurn() const
 {
     return rateOfTurn;
@@ -1368,6 +1407,11 @@ irr::f32 OwnShip::getRoll() const
     return roll;
 }
 
+irr::f32 OwnShip::getWaveHeightFiltered() const
+{
+    return waveHeightFiltered;
+}
+
 std::string OwnShip::getBasePath() const
 {
     return basePath;
@@ -1684,6 +1728,11 @@ irr::f32 OwnShip::getShipMass() const
     return shipMass;
 }
 
+irr::f32 OwnShip::getShipInertia() const
+{
+    return Izz;
+}
+
 irr::f32 OwnShip::getScaleFactor() const
 {
     return scaleFactor;
@@ -2464,25 +2513,50 @@ void OwnShip::collisionDetectAndRespond(irr::f32 &reaction, irr::f32 &lateralRea
         rot.setRotationDegrees(ship->getRotation());
         irr::core::vector3df shipAbsolutePosition = ship->getAbsolutePosition();
 
-        for (int i = 0; i < contactPoints.size(); i++)
+        // Rays from inside the hull out to each contact point, in world coordinates
+        contactRays.resize(contactPoints.size());
+        irr::f32 contactRadiusSQ = 0;
+        for (std::vector<ContactPoint>::size_type i = 0; i < contactPoints.size(); i++)
         {
             irr::core::vector3df pointPosition = contactPoints.at(i).position;
-            irr::core::vector3df pointPositionForNormal = pointPosition + contactPoints.at(i).normal;
             irr::core::vector3df internalPointPosition = contactPoints.at(i).internalPosition;
-
-            // Rotate with own ship
             rot.transformVect(pointPosition);
-            rot.transformVect(pointPositionForNormal);
             rot.transformVect(internalPointPosition);
+            contactRadiusSQ = std::max(contactRadiusSQ, std::max(pointPosition.getLengthSQ(), internalPointPosition.getLengthSQ()));
+            contactRays.at(i) = irr::core::line3d<irr::f32>(internalPointPosition + shipAbsolutePosition, pointPosition + shipAbsolutePosition);
+        }
+
+        // Check contact with pickable scenery elements and other ships for all points together, only looking at objects near own ship
+        contactQuery.findNearbyNodes(device->getSceneManager(), shipAbsolutePosition, sqrt(contactRadiusSQ), IDFlag_IsPickable, ship);
+        contactQuery.getCollisionPoints(contactRays, contactHits);
 
-            pointPosition += shipAbsolutePosition;
+        // Terrain height below all points together
+        contactPointX.resize(contactPoints.size());
+        contactPointZ.resize(contactPoints.size());
+        contactTerrainHeights.resize(contactPoints.size());
+        for (std::vector<ContactPoint>::size_type i = 0; i < contactPoints.size(); i++)
+        {
+            contactPointX.at(i) = contactRays.at(i).end.X;
+            contactPointZ.at(i) = contactRays.at(i).end.Z;
+        }
+        if (!contactPoints.empty())
+        {
+            terrain->getHeights(&contactPointX[0], &contactPointZ[0], &contactTerrainHeights[0], contactPoints.size());
+        }
+
+        for (std::vector<ContactPoint>::size_type i = 0; i < contactPoints.size(); i++)
+        {
+            irr::core::vector3df pointPosition = contactRays.at(i).end;
+            irr::core::vector3df pointPositionForNormal = contactPoints.at(i).position + contactPoints.at(i).normal;
+
+            // Rotate with own ship
+            rot.transformVect(pointPositionForNormal);
             pointPositionForNormal += shipAbsolutePosition;
-            internalPointPosition += shipAbsolutePosition;
 
             irr::f32 localIntersection = 0; // Ready to use
 
             // Find depth below the contact point
-            irr::f32 localDepth = -1 * terrain->getHeight(pointPosition.X, pointPosition.Z) + pointPosition.Y;
+            irr::f32 localDepth = -1 * contactTerrainHeights.at(i) + pointPosition.Y;
 
             // Contact model (proof of principle!)
             if (localDepth < 0)
@@ -2493,17 +2567,10 @@ void OwnShip::collisionDetectAndRespond(irr::f32 &reaction, irr::f32 &lateralRea
             irr::f32 remotePointAxialSpeed = 0;
             irr::f32 remotePointLateralSpeed = 0;
 
-            // Also check contact with pickable scenery elements here (or other ships?)
-            irr::core::line3d<irr::f32> ray(internalPointPosition, pointPosition);
-            irr::core::vector3df intersection;
-            irr::core::triangle3df hitTriangle;
-            irr::scene::ISceneNode *selectedSceneNode =
-                device->getSceneManager()->getSceneCollisionManager()->getSceneNodeAndCollisionPointFromRay(
-                    ray,
-                    intersection,      // This will be the position of the collision
-                    hitTriangle,       // This will be the triangle hit in the collision
-                    IDFlag_IsPickable, // (bitmask)
-                    0);                // Check all nodes
+            // Contact with pickable scenery elements or other ships, found above
+            irr::core::vector3df intersection = contactHits.at(i).intersection;
+            irr::core::triangle3df hitTriangle = contactHits.at(i).triangle;
+            irr::scene::ISceneNode *selectedSceneNode = contactHits.at(i).node;
 
             // Check normal directions of contact triangle  - if they are pointing in the same direction, then we are on the 'free' side of the contact, and can ignore it
             if (selectedSceneNode)
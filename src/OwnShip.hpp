@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "Ship.hpp"
+#include "ContactQuery.hpp"
 
 // Forward declarations
 class SimulationModel;
@@ -73,6 +74,9 @@ public:
         void setBowThruster(irr::f32 proportion);                     // Set the bow thruster, (-ve port, +ve stbd), range is +-1. This method limits the range applied
         void setSternThruster(irr::f32 proportion);                   // Set the bow thruster, (-ve port, +ve stbd), range is +-1. This method limits the range applied
         void setRateOfTurn(irr::f32 rateOfTurn);                      // Sets the rate of turn (used when controlled as secondary)
+        void setMotionState(irr::f32 heading, irr::f32 axialSpeed, irr::f32 lateralSpeed, irr::f32 rateOfTurn); // Restores heading (deg), speeds (m/s) and rate of turn, without changing control mode (used when replaying a session)
+        void setActuatorState(irr::f32 rudder, irr::f32 portEngine, irr::f32 stbdEngine, irr::f32 portAzimuthAngle, irr::f32 stbdAzimuthAngle); // Restores the actual rudder (deg), engines (+-1) and azimuth angles (deg), bypassing the rate limits (used when replaying a session)
+        void setAttitudeState(irr::f32 pitch, irr::f32 roll, irr::f32 waveHeightFiltered); // Restores pitch, roll (deg) and filtered wave height (m) (used when replaying a session)
         void setBowThrusterRate(irr::f32 bowThrusterRate);            // Sets the rate of increase of bow thruster, used for joystick button control
         void setSternThrusterRate(irr::f32 sternThrusterRate);        // Sets the rate of increase of stern thruster, used for joystick button control
         void setRudderPumpState(int whichPump, bool rudderPumpState); // Sets how the rudder is responding. Assumes that whichPump can be 1 or 2
@@ -92,6 +96,7 @@ public:
         irr::f32 getStbdAzimuthAngle() const; // degrees
         irr::f32 getPitch() const;
         irr::f32 getRoll() const;
+        irr::f32 getWaveHeightFiltered() const; // m
         irr::f32 getCOG() const;
         irr::f32 getSOG() const; // m/s
         irr::f32 getSpeedThroughWater() const; // m/s
@@ -153,6 +158,7 @@ public:
         bool isBuoyCollision() const;
         bool isOtherShipCollision() const;
         irr::f32 getShipMass() const;
+        irr::f32 getShipInertia() const; // About the vertical axis
         irr::f32 getScaleFactor() const;
 
         void enableTriangleSelector(bool selectorEnabled);
@@ -334,6 +340,12 @@ private:
         bool otherShipCollision;
 
         std::vector<ContactPoint> contactPoints;
+        ContactQuery contactQuery;                        // Finds where the contact points hit other objects
+        std::vector<irr::core::line3df> contactRays;      // Working storage for contact checks, one per contact point
+        std::vector<ContactQuery::Hit> contactHits;
+        std::vector<irr::f32> contactPointX;
+        std::vector<irr::f32> contactPointZ;
+        std::vector<irr::f32> contactTerrainHeights;
 
         irr::f32 contactStiffnessFactor;
         irr::f32 contactDampingFactor;
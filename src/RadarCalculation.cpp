@@ -21,6 +21,8 @@
 #include "Buoys.hpp"
 #include "OtherShips.hpp"
 #include "RadarData.hpp"
+#include "RadarLineProcessing.hpp"
+#include "SpatialIndex.hpp"
 #include "Angles.hpp"
 #include "Constants.hpp"
 #include "IniFile.hpp"
@@ -38,6 +40,28 @@
 #define IPROF(a) //intentionally empty placeholder
 #endif
 
+const irr::f32 RADAR_RPM = 25; //Todo: Make a ship parameter
+const irr::f32 RPMtoDEGPERSECOND = 6;
+
+//Regions of the radar image. An empty region is not valid (isValid() returns false)
+static irr::core::rect<irr::s32> emptyRegion()
+{
+    return irr::core::rect<irr::s32>(0,0,-1,-1);
+}
+
+static void addToRegion(irr::core::rect<irr::s32>& region, const irr::core::rect<irr::s32>& toAdd)
+{
+    if (!toAdd.isValid()) {
+        return;
+    }
+    if (!region.isValid()) {
+        region = toAdd;
+    } else {
+        region.addInternalPoint(toAdd.UpperLeftCorner);
+        region.addInternalPoint(toAdd.LowerRightCorner);
+    }
+}
+
 ////using namespace irr;
 
 RadarCalculation::RadarCalculation() : rangeResolution(128), angularResolution(360)
@@ -80,14 +104,34 @@ RadarCalculation::RadarCalculation() : rangeResolution(128), angularResolution(3
 
     radarScreenStale = true;
     radarRadiusPx = 10; //Set to an arbitrary value initially, will be set later.
+    renderedLineOffset = 0;
+    wholeImageChanged = true;
+    overlayRegion = emptyRegion();
+    changedRegion = emptyRegion();
+    colourLookup.assign(RADAR_COLOUR_LEVELS, 0);
 
-    currentScanAngle = 0;
     currentScanLine  = 0;
+    filterEndStep7 = 1;
+    filterEndStep5 = 1;
+    filterEndStep3 = 1;
+
+    randomSeed = 0;
+    threadedScan = false;
+    radarWorkerStop = false;
+    radarWorkerInputReady = false;
 }
 
 RadarCalculation::~RadarCalculation()
 {
-    //dtor
+    //Stop the radar worker thread, if running
+    if (radarWorkerThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(radarWorkerMutex);
+            radarWorkerStop = true;
+        }
+        radarWorkerCondition.notify_all();
+        radarWorkerThread.join();
+    }
 }
 
 void RadarCalculation::load(std::string radarConfigFile, irr::IrrlichtDevice* dev)
@@ -104,6 +148,14 @@ void RadarCalculation::load(std::string radarConfigFile, irr::IrrlichtDevice* de
     angularResolution = IniFile::iniFileTou32(iniFilename, "RADAR_AngularRes", angularResolution);
     irr::u32 rangeResolution_max = IniFile::iniFileTou32(iniFilename, "RADAR_RangeRes_Max");
     irr::u32 angularResolution_max = IniFile::iniFileTou32(iniFilename, "RADAR_AngularRes_Max");
+    threadedScan = (IniFile::iniFileTou32(iniFilename, "RADAR_Threaded") == 1);
+
+    //Seed radar noise. If not set, use the global random number generator (seeded from the time at startup)
+    irr::u32 radarSeed = IniFile::iniFileTou32(iniFilename, "RADAR_Seed");
+    if (radarSeed == 0) {
+        radarSeed = rand();
+    }
+    setRandomSeed(radarSeed);
     
     //Load parameters from the radarConfig file (if it exists)
     irr::u32 numberOfRadarRanges = IniFile::iniFileTou32(radarConfigFile,"NumberOfRadarRanges");
@@ -239,23 +291,28 @@ void RadarCalculation::load(std::string radarConfigFile, irr::IrrlichtDevice* de
     }
 
     //initialise scanArray size (angularResolution x rangeResolution points per scan)
-    scanArray.resize(angularResolution,std::vector<irr::f32>(rangeResolution,0.0));
-    scanArrayAmplified.resize(angularResolution,std::vector<irr::f32>(rangeResolution,0.0));
-    scanArrayToPlot.resize(angularResolution,std::vector<irr::f32>(rangeResolution,0.0));
-    scanArrayToPlotPrevious.resize(angularResolution,std::vector<irr::f32>(rangeResolution,0.0));
+    scanArray.resize(angularResolution,rangeResolution,0,0.0);
+    scanArrayAmplified.resize(angularResolution,rangeResolution,3,0.0); //3 wrap lines each side for the angular filter
+    scanArrayToPlot.resize(angularResolution,rangeResolution,0,0.0);
     toReplot.resize(angularResolution);
 
-    //initialise arrays
-    for(irr::u32 i = 0; i<angularResolution; i++) {
-        for(irr::u32 j = 0; j<rangeResolution; j++) {
-            scanArray[i][j] = 0.0;
-            scanArrayAmplified[i][j] = 0.0;
-            scanArrayToPlot[i][j] = 0.0;
-            scanArrayToPlotPrevious[i][j] = -1.0;
-        }
-    }
+    //Steps covered by each width of angular filter, widest close in
+    filterEndStep7 = 1;
+    while (filterEndStep7 < rangeResolution && filterEndStep7 < rangeResolution * 0.1) {filterEndStep7++;}
+    filterEndStep5 = filterEndStep7;
+    while (filterEndStep5 < rangeResolution && filterEndStep5 < rangeResolution * 0.2) {filterEndStep5++;}
+    filterEndStep3 = filterEndStep5;
+    while (filterEndStep3 < rangeResolution && filterEndStep3 < rangeResolution * 0.3) {filterEndStep3++;}
 
     scanAngleStep = 360.0f / (irr::f32) angularResolution;
+
+    //Start a worker thread to do the scanning, if required
+    if (threadedScan && !radarWorkerThread.joinable()) {
+        scanArrayToPlotBack = scanArrayToPlot;
+        scanArrayToPlotPublished = scanArrayToPlot;
+        linePublished.assign(angularResolution, false);
+        radarWorkerThread = std::thread(&RadarCalculation::radarWorker, this);
+    }
 }
 
 void RadarCalculation::decreaseRange()
@@ -517,17 +574,33 @@ bool RadarCalculation::getHeadUp() const//Head or course up
     return headUp;
 }
 
+void RadarCalculation::setRandomSeed(irr::u32 seed)
+{
+    //Separate generators for the scan (which may be on the worker thread) and ARPA (on the main thread)
+    pauseWorker();
+    randomSeed = seed;
+    scanRandom.seed(seed);
+    arpaRandom.seed((uint64_t)seed + 1);
+    resumeWorker();
+}
+
+irr::u32 RadarCalculation::getRandomSeed() const
+{
+    return randomSeed;
+}
+
+irr::core::rect<irr::s32> RadarCalculation::getChangedRegion() const
+{
+    return changedRegion;
+}
+
 void RadarCalculation::toggleRadarOn()
 {
 	radarOn = !radarOn;
 
 	if (!radarOn) {
 		//Reset array to empty
-		for (irr::u32 i = 0; i < angularResolution; i++) {
-			for (irr::u32 j = 0; j < rangeResolution; j++) {
-				scanArrayToPlot[i][j] = 0.0;
-			}
-		}
+		scanArrayToPlot.fill(0.0);
         radarScreenStale = true;
 	}
 }
@@ -558,6 +631,8 @@ void RadarCalculation::setArpaMode(int mode)
                 arpaContacts.erase(arpaContacts.begin() + i);
             }
         }
+        // Only manual contacts remain, and these aren't indexed
+        arpaContactIndex.clear();
         arpaTracks.clear(); // This will be regenerated as we have set display ID to 0
     }
 }
@@ -634,7 +709,7 @@ void RadarCalculation::changeRadarColourChoice()
     radarScreenStale = true;
 }
 
-void RadarCalculation::update(irr::video::IImage * radarImage, irr::video::IImage * radarImageOverlaid, irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime, irr::core::vector2di mouseRelPosition, bool isMouseDown)
+void RadarCalculation::update(irr::video::IImage * radarImage, irr::video::IImage * radarImageOverlaid, irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime, irr::core::vector2di mouseRelPosition, bool isMouseDown)
 {
 
     #ifdef WITH_PROFILING
@@ -646,12 +721,10 @@ void RadarCalculation::update(irr::video::IImage * radarImage, irr::video::IImag
     //Reset screen if needed
     if(radarScreenStale) {
         radarImage->fill(irr::video::SColor(255, 128, 128, 128)); //Fill with background colour
-        //Reset 'previous' array so it will all get re-drawn
+        wholeImageChanged = true;
+        //Mark all lines so they will all get re-drawn
         for(irr::u32 i = 0; i<angularResolution; i++) {
             toReplot[i] = true;
-            for(irr::u32 j = 0; j<rangeResolution; j++) {
-                scanArrayToPlotPrevious[i][j] = -1.0;
-            }
         }
         radarScreenStale = false;
     }
@@ -682,7 +755,11 @@ void RadarCalculation::update(irr::video::IImage * radarImage, irr::video::IImag
     CursorRangeNm = pow(pow(cursorRangeXNm,2)+pow(cursorRangeYNm,2),0.5);
 
     } { IPROF("Scan");
-    scan(offsetPosition, terrain, ownShip, buoys, otherShips, weather, rain, tideHeight, deltaTime, absoluteTime); // scan into scanArray[row (angle)][column (step)], and with filtering and amplification into scanArrayAmplified[][]
+    if (threadedScan) {
+        updateWorker(offsetPosition, terrain, ownShip, buoys, otherShips, spatialIndex, weather, rain, tideHeight, deltaTime, absoluteTime); // pass snapshot to the worker, and collect completed scan lines into scanArrayToPlot
+    } else {
+        scan(offsetPosition, terrain, ownShip, buoys, otherShips, spatialIndex, weather, rain, tideHeight, deltaTime, absoluteTime); // scan into scanArray[row (angle)][column (step)], and with filtering and amplification into scanArrayAmplified[][]
+    }
     } { IPROF("Update ARPA");
 	updateARPA(offsetPosition, ownShip, absoluteTime); //From data in arpaContacts, updated in scan()
 	} { IPROF("Render");
@@ -692,376 +769,628 @@ void RadarCalculation::update(irr::video::IImage * radarImage, irr::video::IImag
 }
 
 
-void RadarCalculation::scan(irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime)
+void RadarCalculation::getScanInput(RadarScanInput& input, irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime) const
+{
+    //Take a snapshot of everything the scan needs from the rest of the simulation
+
+    input.position = ownShip.getPosition();
+    //Get absolute position relative to SW corner of world model
+    input.offsetPosition = offsetPosition;
+    input.absolutePosition = offsetPosition;
+    input.absolutePosition.X += input.position.X;
+    input.absolutePosition.Y += input.position.Y;
+    input.absolutePosition.Z += input.position.Z;
+
+    input.terrain = &terrain;
+    input.weather = weather;
+    input.rain = rain;
+    input.tideHeight = tideHeight;
+    input.scanTime = deltaTime;
+    input.absoluteTime = absoluteTime;
+
+    input.rangeNm = radarRangeNm.at(radarRangeIndex); //Assume that radarRangeIndex is in bounds
+    input.gain = radarGain;
+    input.seaClutterReduction = radarSeaClutterReduction;
+    input.rainClutterReduction = radarRainClutterReduction;
+    input.arpaMode = arpaMode;
+
+    //Load radar data for other contacts, ignoring any entirely beyond the current range
+    irr::f32 maxScanRange = M_IN_NM*input.rangeNm*(rangeResolution - 0.5)/rangeResolution;
+    input.radarData.clear();
+    //Only other ships and buoys near enough to be in range are considered. These come back as other ships first, then buoys.
+    std::vector<SpatialIndex::Object> nearbyObjects;
+    spatialIndex.findInRange(input.position.X, input.position.Z, maxScanRange, nearbyObjects);
+    for (std::vector<SpatialIndex::Object>::size_type i = 0; i < nearbyObjects.size(); i++) {
+        RadarData thisRadarData;
+        if (nearbyObjects.at(i).type == E_SPATIAL_OTHER_SHIP) {
+            thisRadarData = otherShips.getRadarData(nearbyObjects.at(i).number + 1,input.position); //Contact IDs start from 1
+        } else {
+            thisRadarData = buoys.getRadarData(nearbyObjects.at(i).number + 1,input.position);
+        }
+        if (thisRadarData.range - 0.5*std::max(thisRadarData.length,thisRadarData.width) <= maxScanRange) {
+            input.radarData.push_back(thisRadarData);
+        }
+    }
+}
+
+void RadarCalculation::prepareScan(const RadarScanInput& input)
+{
+    //Rebuild cached cell geometry if range, resolution or controls have changed
+    const irr::f32 windDirectionDeg = 0; //FIXME: Needs wind direction
+    scanGeometry.update(input.rangeNm, angularResolution, rangeResolution, radarScannerHeight, input.gain, input.seaClutterReduction, input.rainClutterReduction, windDirectionDeg);
+
+    //Terrain samples are kept until the ship moves into a different cell
+    terrainCache.update(scanGeometry, angularResolution, rangeResolution, input.offsetPosition, input.position);
+
+    //Per sweep geometry for each contact, used to intersect it with each scan line
+    contactGeometry.resize(input.radarData.size());
+    for (unsigned int thisContact = 0; thisContact<input.radarData.size(); thisContact++) {
+        contactGeometry[thisContact] = getContactGeometry(input.radarData[thisContact]);
+    }
+
+    //Index the contacts by the scan lines they may appear on, so each scan line only checks nearby contacts.
+    //Done for each snapshot, as the contacts' bearings change whenever they or own ship move, but only touches the lines the contacts cover.
+    buildContactLineIndex(input.radarData);
+}
+
+void RadarCalculation::scan(irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime)
 {
 
     //IPROF_FUNC;
-    const irr::u32 SECONDS_BETWEEN_SCANS = 2;
+    getScanInput(scanInput, offsetPosition, terrain, ownShip, buoys, otherShips, spatialIndex, weather, rain, tideHeight, deltaTime, absoluteTime);
+    prepareScan(scanInput);
 
-    irr::core::vector3df position = ownShip.getPosition();
-    //Get absolute position relative to SW corner of world model
-    irr::core::vector3d<int64_t> absolutePosition = offsetPosition;
-    absolutePosition.X += position.X;
-    absolutePosition.Y += position.Y;
-    absolutePosition.Z += position.Z;
+    irr::u32 scansPerLoop = RADAR_RPM * RPMtoDEGPERSECOND * deltaTime / (irr::f32) scanAngleStep + scanRandom.uniform(); //Add random value (0-1, mean 0.5), so with rounding, we get the correct radar speed, even though we can only do an integer number of scans
+
+    if (scansPerLoop > 30) {scansPerLoop = 30;} //Limit to reasonable bounds
+    scanDetections.clear();
+    for(irr::u32 i = 0; i<scansPerLoop;i++) { //Start of repeatable scan section
+        irr::u32 plottedLine = scanLine(scanInput, terrain, scanArrayToPlot, scanDetections);
+        toReplot[plottedLine] = true;
+    } //End of repeatable scan section
+
+    //Add any detected contacts to ARPA
+    for (unsigned int i = 0; i<scanDetections.size(); i++) {
+        addArpaScan(scanDetections[i]);
+    }
+
+}
+
+void RadarCalculation::updateWorker(irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime)
+{
+    //Build the snapshot outside the lock, as this reads all contacts
+    getScanInput(scanInput, offsetPosition, terrain, ownShip, buoys, otherShips, spatialIndex, weather, rain, tideHeight, deltaTime, absoluteTime);
+
+    scanDetections.clear();
+    {
+        std::lock_guard<std::mutex> lock(radarWorkerMutex);
+
+        //Hand over the snapshot. If the worker hasn't picked up the previous one, accumulate the time to scan
+        irr::f32 outstandingScanTime = radarWorkerInput.scanTime;
+        std::swap(radarWorkerInput, scanInput);
+        radarWorkerInput.scanTime += outstandingScanTime;
+        radarWorkerInputReady = true;
+
+        //Collect completed scan lines
+        for (irr::u32 i = 0; i < angularResolution; i++) {
+            if (linePublished[i]) {
+                scanArrayToPlot.copyLine(scanArrayToPlotPublished, i);
+                toReplot[i] = true;
+                linePublished[i] = false;
+            }
+        }
+        std::swap(scanDetections, publishedDetections);
+    }
+    radarWorkerCondition.notify_one();
+
+    //Add any detected contacts to ARPA
+    for (unsigned int i = 0; i<scanDetections.size(); i++) {
+        addArpaScan(scanDetections[i]);
+    }
+}
+
+irr::u32 RadarCalculation::scanLine(const RadarScanInput& input, const Terrain& terrain, RadarScanArray& plotArray, std::vector<RadarDetection>& detections)
+{
+    //Scan the current scan line into scanArray and scanArrayAmplified, and the filtered line behind it into plotArray. Detected contacts are added to detections.
+    //This may be called from the radar worker thread, so must only use the input snapshot, and state that the main thread does not change.
 
     //Some tuning constants
     irr::f32 radarFactorLand=2.0;
     irr::f32 radarFactorVessel=0.0001;
 
-    //Convert range to cell size
-    irr::f32 cellLength = M_IN_NM*radarRangeNm.at(radarRangeIndex)/rangeResolution; ; //Assume that radarRangeIndex is in bounds
+    irr::f32 cellLength = scanGeometry.getCellLength();
+    irr::f32 rainFilter = scanGeometry.getRainFilter();
+
+    //Intersect each contact with this scan line once, to find which steps it covers. These are sorted by their first step.
+    lineContactIntervals.clear();
+    const std::vector<irr::u32>& lineContacts = contactLineIndex[currentScanLine];
+    const irr::u32 numberOfLineContacts = lineContacts.size() + allLineContacts.size();
+    for (unsigned int lineContact = 0; lineContact<numberOfLineContacts; lineContact++) {
+        irr::u32 thisContact = (lineContact < lineContacts.size()) ? lineContacts[lineContact] : allLineContacts[lineContact - lineContacts.size()];
+        RadarContactInterval contactInterval;
+        if (getContactInterval(input.radarData[thisContact], contactGeometry[thisContact], currentScanLine, contactInterval)) {
+            contactInterval.contactIndex = thisContact;
+            lineContactIntervals.push_back(contactInterval);
+        }
+    }
+    std::sort(lineContactIntervals.begin(), lineContactIntervals.end(), isContactIntervalBefore);
+    std::vector<RadarContactInterval>::size_type nextContactInterval = 0;
+    activeContactIntervals.clear();
+
+    //Scan line for the filtered output, lagging behind by 3 lines
+    irr::s32 filterAngle = (irr::s32)currentScanLine - 3;
+        while(filterAngle < 0) {filterAngle+=angularResolution;}
+        while(filterAngle >= angularResolution) {filterAngle-=angularResolution;}
+
+    irr::f32* rawLine = scanArray[currentScanLine];
+    const irr::f32* terrainLine = terrainCache.getLine(terrain, scanGeometry, currentScanLine); //Terrain height for each step
+    irr::f32 scanSlope = -0.5; //Slope at start of scan (in metres/metre) - Make slightly negative so vessel contacts close in get detected
+    for (irr::u32 currentStep = 1; currentStep<rangeResolution; currentStep++) { //Note that currentStep starts as 1, not 0. This is used in anti-rain clutter filter, which checks element at currentStep-1
+        //scan into array, accessed as  scanArray[row (angle)][column (step)]
+
+        //Clear old value
+        rawLine[currentStep] = 0.0;
+
+        //Get range of area being scanned
+        irr::f32 localRange = scanGeometry.stepRange[currentStep];
+
+        //get adjustment of height for earth's curvature, plus scanner height
+        irr::f32 heightCorrection = scanGeometry.stepHeightCorrection[currentStep];
+
+        //Calculate noise
+        irr::f32 localNoise = radarNoise(radarNoiseLevel,radarSeaClutter,radarRainClutter,input.weather,currentScanLine,currentStep,scanSlope,input.rain);
+
+        //Update the contacts covering this step: Add any that start here, and remove any that have ended
+        while (nextContactInterval < lineContactIntervals.size() && lineContactIntervals[nextContactInterval].minStep <= currentStep) {
+            activeContactIntervals.push_back(nextContactInterval);
+            nextContactInterval++;
+        }
+
+        //Scan other contacts here
+        for (unsigned int activeIndex = 0; activeIndex<activeContactIntervals.size();) {
+            const RadarContactInterval& contactInterval = lineContactIntervals[activeContactIntervals[activeIndex]];
+            if (contactInterval.maxStep < currentStep) {
+                //Finished with this one, so remove it (order doesn't matter)
+                activeContactIntervals[activeIndex] = activeContactIntervals.back();
+                activeContactIntervals.pop_back();
+                continue;
+            }
+            activeIndex++;
+
+            const RadarData& thisRadarData = input.radarData[contactInterval.contactIndex];
+            irr::f32 contactHeightAboveLine = (thisRadarData.height - heightCorrection) - scanSlope*localRange;
+            if (contactHeightAboveLine > 0) {
+                //Contact is in this cell, and visible
+                irr::f32 radarEchoStrength = radarFactorVessel * scanGeometry.stepVesselFactor[currentStep] * thisRadarData.rcs;
+                rawLine[currentStep] += radarEchoStrength;
+
+                // ARPA mode - 0: Off/Manual, 1: MARPA, 2: ARPA
+                if (input.arpaMode > 0 && radarEchoStrength*2 > localNoise) {
+                    //Contact is detectable in noise, pass on to be added to ARPA
+                    RadarDetection detection;
+                    detection.contact = thisRadarData.contact;
+                    detection.angle = thisRadarData.angle;
+                    detection.range = thisRadarData.range;
+                    detection.scannerPosition = input.absolutePosition;
+                    detection.timeStamp = input.absoluteTime;
+                    detections.push_back(detection);
+                }
+                //Todo: Also check for contacts beyond the current scan range.
+
+                /*
+                ;check how visible against noise/clutter. If visible, record as detected for ARPA tracking
+                If radarEchoStrength#*2 > radarNoiseValueNoBlock(radarNoiseLevel#, radarSeaClutter#, radarRainClutter#, weather#, AllRadarTargets(i)\range, rainIntensity)
+
+                    ;DebugLog "Contact:"
+                    ;DebugLog Str(radarNoiseValueNoBlock(radarNoiseLevel#, radarSeaClutter#, radarRainClutter#, weather#, AllRadarTargets(i)\range, rainIntensity))
+                    ;DebugLog radarEchoStrength#*2
+
+                    contactLastDetected(i) = absolute_time
+                EndIf
+
+                RadarIntensity#(Int(radarBrg#),RadarCurrentStep) = RadarIntensity#(Int(radarBrg#),RadarCurrentStep) + radarEchoStrength# ;add target reflection to array
+
+                ;RACON code
+                ;make an echo line behind the contact
+                If AllRadarTargets(i)\racon <> ""
+
+                    If Float(time#+AllRadarTargets(i)\raconOffsetTime) Mod 60 <= RaconOnTime# ;Show for RaconOnTime# seconds per minute
+
+                        Local raconEchoStrength# = radarFactorRACON * (1852/radarRange#)^2;RACON/SART goes with inverse square law as we are receiving the direct signal, not echo
+
+                        ;set start point for racon echo (global variable)
+                        raconCurrentStep = RadarCurrentStep
+
+                        addRaconString(raconEchoStrength, radarBrg#, 750, radarStep#, AllRadarTargets(i)\racon$)
+
+                    EndIf
+
+                EndIf
+                */
+
+                //if a target entirely covers the angle of a cell, then use its blocking height and increase radarHeight, so it blocks reflections from behind
+                if (contactInterval.blocksLine) {
+                    //reset scanSlope to new value if the solid height is higher
+                    scanSlope = std::max(scanSlope,(thisRadarData.solidHeight-heightCorrection)/localRange);
+                }
+            }
+        }
+
+        //Add land scan
+        irr::f32 terrainHeightAboveSea = terrainLine[currentStep] - input.tideHeight;
+        irr::f32 radarHeight = terrainHeightAboveSea - heightCorrection;
+        irr::f32 localSlope = radarHeight/localRange;
+        irr::f32 heightAboveLine = radarHeight - scanSlope*localRange; //Find height above previous maximum scan slope
 
-    //Load radar data for other contacts
-    std::vector<RadarData> radarData;
-    //For other ships
-    for (std::vector<RadarData>::size_type contactID=1; contactID<=otherShips.getNumber(); contactID++) {
-        radarData.push_back(otherShips.getRadarData(contactID,position));
+        if (heightAboveLine>0 && terrainHeightAboveSea>0) {
+            irr::f32 radarLocalGradient = heightAboveLine/cellLength;
+            scanSlope = localSlope; //Highest so far on scan
+            rawLine[currentStep] += radarFactorLand*std::atan(radarLocalGradient)*(2/PI)*scanGeometry.stepLandFactor[currentStep]; //make a reflection off a plane wall at 1nm have a magnitude of 1*radarFactorLand
+        }
+
+        //Add radar noise
+        rawLine[currentStep] += localNoise;
+
+    } //End of for loop scanning out
+
+    //Do amplification on the whole line: scanArrayAmplified between 0 and 1 will set displayed intensity. Rain filter and gain (including swept gain) are cached in scanGeometry
+    RadarLineProcessing::amplifyLine(rawLine, &scanGeometry.stepAmplification[0], rainFilter, scanArrayAmplified[currentScanLine], rangeResolution);
+    scanArrayAmplified.updateWrap(currentScanLine);
+
+    //Generate a filtered version, based on the angles around. Lag behind by 3 lines, so we can filter on what's ahead, as well as what's behind.
+    //The wrap lines in scanArrayAmplified mean filterAngle-3 to filterAngle+3 can be used directly. Amplified values are already clamped between 0 and 1.
+    const irr::f32* filterLines[7];
+    for (irr::s32 i = 0; i < 7; i++) {
+        filterLines[i] = scanArrayAmplified[filterAngle - 3 + i];
     }
-    //For buoys
-    for (std::vector<RadarData>::size_type contactID=1; contactID<=buoys.getNumber(); contactID++) {
-        radarData.push_back(buoys.getRadarData(contactID,position));
+    irr::f32* plotLine = plotArray[filterAngle];
+    RadarLineProcessing::maxOfLines(filterLines, 7, plotLine, 1, filterEndStep7); //Widest filter close in
+    RadarLineProcessing::maxOfLines(filterLines + 1, 5, plotLine, filterEndStep7, filterEndStep5);
+    RadarLineProcessing::maxOfLines(filterLines + 2, 3, plotLine, filterEndStep5, filterEndStep3);
+    RadarLineProcessing::maxOfLines(filterLines + 3, 1, plotLine, filterEndStep3, rangeResolution);
+
+    //Increment scan line for next time
+    currentScanLine++;
+    if (currentScanLine >= angularResolution) {
+        currentScanLine = 0;
     }
 
-    const irr::f32 RADAR_RPM = 25; //Todo: Make a ship parameter
-    const irr::f32 RPMtoDEGPERSECOND = 6;
-    irr::u32 scansPerLoop = RADAR_RPM * RPMtoDEGPERSECOND * deltaTime / (irr::f32) scanAngleStep + (irr::f32) rand() / RAND_MAX ; //Add random value (0-1, mean 0.5), so with rounding, we get the correct radar speed, even though we can only do an integer number of scans
+    return filterAngle;
+}
 
-    if (scansPerLoop > 30) {scansPerLoop = 30;} //Limit to reasonable bounds
-    for(irr::u32 i = 0; i<scansPerLoop;i++) { //Start of repeatable scan section
+void RadarCalculation::radarWorker()
+{
+    //Radar worker thread: Sweep at the radar's rotation rate, from the latest snapshot provided by update(), and publish completed scan lines
+    RadarScanInput workerInput;
+    std::vector<RadarDetection> workerDetections;
+    irr::f32 linesOutstanding = 0; //Fractional scan lines carried over between updates
+
+    while (true) {
+        {
+            //Wait for a new snapshot
+            std::unique_lock<std::mutex> lock(radarWorkerMutex);
+            while (!radarWorkerInputReady && !radarWorkerStop) {
+                radarWorkerCondition.wait(lock);
+            }
+            if (radarWorkerStop) {
+                return;
+            }
+            std::swap(workerInput, radarWorkerInput);
+            radarWorkerInput.scanTime = 0; //Time accumulated in workerInput is now being scanned
+            radarWorkerInputReady = false;
+        }
 
-        // the actual angle we want to work with has to be determined here
-        currentScanAngle = ((irr::f32) currentScanLine / (irr::f32) angularResolution) * 360.0f;
-
-        irr::f32 scanSlope = -0.5; //Slope at start of scan (in metres/metre) - Make slightly negative so vessel contacts close in get detected
-        for (irr::u32 currentStep = 1; currentStep<rangeResolution; currentStep++) { //Note that currentStep starts as 1, not 0. This is used in anti-rain clutter filter, which checks element at currentStep-1
-            //scan into array, accessed as  scanArray[row (angle)][column (step)]
-
-            //Clear old value
-            scanArray[currentScanLine][currentStep] = 0.0;
-
-            //Get location of area being scanned
-            irr::f32 localRange = cellLength*currentStep;
-            irr::f32 relX = localRange*sin(currentScanAngle*irr::core::DEGTORAD); //Distance from ship
-            irr::f32 relZ = localRange*cos(currentScanAngle*irr::core::DEGTORAD);
-            irr::f32 localX = position.X + relX;
-            irr::f32 localZ = position.Z + relZ;
-
-            //get extents
-            irr::f32 minCellAngle = Angles::normaliseAngle(currentScanAngle - scanAngleStep/2.0);
-            irr::f32 maxCellAngle = Angles::normaliseAngle(currentScanAngle + scanAngleStep/2.0);
-            irr::f32 minCellRange = localRange - cellLength/2.0;
-            irr::f32 maxCellRange = localRange + cellLength/2.0;
-
-            // Get extreme points
-            irr::f32 relXCorner1 = minCellRange*sin(minCellAngle*irr::core::DEGTORAD);
-            irr::f32 relXCorner2 = minCellRange*sin(maxCellAngle*irr::core::DEGTORAD);
-            irr::f32 relXCorner3 = maxCellRange*sin(minCellAngle*irr::core::DEGTORAD);
-            irr::f32 relXCorner4 = maxCellRange*sin(maxCellAngle*irr::core::DEGTORAD);
-            irr::f32 relZCorner1 = minCellRange*cos(minCellAngle*irr::core::DEGTORAD);
-            irr::f32 relZCorner2 = minCellRange*cos(maxCellAngle*irr::core::DEGTORAD);
-            irr::f32 relZCorner3 = maxCellRange*cos(minCellAngle*irr::core::DEGTORAD);
-            irr::f32 relZCorner4 = maxCellRange*cos(maxCellAngle*irr::core::DEGTORAD);
-
-            //get adjustment of height for earth's curvature
-            irr::f32 dropWithCurvature = std::pow(localRange,2)/(2*EARTH_RAD_M*EARTH_RAD_CORRECTION);
-
-            //Calculate noise
-            irr::f32 localNoise = radarNoise(radarNoiseLevel,radarSeaClutter,radarRainClutter,weather,localRange,currentScanAngle,0,scanSlope,rain); //FIXME: Needs wind direction
-
-            //Scan other contacts here
-            for(unsigned int thisContact = 0; thisContact<radarData.size(); thisContact++) {
-                irr::f32 contactHeightAboveLine = (radarData.at(thisContact).height - radarScannerHeight - dropWithCurvature) - scanSlope*localRange;
-                if (contactHeightAboveLine > 0) {
-                    //Contact would be visible if in this cell. Check if it is
-                    
-                    //Ellipse based check - check if any corner point of the cell is within the contact ellipse. If so, then it's definitely visible. If not, fall back to old checks
-                    bool contactEllipseFound = false;
-                    
-                    if (isPointInEllipse(relX, relZ, radarData.at(thisContact).relX, radarData.at(thisContact).relZ, radarData.at(thisContact).width, radarData.at(thisContact).length, radarData.at(thisContact).heading)) {
-                        contactEllipseFound = true;
-                    } else if (isPointInEllipse(relXCorner1, relZCorner1, radarData.at(thisContact).relX, radarData.at(thisContact).relZ, radarData.at(thisContact).width, radarData.at(thisContact).length, radarData.at(thisContact).heading)) {
-                        contactEllipseFound = true;
-                    } else if (isPointInEllipse(relXCorner2, relZCorner2, radarData.at(thisContact).relX, radarData.at(thisContact).relZ, radarData.at(thisContact).width, radarData.at(thisContact).length, radarData.at(thisContact).heading)) {
-                        contactEllipseFound = true;
-                    } else if (isPointInEllipse(relXCorner3, relZCorner3, radarData.at(thisContact).relX, radarData.at(thisContact).relZ, radarData.at(thisContact).width, radarData.at(thisContact).length, radarData.at(thisContact).heading)) {
-                        contactEllipseFound = true;
-                    } else if (isPointInEllipse(relXCorner4, relZCorner4, radarData.at(thisContact).relX, radarData.at(thisContact).relZ, radarData.at(thisContact).width, radarData.at(thisContact).length, radarData.at(thisContact).heading)) {
-                        contactEllipseFound = true;
-                    }
-                    
-
-                    //Start of B3D code
-                    //Check if centre of target within the cell. If not then check if Either min range or max range of contact is within the cell, or min and max span the cell
-                    if (contactEllipseFound 
-                            || (radarData.at(thisContact).range >= minCellRange && radarData.at(thisContact).range <= maxCellRange) 
-                            || (radarData.at(thisContact).minRange >= minCellRange && radarData.at(thisContact).minRange <= maxCellRange)
-                            || (radarData.at(thisContact).maxRange >= minCellRange && radarData.at(thisContact).maxRange <= maxCellRange) 
-                            || (radarData.at(thisContact).minRange < minCellRange && radarData.at(thisContact).maxRange > maxCellRange)) {
-
-                        //Check if centre of target within the cell. If not then check if either min angle or max angle of contact is within the cell, or min and max span the cell
-                        if (contactEllipseFound 
-                            || (Angles::isAngleBetween(radarData.at(thisContact).angle,minCellAngle,maxCellAngle)) 
-                            || (Angles::isAngleBetween(radarData.at(thisContact).minAngle,minCellAngle,maxCellAngle))
-                            || (Angles::isAngleBetween(radarData.at(thisContact).maxAngle,minCellAngle,maxCellAngle))
-                            || (Angles::normaliseAngle(radarData.at(thisContact).minAngle-minCellAngle) > 270 && Angles::normaliseAngle(radarData.at(thisContact).maxAngle-maxCellAngle) < 90)) {
-
-                            irr::f32 rangeAtCellMin = rangeAtAngle(minCellAngle,radarData.at(thisContact).relX,radarData.at(thisContact).relZ,radarData.at(thisContact).heading);
-                            irr::f32 rangeAtCellMax = rangeAtAngle(maxCellAngle,radarData.at(thisContact).relX,radarData.at(thisContact).relZ,radarData.at(thisContact).heading);
-
-                            //check if the contact intersects this exact cell, if its extremes overlap it
-                            //Also check if the target centre is in the cell, or the extended target spans the cell (ie RangeAtCellMin less than minCellRange and rangeAtCellMax greater than maxCellRange and vice versa)
-                            if (contactEllipseFound 
-                                    || (((radarData.at(thisContact).range >= minCellRange && radarData.at(thisContact).range <= maxCellRange) 
-                                            && (Angles::isAngleBetween(radarData.at(thisContact).angle,minCellAngle,maxCellAngle)))
-                                        || (rangeAtCellMin >= minCellRange && rangeAtCellMin <= maxCellRange)
-                                        || (rangeAtCellMax >= minCellRange && rangeAtCellMax <= maxCellRange)
-                                        || (rangeAtCellMin < minCellRange && rangeAtCellMax > maxCellRange)
-                                        || (rangeAtCellMax < minCellRange && rangeAtCellMin > maxCellRange))) {
-
-                                irr::f32 radarEchoStrength = radarFactorVessel * std::pow(M_IN_NM/localRange,4) * radarData.at(thisContact).rcs;
-                                scanArray[currentScanLine][currentStep] += radarEchoStrength;
-
-                                //Start ARPA section
-                                // ARPA mode - 0: Off/Manual, 1: MARPA, 2: ARPA
-                                if (arpaMode > 0 && radarEchoStrength*2 > localNoise) {
-                                    //Contact is detectable in noise
-
-                                    //Iterate through arpaContacts array, checking if this contact is in the list (by checking the if the 'contact' pointer is to the same underlying ship/buoy)
-                                    int existingArpaContact=-1;
-                                    for (unsigned int j = 0; j<arpaContacts.size(); j++) {
-                                        if (arpaContacts.at(j).contact == radarData.at(thisContact).contact) {
-                                            existingArpaContact = j;
-                                        }
-                                    }
-                                    //If it doesn't exist, add it, and make existingArpaContact point to it
-                                    if (existingArpaContact<0) {
-                                        ARPAContact newContact;
-                                        newContact.contact = radarData.at(thisContact).contact;
-                                        newContact.contactType=CONTACT_NORMAL;
-                                        //newContact.displayID = 0; //Initially not displayed
-                                        newContact.totalXMovementEst = 0;
-                                        newContact.totalZMovementEst = 0;
-
-                                        //Zeros for estimated state
-                                        newContact.estimate.displayID = 0;
-                                        newContact.estimate.stationary = true;
-                                        newContact.estimate.lost = false;
-                                        newContact.estimate.absVectorX = 0;
-                                        newContact.estimate.absVectorZ = 0;
-                                        newContact.estimate.absHeading = 0;
-                                        newContact.estimate.bearing = 0;
-                                        newContact.estimate.range = 0;
-                                        newContact.estimate.speed = 0;
-                                        newContact.estimate.contactType = newContact.contactType; //Redundant here, but useful to pass to the GUI later
-
-                                        arpaContacts.push_back(newContact);
-                                        existingArpaContact = arpaContacts.size()-1;
-                                        //std::cout << "Adding contact " << existingArpaContact << std::endl;
-                                    }
-                                    //Add this scan (if not already scanned in the last X seconds
-                                    size_t scansSize = arpaContacts.at(existingArpaContact).scans.size();
-                                    if (scansSize==0 || absoluteTime > SECONDS_BETWEEN_SCANS + arpaContacts.at(existingArpaContact).scans.at(scansSize-1).timeStamp) {
-                                        ARPAScan newScan;
-                                        newScan.timeStamp = absoluteTime;
-
-                                        //Add noise/uncertainty
-                                        irr::f32 angleUncertainty = scanAngleStep/2.0 * (2.0*(irr::f32)rand()/RAND_MAX - 1);
-                                        irr::f32 rangeUncertainty = rangeSensitivity * (2.0*(irr::f32)rand()/RAND_MAX - 1)/M_IN_NM;
-
-                                        newScan.bearingDeg = angleUncertainty + radarData.at(thisContact).angle;
-                                        newScan.rangeNm = rangeUncertainty + radarData.at(thisContact).range / M_IN_NM;
-
-                                        newScan.x = absolutePosition.X + newScan.rangeNm*M_IN_NM * sin(newScan.bearingDeg*RAD_IN_DEG);
-                                        newScan.z = absolutePosition.Z + newScan.rangeNm*M_IN_NM * cos(newScan.bearingDeg*RAD_IN_DEG);;
-                                        //newScan.estimatedRCS = 100;//Todo: Implement
-
-                                        //Keep track of estimated total movement if in full ARPA
-                                        // 0: Off/Manual, 1: MARPA, 2: ARPA
-                                        if (scansSize > 0 && arpaMode == 2) {
-                                            arpaContacts.at(existingArpaContact).totalXMovementEst += arpaContacts.at(existingArpaContact).scans.at(scansSize-1).x - newScan.x;
-                                            arpaContacts.at(existingArpaContact).totalZMovementEst += arpaContacts.at(existingArpaContact).scans.at(scansSize-1).z - newScan.z;
-                                        } else {
-                                            arpaContacts.at(existingArpaContact).totalXMovementEst = 0;
-                                            arpaContacts.at(existingArpaContact).totalZMovementEst = 0;
-                                        }
-
-                                        if (arpaContacts.at(existingArpaContact).estimate.stationary) {
-                                            // If stationary, don't keep previous scans (we are about to add the most recent)
-                                            arpaContacts.at(existingArpaContact).scans.clear();
-                                        }
-                                            
-                                        arpaContacts.at(existingArpaContact).scans.push_back(newScan);
-                                        //std::cout << "ARPA update on " << existingArpaContact << std::endl;
-                                        //Todo: should we limit the size of this, so it doesn't continue accumulating?
-
-                                    }
-
-
-                                } //End ARPA Section
-                                //Todo: Also check for contacts beyond the current scan range.
-
-                                /*
-                                ;check how visible against noise/clutter. If visible, record as detected for ARPA tracking
-                                If radarEchoStrength#*2 > radarNoiseValueNoBlock(radarNoiseLevel#, radarSeaClutter#, radarRainClutter#, weather#, AllRadarTargets(i)\range, rainIntensity)
-
-                                    ;DebugLog "Contact:"
-                                    ;DebugLog Str(radarNoiseValueNoBlock(radarNoiseLevel#, radarSeaClutter#, radarRainClutter#, weather#, AllRadarTargets(i)\range, rainIntensity))
-                                    ;DebugLog radarEchoStrength#*2
-
-                                    contactLastDetected(i) = absolute_time
-                                EndIf
-
-                                RadarIntensity#(Int(radarBrg#),RadarCurrentStep) = RadarIntensity#(Int(radarBrg#),RadarCurrentStep) + radarEchoStrength# ;add target reflection to array
-
-                                ;RACON code
-                                ;make an echo line behind the contact
-                                If AllRadarTargets(i)\racon <> ""
-
-                                    If Float(time#+AllRadarTargets(i)\raconOffsetTime) Mod 60 <= RaconOnTime# ;Show for RaconOnTime# seconds per minute
-
-                                        Local raconEchoStrength# = radarFactorRACON * (1852/radarRange#)^2;RACON/SART goes with inverse square law as we are receiving the direct signal, not echo
-
-                                        ;set start point for racon echo (global variable)
-                                        raconCurrentStep = RadarCurrentStep
-
-                                        addRaconString(raconEchoStrength, radarBrg#, 750, radarStep#, AllRadarTargets(i)\racon$)
-
-                                    EndIf
-
-                                EndIf
-                                */
-                                //if a target entirely covers the angle of a cell, then use its blocking height and increase radarHeight, so it blocks reflections from behind
-                                if ( Angles::normaliseAngle(radarData.at(thisContact).minAngle-minCellAngle) > 270 && Angles::normaliseAngle(radarData.at(thisContact).maxAngle-maxCellAngle) < 90) {
-                                    //reset scanSlope to new value if the solid height is higher
-                                    scanSlope = std::max(scanSlope,(radarData.at(thisContact).solidHeight-radarScannerHeight-dropWithCurvature)/localRange);
-
-                                }
-                            }
-
-
-                        }
-                    }
-                    //End of B3D code
-                }
+        //Hold the terrain in place until this snapshot's lines are done. See pauseWorker().
+        std::lock_guard<std::mutex> terrainLock(radarTerrainMutex);
+
+        prepareScan(workerInput);
+
+        //Scan at the real antenna rotation rate, whatever the frame rate. Limit to one full rotation.
+        linesOutstanding += RADAR_RPM * RPMtoDEGPERSECOND * workerInput.scanTime / scanAngleStep;
+        if (linesOutstanding > angularResolution) {
+            linesOutstanding = angularResolution;
+        }
+
+        while (linesOutstanding >= 1) {
+            linesOutstanding -= 1;
+            workerDetections.clear();
+            irr::u32 plottedLine = scanLine(workerInput, *workerInput.terrain, scanArrayToPlotBack, workerDetections);
+
+            //Publish the completed line
+            std::lock_guard<std::mutex> lock(radarWorkerMutex);
+            scanArrayToPlotPublished.copyLine(scanArrayToPlotBack, plottedLine);
+            linePublished[plottedLine] = true;
+            publishedDetections.insert(publishedDetections.end(), workerDetections.begin(), workerDetections.end());
+            if (radarWorkerStop) {
+                return;
             }
+        }
+    }
+}
+
+void RadarCalculation::pauseWorker()
+{
+    if (!radarWorkerThread.joinable()) {
+        return;
+    }
+    radarTerrainMutex.lock();
 
-            //Add land scan
-            irr::f32 terrainHeightAboveSea = terrain.getHeight(localX,localZ) - tideHeight;
-            irr::f32 radarHeight = terrainHeightAboveSea - dropWithCurvature - radarScannerHeight;
-            irr::f32 localSlope = radarHeight/localRange;
-            irr::f32 heightAboveLine = radarHeight - scanSlope*localRange; //Find height above previous maximum scan slope
+    //A snapshot not yet picked up was taken before the move, so would be scanned against moved terrain. Drop it, but keep its time to scan.
+    std::lock_guard<std::mutex> lock(radarWorkerMutex);
+    radarWorkerInputReady = false;
+}
+
+void RadarCalculation::resumeWorker()
+{
+    if (!radarWorkerThread.joinable()) {
+        return;
+    }
+    radarTerrainMutex.unlock();
+}
 
-            if (heightAboveLine>0 && terrainHeightAboveSea>0) {
-                irr::f32 radarLocalGradient = heightAboveLine/cellLength;
-                scanSlope = localSlope; //Highest so far on scan
-                scanArray[currentScanLine][currentStep] += radarFactorLand*std::atan(radarLocalGradient)*(2/PI)/std::pow(localRange/M_IN_NM,3); //make a reflection off a plane wall at 1nm have a magnitude of 1*radarFactorLand
+void RadarCalculation::buildContactLineIndex(const std::vector<RadarData>& radarData)
+{
+    //For each scan line, list the contacts whose bounding circle overlaps it. Assumes contactGeometry is up to date.
+    if (contactLineIndex.size() != angularResolution) {
+        contactLineIndex.assign(angularResolution, std::vector<irr::u32>());
+        indexedLines.clear();
+    }
+    for (std::vector<irr::u32>::size_type i = 0; i < indexedLines.size(); i++) {
+        contactLineIndex[indexedLines[i]].clear();
+    }
+    indexedLines.clear();
+    allLineContacts.clear();
+
+    for (unsigned int thisContact = 0; thisContact<radarData.size(); thisContact++) {
+        const RadarContactGeometry& geometry = contactGeometry[thisContact];
+
+        //Half width in scan lines, allowing for the width of the scan line itself
+        irr::f32 halfWidthLines = (geometry.angularHalfWidth + scanAngleStep/2.0)/scanAngleStep;
+        if (geometry.angularHalfWidth >= 180 || 2*halfWidthLines + 1 >= angularResolution) {
+            //Could be on any line
+            allLineContacts.push_back(thisContact);
+        } else {
+            irr::f32 centreLine = Angles::normaliseAngle(radarData[thisContact].angle)/scanAngleStep;
+            irr::s32 firstLine = std::floor(centreLine - halfWidthLines);
+            irr::s32 lastLine = std::ceil(centreLine + halfWidthLines);
+            for (irr::s32 line = firstLine; line <= lastLine; line++) {
+                irr::s32 wrappedLine = line % (irr::s32)angularResolution;
+                if (wrappedLine < 0) {
+                    wrappedLine += angularResolution;
+                }
+                if (contactLineIndex[wrappedLine].empty()) {
+                    indexedLines.push_back(wrappedLine);
+                }
+                contactLineIndex[wrappedLine].push_back(thisContact);
             }
+        }
+    }
+}
 
-            //Add radar noise
-            scanArray[currentScanLine][currentStep] += localNoise;
+RadarContactGeometry RadarCalculation::getContactGeometry(const RadarData& contact) const
+{
+    RadarContactGeometry geometry;
+
+    geometry.sinHeading = sin(contact.heading*irr::core::DEGTORAD);
+    geometry.cosHeading = cos(contact.heading*irr::core::DEGTORAD);
+    geometry.halfLength = contact.length/2.0;
+    geometry.halfWidth = contact.width/2.0;
+
+    //Bounding circle, used to quickly reject scan lines that can't intersect the contact
+    irr::f32 boundingRadius = std::max(geometry.halfLength, geometry.halfWidth);
+    geometry.closestRange = std::max(0.0f, contact.range - boundingRadius);
+    if (contact.range > boundingRadius) {
+        geometry.angularHalfWidth = irr::core::RADTODEG*std::asin(boundingRadius/contact.range);
+    } else {
+        //Scanner is within the bounding circle, so check all scan lines
+        geometry.angularHalfWidth = 180;
+    }
+
+    return geometry;
+}
 
-            //Do amplification: scanArrayAmplified between 0 and 1 will set displayed intensity, values above 1 will be limited at max intensity
+bool RadarCalculation::getContactInterval(const RadarData& contact, const RadarContactGeometry& geometry, irr::u32 scanLine, RadarContactInterval& contactInterval) const
+{
+    //Intersect the contact (an ellipse of its length and width, along its heading) with the sector covered by this scan line,
+    //and find the range of steps covered. Returns false if the contact is not on this scan line.
+
+    irr::f32 cellLength = scanGeometry.getCellLength();
+    irr::f32 maxScanRange = scanGeometry.stepMaxRange[rangeResolution-1];
+
+    //Quick checks against the bounding circle
+    if (geometry.closestRange > maxScanRange) {
+        return false;
+    }
+    if (geometry.angularHalfWidth < 180) {
+        irr::f32 angleFromLine = Angles::normaliseAngle(contact.angle - scanGeometry.lineAngle[scanLine]);
+        if (angleFromLine > 180) {
+            angleFromLine = 360 - angleFromLine;
+        }
+        if (angleFromLine > geometry.angularHalfWidth + scanAngleStep/2.0) {
+            return false;
+        }
+    }
 
-            //Calculate from parameters
-            //localRange is range in metres
-            irr::f32 rainFilter = pow(radarRainClutterReduction/100.0,0.1);
-            irr::f32 maxSTCdistance = 8*M_IN_NM*radarSeaClutterReduction/100.0; //This sets the distance at which the swept gain control becomes 1, and is 8Nm at full reduction
-            irr::f32 radarSTCGain;
-            if(maxSTCdistance>0) {
-                radarSTCGain = pow(localRange/maxSTCdistance,3);
-                if (radarSTCGain > 1) {radarSTCGain=1;} //Gain should never be increased (above 1.0)
+    //Scan line sector edges, and centre
+    irr::f32 raySin[3] = {scanGeometry.lineSinMin[scanLine], scanGeometry.lineSin[scanLine], scanGeometry.lineSinMax[scanLine]};
+    irr::f32 rayCos[3] = {scanGeometry.lineCosMin[scanLine], scanGeometry.lineCos[scanLine], scanGeometry.lineCosMax[scanLine]};
+
+    bool found = false;
+    irr::f32 minRange = 0;
+    irr::f32 maxRange = 0;
+
+    //Points on the contact which are within the sector: Centre, and ends of the keel line
+    irr::f32 pointX[3] = {contact.relX,
+                          contact.relX + geometry.halfLength*geometry.sinHeading,
+                          contact.relX - geometry.halfLength*geometry.sinHeading};
+    irr::f32 pointZ[3] = {contact.relZ,
+                          contact.relZ + geometry.halfLength*geometry.cosHeading,
+                          contact.relZ - geometry.halfLength*geometry.cosHeading};
+    for (unsigned int i = 0; i < 3; i++) {
+        //Check if the point is clockwise of the start edge, and anticlockwise of the end edge
+        if (rayCos[0]*pointX[i] - raySin[0]*pointZ[i] >= 0 && raySin[2]*pointZ[i] - rayCos[2]*pointX[i] >= 0) {
+            irr::f32 pointRange = std::sqrt(pointX[i]*pointX[i] + pointZ[i]*pointZ[i]);
+            if (!found) {
+                minRange = pointRange;
+                maxRange = pointRange;
+                found = true;
             } else {
-                radarSTCGain = 1;
+                minRange = std::min(minRange, pointRange);
+                maxRange = std::max(maxRange, pointRange);
             }
+        }
+    }
 
-            //calculate high pass filter
-            irr::f32 intensityGradient = scanArray[currentScanLine][currentStep] - scanArray[currentScanLine][currentStep-1];
-            if (intensityGradient<0) {intensityGradient=0;}
-
-            irr::f32 filteredSignal = intensityGradient*rainFilter + scanArray[currentScanLine][currentStep]*(1-rainFilter);
-            irr::f32 radarLocalGain = 500000*(8*pow(radarGain/100.0,4)) * radarSTCGain ;
-
-            //take log (natural) of signal
-            irr::f32 logSignal = log(filteredSignal*radarLocalGain);
-            scanArrayAmplified[currentScanLine][currentStep] = std::max(0.0f,logSignal);
-
-            //Generate a filtered version, based on the angles around. Lag behind by (for example) 3 steps, so we can filter on what's ahead, as well as what's behind
-            irr::s32 filterAngle = (irr::s32)currentScanLine - 3;
-                while(filterAngle < 0) {filterAngle+=angularResolution;}
-                while(filterAngle >= angularResolution) {filterAngle-=angularResolution;}
-            irr::s32 filterAngle_1 = filterAngle - 3;
-                while(filterAngle_1 < 0) {filterAngle_1+=angularResolution;}
-                while(filterAngle_1 >= angularResolution) {filterAngle_1-=angularResolution;}
-            irr::s32 filterAngle_2 = filterAngle - 2;
-                while(filterAngle_2 < 0) {filterAngle_2+=angularResolution;}
-                while(filterAngle_2 >= angularResolution) {filterAngle_2-=angularResolution;}
-            irr::s32 filterAngle_3 = filterAngle - 1;
-                while(filterAngle_3 < 0) {filterAngle_3+=angularResolution;}
-                while(filterAngle_3 >= angularResolution) {filterAngle_3-=angularResolution;}
-            irr::s32 filterAngle_4 = filterAngle;
-                while(filterAngle_4 < 0) {filterAngle_4+=angularResolution;}
-                while(filterAngle_4 >= angularResolution) {filterAngle_4-=angularResolution;}
-            irr::s32 filterAngle_5 = filterAngle + 1;
-                while(filterAngle_5 < 0) {filterAngle_5+=angularResolution;}
-                while(filterAngle_5 >= angularResolution) {filterAngle_5-=angularResolution;}
-            irr::s32 filterAngle_6 = filterAngle + 2;
-                while(filterAngle_6 < 0) {filterAngle_6+=angularResolution;}
-                while(filterAngle_6 >= angularResolution) {filterAngle_6-=angularResolution;}
-            irr::s32 filterAngle_7 = filterAngle + 3;
-                while(filterAngle_7 < 0) {filterAngle_7+=angularResolution;}
-                while(filterAngle_7 >= angularResolution) {filterAngle_7-=angularResolution;}
-            if (currentStep < rangeResolution * 0.1) {
-                scanArrayToPlot[filterAngle][currentStep] = std::max({
-                    scanArrayAmplified[filterAngle_1][currentStep],
-                    scanArrayAmplified[filterAngle_2][currentStep],
-                    scanArrayAmplified[filterAngle_3][currentStep],
-                    scanArrayAmplified[filterAngle_4][currentStep],
-                    scanArrayAmplified[filterAngle_5][currentStep],
-                    scanArrayAmplified[filterAngle_6][currentStep],
-                    scanArrayAmplified[filterAngle_7][currentStep]
-                });
-
-            } else if (currentStep < rangeResolution * 0.2) {
-                scanArrayToPlot[filterAngle][currentStep] = std::max({
-                    scanArrayAmplified[filterAngle_2][currentStep],
-                    scanArrayAmplified[filterAngle_3][currentStep],
-                    scanArrayAmplified[filterAngle_4][currentStep],
-                    scanArrayAmplified[filterAngle_5][currentStep],
-                    scanArrayAmplified[filterAngle_6][currentStep]
-                });
-            } else if (currentStep < rangeResolution * 0.3) {
-                scanArrayToPlot[filterAngle][currentStep] = std::max({
-                    scanArrayAmplified[filterAngle_3][currentStep],
-                    scanArrayAmplified[filterAngle_4][currentStep],
-                    scanArrayAmplified[filterAngle_5][currentStep],
-                });
-            } else {
-                scanArrayToPlot[filterAngle][currentStep] = scanArrayAmplified[filterAngle_4][currentStep];
+    //Intersections of the sector edges and centre line with the ellipse and the keel line
+    irr::f32 alongOffset = contact.relX*geometry.sinHeading + contact.relZ*geometry.cosHeading; //Contact centre, in contact's axes
+    irr::f32 acrossOffset = contact.relX*geometry.cosHeading - contact.relZ*geometry.sinHeading;
+    for (unsigned int i = 0; i < 3; i++) {
+        irr::f32 along = raySin[i]*geometry.sinHeading + rayCos[i]*geometry.cosHeading; //Ray direction, in contact's axes
+        irr::f32 across = raySin[i]*geometry.cosHeading - rayCos[i]*geometry.sinHeading;
+
+        irr::f32 hitRanges[3];
+        unsigned int numberOfHits = 0;
+
+        //Ellipse: ((t*along - alongOffset)/halfLength)^2 + ((t*across - acrossOffset)/halfWidth)^2 = 1
+        if (geometry.halfLength > 0 && geometry.halfWidth > 0) {
+            irr::f32 invLength2 = 1.0/(geometry.halfLength*geometry.halfLength);
+            irr::f32 invWidth2 = 1.0/(geometry.halfWidth*geometry.halfWidth);
+            irr::f32 a = along*along*invLength2 + across*across*invWidth2;
+            irr::f32 b = -2*(along*alongOffset*invLength2 + across*acrossOffset*invWidth2);
+            irr::f32 c = alongOffset*alongOffset*invLength2 + acrossOffset*acrossOffset*invWidth2 - 1;
+            irr::f32 discriminant = b*b - 4*a*c;
+            if (a > 0 && discriminant >= 0) {
+                irr::f32 root = std::sqrt(discriminant);
+                irr::f32 t1 = (-b - root)/(2*a);
+                irr::f32 t2 = (-b + root)/(2*a);
+                if (t2 >= 0) {
+                    hitRanges[numberOfHits++] = std::max(0.0f, t1);
+                    hitRanges[numberOfHits++] = t2;
+                }
             }
-            toReplot[filterAngle] = true;
+        }
 
-            //Clamp between 0 and 1
-            if (scanArrayToPlot[filterAngle][currentStep] < 0) {
-                scanArrayToPlot[filterAngle][currentStep] = 0;
+        //Keel line: t*ray = centre + lambda*heading, with lambda between -halfLength and halfLength
+        irr::f32 determinant = rayCos[i]*geometry.sinHeading - raySin[i]*geometry.cosHeading;
+        if (std::abs(determinant) > 0.0001) {
+            irr::f32 t = (contact.relZ*geometry.sinHeading - contact.relX*geometry.cosHeading)/determinant;
+            irr::f32 lambda = (raySin[i]*contact.relZ - rayCos[i]*contact.relX)/determinant;
+            if (t >= 0 && std::abs(lambda) <= geometry.halfLength) {
+                hitRanges[numberOfHits++] = t;
             }
-            if (scanArrayToPlot[filterAngle][currentStep] > 1) {
-                scanArrayToPlot[filterAngle][currentStep] = 1;
+        }
+
+        for (unsigned int j = 0; j < numberOfHits; j++) {
+            if (!found) {
+                minRange = hitRanges[j];
+                maxRange = hitRanges[j];
+                found = true;
+            } else {
+                minRange = std::min(minRange, hitRanges[j]);
+                maxRange = std::max(maxRange, hitRanges[j]);
             }
+        }
+    }
 
-        } //End of for loop scanning out
+    if (!found || minRange > maxScanRange) {
+        return false;
+    }
 
+    //Convert to steps: Step n covers (n-0.5)*cellLength to (n+0.5)*cellLength
+    irr::f32 minStep = std::ceil(minRange/cellLength - 0.5);
+    irr::f32 maxStep = std::floor(maxRange/cellLength + 0.5);
+    if (minStep < 1) {minStep = 1;}
+    if (maxStep > rangeResolution - 1) {maxStep = rangeResolution - 1;}
+    if (maxStep < minStep) {
+        return false;
+    }
+    contactInterval.minStep = minStep;
+    contactInterval.maxStep = maxStep;
+
+    //Check if the contact entirely covers the angle of the scan line
+    contactInterval.blocksLine = Angles::normaliseAngle(contact.minAngle-scanGeometry.lineMinAngle[scanLine]) > 270 && Angles::normaliseAngle(contact.maxAngle-scanGeometry.lineMaxAngle[scanLine]) < 90;
 
+    return true;
+}
+
+bool RadarCalculation::isContactIntervalBefore(const RadarContactInterval& first, const RadarContactInterval& second)
+{
+    return first.minStep < second.minStep;
+}
+
+void RadarCalculation::addArpaScan(const RadarDetection& detection)
+{
+    const irr::u32 SECONDS_BETWEEN_SCANS = 2;
 
-        //Increment scan line for next time
-        currentScanLine++;
-        if (currentScanLine >= angularResolution) {
-            currentScanLine = 0;
+    //Check if this contact is in the arpaContacts list (by checking the if the 'contact' pointer is to the same underlying ship/buoy)
+    int existingArpaContact=-1;
+    std::unordered_map<void*, irr::u32>::const_iterator indexEntry = arpaContactIndex.find(detection.contact);
+    if (indexEntry != arpaContactIndex.end()) {
+        existingArpaContact = indexEntry->second;
+    }
+    //If it doesn't exist, add it, and make existingArpaContact point to it
+    if (existingArpaContact<0) {
+        ARPAContact newContact;
+        newContact.contact = detection.contact;
+        newContact.contactType=CONTACT_NORMAL;
+        //newContact.displayID = 0; //Initially not displayed
+        newContact.totalXMovementEst = 0;
+        newContact.totalZMovementEst = 0;
+
+        //Zeros for estimated state
+        newContact.estimate.displayID = 0;
+        newContact.estimate.stationary = true;
+        newContact.estimate.lost = false;
+        newContact.estimate.absVectorX = 0;
+        newContact.estimate.absVectorZ = 0;
+        newContact.estimate.absHeading = 0;
+        newContact.estimate.bearing = 0;
+        newContact.estimate.range = 0;
+        newContact.estimate.speed = 0;
+        newContact.estimate.contactType = newContact.contactType; //Redundant here, but useful to pass to the GUI later
+
+        arpaContacts.push_back(newContact);
+        existingArpaContact = arpaContacts.size()-1;
+        arpaContactIndex[detection.contact] = existingArpaContact;
+        //std::cout << "Adding contact " << existingArpaContact << std::endl;
+    }
+    //Add this scan (if not already scanned in the last X seconds
+    size_t scansSize = arpaContacts.at(existingArpaContact).scans.size();
+    if (scansSize==0 || detection.timeStamp > SECONDS_BETWEEN_SCANS + arpaContacts.at(existingArpaContact).scans.at(scansSize-1).timeStamp) {
+        ARPAScan newScan;
+        newScan.timeStamp = detection.timeStamp;
+
+        //Add noise/uncertainty
+        irr::f32 angleUncertainty = scanAngleStep/2.0 * (2.0*arpaRandom.uniform() - 1);
+        irr::f32 rangeUncertainty = rangeSensitivity * (2.0*arpaRandom.uniform() - 1)/M_IN_NM;
+
+        newScan.bearingDeg = angleUncertainty + detection.angle;
+        newScan.rangeNm = rangeUncertainty + detection.range / M_IN_NM;
+
+        newScan.x = detection.scannerPosition.X + newScan.rangeNm*M_IN_NM * sin(newScan.bearingDeg*RAD_IN_DEG);
+        newScan.z = detection.scannerPosition.Z + newScan.rangeNm*M_IN_NM * cos(newScan.bearingDeg*RAD_IN_DEG);;
+        //newScan.estimatedRCS = 100;//Todo: Implement
+
+        //Keep track of estimated total movement if in full ARPA
+        // 0: Off/Manual, 1: MARPA, 2: ARPA
+        if (scansSize > 0 && arpaMode == 2) {
+            arpaContacts.at(existingArpaContact).totalXMovementEst += arpaContacts.at(existingArpaContact).scans.at(scansSize-1).x - newScan.x;
+            arpaContacts.at(existingArpaContact).totalZMovementEst += arpaContacts.at(existingArpaContact).scans.at(scansSize-1).z - newScan.z;
+        } else {
+            arpaContacts.at(existingArpaContact).totalXMovementEst = 0;
+            arpaContacts.at(existingArpaContact).totalZMovementEst = 0;
         }
-    } //End of repeatable scan section
 
+        if (arpaContacts.at(existingArpaContact).estimate.stationary) {
+            // If stationary, don't keep previous scans (we are about to add the most recent)
+            arpaContacts.at(existingArpaContact).clearScans();
+        }
 
+        //Only the most recent ARPA_SCAN_HISTORY scans are kept
+        arpaContacts.at(existingArpaContact).addScan(newScan);
+        //std::cout << "ARPA update on " << existingArpaContact << std::endl;
 
+    }
 }
 
 void RadarCalculation::addManualPoint(bool newContact, irr::core::vector3d<int64_t> offsetPosition, const OwnShip& ownShip, uint64_t absoluteTime)
@@ -1129,8 +1458,7 @@ void RadarCalculation::addManualPoint(bool newContact, irr::core::vector3d<int64
 
     //Don't need to keep track of totalXMovementEst and totalZMovementEst for manual
     
-    arpaContacts.at(existingArpaContact).scans.push_back(newScan);
-    //Todo: should we limit the size of this, so it doesn't continue accumulating?
+    arpaContacts.at(existingArpaContact).addScan(newScan);
 }
 
 void RadarCalculation::clearManualPoints()
@@ -1142,7 +1470,7 @@ void RadarCalculation::clearManualPoints()
 
     if (existingArpaContact >= 0) {
         // Found the contact, remove all scans. Estimate will be regenerated later.
-        arpaContacts.at(existingArpaContact).scans.clear();
+        arpaContacts.at(existingArpaContact).clearScans();
     }
 
 }
@@ -1176,8 +1504,11 @@ void RadarCalculation::clearTargetFromCursor()
     }
 
     if (closeContact >= 0 && closeContact < arpaContacts.size()) {
-        // Clear pointer to underlying contact, and mark as stationary
+        // Clear pointer to underlying contact, and mark as stationary. A new detection of the same ship/buoy will then start a new contact.
         arpaContacts.at(closeContact).estimate.stationary = true;
+        if (arpaContacts.at(closeContact).contact != 0) {
+            arpaContactIndex.erase(arpaContacts.at(closeContact).contact);
+        }
         arpaContacts.at(closeContact).contact = 0;
     }
 
@@ -1306,66 +1637,36 @@ void RadarCalculation::updateArpaEstimate(ARPAContact& thisArpaContact, int cont
                     }
                 }
 
-                irr::s32 stepsBack = 60; //Default time for tracking (time = stepsBack * SECONDS_BETWEEN_SCANS)
-                irr::s32 recentStepsBack = 10; //Shorter time for tracking (if motion has changed significantly)
+                //Tracking filters are updated with each scan, so the estimate doesn't depend on how many scans are kept.
+                //The long filter averages over ARPA_LONG_TRACK_SCANS scans, and the short one over ARPA_SHORT_TRACK_SCANS.
+                const ARPATrackFilter* track = &thisArpaContact.longTrack;
 
-                irr::s32 currentScanIndex = thisArpaContact.scans.size() - 1;
-                irr::s32 referenceScanIndex = currentScanIndex - stepsBack;
-                if (referenceScanIndex < 0) {
-                    referenceScanIndex = 0;
-                }
+                //Check if heading/speed has changed dramatically, by comparing with the short filter. If so, use the short filter
+                if (thisArpaContact.longTrack.scans > ARPA_SHORT_TRACK_SCANS) {
+                    //Difference in estimation
+                    irr::f32 changeX = thisArpaContact.shortTrack.vectorX - thisArpaContact.longTrack.vectorX;
+                    irr::f32 changeZ = thisArpaContact.shortTrack.vectorZ - thisArpaContact.longTrack.vectorZ;
 
-                ARPAScan currentScanData = thisArpaContact.scans.at(currentScanIndex);
-                ARPAScan referenceScanData = thisArpaContact.scans.at(referenceScanIndex);
-
-                //Check if heading/speed has changed dramatically, by taking last 10 scans. If so, reduce steps back to 10
-                irr::s32 actualStepsBack = currentScanIndex - referenceScanIndex;
-                if (actualStepsBack > recentStepsBack) {
-                    ARPAScan recentScanData = thisArpaContact.scans.at(currentScanIndex-recentStepsBack);
-                    irr::f32 deltaTimeRecent = currentScanData.timeStamp - recentScanData.timeStamp;
-                    irr::f32 deltaTimeFull   = currentScanData.timeStamp - referenceScanData.timeStamp;
-                    if (deltaTimeRecent>0 && deltaTimeFull > 0) {
-                        irr::f32 deltaXRecent = currentScanData.x - recentScanData.x;
-                        irr::f32 deltaZRecent = currentScanData.z - recentScanData.z;
-                        irr::f32 deltaXFull   = currentScanData.x - referenceScanData.x;
-                        irr::f32 deltaZFull   = currentScanData.z - referenceScanData.z;
-
-                        //Absolute vector
-                        irr::f32 absVectorXRecent = deltaXRecent/deltaTimeRecent; //m/s
-                        irr::f32 absVectorZRecent = deltaZRecent/deltaTimeRecent; //m/s
-                        irr::f32 absVectorXFull = deltaXFull/deltaTimeFull; //m/s
-                        irr::f32 absVectorZFull = deltaZFull/deltaTimeFull; //m/s
-
-                        //Difference in estimation
-                        irr::f32 changeX = absVectorXRecent - absVectorXFull;
-                        irr::f32 changeZ = absVectorZRecent - absVectorZFull;
-
-                        //If speed estimates differ by more than 1m/s in either direction, prefer the more recent estimate. Otherwise, leave unchanged
-                        if (std::abs(changeX) > 1.0 || std::abs(changeZ) > 1.0) {
-                            referenceScanData = recentScanData; //It seems like the course or speed has changed significantly
-                        }
+                    //If speed estimates differ by more than 1m/s in either direction, prefer the more recent estimate. Otherwise, leave unchanged
+                    if (std::abs(changeX) > 1.0 || std::abs(changeZ) > 1.0) {
+                        track = &thisArpaContact.shortTrack; //It seems like the course or speed has changed significantly
                     }
                 }
 
-                //Find difference in time, position x, position z
-                irr::f32 deltaTime = currentScanData.timeStamp - referenceScanData.timeStamp;
-                if (deltaTime<=0) {
+                if (track->scans < 2) {
                     // Special case to just show estimated position if nothing else can be calculated
-                    irr::f32 relXEst = currentScanData.x - absolutePosition.X;
-                    irr::f32 relZEst = currentScanData.z - absolutePosition.Z;
+                    irr::f32 relXEst = track->x - absolutePosition.X;
+                    irr::f32 relZEst = track->z - absolutePosition.Z;
                     thisArpaContact.estimate.bearing = std::atan2(relXEst,relZEst)/RAD_IN_DEG;
                     while (thisArpaContact.estimate.bearing < 0 ) {
                         thisArpaContact.estimate.bearing += 360;
                     }
                     thisArpaContact.estimate.range =  std::sqrt(pow(relXEst,2)+pow(relZEst,2))/M_IN_NM; //Nm
                 } else {
-                    irr::f32 deltaX = currentScanData.x - referenceScanData.x;
-                    irr::f32 deltaZ = currentScanData.z - referenceScanData.z;
-
                     //Absolute vector
-                    thisArpaContact.estimate.absVectorX = deltaX/deltaTime; //m/s
-                    thisArpaContact.estimate.absVectorZ = deltaZ/deltaTime; //m/s
-                    thisArpaContact.estimate.absHeading = std::atan2(deltaX,deltaZ)/RAD_IN_DEG;
+                    thisArpaContact.estimate.absVectorX = track->vectorX; //m/s
+                    thisArpaContact.estimate.absVectorZ = track->vectorZ; //m/s
+                    thisArpaContact.estimate.absHeading = std::atan2(track->vectorX,track->vectorZ)/RAD_IN_DEG;
                     while (thisArpaContact.estimate.absHeading < 0 ) {
                         thisArpaContact.estimate.absHeading += 360;
                     }
@@ -1378,8 +1679,8 @@ void RadarCalculation::updateArpaEstimate(ARPAContact& thisArpaContact, int cont
                     }
 
                     //Estimated current position:
-                    irr::f32 relXEst = currentScanData.x - absolutePosition.X + thisArpaContact.estimate.absVectorX * (absoluteTime - currentScanData.timeStamp);
-                    irr::f32 relZEst = currentScanData.z - absolutePosition.Z + thisArpaContact.estimate.absVectorZ * (absoluteTime - currentScanData.timeStamp);
+                    irr::f32 relXEst = track->x - absolutePosition.X + thisArpaContact.estimate.absVectorX * (irr::f32)(absoluteTime - track->timeStamp);
+                    irr::f32 relZEst = track->z - absolutePosition.Z + thisArpaContact.estimate.absVectorZ * (irr::f32)(absoluteTime - track->timeStamp);
                     thisArpaContact.estimate.bearing = std::atan2(relXEst,relZEst)/RAD_IN_DEG;
                     while (thisArpaContact.estimate.bearing < 0 ) {
                         thisArpaContact.estimate.bearing += 360;
@@ -1399,7 +1700,7 @@ void RadarCalculation::updateArpaEstimate(ARPAContact& thisArpaContact, int cont
                     //std::cout << "Contact " << thisArpaContact.estimate.displayID << " CPA: " <<  thisArpaContact.estimate.cpa << " nm in " << thisArpaContact.estimate.tcpa << " minutes" << std::endl;
 
 
-                } //If time between scans > 0 
+                } //If velocity known
             } //Contact not lost
         } //If at least 2 scans
     } //If ARPA is on
@@ -1426,66 +1727,62 @@ void RadarCalculation::render(irr::video::IImage * radarImage, irr::video::IImag
     //draw from array to image
     irr::f32 centrePixel = (bitmapWidth-1.0)/2.0; //The centre of the bitmap. Normally this will be a fractional number (##.5)
 
-    //precalculate cell max/min range for speed outside nested loop
-	std::vector<irr::f32> cellMinRange;
-	std::vector<irr::f32> cellMaxRange;
-	//irr::f32 cellMinRange [rangeResolution];
-    //irr::f32 cellMaxRange [rangeResolution];
-	cellMinRange.push_back(0);
-	cellMaxRange.push_back(0);
-    for (irr::u32 currentStep = 1; currentStep<rangeResolution; currentStep++) { //Note that we start with the element at 1, so we've already pushed in a dummy entry at 0
-        cellMinRange.push_back((currentStep-0.5)*(bitmapWidth*0.5/(float)rangeResolution));//Range in pixels from centre
-        cellMaxRange.push_back((currentStep+0.5)*(bitmapWidth*0.5/(float)rangeResolution));
-    }
-
-    irr::f32 scanAngle;
-
-    for (int scanLine = 0; scanLine < angularResolution; scanLine++) {
-
-        scanAngle = ((irr::f32) scanLine / (irr::f32) angularResolution) * 360.0f;
-
-        irr::f32 cellMinAngle = scanAngle - scanAngleStep / 2.0;
-        irr::f32 cellMaxAngle = scanAngle + scanAngleStep / 2.0;
-
-        for (irr::u32 currentStep = 1; currentStep<rangeResolution; currentStep++) {
-
-            //If the sector has changed, draw it. If we're stabilising the picture, need to re-draw all in case the ship's head has changed
-            if(toReplot[scanLine] || stabilised)
-            {
-
-                if (headUp || scanArrayToPlotPrevious[scanLine][currentStep] != scanArrayToPlot[scanLine][currentStep]) { //If north up, we only need to replot if the previous plot to this sector was different
-                    irr::f32 pixelColour=scanArrayToPlot[scanLine][currentStep];
-
-                    if (pixelColour>1.0) {pixelColour = 1.0;}
-                    if (pixelColour<0)   {pixelColour =   0;}
-
-                    if (currentRadarColourChoice < radarForegroundColours.size() && currentRadarColourChoice < radarBackgroundColours.size()) {
-                        //Interpolate colour between foreground and background
-                        irr::video::SColor thisColour = radarForegroundColours.at(currentRadarColourChoice).getInterpolated(radarBackgroundColours.at(currentRadarColourChoice), pixelColour);
-                        drawSector(radarImage,
-                                centrePixel,
-                                centrePixel,
-                                cellMinRange[currentStep],
-                                cellMaxRange[currentStep],
-                                cellMinAngle,
-                                cellMaxAngle,
-                                thisColour.getAlpha(),
-                                thisColour.getRed(),
-                                thisColour.getGreen(),
-                                thisColour.getBlue(),
-                                ownShipHeading);
-                    }
+    //Rotation of the picture, in scan lines
+    irr::f32 lineOffset = 0;
+    if (headUp) {
+        lineOffset = ownShipHeading/scanAngleStep;
+    }
+
+    //Update the map from pixels to scan cells if the display size has changed. If it has changed, or the picture has rotated, every pixel needs re-drawing.
+    bool redrawAll = pixelMap.update(bitmapWidth, radarImage->getPitch()/4, angularResolution, rangeResolution);
+    if (lineOffset != renderedLineOffset) {
+        redrawAll = true;
+        renderedLineOffset = lineOffset;
+    }
+
+    if (radarImage->getColorFormat() == irr::video::ECF_A8R8G8B8 &&
+        currentRadarColourChoice < radarForegroundColours.size() && currentRadarColourChoice < radarBackgroundColours.size()) {
 
-                    scanArrayToPlotPrevious[scanLine][currentStep] = scanArrayToPlot[scanLine][currentStep]; //Record what we have plotted
+        //Look up table for each intensity level, interpolating colour between foreground and background
+        for (irr::u32 i = 0; i < RADAR_COLOUR_LEVELS; i++) {
+            colourLookup[i] = radarForegroundColours.at(currentRadarColourChoice).getInterpolated(radarBackgroundColours.at(currentRadarColourChoice), (irr::f32)i/(RADAR_COLOUR_LEVELS-1)).color;
+        }
+
+        irr::u32* pixels = (irr::u32*)radarImage->getData();
+        if (redrawAll) {
+            pixelMap.renderAll(pixels, scanArrayToPlot, lineOffset, &colourLookup[0]);
+        } else {
+            //Only draw the scan lines that have changed
+            for (irr::u32 scanLine = 0; scanLine < angularResolution; scanLine++) {
+                if (toReplot[scanLine]) {
+                    pixelMap.renderLine(pixels, scanArrayToPlot, scanLine, lineOffset, &colourLookup[0]);
                 }
             }
         }
-        //We don't need to replot this line
-        toReplot[scanLine]=false;
     }
 
-    //Copy image into overlaid
-    radarImage->copyTo(radarImageOverlaid);
+    //Find the region of the radar picture that has changed, and mark lines as not needing to be replotted
+    irr::core::rect<irr::s32> imageRegion(0,0,radarImage->getDimension().Width,radarImage->getDimension().Height);
+    irr::core::rect<irr::s32> radarChangedRegion = emptyRegion();
+    if (redrawAll || wholeImageChanged) {
+        radarChangedRegion = imageRegion;
+        wholeImageChanged = false;
+    }
+    for (irr::u32 scanLine = 0; scanLine < angularResolution; scanLine++) {
+        if (toReplot[scanLine]) {
+            addToRegion(radarChangedRegion, pixelMap.getLineBounds(scanLine, lineOffset));
+            toReplot[scanLine]=false;
+        }
+    }
+
+    //Copy changed parts of the image into overlaid, including where the overlay was last drawn, so it is cleared
+    irr::core::rect<irr::s32> copyRegion = radarChangedRegion;
+    addToRegion(copyRegion, overlayRegion);
+    copyRegion.clipAgainst(imageRegion);
+    if (copyRegion.isValid() && copyRegion.getArea() > 0) {
+        radarImage->copyTo(radarImageOverlaid, copyRegion.UpperLeftCorner, copyRegion);
+    }
+    overlayRegion = emptyRegion(); //Updated as the overlay is drawn
 
     //Adjust for head up/course up
     irr::f32 radarOffsetAngle = 0;
@@ -1539,6 +1836,7 @@ void RadarCalculation::render(irr::video::IImage * radarImage, irr::video::IImag
                     if (idNumberImage) {
                         irr::core::rect<irr::s32> sourceRect = irr::core::rect<irr::s32>(0,0,idNumberImage->getDimension().Width,idNumberImage->getDimension().Height);
                         idNumberImage->copyToWithAlpha(radarImageOverlaid,irr::core::position2d<irr::s32>(xTextPos,yTextPos),sourceRect,irr::video::SColor(255,255,255,255));
+                        addToRegion(overlayRegion, irr::core::rect<irr::s32>(irr::core::position2d<irr::s32>(xTextPos,yTextPos),sourceRect.getSize()));
                         idNumberImage->drop();
                     }
 				}
@@ -1573,6 +1871,7 @@ void RadarCalculation::render(irr::video::IImage * radarImage, irr::video::IImag
             if (idNumberImage) {
                 irr::core::rect<irr::s32> sourceRect = irr::core::rect<irr::s32>(0,0,idNumberImage->getDimension().Width,idNumberImage->getDimension().Height);
                 idNumberImage->copyToWithAlpha(radarImageOverlaid,irr::core::position2d<irr::s32>(deltaX-10,deltaY-10),sourceRect,irr::video::SColor(255,255,255,255));
+                addToRegion(overlayRegion, irr::core::rect<irr::s32>(irr::core::position2d<irr::s32>(deltaX-10,deltaY-10),sourceRect.getSize()));
                 idNumberImage->drop();
             }
 
@@ -1610,68 +1909,10 @@ void RadarCalculation::render(irr::video::IImage * radarImage, irr::video::IImag
         }
     }
 
-
-}
-
-void RadarCalculation::drawSector(irr::video::IImage * radarImage,irr::f32 centreX, irr::f32 centreY, irr::f32 innerRadius, irr::f32 outerRadius, irr::f32 startAngle, irr::f32 endAngle, irr::u32 alpha, irr::u32 red, irr::u32 green, irr::u32 blue, irr::f32 ownShipHeading)
-//draw a bounded sector
-{
-
-    //IPROF_FUNC;
-
-    if (headUp) {
-        startAngle -= ownShipHeading;
-        endAngle -= ownShipHeading;
-    }
-
-    //find the corner points (Fixme: Not quite right when the extreme point is on the outer curve)
-    irr::f32 sinStartAngle = std::sin(irr::core::DEGTORAD*startAngle);
-    irr::f32 cosStartAngle = std::cos(irr::core::DEGTORAD*startAngle);
-    irr::f32 sinEndAngle = std::sin(irr::core::DEGTORAD*endAngle);
-    irr::f32 cosEndAngle = std::cos(irr::core::DEGTORAD*endAngle);
-
-    irr::f32 point1X = centreX + sinStartAngle*innerRadius;
-    irr::f32 point1Y = centreY - cosStartAngle*innerRadius;
-    irr::f32 point2X = centreX + sinStartAngle*outerRadius;
-    irr::f32 point2Y = centreY - cosStartAngle*outerRadius;
-    irr::f32 point3X = centreX + sinEndAngle*outerRadius;
-    irr::f32 point3Y = centreY - cosEndAngle*outerRadius;
-    irr::f32 point4X = centreX + sinEndAngle*innerRadius;
-    irr::f32 point4Y = centreY - cosEndAngle*innerRadius;
-
-    //find the 'bounding box'
-    irr::s32 minX = std::min(std::min(point1X,point2X),std::min(point3X,point4X));
-    irr::s32 maxX = std::max(std::max(point1X,point2X),std::max(point3X,point4X));
-    irr::s32 minY = std::min(std::min(point1Y,point2Y),std::min(point3Y,point4Y));
-    irr::s32 maxY = std::max(std::max(point1Y,point2Y),std::max(point3Y,point4Y));
-
-    irr::f32 innerRadiusSqr = innerRadius*innerRadius;
-    irr::f32 outerRadiusSqr = outerRadius*outerRadius;
-
-    //draw the points
-    for (int i = minX;i<=maxX;i++) {
-        irr::f32 localX = i - centreX; //position referred to centre
-        irr::f32 localXSq = localX*localX;
-
-        for (int j = minY;j<=maxY;j++) {
-
-            irr::f32 localY = j - centreY; //position referred to centre
-
-            irr::f32 localRadiusSqr = localXSq + localY*localY; //check radius of points
-            //irr::f32 localAngle = irr::core::RADTODEG*std::atan2(localX,-1*localY); //check angle of point
-            //irr::f32 localAngle = irr::core::RADTODEG*fast_atan2f(localX,-1*localY);
-
-            //if the point is within the limits, plot it
-            if (localRadiusSqr >= innerRadiusSqr && localRadiusSqr <= outerRadiusSqr) {
-                //if (Angles::isAngleBetween(localAngle,startAngle,endAngle)) {
-                if (Angles::isAngleBetween(irr::core::vector2df(localX,-1*localY),irr::core::vector2df(sinStartAngle,cosStartAngle),irr::core::vector2df(sinEndAngle,cosEndAngle))) {
-                    //Plot i,j
-                    if (i >= 0 && j >= 0) {radarImage->setPixel(i,j,irr::video::SColor(alpha,red,green,blue));}
-                }
-            }
-        }
-    }
-
+    //Record what has changed in radarImageOverlaid, so only this needs to be used to update the display
+    changedRegion = copyRegion;
+    addToRegion(changedRegion, overlayRegion);
+    changedRegion.clipAgainst(imageRegion);
 }
 
 void RadarCalculation::drawLine(irr::video::IImage * radarImage, irr::f32 startX, irr::f32 startY, irr::f32 endX, irr::f32 endY, irr::u32 alpha, irr::u32 red, irr::u32 green, irr::u32 blue)//Try with irr::f32 as inputs so we can do interpolation based on the theoretical start and end
@@ -1684,6 +1925,9 @@ void RadarCalculation::drawLine(irr::video::IImage * radarImage, irr::f32 startX
 
     irr::u32 radiusSquared = pow(radarRadiusPx,2);
 
+    //Record the area drawn on
+    addToRegion(overlayRegion, irr::core::rect<irr::s32>(Utilities::round(std::min(startX,endX)), Utilities::round(std::min(startY,endY)), Utilities::round(std::max(startX,endX))+1, Utilities::round(std::max(startY,endY))+1));
+
     if (lengthSum > 0) {
         for (irr::f32 i = 0; i<=1; i += 1/lengthSum) {
             irr::s32 thisX = Utilities::round(startX + deltaX * i);
@@ -1715,6 +1959,9 @@ void RadarCalculation::drawCircle(irr::video::IImage * radarImage, irr::f32 cent
 
     irr::u32 radiusSquared = pow(radarRadiusPx,2);
 
+    //Record the area drawn on
+    addToRegion(overlayRegion, irr::core::rect<irr::s32>(Utilities::round(centreX-radius), Utilities::round(centreY-radius), Utilities::round(centreX+radius)+1, Utilities::round(centreY+radius)+1));
+
     if (circumference > 0) {
         for (irr::f32 i = 0; i<=1; i += 1/circumference) {
             irr::s32 thisX = Utilities::round(centreX + radius * sin(i*2*PI));
@@ -1742,109 +1989,35 @@ void RadarCalculation::drawCircle(irr::video::IImage * radarImage, irr::f32 cent
     }
 }
 
-irr::f32 RadarCalculation::rangeAtAngle(irr::f32 checkAngle,irr::f32 centreX, irr::f32 centreZ, irr::f32 heading)
-{
-	//Special case is if heading and checkAngle are identical. In this case, return the centre point if it lies on the angle, and 0 if not
-	if (std::abs(Angles::normaliseAngle(checkAngle-heading)) < 0.001) {
-		if (Angles::normaliseAngle(irr::core::RADTODEG*std::atan2(centreX,centreZ)-checkAngle) < 0.1) {
-			return std::sqrt(std::pow(centreX,2) + std::pow(centreZ,2));
-		} else {
-			return 0;
-		}
-	}
-
-	irr::f32 lambda; //This is the distance from the centre of the contact
-
-	lambda = (centreX - centreZ*tan(irr::core::DEGTORAD*checkAngle))/(cos(irr::core::DEGTORAD*heading)*tan(irr::core::DEGTORAD*checkAngle) - sin(irr::core::DEGTORAD*heading));
-
-	irr::f32 distanceSqr = std::pow(lambda,2) + lambda*(2*centreX*sin(irr::core::DEGTORAD*heading) + 2*centreZ*cos(irr::core::DEGTORAD*heading)) + (std::pow(centreX,2) + std::pow(centreZ,2));
-
-	irr::f32 distance = 0;
-
-	if (distanceSqr > 0) {
-		distance = std::sqrt(distanceSqr);
-	}
-
-	return distance;
-
-}
-
-irr::f32 RadarCalculation::radarNoise(irr::f32 radarNoiseLevel, irr::f32 radarSeaClutter, irr::f32 radarRainClutter, irr::f32 weather, irr::f32 radarRange,irr::f32 radarBrgDeg, irr::f32 windDirectionDeg, irr::f32 radarInclinationAngle, irr::f32 rainIntensity)
-//radarRange in metres
+irr::f32 RadarCalculation::radarNoise(irr::f32 radarNoiseLevel, irr::f32 radarSeaClutter, irr::f32 radarRainClutter, irr::f32 weather, irr::u32 scanLine, irr::u32 step, irr::f32 radarInclinationAngle, irr::f32 rainIntensity)
+//Range and bearing dependent terms are looked up from scanGeometry for this scan line and step
 {
 	irr::f32 radarNoiseVal = 0;
 
-	if (radarRange != 0) {
-
-		irr::f32 randomValue = (irr::f32)rand()/RAND_MAX; //store this so we can manipulate the random distribution;
-		irr::f32 randomValueSea = (irr::f32)rand()/RAND_MAX; //different value for sea clutter;
+	if (step > 0) {
 
-		//reshape the uniform random distribution into one with an infinite tail up to high values
-		irr::f32 randomValueWithTail=0;
-		if (randomValue > 0) {
-            //3rd power is to shape distribution so sufficient high energy returns are generated
-			randomValueWithTail = randomValue * pow( (1/randomValue) - 1, 3);
-		}
+		//random distribution with an infinite tail up to high values, shaped as u*((1/u)-1)^3 for uniform u, so sufficient high energy returns are generated
+		irr::f32 randomValueWithTail = scanRandom.heavyTail();
 
 		//same for sea clutter noise
 		irr::f32 randomValueWithTailSea=0;
-		if (randomValueSea > 0) {
-            if (radarInclinationAngle > 0) {
-                randomValueWithTailSea = 0; //if radar is scanning upwards, must be above sea surface, so don't add clutter
-            } else {
-                //3rd power is to shape distribution so sufficient high energy returns are generated
-                randomValueWithTailSea = randomValueSea * pow((1/randomValueSea) - 1, 3);
-            }
+		if (radarInclinationAngle <= 0) { //if radar is scanning upwards, must be above sea surface, so don't add clutter
+			randomValueWithTailSea = scanRandom.heavyTail();
 		}
 
-		//less high power returns for rain clutter - roughly gaussian, so get an average of independent random numbers
-		irr::f32 randomValueWithTailRain = ((irr::f32)rand()/RAND_MAX + (irr::f32)rand()/RAND_MAX + (irr::f32)rand()/RAND_MAX + (irr::f32)rand()/RAND_MAX)/4.0;
+		//less high power returns for rain clutter - roughly gaussian, distributed as an average of four independent random numbers
+		irr::f32 randomValueWithTailRain = scanRandom.averageOfFour();
 
 		//Apply directional correction to the clutter, so most is upwind, some is downwind. Mean value = 1
-		irr::f32 relativeWindAngle = (windDirectionDeg - radarBrgDeg)*RAD_IN_DEG;
-		irr::f32 windCorrectionFactor = 2.5*(0.5*(cos(2*relativeWindAngle)+1))*(0.5+sin(relativeWindAngle/2.0)*0.5);
-		randomValueWithTailSea = randomValueWithTailSea * windCorrectionFactor;
+		randomValueWithTailSea = randomValueWithTailSea * scanGeometry.lineSeaClutterWindFactor[scanLine];
 
 		//noise is constant
 		radarNoiseVal = radarNoiseLevel * randomValueWithTail;
 		//clutter falls off with distance^3, and is normalised for weather#=6
-		radarNoiseVal += radarSeaClutter * randomValueWithTailSea * (weather/6.0) * pow((M_IN_NM/radarRange),3);
+		radarNoiseVal += radarSeaClutter * randomValueWithTailSea * (weather/6.0) * scanGeometry.stepSeaClutterFactor[step];
 		//rain clutter falls off with distance^2, and is normalised for rainIntensity#=10
-		radarNoiseVal += radarRainClutter * randomValueWithTailRain * (rainIntensity/10.0)*(rainIntensity/10.0) * pow((M_IN_NM/radarRange),2);
+		radarNoiseVal += radarRainClutter * randomValueWithTailRain * (rainIntensity/10.0)*(rainIntensity/10.0) * scanGeometry.stepRainClutterFactor[step];
 	}
 
 	return radarNoiseVal;
 }
-
-bool RadarCalculation::isPointInEllipse(irr::f32 pointX, irr::f32 pointZ, irr::f32 centreX, irr::f32 centreZ, irr::f32 width, irr::f32 length, irr::f32 angle)
-{
-    
-    // Quick first check
-    if ( fmax(abs(pointX - centreX), abs(pointZ - centreZ)) > fmax(width, length)) {
-        return false;
-    }
-    
-    // Detailed check
-
-    // See https://stackoverflow.com/a/16824748/12829372
-    irr::f32 cosAngle = cos(-1.0 * angle * irr::core::DEGTORAD);
-    irr::f32 sinAngle = sin(-1.0 * angle * irr::core::DEGTORAD);
-
-    irr::f32 halfWidth2 = width/2 * width/2;
-    irr::f32 halfLength2 = length/2 * length/2;
-    
-    if (halfLength2 == 0 || halfWidth2 == 0) {
-        return false;
-    }
-
-    irr::f32 paramA = pow(cosAngle*(pointX-centreX)+sinAngle*(pointZ-centreZ),2);
-    irr::f32 paramB = pow(sinAngle*(pointX-centreX)-cosAngle*(pointZ-centreZ),2);
-
-    irr::f32 ellipse=(paramA/halfWidth2)+(paramB/halfLength2);
-
-    if (ellipse <= 1) {
-        return true;
-    } else {
-        return false;
-    }
-}
\ No newline at end of file
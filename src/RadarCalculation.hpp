@@ -19,9 +19,20 @@
 
 #include "irrlicht.h"
 
+#include "RadarData.hpp"
+#include "RadarPixelMap.hpp"
+#include "RadarRandom.hpp"
+#include "RadarScanArray.hpp"
+#include "RadarScanGeometry.hpp"
+#include "RadarTerrainCache.hpp"
+
 #include <vector>
 #include <string>
 #include <stdint.h> //for uint64_t
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
 
 #include <ctime> //To check time elapsed between changing EBL when button held down
 
@@ -29,7 +40,7 @@ class Terrain;
 class OwnShip;
 class Buoys;
 class OtherShips;
-struct RadarData;
+class SpatialIndex;
 
 enum ARPA_CONTACT_TYPE {
     CONTACT_NONE,
@@ -55,6 +66,87 @@ struct ARPAScan {
     }
 };
 
+const irr::u32 ARPA_SCAN_HISTORY = 64; //Most recent scans kept for each contact
+const irr::u32 ARPA_LONG_TRACK_SCANS = 61; //Scans used for normal tracking (time = (scans-1) * seconds between scans)
+const irr::u32 ARPA_SHORT_TRACK_SCANS = 11; //Scans used for tracking if the motion has changed significantly
+
+struct ARPAScanHistory {
+    //Fixed size ring buffer of the most recent scans, indexed from the oldest (0) to the newest (size()-1). When full, adding a scan drops the oldest.
+    ARPAScan scanBuffer[ARPA_SCAN_HISTORY];
+    irr::u32 first;
+    irr::u32 count;
+
+    ARPAScanHistory() {
+        first = 0;
+        count = 0;
+    }
+    irr::u32 size() const {return count;}
+    bool empty() const {return count == 0;}
+    void clear() {first = 0; count = 0;}
+    const ARPAScan& at(irr::u32 i) const {return scanBuffer[(first + i) % ARPA_SCAN_HISTORY];}
+    const ARPAScan& back() const {return at(count - 1);}
+    void push_back(const ARPAScan& scan) {
+        if (count < ARPA_SCAN_HISTORY) {
+            scanBuffer[(first + count) % ARPA_SCAN_HISTORY] = scan;
+            count++;
+        } else {
+            scanBuffer[first] = scan;
+            first = (first + 1) % ARPA_SCAN_HISTORY;
+        }
+    }
+};
+
+struct ARPATrackFilter {
+    //Alpha-beta filter for position and velocity, updated once for each new scan.
+    //The gains are those of a least squares straight line fit through all the scans so far, until maxScans is reached, after which they stay constant.
+    irr::u32 maxScans;
+    irr::u32 scans; //Number of scans in the filter's memory, up to maxScans
+    irr::f32 x; //Absolute metres
+    irr::f32 z; //Absolute metres
+    irr::f32 vectorX; //m/s
+    irr::f32 vectorZ; //m/s
+    uint64_t timeStamp; //Time of last scan (s)
+
+    ARPATrackFilter(irr::u32 maxScans) {
+        this->maxScans = maxScans;
+        reset();
+    }
+    void reset() {
+        scans = 0;
+        x = 0;
+        z = 0;
+        vectorX = 0;
+        vectorZ = 0;
+        timeStamp = 0;
+    }
+    void update(const ARPAScan& scan) {
+        if (scans == 0 || scan.timeStamp <= timeStamp) {
+            //First scan, or no time since last one, so only the position is known
+            x = scan.x;
+            z = scan.z;
+            if (scans == 0) {
+                scans = 1;
+                timeStamp = scan.timeStamp;
+            }
+            return;
+        }
+        irr::f32 deltaTime = scan.timeStamp - timeStamp;
+        if (scans < maxScans) {
+            scans++;
+        }
+        irr::f32 alpha = 2.0*(2.0*scans - 1)/(scans*(scans + 1.0));
+        irr::f32 beta = 6.0/(scans*(scans + 1.0));
+
+        irr::f32 residualX = scan.x - (x + vectorX*deltaTime);
+        irr::f32 residualZ = scan.z - (z + vectorZ*deltaTime);
+        x += vectorX*deltaTime + alpha*residualX;
+        z += vectorZ*deltaTime + alpha*residualZ;
+        vectorX += beta*residualX/deltaTime;
+        vectorZ += beta*residualZ/deltaTime;
+        timeStamp = scan.timeStamp;
+    }
+};
+
 struct ARPAEstimatedState {
     irr::u32 displayID; //User displayed ID
     bool stationary; // E.g. if detected as static and a small RCS or a buoy.
@@ -92,7 +184,9 @@ struct ARPAEstimatedState {
 };
 
 struct ARPAContact {
-    std::vector<ARPAScan> scans;
+    ARPAScanHistory scans; //Add and clear with addScan() and clearScans(), so the tracking filters are kept up to date
+    ARPATrackFilter longTrack;
+    ARPATrackFilter shortTrack;
     irr::f32 totalXMovementEst; //Estimates of total movement (sum of absolutes) in X and Z, to help detect stationary contacts
     irr::f32 totalZMovementEst;
     ARPA_CONTACT_TYPE contactType;
@@ -100,12 +194,105 @@ struct ARPAContact {
     //irr::u32 displayID;
     ARPAEstimatedState estimate;
 
-    ARPAContact() {
+    ARPAContact() : longTrack(ARPA_LONG_TRACK_SCANS), shortTrack(ARPA_SHORT_TRACK_SCANS) {
         totalXMovementEst = 0;
         totalZMovementEst = 0;
         contactType = CONTACT_NONE;
         contact = 0;
-    } 
+    }
+    void addScan(const ARPAScan& scan) {
+        scans.push_back(scan);
+        longTrack.update(scan);
+        shortTrack.update(scan);
+    }
+    void clearScans() {
+        scans.clear();
+        longTrack.reset();
+        shortTrack.reset();
+    }
+};
+
+struct RadarScanInput {
+    //Snapshot of everything the scan needs from the rest of the simulation, so the scan can run on the radar worker thread
+    const Terrain* terrain;
+    irr::core::vector3df position; //Own ship (scanner) position
+    irr::core::vector3d<int64_t> absolutePosition; //Relative to SW corner of world model
+    irr::core::vector3d<int64_t> offsetPosition; //Of the local coordinate system, relative to SW corner of world model
+    std::vector<RadarData> radarData; //Contacts within range
+    irr::f32 weather;
+    irr::f32 rain;
+    irr::f32 tideHeight;
+    irr::f32 scanTime; //Simulation time to scan for (s)
+    uint64_t absoluteTime;
+    irr::f32 rangeNm;
+    irr::f32 gain;
+    irr::f32 seaClutterReduction;
+    irr::f32 rainClutterReduction;
+    int arpaMode;
+
+    RadarScanInput() {
+        terrain = 0;
+        weather = 0;
+        rain = 0;
+        tideHeight = 0;
+        scanTime = 0;
+        absoluteTime = 0;
+        rangeNm = 0;
+        gain = 0;
+        seaClutterReduction = 0;
+        rainClutterReduction = 0;
+        arpaMode = 0;
+    }
+};
+
+struct RadarDetection {
+    //A contact detected above the noise during a scan, to be added to ARPA
+    void* contact;
+    irr::f32 angle; //Degrees
+    irr::f32 range; //Metres
+    irr::core::vector3d<int64_t> scannerPosition; //Absolute position of scanner when detected
+    uint64_t timeStamp;
+
+    RadarDetection() {
+        contact = 0;
+        angle = 0;
+        range = 0;
+        timeStamp = 0;
+    }
+};
+
+struct RadarContactGeometry {
+    //Per sweep geometry of a radar contact, used to intersect it with each scan line
+    irr::f32 sinHeading;
+    irr::f32 cosHeading;
+    irr::f32 halfLength; //Metres
+    irr::f32 halfWidth; //Metres
+    irr::f32 closestRange; //Range to the contact's bounding circle (Metres)
+    irr::f32 angularHalfWidth; //Half angle subtended by the contact's bounding circle (Degrees). 180 if the scanner is inside it.
+
+    RadarContactGeometry() {
+        sinHeading = 0;
+        cosHeading = 1;
+        halfLength = 0;
+        halfWidth = 0;
+        closestRange = 0;
+        angularHalfWidth = 0;
+    }
+};
+
+struct RadarContactInterval {
+    //The range steps covered by a contact on one scan line
+    irr::u32 minStep;
+    irr::u32 maxStep;
+    irr::u32 contactIndex; //Index into this sweep's radar data
+    bool blocksLine; //If the contact covers the whole angle of the scan line, so blocks returns from behind it
+
+    RadarContactInterval() {
+        minStep = 0;
+        maxStep = 0;
+        contactIndex = 0;
+        blocksLine = false;
+    }
 };
 
 class RadarCalculation
@@ -142,6 +329,9 @@ class RadarCalculation
         void setCourseUp();
         void setHeadUp();
         bool getHeadUp() const; //Head or course up
+        void setRandomSeed(irr::u32 seed); //Seed for radar noise and ARPA measurement errors, so they can be repeated
+        irr::u32 getRandomSeed() const;
+        irr::core::rect<irr::s32> getChangedRegion() const; //Region of the overlaid radar image changed by the last update(). Not valid if nothing has changed.
 		void toggleRadarOn();
         bool isRadarOn() const;
 		int getArpaMode() const;
@@ -160,16 +350,35 @@ class RadarCalculation
         void clearManualPoints();
         void trackTargetFromCursor();
         void clearTargetFromCursor();
-        void update(irr::video::IImage * radarImage, irr::video::IImage * radarImageOverlaid, irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime, irr::core::vector2di mouseRelPosition, bool isMouseDown);
+        void update(irr::video::IImage * radarImage, irr::video::IImage * radarImageOverlaid, irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime, irr::core::vector2di mouseRelPosition, bool isMouseDown);
+        //Call around anything that moves the terrain, e.g. origin normalisation. Waits for the worker thread (if used) to finish its current lines, and holds it until resumeWorker().
+        void pauseWorker();
+        void resumeWorker();
 
     private:
         irr::IrrlichtDevice* device;
-        std::vector<std::vector<irr::f32> > scanArray;
-        std::vector<std::vector<irr::f32> > scanArrayAmplified;
-        std::vector<std::vector<irr::f32> > scanArrayToPlot;
-        std::vector<std::vector<irr::f32> > scanArrayToPlotPrevious;
+        RadarScanArray scanArray;
+        RadarScanArray scanArrayAmplified; //Has 3 wrap lines each side, for the angular filter
+        RadarScanArray scanArrayToPlot;
+        irr::u32 filterEndStep7; //Steps below this are filtered over 7 lines, then 5, then 3, then not filtered
+        irr::u32 filterEndStep5;
+        irr::u32 filterEndStep3;
         std::vector<bool> toReplot;
+        RadarScanGeometry scanGeometry; //Cached trigonometry and range dependent factors for the scan
+        RadarTerrainCache terrainCache; //Terrain height at each scan cell
+        RadarRandom scanRandom; //Noise and sweep timing, used by whichever thread is scanning
+        RadarRandom arpaRandom; //ARPA measurement errors, used on the main thread
+        irr::u32 randomSeed; //As last set
+        RadarScanInput scanInput; //Snapshot for the current scan
+        std::vector<RadarDetection> scanDetections; //Contacts detected in the current scan
+        std::vector<RadarContactGeometry> contactGeometry; //For each contact in the current sweep
+        std::vector<std::vector<irr::u32> > contactLineIndex; //For each scan line, the contacts in the current sweep which may be on it
+        std::vector<irr::u32> indexedLines; //Lines with entries in contactLineIndex, so only these need clearing
+        std::vector<irr::u32> allLineContacts; //Contacts which may be on any line, kept out of contactLineIndex
+        std::vector<RadarContactInterval> lineContactIntervals; //Contacts on the current scan line, sorted by first step
+        std::vector<irr::u32> activeContactIntervals; //Indices into lineContactIntervals covering the current step
         std::vector<ARPAContact> arpaContacts;
+        std::unordered_map<void*, irr::u32> arpaContactIndex; //Index in arpaContacts of each automatically acquired contact, by the contact pointer
         std::vector<irr::u32> arpaTracks;
         bool radarOn;
         int arpaMode; // 0: Off/Manual, 1: MARPA, 2: ARPA
@@ -177,7 +386,6 @@ class RadarCalculation
         irr::f32 radarGain;
         irr::f32 radarRainClutterReduction;
         irr::f32 radarSeaClutterReduction;
-        irr::f32 currentScanAngle;
         irr::f32 scanAngleStep;
         irr::u32 currentScanLine; //Note that this MUST be an integer, as the scanline number is used to look up values in radar scan arrays
         irr::u32 rangeResolution;
@@ -206,25 +414,52 @@ class RadarCalculation
         bool stabilised;
         irr::u32 radarRadiusPx;
         bool radarScreenStale;
+        RadarPixelMap pixelMap; //Which scan cell is shown in each pixel
+        std::vector<irr::u32> colourLookup; //A8R8G8B8 colour for each intensity level
+        irr::f32 renderedLineOffset; //Rotation (in scan lines) of the picture last rendered
+        bool wholeImageChanged; //Set when radarImage has been cleared
+        irr::core::rect<irr::s32> overlayRegion; //Region of radarImageOverlaid drawn over by the last render()
+        irr::core::rect<irr::s32> changedRegion; //Region of radarImageOverlaid changed by the last render()
         bool trueVectors;
         irr::f32 vectorLengthMinutes;
 
+        //Radar worker thread. If used, the worker owns scanArray, scanArrayAmplified and the scan state above, and publishes completed lines into scanArrayToPlotPublished
+        bool threadedScan;
+        std::thread radarWorkerThread;
+        std::mutex radarWorkerMutex; //Protects the radarWorker* and *Published members below
+        std::condition_variable radarWorkerCondition;
+        bool radarWorkerStop;
+        bool radarWorkerInputReady;
+        RadarScanInput radarWorkerInput; //Latest snapshot for the worker
+        std::mutex radarTerrainMutex; //Held by the worker while scanning, so the terrain can't be moved during a scan
+        RadarScanArray scanArrayToPlotBack; //Worker's copy of scanArrayToPlot
+        RadarScanArray scanArrayToPlotPublished; //Completed lines, not yet collected by update()
+        std::vector<bool> linePublished;
+        std::vector<RadarDetection> publishedDetections;
+
         //colours
         std::vector<irr::video::SColor> radarBackgroundColours;
         std::vector<irr::video::SColor> radarForegroundColours;
         irr::u32 currentRadarColourChoice;
 
         std::vector<irr::f32> radarRangeNm;
-        void scan(irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime);
+        void getScanInput(RadarScanInput& input, irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime) const;
+        void prepareScan(const RadarScanInput& input);
+        void scan(irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime);
+        void updateWorker(irr::core::vector3d<int64_t> offsetPosition, const Terrain& terrain, const OwnShip& ownShip, const Buoys& buoys, const OtherShips& otherShips, const SpatialIndex& spatialIndex, irr::f32 weather, irr::f32 rain, irr::f32 tideHeight, irr::f32 deltaTime, uint64_t absoluteTime);
+        irr::u32 scanLine(const RadarScanInput& input, const Terrain& terrain, RadarScanArray& plotArray, std::vector<RadarDetection>& detections);
+        void radarWorker();
+        void buildContactLineIndex(const std::vector<RadarData>& radarData);
+        RadarContactGeometry getContactGeometry(const RadarData& contact) const;
+        bool getContactInterval(const RadarData& contact, const RadarContactGeometry& geometry, irr::u32 scanLine, RadarContactInterval& contactInterval) const;
+        static bool isContactIntervalBefore(const RadarContactInterval& first, const RadarContactInterval& second);
+        void addArpaScan(const RadarDetection& detection);
         void updateARPA(irr::core::vector3d<int64_t> offsetPosition, const OwnShip& ownShip, uint64_t absoluteTime);
         void updateArpaEstimate(ARPAContact& thisArpaContact, int contactID, const OwnShip& ownShip, irr::core::vector3d<int64_t> absolutePosition, uint64_t absoluteTime);
-        irr::f32 radarNoise(irr::f32 radarNoiseLevel, irr::f32 radarSeaClutter, irr::f32 radarRainClutter, irr::f32 weather, irr::f32 radarRange,irr::f32 radarBrgDeg, irr::f32 windDirectionDeg, irr::f32 radarInclinationAngle, irr::f32 rainIntensity);
+        irr::f32 radarNoise(irr::f32 radarNoiseLevel, irr::f32 radarSeaClutter, irr::f32 radarRainClutter, irr::f32 weather, irr::u32 scanLine, irr::u32 step, irr::f32 radarInclinationAngle, irr::f32 rainIntensity);
         void render(irr::video::IImage * radarImage, irr::video::IImage * radarImageOverlaid, irr::f32 ownShipHeading, irr::f32 ownShipSpeed);
-        irr::f32 rangeAtAngle(irr::f32 checkAngle,irr::f32 centreX, irr::f32 centreZ, irr::f32 heading);
-        void drawSector(irr::video::IImage * radarImage,irr::f32 centreX, irr::f32 centreY, irr::f32 innerRadius, irr::f32 outerRadius, irr::f32 startAngle, irr::f32 endAngle, irr::u32 alpha, irr::u32 red, irr::u32 green, irr::u32 blue, irr::f32 ownShipHeading);
         void drawLine(irr::video::IImage * radarImage, irr::f32 startX, irr::f32 startY, irr::f32 endX, irr::f32 endY, irr::u32 alpha, irr::u32 red, irr::u32 green, irr::u32 blue);//Try with f32 as inputs so we can do interpolation based on the theoretical start and end
         void drawCircle(irr::video::IImage * radarImage, irr::f32 centreX, irr::f32 centreY, irr::f32 radius, irr::u32 alpha, irr::u32 red, irr::u32 green, irr::u32 blue);//Try with f32 as inputs so we can do interpolation based on the theoretical start and end
-        bool isPointInEllipse(irr::f32 pointX, irr::f32 pointZ, irr::f32 centreX, irr::f32 centreZ, irr::f32 width, irr::f32 length, irr::f32 angle);
 
 };
 
@@ -0,0 +1,223 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "RadarLineProcessing.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RADAR_USE_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+    #define RADAR_USE_AVX
+    #include <immintrin.h>
+#endif
+
+//The amplified signal is log(signal), clamped to 0-1, so only log(x) for 1 <= x <= e is needed.
+//This uses the Cephes logf polynomial: x is halved if above sqrt(2), so the polynomial is only evaluated for sqrt(0.5) <= x < sqrt(2).
+//Within the range needed, at most one halving is required, so no exponent extraction is needed, and the same steps can be used for scalar and SIMD.
+namespace
+{
+    const irr::f32 SQRT2 = 1.41421356f;
+    const irr::f32 E = 2.71828183f;
+    const irr::f32 LOG_P0 = 7.0376836292E-2f;
+    const irr::f32 LOG_P1 = -1.1514610310E-1f;
+    const irr::f32 LOG_P2 = 1.1676998740E-1f;
+    const irr::f32 LOG_P3 = -1.2420140846E-1f;
+    const irr::f32 LOG_P4 = 1.4249322787E-1f;
+    const irr::f32 LOG_P5 = -1.6668057665E-1f;
+    const irr::f32 LOG_P6 = 2.0000714765E-1f;
+    const irr::f32 LOG_P7 = -2.4999993993E-1f;
+    const irr::f32 LOG_P8 = 3.3333331174E-1f;
+    const irr::f32 LOG_Q1 = -2.12194440e-4f; //ln(2) = LOG_Q2 - LOG_Q1, split for accuracy
+    const irr::f32 LOG_Q2 = 0.693359375f;
+
+    //log(x) for 1 <= x <= e
+    inline irr::f32 logScalar(irr::f32 x)
+    {
+        irr::f32 e = 0;
+        if (x > SQRT2) {
+            x *= 0.5f;
+            e = 1;
+        }
+        irr::f32 m = x - 1;
+        irr::f32 z = m*m;
+        irr::f32 y = LOG_P0;
+        y = y*m + LOG_P1;
+        y = y*m + LOG_P2;
+        y = y*m + LOG_P3;
+        y = y*m + LOG_P4;
+        y = y*m + LOG_P5;
+        y = y*m + LOG_P6;
+        y = y*m + LOG_P7;
+        y = y*m + LOG_P8;
+        y = y*m*z;
+        y += LOG_Q1*e;
+        y -= 0.5f*z;
+        return m + y + LOG_Q2*e;
+    }
+
+    //Filter, gain, log and clamp for a single step
+    inline irr::f32 amplifyScalar(irr::f32 current, irr::f32 previous, irr::f32 gain, irr::f32 rainFilter)
+    {
+        //Rain clutter high pass filter
+        irr::f32 gradient = current - previous;
+        if (gradient < 0) {
+            gradient = 0;
+        }
+        irr::f32 filtered = gradient*rainFilter + current*(1-rainFilter);
+
+        //Log amplification, clamped to 0-1
+        irr::f32 signal = filtered*gain;
+        if (!(signal > 1)) {
+            return 0;
+        }
+        if (signal > E) {
+            return 1;
+        }
+        return logScalar(signal);
+    }
+
+    #ifdef RADAR_USE_AVX
+    inline __m256 logAVX(__m256 x)
+    {
+        __m256 halve = _mm256_cmp_ps(x, _mm256_set1_ps(SQRT2), _CMP_GT_OQ);
+        __m256 e = _mm256_and_ps(halve, _mm256_set1_ps(1.0f));
+        x = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(0.5f)), halve);
+        __m256 m = _mm256_sub_ps(x, _mm256_set1_ps(1.0f));
+        __m256 z = _mm256_mul_ps(m, m);
+        __m256 y = _mm256_set1_ps(LOG_P0);
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P1));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P2));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P3));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P4));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P5));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P6));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P7));
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P8));
+        y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+        y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(LOG_Q1)));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+        return _mm256_add_ps(_mm256_add_ps(m, y), _mm256_mul_ps(e, _mm256_set1_ps(LOG_Q2)));
+    }
+    #endif
+
+    #ifdef RADAR_USE_SSE2
+    inline __m128 logSSE2(__m128 x)
+    {
+        __m128 halve = _mm_cmpgt_ps(x, _mm_set1_ps(SQRT2));
+        __m128 e = _mm_and_ps(halve, _mm_set1_ps(1.0f));
+        x = _mm_or_ps(_mm_and_ps(halve, _mm_mul_ps(x, _mm_set1_ps(0.5f))), _mm_andnot_ps(halve, x));
+        __m128 m = _mm_sub_ps(x, _mm_set1_ps(1.0f));
+        __m128 z = _mm_mul_ps(m, m);
+        __m128 y = _mm_set1_ps(LOG_P0);
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P1));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P2));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P3));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P4));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P5));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P6));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P7));
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P8));
+        y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+        y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(LOG_Q1)));
+        y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(LOG_Q2)));
+    }
+    #endif
+}
+
+void RadarLineProcessing::amplifyLine(const irr::f32* raw, const irr::f32* gain, irr::f32 rainFilter, irr::f32* amplified, irr::u32 steps)
+{
+    if (steps == 0) {
+        return;
+    }
+
+    amplified[0] = 0; //Step 0 is not scanned
+    irr::u32 j = 1;
+
+    //Signal is clamped to 1-e before the log, so the result is 0-1
+    #ifdef RADAR_USE_AVX
+    const __m256 rainAVX = _mm256_set1_ps(rainFilter);
+    const __m256 notRainAVX = _mm256_set1_ps(1-rainFilter);
+    for (; j + 8 <= steps; j += 8) {
+        __m256 current = _mm256_loadu_ps(raw + j);
+        __m256 previous = _mm256_loadu_ps(raw + j - 1);
+        __m256 gradient = _mm256_max_ps(_mm256_sub_ps(current, previous), _mm256_setzero_ps());
+        __m256 filtered = _mm256_add_ps(_mm256_mul_ps(gradient, rainAVX), _mm256_mul_ps(current, notRainAVX));
+        __m256 signal = _mm256_mul_ps(filtered, _mm256_loadu_ps(gain + j));
+        signal = _mm256_min_ps(_mm256_max_ps(signal, _mm256_set1_ps(1.0f)), _mm256_set1_ps(E));
+        _mm256_storeu_ps(amplified + j, logAVX(signal));
+    }
+    #endif
+
+    #ifdef RADAR_USE_SSE2
+    const __m128 rainSSE = _mm_set1_ps(rainFilter);
+    const __m128 notRainSSE = _mm_set1_ps(1-rainFilter);
+    for (; j + 4 <= steps; j += 4) {
+        __m128 current = _mm_loadu_ps(raw + j);
+        __m128 previous = _mm_loadu_ps(raw + j - 1);
+        __m128 gradient = _mm_max_ps(_mm_sub_ps(current, previous), _mm_setzero_ps());
+        __m128 filtered = _mm_add_ps(_mm_mul_ps(gradient, rainSSE), _mm_mul_ps(current, notRainSSE));
+        __m128 signal = _mm_mul_ps(filtered, _mm_loadu_ps(gain + j));
+        signal = _mm_min_ps(_mm_max_ps(signal, _mm_set1_ps(1.0f)), _mm_set1_ps(E));
+        _mm_storeu_ps(amplified + j, logSSE2(signal));
+    }
+    #endif
+
+    //Remainder, or all if no SIMD available
+    for (; j < steps; j++) {
+        amplified[j] = amplifyScalar(raw[j], raw[j-1], gain[j], rainFilter);
+    }
+}
+
+void RadarLineProcessing::maxOfLines(const irr::f32* const* lines, irr::u32 numberOfLines, irr::f32* output, irr::u32 startStep, irr::u32 endStep)
+{
+    if (numberOfLines == 0) {
+        return;
+    }
+
+    irr::u32 j = startStep;
+
+    #ifdef RADAR_USE_AVX
+    for (; j + 8 <= endStep; j += 8) {
+        __m256 maximum = _mm256_loadu_ps(lines[0] + j);
+        for (irr::u32 k = 1; k < numberOfLines; k++) {
+            maximum = _mm256_max_ps(maximum, _mm256_loadu_ps(lines[k] + j));
+        }
+        _mm256_storeu_ps(output + j, maximum);
+    }
+    #endif
+
+    #ifdef RADAR_USE_SSE2
+    for (; j + 4 <= endStep; j += 4) {
+        __m128 maximum = _mm_loadu_ps(lines[0] + j);
+        for (irr::u32 k = 1; k < numberOfLines; k++) {
+            maximum = _mm_max_ps(maximum, _mm_loadu_ps(lines[k] + j));
+        }
+        _mm_storeu_ps(output + j, maximum);
+    }
+    #endif
+
+    for (; j < endStep; j++) {
+        irr::f32 maximum = lines[0][j];
+        for (irr::u32 k = 1; k < numberOfLines; k++) {
+            if (lines[k][j] > maximum) {
+                maximum = lines[k][j];
+            }
+        }
+        output[j] = maximum;
+    }
+}
@@ -0,0 +1,33 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __RADARLINEPROCESSING_HPP_INCLUDED__
+#define __RADARLINEPROCESSING_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+//Post processing of a complete radar scan line, working on a whole line at a time.
+//Uses SSE2 or AVX where available at compile time, with a scalar fallback.
+namespace RadarLineProcessing
+{
+    //Rain clutter high pass filter, gain and log amplification, from raw[1] to raw[steps-1]. Output is clamped to 0-1, and amplified[0] is set to 0.
+    void amplifyLine(const irr::f32* raw, const irr::f32* gain, irr::f32 rainFilter, irr::f32* amplified, irr::u32 steps);
+
+    //output[step] = maximum of lines[0..numberOfLines-1][step], for startStep <= step < endStep
+    void maxOfLines(const irr::f32* const* lines, irr::u32 numberOfLines, irr::f32* output, irr::u32 startStep, irr::u32 endStep);
+}
+
+#endif // __RADARLINEPROCESSING_HPP_INCLUDED__
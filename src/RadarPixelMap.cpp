@@ -0,0 +1,183 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "RadarPixelMap.hpp"
+#include "RadarScanArray.hpp"
+
+#include <cmath>
+
+RadarPixelMap::RadarPixelMap()
+{
+    bitmapWidth = 0;
+    pitchPixels = 0;
+    angularResolution = 0;
+    rangeResolution = 0;
+}
+
+bool RadarPixelMap::update(irr::u32 bitmapWidth, irr::u32 pitchPixels, irr::u32 angularResolution, irr::u32 rangeResolution)
+{
+    if (this->bitmapWidth == bitmapWidth &&
+        this->pitchPixels == pitchPixels &&
+        this->angularResolution == angularResolution &&
+        this->rangeResolution == rangeResolution) {
+        //Nothing has changed
+        return false;
+    }
+
+    this->bitmapWidth = bitmapWidth;
+    this->pitchPixels = pitchPixels;
+    this->angularResolution = angularResolution;
+    this->rangeResolution = rangeResolution;
+
+    pixels.clear();
+    linePixels.clear();
+    lineStart.assign(angularResolution+1, 0);
+    lineBounds.assign(angularResolution, irr::core::rect<irr::s32>(0,0,0,0));
+
+    if (bitmapWidth == 0 || angularResolution == 0 || rangeResolution == 0) {
+        return true;
+    }
+
+    irr::f32 centrePixel = (bitmapWidth-1.0)/2.0; //The centre of the bitmap. Normally this will be a fractional number (##.5)
+    irr::f32 pixelsPerStep = bitmapWidth*0.5/(irr::f32)rangeResolution;
+    irr::f32 linesPerDegree = angularResolution/360.0;
+
+    //Find the cell shown in each pixel. Each cell covers +-0.5 steps and +-0.5 scan lines about its centre. Step 0 is never drawn.
+    std::vector<irr::u32> pixelsInLine(angularResolution, 0);
+    for (irr::u32 j = 0; j < bitmapWidth; j++) {
+        irr::f32 localY = j - centrePixel;
+        for (irr::u32 i = 0; i < bitmapWidth; i++) {
+            irr::f32 localX = i - centrePixel;
+            irr::f32 localRadius = std::sqrt(localX*localX + localY*localY);
+            irr::s32 step = (irr::s32)std::floor(localRadius/pixelsPerStep + 0.5);
+            if (step < 1 || step >= (irr::s32)rangeResolution) {
+                continue;
+            }
+
+            irr::f32 localAngle = irr::core::RADTODEG*std::atan2(localX,-1*localY); //Clockwise from up
+            if (localAngle < 0) {
+                localAngle += 360;
+            }
+
+            RadarPixel pixel;
+            pixel.pixelIndex = j*pitchPixels + i;
+            pixel.lineAngle = localAngle*linesPerDegree;
+            pixel.step = step;
+            irr::u32 line = pixelLine(pixel, 0);
+
+            //Record bounds of each north up scan line
+            if (pixelsInLine[line] == 0) {
+                lineBounds[line] = irr::core::rect<irr::s32>(i, j, i+1, j+1);
+            } else {
+                lineBounds[line].addInternalPoint(i+1, j+1);
+                lineBounds[line].addInternalPoint(i, j);
+            }
+            pixelsInLine[line]++;
+            pixels.push_back(pixel);
+        }
+    }
+
+    //Group pixel indices by north up scan line
+    for (irr::u32 line = 0; line < angularResolution; line++) {
+        lineStart[line+1] = lineStart[line] + pixelsInLine[line];
+    }
+    linePixels.resize(pixels.size());
+    std::vector<irr::u32> nextInLine(lineStart.begin(), lineStart.end()-1);
+    for (irr::u32 k = 0; k < pixels.size(); k++) {
+        linePixels[nextInLine[pixelLine(pixels[k], 0)]++] = k;
+    }
+
+    return true;
+}
+
+void RadarPixelMap::renderAll(irr::u32* pixels, const RadarScanArray& plotArray, irr::f32 lineOffset, const irr::u32* colourLookup) const
+{
+    irr::f32 normalisedOffset = normaliseLineOffset(lineOffset);
+    for (std::vector<RadarPixel>::const_iterator it = this->pixels.begin(); it != this->pixels.end(); ++it) {
+        renderPixel(pixels, plotArray, *it, pixelLine(*it, normalisedOffset), colourLookup);
+    }
+}
+
+void RadarPixelMap::renderLine(irr::u32* pixels, const RadarScanArray& plotArray, irr::u32 scanLine, irr::f32 lineOffset, const irr::u32* colourLookup) const
+{
+    if (scanLine >= angularResolution) {
+        return;
+    }
+
+    //With a rotation, pixels showing this line are in at most two of the north up groups
+    irr::f32 normalisedOffset = normaliseLineOffset(lineOffset);
+    irr::u32 wholeOffset = (irr::u32)normalisedOffset;
+    irr::u32 groupsToCheck = (normalisedOffset > wholeOffset) ? 2 : 1;
+
+    for (irr::u32 g = 0; g < groupsToCheck; g++) {
+        irr::u32 group = (scanLine + 2*angularResolution - wholeOffset - g) % angularResolution;
+        for (irr::u32 k = lineStart[group]; k < lineStart[group+1]; k++) {
+            const RadarPixel& pixel = this->pixels[linePixels[k]];
+            if (pixelLine(pixel, normalisedOffset) == scanLine) {
+                renderPixel(pixels, plotArray, pixel, scanLine, colourLookup);
+            }
+        }
+    }
+}
+
+irr::core::rect<irr::s32> RadarPixelMap::getLineBounds(irr::u32 scanLine, irr::f32 lineOffset) const
+{
+    if (scanLine >= angularResolution) {
+        return irr::core::rect<irr::s32>(0,0,0,0);
+    }
+
+    irr::f32 normalisedOffset = normaliseLineOffset(lineOffset);
+    irr::u32 wholeOffset = (irr::u32)normalisedOffset;
+
+    irr::u32 group = (scanLine + 2*angularResolution - wholeOffset) % angularResolution;
+    irr::core::rect<irr::s32> bounds = lineBounds[group];
+    if (normalisedOffset > wholeOffset) {
+        irr::u32 previousGroup = (group + angularResolution - 1) % angularResolution;
+        bounds.addInternalPoint(lineBounds[previousGroup].UpperLeftCorner);
+        bounds.addInternalPoint(lineBounds[previousGroup].LowerRightCorner);
+    }
+    return bounds;
+}
+
+irr::f32 RadarPixelMap::normaliseLineOffset(irr::f32 lineOffset) const
+{
+    lineOffset = std::fmod(lineOffset, (irr::f32)angularResolution);
+    if (lineOffset < 0) {
+        lineOffset += angularResolution;
+    }
+    if (lineOffset >= angularResolution) {
+        lineOffset = 0;
+    }
+    return lineOffset;
+}
+
+irr::u32 RadarPixelMap::pixelLine(const RadarPixel& pixel, irr::f32 normalisedOffset) const
+{
+    //Nearest scan line, wrapping round. Both lineAngle and the offset are in the range 0 to angularResolution.
+    irr::u32 line = (irr::u32)(pixel.lineAngle + normalisedOffset + 0.5f);
+    while (line >= angularResolution) {
+        line -= angularResolution;
+    }
+    return line;
+}
+
+void RadarPixelMap::renderPixel(irr::u32* pixels, const RadarScanArray& plotArray, const RadarPixel& pixel, irr::u32 scanLine, const irr::u32* colourLookup) const
+{
+    irr::f32 pixelColour = plotArray[scanLine][pixel.step];
+    if (pixelColour > 1.0) {pixelColour = 1.0;}
+    if (pixelColour < 0)   {pixelColour =   0;}
+    pixels[pixel.pixelIndex] = colourLookup[(irr::u32)(pixelColour*(RADAR_COLOUR_LEVELS-1) + 0.5f)];
+}
@@ -0,0 +1,66 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __RADARPIXELMAP_HPP_INCLUDED__
+#define __RADARPIXELMAP_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <vector>
+
+class RadarScanArray;
+
+const irr::u32 RADAR_COLOUR_LEVELS = 256; //Entries in the colour look up table passed to render functions, for intensity 0 to 1
+
+//Precalculated mapping from each pixel of the radar picture to the (scan line, step) cell it displays, in the north up orientation.
+//For head up, the scan line is offset by the heading (in scan lines), so the same map can be used for any rotation.
+//Pixels are stored in raster order for whole picture redraws, and also grouped by north up scan line, so single lines can be redrawn.
+class RadarPixelMap
+{
+    public:
+        RadarPixelMap();
+        bool update(irr::u32 bitmapWidth, irr::u32 pitchPixels, irr::u32 angularResolution, irr::u32 rangeResolution); //Rebuild the map if any input has changed. Returns true if rebuilt.
+
+        //Write the colour for each pixel into an A8R8G8B8 image. lineOffset is the rotation of the picture in scan lines (heading/scan angle step for head up, 0 for north up)
+        void renderAll(irr::u32* pixels, const RadarScanArray& plotArray, irr::f32 lineOffset, const irr::u32* colourLookup) const;
+        void renderLine(irr::u32* pixels, const RadarScanArray& plotArray, irr::u32 scanLine, irr::f32 lineOffset, const irr::u32* colourLookup) const;
+
+        //Bounding rectangle of the pixels showing a scan line, for the given rotation
+        irr::core::rect<irr::s32> getLineBounds(irr::u32 scanLine, irr::f32 lineOffset) const;
+
+    private:
+        struct RadarPixel {
+            irr::u32 pixelIndex; //y*pitch + x
+            irr::f32 lineAngle; //Bearing from centre, in scan lines (0 to angularResolution)
+            irr::u32 step;
+        };
+
+        irr::u32 bitmapWidth;
+        irr::u32 pitchPixels;
+        irr::u32 angularResolution;
+        irr::u32 rangeResolution;
+
+        std::vector<RadarPixel> pixels; //Raster order, only pixels within a displayed cell
+        std::vector<irr::u32> linePixels; //Index into pixels, grouped by north up scan line
+        std::vector<irr::u32> lineStart; //Start of each scan line's group in linePixels, with an extra entry at the end
+        std::vector<irr::core::rect<irr::s32> > lineBounds; //Bounding rectangle of each group
+
+        irr::f32 normaliseLineOffset(irr::f32 lineOffset) const; //Into the range 0 to angularResolution
+        irr::u32 pixelLine(const RadarPixel& pixel, irr::f32 normalisedOffset) const;
+        void renderPixel(irr::u32* pixels, const RadarScanArray& plotArray, const RadarPixel& pixel, irr::u32 scanLine, const irr::u32* colourLookup) const;
+};
+
+#endif // __RADARPIXELMAP_HPP_INCLUDED__
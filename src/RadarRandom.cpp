@@ -0,0 +1,145 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "RadarRandom.hpp"
+
+#include <vector>
+
+//The shaped distributions are sampled by inverse CDF, from a table indexed by the top bits of a random number, interpolated using the remaining bits.
+const irr::u32 TABLE_BITS = 12;
+const irr::u32 TABLE_SIZE = 1 << TABLE_BITS;
+const irr::u32 FRACTION_BITS = 32 - TABLE_BITS;
+const irr::f32 FRACTION_SCALE = 1.0f/(1 << FRACTION_BITS);
+const irr::u32 HEAVY_TAIL_EXACT_BINS = 16; //Bins at the end of the heavy tail table where the curve is too steep to interpolate, so are calculated exactly
+
+struct RadarRandomTables {
+    std::vector<irr::f32> heavyTail; //TABLE_SIZE+1 entries, for v = 0 to 1, where u = 1-v
+    std::vector<irr::f32> averageOfFour; //TABLE_SIZE+1 entries, for probability 0 to 1
+
+    RadarRandomTables() {
+        heavyTail.assign(TABLE_SIZE+1, 0);
+        averageOfFour.assign(TABLE_SIZE+1, 0);
+
+        //u*((1/u)-1)^3 = (1-u)^3/u^2, which decreases as u increases, so sort by v = 1-u to give an increasing (inverse CDF) function v^3/(1-v)^2
+        for (irr::u32 i = 0; i < TABLE_SIZE; i++) {
+            double v = (double)i/TABLE_SIZE;
+            heavyTail[i] = v*v*v/((1-v)*(1-v));
+        }
+        heavyTail[TABLE_SIZE] = heavyTail[TABLE_SIZE-1]; //Not used, as v=1 is infinite
+
+        //The sum of four uniform values has the Irwin-Hall distribution. Invert its CDF by bisection.
+        for (irr::u32 i = 0; i <= TABLE_SIZE; i++) {
+            double probability = (double)i/TABLE_SIZE;
+            double low = 0;
+            double high = 4;
+            for (int iteration = 0; iteration < 60; iteration++) {
+                double mid = 0.5*(low + high);
+                if (irwinHallFourCDF(mid) < probability) {
+                    low = mid;
+                } else {
+                    high = mid;
+                }
+            }
+            averageOfFour[i] = 0.5*(low + high)/4.0;
+        }
+    }
+
+    static double irwinHallFourCDF(double x) {
+        //Probability that the sum of four uniform values is less than x
+        const double binomial[5] = {1, 4, 6, 4, 1};
+        double sum = 0;
+        for (int k = 0; k <= 4 && k <= x; k++) {
+            double term = binomial[k]*(x-k)*(x-k)*(x-k)*(x-k);
+            sum += (k % 2 == 0) ? term : -term;
+        }
+        return sum/24.0;
+    }
+};
+
+static const RadarRandomTables& getTables()
+{
+    static const RadarRandomTables tables; //Built once, on first use
+    return tables;
+}
+
+static inline irr::u32 rotateLeft(irr::u32 x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+RadarRandom::RadarRandom()
+{
+    seed(0);
+    getTables(); //Make sure tables are built before any sampling is needed
+}
+
+void RadarRandom::seed(uint64_t seedValue)
+{
+    //Expand the seed into the state with splitmix64, which never gives an all zero state
+    for (int i = 0; i < 4; i += 2) {
+        seedValue += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = seedValue;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z = z ^ (z >> 31);
+        state[i] = (irr::u32)z;
+        state[i+1] = (irr::u32)(z >> 32);
+    }
+}
+
+irr::u32 RadarRandom::next()
+{
+    irr::u32 result = rotateLeft(state[0] + state[3], 7) + state[0];
+    irr::u32 t = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotateLeft(state[3], 11);
+
+    return result;
+}
+
+irr::f32 RadarRandom::uniform()
+{
+    return (next() >> 8) * (1.0f/16777216.0f); //24 bits, so exactly representable
+}
+
+irr::f32 RadarRandom::heavyTail()
+{
+    const std::vector<irr::f32>& table = getTables().heavyTail;
+    irr::u32 randomBits = next();
+    irr::u32 index = randomBits >> FRACTION_BITS;
+    irr::f32 fraction = (randomBits & ((1 << FRACTION_BITS) - 1)) * FRACTION_SCALE;
+
+    if (index >= TABLE_SIZE - HEAVY_TAIL_EXACT_BINS) {
+        //Steep end of the tail. Use double, so v is never rounded up to 1.
+        double v = ((randomBits >> 8) + 0.5)/16777216.0;
+        return v*v*v/((1-v)*(1-v));
+    }
+    return table[index] + fraction*(table[index+1] - table[index]);
+}
+
+irr::f32 RadarRandom::averageOfFour()
+{
+    const std::vector<irr::f32>& table = getTables().averageOfFour;
+    irr::u32 randomBits = next();
+    irr::u32 index = randomBits >> FRACTION_BITS;
+    irr::f32 fraction = (randomBits & ((1 << FRACTION_BITS) - 1)) * FRACTION_SCALE;
+    return table[index] + fraction*(table[index+1] - table[index]);
+}
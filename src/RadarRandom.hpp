@@ -0,0 +1,41 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __RADARRANDOM_HPP_INCLUDED__
+#define __RADARRANDOM_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <stdint.h> //for uint64_t
+
+//Fast, seedable random number generator for radar noise (xoshiro128++), so the radar does not use the shared rand() state.
+//The same seed always gives the same sequence, on any platform.
+//Each instance must only be used from one thread at a time.
+class RadarRandom
+{
+    public:
+        RadarRandom();
+        void seed(uint64_t seedValue);
+        irr::u32 next(); //Uniform over all 32 bit values
+        irr::f32 uniform(); //Uniform, 0 <= value < 1
+        irr::f32 heavyTail(); //Distributed as u*((1/u)-1)^3, for u uniform between 0 and 1. Mostly small values, with an infinite tail up to high values.
+        irr::f32 averageOfFour(); //Distributed as the average of four uniform values between 0 and 1. Roughly gaussian, with mean 0.5.
+
+    private:
+        irr::u32 state[4];
+};
+
+#endif // __RADARRANDOM_HPP_INCLUDED__
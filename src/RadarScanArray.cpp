@@ -0,0 +1,120 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "RadarScanArray.hpp"
+
+#include <algorithm>
+#include <cstring> //For memcpy
+#include <stdint.h> //For uintptr_t
+
+RadarScanArray::RadarScanArray()
+{
+    offset = 0;
+    lines = 0;
+    steps = 0;
+    stride = 0;
+    wrapLines = 0;
+}
+
+RadarScanArray::RadarScanArray(const RadarScanArray& other)
+{
+    lines = other.lines;
+    steps = other.steps;
+    stride = other.stride;
+    wrapLines = other.wrapLines;
+    data.resize(other.data.size());
+    alignData();
+    if (!data.empty()) {
+        memcpy(&data[offset], &other.data[other.offset], (lines + 2*wrapLines)*stride*sizeof(irr::f32));
+    }
+}
+
+RadarScanArray& RadarScanArray::operator=(const RadarScanArray& other)
+{
+    if (this != &other) {
+        lines = other.lines;
+        steps = other.steps;
+        stride = other.stride;
+        wrapLines = other.wrapLines;
+        data.resize(other.data.size());
+        alignData();
+        if (!data.empty()) {
+            memcpy(&data[offset], &other.data[other.offset], (lines + 2*wrapLines)*stride*sizeof(irr::f32));
+        }
+    }
+    return *this;
+}
+
+void RadarScanArray::resize(irr::u32 lines, irr::u32 steps, irr::u32 wrapLines, irr::f32 value)
+{
+    this->lines = lines;
+    this->steps = steps;
+    this->wrapLines = wrapLines;
+    stride = ((steps + RADAR_SCAN_ARRAY_ALIGN - 1)/RADAR_SCAN_ARRAY_ALIGN)*RADAR_SCAN_ARRAY_ALIGN;
+
+    //Allocate enough extra to be able to align the start
+    data.assign((lines + 2*wrapLines)*stride + RADAR_SCAN_ARRAY_ALIGN, value);
+    alignData();
+}
+
+void RadarScanArray::fill(irr::f32 value)
+{
+    std::fill(data.begin(), data.end(), value);
+}
+
+void RadarScanArray::updateWrap(irr::u32 line)
+{
+    if (wrapLines == 0 || lines == 0) {
+        return;
+    }
+
+    //Check each wrap line before and after the main lines, and update if it mirrors this one
+    for (irr::s32 wrapLine = -(irr::s32)wrapLines; wrapLine < (irr::s32)(lines + wrapLines); wrapLine++) {
+        if (wrapLine == 0) {
+            //Skip over the main lines
+            wrapLine = lines - 1;
+            continue;
+        }
+        irr::s32 mirroredLine = wrapLine % (irr::s32)lines;
+        if (mirroredLine < 0) {
+            mirroredLine += lines;
+        }
+        if (mirroredLine == (irr::s32)line) {
+            memcpy((*this)[wrapLine], (*this)[line], stride*sizeof(irr::f32));
+        }
+    }
+}
+
+void RadarScanArray::copyLine(const RadarScanArray& source, irr::u32 line)
+{
+    memcpy((*this)[line], source[line], std::min(stride, source.stride)*sizeof(irr::f32));
+    updateWrap(line);
+}
+
+irr::u32 RadarScanArray::getStride() const
+{
+    return stride;
+}
+
+void RadarScanArray::alignData()
+{
+    offset = 0;
+    if (!data.empty()) {
+        uintptr_t address = (uintptr_t)&data[0];
+        uintptr_t alignBytes = RADAR_SCAN_ARRAY_ALIGN*sizeof(irr::f32);
+        offset = ((alignBytes - address % alignBytes) % alignBytes)/sizeof(irr::f32);
+    }
+}
@@ -0,0 +1,55 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __RADARSCANARRAY_HPP_INCLUDED__
+#define __RADARSCANARRAY_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <vector>
+
+//Contiguous storage for radar scan values, accessed as array[line (angle)][step (range)].
+//Each line is padded to a multiple of RADAR_SCAN_ARRAY_ALIGN values and starts on an aligned boundary, so whole lines can be processed with SIMD.
+//Optionally, extra 'wrap' lines are kept before and after, holding copies of the lines at the other end, so lines -wrapLines to lines+wrapLines-1 can be read without wrapping the index.
+const irr::u32 RADAR_SCAN_ARRAY_ALIGN = 8; //In floats, so 32 bytes
+
+class RadarScanArray
+{
+    public:
+        RadarScanArray();
+        RadarScanArray(const RadarScanArray& other);
+        RadarScanArray& operator=(const RadarScanArray& other);
+        void resize(irr::u32 lines, irr::u32 steps, irr::u32 wrapLines, irr::f32 value);
+        void fill(irr::f32 value);
+        void updateWrap(irr::u32 line); //Copy this line into any wrap lines that mirror it. Call after changing a line if wrapLines > 0.
+        void copyLine(const RadarScanArray& source, irr::u32 line); //Arrays must be the same size
+        irr::u32 getStride() const; //Values between the start of each line
+
+        irr::f32* operator[](irr::s32 line) {return &data[offset + (line + wrapLines)*stride];}
+        const irr::f32* operator[](irr::s32 line) const {return &data[offset + (line + wrapLines)*stride];}
+
+    private:
+        std::vector<irr::f32> data;
+        irr::u32 offset; //Index of the first aligned value in data
+        irr::u32 lines;
+        irr::u32 steps;
+        irr::u32 stride;
+        irr::u32 wrapLines;
+
+        void alignData();
+};
+
+#endif // __RADARSCANARRAY_HPP_INCLUDED__
@@ -0,0 +1,165 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "RadarScanGeometry.hpp"
+
+#include "Angles.hpp"
+#include "Constants.hpp"
+
+#include <cmath>
+
+RadarScanGeometry::RadarScanGeometry()
+{
+    valid = false;
+    rangeNm = 0;
+    angularResolution = 0;
+    rangeResolution = 0;
+    scannerHeight = 0;
+    gain = 0;
+    seaClutterReduction = 0;
+    rainClutterReduction = 0;
+    windDirectionDeg = 0;
+
+    cellLength = 0;
+    scanAngleStep = 0;
+    rainFilter = 0;
+}
+
+bool RadarScanGeometry::update(irr::f32 rangeNm, irr::u32 angularResolution, irr::u32 rangeResolution, irr::f32 scannerHeight, irr::f32 gain, irr::f32 seaClutterReduction, irr::f32 rainClutterReduction, irr::f32 windDirectionDeg)
+{
+    if (valid &&
+        this->rangeNm == rangeNm &&
+        this->angularResolution == angularResolution &&
+        this->rangeResolution == rangeResolution &&
+        this->scannerHeight == scannerHeight &&
+        this->gain == gain &&
+        this->seaClutterReduction == seaClutterReduction &&
+        this->rainClutterReduction == rainClutterReduction &&
+        this->windDirectionDeg == windDirectionDeg) {
+        //Nothing has changed
+        return false;
+    }
+
+    this->rangeNm = rangeNm;
+    this->angularResolution = angularResolution;
+    this->rangeResolution = rangeResolution;
+    this->scannerHeight = scannerHeight;
+    this->gain = gain;
+    this->seaClutterReduction = seaClutterReduction;
+    this->rainClutterReduction = rainClutterReduction;
+    this->windDirectionDeg = windDirectionDeg;
+
+    rebuild();
+    valid = true;
+    return true;
+}
+
+irr::f32 RadarScanGeometry::getCellLength() const
+{
+    return cellLength;
+}
+
+irr::f32 RadarScanGeometry::getScanAngleStep() const
+{
+    return scanAngleStep;
+}
+
+irr::f32 RadarScanGeometry::getRainFilter() const
+{
+    return rainFilter;
+}
+
+void RadarScanGeometry::rebuild()
+{
+    //Convert range to cell size
+    cellLength = M_IN_NM*rangeNm/rangeResolution;
+    scanAngleStep = 360.0f / (irr::f32) angularResolution;
+
+    //Per scan line
+    lineAngle.assign(angularResolution,0);
+    lineMinAngle.assign(angularResolution,0);
+    lineMaxAngle.assign(angularResolution,0);
+    lineSin.assign(angularResolution,0);
+    lineCos.assign(angularResolution,0);
+    lineSinMin.assign(angularResolution,0);
+    lineCosMin.assign(angularResolution,0);
+    lineSinMax.assign(angularResolution,0);
+    lineCosMax.assign(angularResolution,0);
+    lineSeaClutterWindFactor.assign(angularResolution,0);
+
+    for (irr::u32 i = 0; i < angularResolution; i++) {
+        irr::f32 scanAngle = ((irr::f32) i / (irr::f32) angularResolution) * 360.0f;
+        irr::f32 minCellAngle = Angles::normaliseAngle(scanAngle - scanAngleStep/2.0);
+        irr::f32 maxCellAngle = Angles::normaliseAngle(scanAngle + scanAngleStep/2.0);
+
+        lineAngle[i] = scanAngle;
+        lineMinAngle[i] = minCellAngle;
+        lineMaxAngle[i] = maxCellAngle;
+        lineSin[i] = sin(scanAngle*irr::core::DEGTORAD);
+        lineCos[i] = cos(scanAngle*irr::core::DEGTORAD);
+        lineSinMin[i] = sin(minCellAngle*irr::core::DEGTORAD);
+        lineCosMin[i] = cos(minCellAngle*irr::core::DEGTORAD);
+        lineSinMax[i] = sin(maxCellAngle*irr::core::DEGTORAD);
+        lineCosMax[i] = cos(maxCellAngle*irr::core::DEGTORAD);
+
+        //Apply directional correction to the clutter, so most is upwind, some is downwind. Mean value = 1
+        irr::f32 relativeWindAngle = (windDirectionDeg - scanAngle)*RAD_IN_DEG;
+        lineSeaClutterWindFactor[i] = 2.5*(0.5*(cos(2*relativeWindAngle)+1))*(0.5+sin(relativeWindAngle/2.0)*0.5);
+    }
+
+    //Per step
+    stepRange.assign(rangeResolution,0);
+    stepMinRange.assign(rangeResolution,0);
+    stepMaxRange.assign(rangeResolution,0);
+    stepDropWithCurvature.assign(rangeResolution,0);
+    stepHeightCorrection.assign(rangeResolution,0);
+    stepVesselFactor.assign(rangeResolution,0);
+    stepLandFactor.assign(rangeResolution,0);
+    stepSeaClutterFactor.assign(rangeResolution,0);
+    stepRainClutterFactor.assign(rangeResolution,0);
+    stepAmplification.assign(rangeResolution,0);
+
+    //Calculate from parameters
+    rainFilter = pow(rainClutterReduction/100.0,0.1);
+    irr::f32 maxSTCdistance = 8*M_IN_NM*seaClutterReduction/100.0; //This sets the distance at which the swept gain control becomes 1, and is 8Nm at full reduction
+    irr::f32 radarBaseGain = 500000*(8*pow(gain/100.0,4));
+
+    for (irr::u32 j = 1; j < rangeResolution; j++) {
+        irr::f32 localRange = cellLength*j;
+
+        stepRange[j] = localRange;
+        stepMinRange[j] = localRange - cellLength/2.0;
+        stepMaxRange[j] = localRange + cellLength/2.0;
+
+        //get adjustment of height for earth's curvature
+        stepDropWithCurvature[j] = std::pow(localRange,2)/(2*EARTH_RAD_M*EARTH_RAD_CORRECTION);
+        stepHeightCorrection[j] = stepDropWithCurvature[j] + scannerHeight;
+
+        stepVesselFactor[j] = std::pow(M_IN_NM/localRange,4);
+        stepLandFactor[j] = 1.0/std::pow(localRange/M_IN_NM,3);
+        stepSeaClutterFactor[j] = pow((M_IN_NM/localRange),3);
+        stepRainClutterFactor[j] = pow((M_IN_NM/localRange),2);
+
+        irr::f32 radarSTCGain;
+        if(maxSTCdistance>0) {
+            radarSTCGain = pow(localRange/maxSTCdistance,3);
+            if (radarSTCGain > 1) {radarSTCGain=1;} //Gain should never be increased (above 1.0)
+        } else {
+            radarSTCGain = 1;
+        }
+        stepAmplification[j] = radarBaseGain * radarSTCGain;
+    }
+}
@@ -0,0 +1,78 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __RADARSCANGEOMETRY_HPP_INCLUDED__
+#define __RADARSCANGEOMETRY_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <vector>
+
+//Cached polar cell geometry for the radar scan. None of these values depend on the scene, only on
+//the radar range, resolution, scanner height and control settings, so they are only rebuilt when one of these changes.
+//The tables are read directly by RadarCalculation::scan(), and should be treated as read only outside this class.
+class RadarScanGeometry
+{
+    public:
+        RadarScanGeometry();
+        bool update(irr::f32 rangeNm, irr::u32 angularResolution, irr::u32 rangeResolution, irr::f32 scannerHeight, irr::f32 gain, irr::f32 seaClutterReduction, irr::f32 rainClutterReduction, irr::f32 windDirectionDeg); //Rebuild tables if any input has changed. Returns true if rebuilt.
+        irr::f32 getCellLength() const; //Metres
+        irr::f32 getScanAngleStep() const; //Degrees
+        irr::f32 getRainFilter() const; //Rain clutter high pass filter weighting, 0-1
+
+        //Per scan line tables, indexed by scan line (bearing)
+        std::vector<irr::f32> lineAngle; //Degrees
+        std::vector<irr::f32> lineMinAngle; //Normalised angle of cell edge (Degrees)
+        std::vector<irr::f32> lineMaxAngle;
+        std::vector<irr::f32> lineSin;
+        std::vector<irr::f32> lineCos;
+        std::vector<irr::f32> lineSinMin;
+        std::vector<irr::f32> lineCosMin;
+        std::vector<irr::f32> lineSinMax;
+        std::vector<irr::f32> lineCosMax;
+        std::vector<irr::f32> lineSeaClutterWindFactor; //Directional correction for sea clutter, mean value 1
+
+        //Per step tables, indexed by step (range). Step 0 is not scanned, so is left as zero.
+        std::vector<irr::f32> stepRange; //Metres
+        std::vector<irr::f32> stepMinRange;
+        std::vector<irr::f32> stepMaxRange;
+        std::vector<irr::f32> stepDropWithCurvature; //Metres, adjustment of height for earth's curvature
+        std::vector<irr::f32> stepHeightCorrection; //Metres, dropWithCurvature + scanner height
+        std::vector<irr::f32> stepVesselFactor; //(1Nm/range)^4
+        std::vector<irr::f32> stepLandFactor; //(1Nm/range)^3
+        std::vector<irr::f32> stepSeaClutterFactor; //(1Nm/range)^3
+        std::vector<irr::f32> stepRainClutterFactor; //(1Nm/range)^2
+        std::vector<irr::f32> stepAmplification; //Overall gain, including swept gain control (STC)
+
+    private:
+        bool valid;
+        irr::f32 rangeNm;
+        irr::u32 angularResolution;
+        irr::u32 rangeResolution;
+        irr::f32 scannerHeight;
+        irr::f32 gain;
+        irr::f32 seaClutterReduction;
+        irr::f32 rainClutterReduction;
+        irr::f32 windDirectionDeg;
+
+        irr::f32 cellLength;
+        irr::f32 scanAngleStep;
+        irr::f32 rainFilter;
+
+        void rebuild();
+};
+
+#endif // __RADARSCANGEOMETRY_HPP_INCLUDED__
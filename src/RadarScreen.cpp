@@ -16,6 +16,7 @@
 
 #include "RadarScreen.hpp"
 #include <iostream>
+#include <cstring> //For memcpy
 
 #ifdef WITH_PROFILING
 #include "iprof.hpp"
@@ -27,7 +28,8 @@
 
 RadarScreen::RadarScreen()
 {
-
+    driver = 0;
+    lastRadarImage = 0;
 }
 
 RadarScreen::~RadarScreen()
@@ -55,7 +57,7 @@ void RadarScreen::setRadarDisplayRadius(irr::u32 radiusPx)
     radarRadiusPx = radiusPx;
 }
 
-void RadarScreen::update(irr::video::IImage* radarImage)
+void RadarScreen::update(irr::video::IImage* radarImage, irr::core::rect<irr::s32> changedRegion)
 {
     #ifdef WITH_PROFILING
     IPROF_FUNC;
@@ -63,7 +65,6 @@ void RadarScreen::update(irr::video::IImage* radarImage)
 
     irr::core::matrix4 m;
     irr::core::vector3df offsetTransformed;
-    irr::video::ITexture* oldTexture = 0;
 
     radarScreen->setVisible(true);
 
@@ -81,16 +82,33 @@ void RadarScreen::update(irr::video::IImage* radarImage)
     radarScreen->setPosition(parent->getPosition() + offsetTransformed);
 	radarScreen->setRotation(parent->getRotation()+irr::core::vector3df(-90+tilt,0,0));
 
-    }{ IPROF("Get old texture");
-
-    //Get old texture if it exists
-
-    if (radarScreen->getMaterialCount()>0) {
-        oldTexture = radarScreen->getMaterial(0).getTexture(0);
+    }{ IPROF("Update texture");
+    //Get the persistent texture for this size of image, and copy in the region that has changed
+    bool textureCreated = false;
+    irr::video::ITexture* radarTexture = getRadarTexture(radarImage, textureCreated);
+    if (!textureCreated) {
+        if (radarImage != lastRadarImage) {
+            //Switched image, so copy all of it
+            changedRegion = irr::core::rect<irr::s32>(0,0,radarImage->getDimension().Width,radarImage->getDimension().Height);
+        }
+        if (changedRegion.isValid() && changedRegion.getArea() > 0) {
+            if (!copyRegionToTexture(radarImage, radarTexture, changedRegion)) {
+                //Can't update in place, so replace the texture
+                for (std::vector<irr::video::ITexture*>::size_type i = 0; i < radarTextures.size(); i++) {
+                    if (radarTextures.at(i) == radarTexture) {
+                        radarTextures.erase(radarTextures.begin() + i);
+                        break;
+                    }
+                }
+                driver->removeTexture(radarTexture);
+                radarTexture = getRadarTexture(radarImage, textureCreated);
+            }
+        }
+    }
+    lastRadarImage = radarImage;
+    if (radarScreen->getMaterialCount()>0 && radarScreen->getMaterial(0).getTexture(0) != radarTexture) {
+        radarScreen->setMaterialTexture(0,radarTexture);
     }
-    }{ IPROF("Make texture from image");
-    //make texture from image and apply to the screen
-    radarScreen->setMaterialTexture(0,driver->addTexture("RadarImage",radarImage));
     }{ IPROF("Scale texture");
     //Scale the texture to get 1:1 image to screen pixel mapping
     irr::f32 radarTextureScaling=1;
@@ -99,13 +117,64 @@ void RadarScreen::update(irr::video::IImage* radarImage)
         if (radarTextureScaling > 1) {radarTextureScaling = 1;} //Don't scale if not needed
     }
     radarScreen->getMaterial(0).getTextureMatrix(0).setTextureScale(radarTextureScaling,radarTextureScaling); //Use this to scale to the correct size: Ratio between radarImage size and the screen pixel diameter.
-    }{ IPROF("Remove old texture");
-    //Remove old texture if it exists
-    if (oldTexture!=0) {
-            driver->removeTexture(oldTexture);
     }
+
+}
+
+irr::video::ITexture* RadarScreen::getRadarTexture(irr::video::IImage* radarImage, bool& created)
+{
+    //Find the texture for this size, or create it from the image if there isn't one
+    created = false;
+    for (std::vector<irr::video::ITexture*>::size_type i = 0; i < radarTextures.size(); i++) {
+        if (radarTextures.at(i)->getOriginalSize() == radarImage->getDimension()) {
+            return radarTextures.at(i);
+        }
+    }
+
+    //Keep a copy in memory, so the texture can be locked and partly updated without reading back from the graphics card
+    bool allowMemoryCopy = driver->getTextureCreationFlag(irr::video::ETCF_ALLOW_MEMORY_COPY);
+    driver->setTextureCreationFlag(irr::video::ETCF_ALLOW_MEMORY_COPY, true);
+    irr::core::stringw textureName = L"RadarImage";
+    textureName += radarImage->getDimension().Width;
+    irr::video::ITexture* radarTexture = driver->addTexture(textureName,radarImage);
+    driver->setTextureCreationFlag(irr::video::ETCF_ALLOW_MEMORY_COPY, allowMemoryCopy);
+
+    if (radarTexture) {
+        radarTextures.push_back(radarTexture);
+        created = true;
+    }
+    return radarTexture;
+}
+
+bool RadarScreen::copyRegionToTexture(irr::video::IImage* radarImage, irr::video::ITexture* texture, irr::core::rect<irr::s32> region)
+{
+    //Copy the rows in region from the image to the texture. Returns false if this isn't possible
+    if (!texture ||
+        texture->getColorFormat() != irr::video::ECF_A8R8G8B8 ||
+        radarImage->getColorFormat() != irr::video::ECF_A8R8G8B8 ||
+        texture->getSize() != radarImage->getDimension()) {
+        return false;
     }
 
+    region.clipAgainst(irr::core::rect<irr::s32>(0,0,radarImage->getDimension().Width,radarImage->getDimension().Height));
+    if (!region.isValid() || region.getArea() == 0) {
+        return true;
+    }
+
+    irr::u8* textureData = (irr::u8*)texture->lock();
+    if (!textureData) {
+        return false;
+    }
+    const irr::u8* imageData = (const irr::u8*)radarImage->getData();
+    irr::u32 rowBytes = region.getWidth()*4;
+    for (irr::s32 y = region.UpperLeftCorner.Y; y < region.LowerRightCorner.Y; y++) {
+        memcpy(textureData + y*texture->getPitch() + region.UpperLeftCorner.X*4,
+               imageData + y*radarImage->getPitch() + region.UpperLeftCorner.X*4,
+               rowBytes);
+    }
+    texture->unlock();
+    texture->regenerateMipMapLevels();
+    return true;
 }
 
 irr::scene::ISceneNode* RadarScreen::getSceneNode() const
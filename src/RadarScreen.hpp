@@ -19,6 +19,8 @@
 
 #include "irrlicht.h"
 
+#include <vector>
+
 class RadarScreen
 {
     public:
@@ -27,7 +29,7 @@ class RadarScreen
 
         void load(irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* parent, irr::core::vector3df offset, irr::f32 size, irr::f32 tilt);
         void setRadarDisplayRadius(irr::u32 radiusPx);
-        void update(irr::video::IImage* radarImage);
+        void update(irr::video::IImage* radarImage, irr::core::rect<irr::s32> changedRegion); //changedRegion is the part of radarImage that has changed since the last update
         irr::scene::ISceneNode* getSceneNode() const;
 
 
@@ -38,6 +40,11 @@ class RadarScreen
         irr::core::vector3df offset;
         irr::u32 radarRadiusPx;
 		irr::f32 tilt;
+        std::vector<irr::video::ITexture*> radarTextures; //Kept for each size of radar image used, and updated in place
+        irr::video::IImage* lastRadarImage; //Image last copied into a texture
+
+        irr::video::ITexture* getRadarTexture(irr::video::IImage* radarImage, bool& created);
+        bool copyRegionToTexture(irr::video::IImage* radarImage, irr::video::ITexture* texture, irr::core::rect<irr::s32> region);
 };
 
 #endif
@@ -0,0 +1,84 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "RadarTerrainCache.hpp"
+#include "RadarScanGeometry.hpp"
+#include "Terrain.hpp"
+
+#include <cmath>
+
+RadarTerrainCache::RadarTerrainCache()
+{
+    angularResolution = 0;
+    rangeResolution = 0;
+    cellLength = 0;
+    cellX = 0;
+    cellZ = 0;
+    centreX = 0;
+    centreZ = 0;
+}
+
+void RadarTerrainCache::update(const RadarScanGeometry& geometry, irr::u32 angularResolution, irr::u32 rangeResolution, irr::core::vector3d<int64_t> offsetPosition, irr::core::vector3df position)
+{
+    irr::f32 newCellLength = geometry.getCellLength();
+    if (newCellLength <= 0) {
+        return;
+    }
+
+    //Find which cell the ship is in
+    double absoluteX = (double)offsetPosition.X + position.X;
+    double absoluteZ = (double)offsetPosition.Z + position.Z;
+    int64_t newCellX = (int64_t)std::floor(absoluteX/newCellLength + 0.5);
+    int64_t newCellZ = (int64_t)std::floor(absoluteZ/newCellLength + 0.5);
+
+    //Centre of the sampled area in local coordinates. This changes if the offset position moves, even if the ship doesn't.
+    centreX = newCellX*(double)newCellLength - offsetPosition.X;
+    centreZ = newCellZ*(double)newCellLength - offsetPosition.Z;
+
+    if (this->angularResolution != angularResolution || this->rangeResolution != rangeResolution) {
+        this->angularResolution = angularResolution;
+        this->rangeResolution = rangeResolution;
+        heights.resize(angularResolution, rangeResolution, 0, 0.0);
+        lineValid.assign(angularResolution, false);
+    } else if (cellLength != newCellLength || cellX != newCellX || cellZ != newCellZ) {
+        lineValid.assign(angularResolution, false);
+    }
+
+    cellLength = newCellLength;
+    cellX = newCellX;
+    cellZ = newCellZ;
+}
+
+const irr::f32* RadarTerrainCache::getLine(const Terrain& terrain, const RadarScanGeometry& geometry, irr::u32 scanLine)
+{
+    irr::f32* heightLine = heights[scanLine];
+    if (!lineValid[scanLine]) {
+        irr::f32 sinScanAngle = geometry.lineSin[scanLine];
+        irr::f32 cosScanAngle = geometry.lineCos[scanLine];
+        sampleX.resize(rangeResolution);
+        sampleZ.resize(rangeResolution);
+        for (irr::u32 step = 1; step < rangeResolution; step++) { //Step 0 is not scanned
+            irr::f32 localRange = geometry.stepRange[step];
+            sampleX[step] = centreX + localRange*sinScanAngle;
+            sampleZ[step] = centreZ + localRange*cosScanAngle;
+        }
+        if (rangeResolution > 1) {
+            terrain.getHeights(&sampleX[1], &sampleZ[1], &heightLine[1], rangeResolution - 1);
+        }
+        lineValid[scanLine] = true;
+    }
+    return heightLine;
+}
@@ -0,0 +1,54 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __RADARTERRAINCACHE_HPP_INCLUDED__
+#define __RADARTERRAINCACHE_HPP_INCLUDED__
+
+#include "irrlicht.h"
+#include "RadarScanArray.hpp"
+
+#include <vector>
+#include <stdint.h> //for int64_t
+
+class Terrain;
+class RadarScanGeometry;
+
+//Terrain height at each radar scan cell, sampled around the own ship position rounded to the nearest cell length.
+//The terrain does not change, so the samples stay valid until the ship moves into a different cell, or the range or resolution changes.
+//Each scan line is sampled the first time it is needed after this, so the cache is rebuilt gradually as the radar sweeps.
+class RadarTerrainCache
+{
+    public:
+        RadarTerrainCache();
+        void update(const RadarScanGeometry& geometry, irr::u32 angularResolution, irr::u32 rangeResolution, irr::core::vector3d<int64_t> offsetPosition, irr::core::vector3df position); //Call once per sweep, before getLine()
+        const irr::f32* getLine(const Terrain& terrain, const RadarScanGeometry& geometry, irr::u32 scanLine); //Terrain height (not corrected for tide or curvature) for each step of the scan line
+
+    private:
+        RadarScanArray heights;
+        std::vector<bool> lineValid;
+
+        irr::u32 angularResolution;
+        irr::u32 rangeResolution;
+        irr::f32 cellLength;
+        int64_t cellX; //Own ship position in cells, from SW corner of world model
+        int64_t cellZ;
+        irr::f32 centreX; //Centre of the sampled area, relative to the current offset position
+        irr::f32 centreZ;
+        std::vector<irr::f32> sampleX; //Positions along the scan line being sampled
+        std::vector<irr::f32> sampleZ;
+};
+
+#endif // __RADARTERRAINCACHE_HPP_INCLUDED__
@@ -65,13 +65,14 @@ class ScenarioData {
     std::string scenarioName, worldName;
     irr::f32 startTime, sunRise, sunSet, weather, rainIntensity, visibilityRange, windDirection, windSpeed;
     irr::u32 startDay, startMonth, startYear;
+    irr::u32 radarSeed; // radarSeed not serialised, so only applies where the scenario is loaded from file. 0 if not set.
     OwnShipData ownShipData;
     std::vector<OtherShipData> otherShipsData;
     std::string description; // description only used in scenario editor
     bool multiplayerName, willOverwrite; // multiplayerName only used in scenario editor
     bool dataPopulated; // dataPopulated only used in scenario editor
 
-    ScenarioData():startTime(0),sunRise(0),sunSet(0),weather(0),rainIntensity(0),visibilityRange(0),windDirection(0),windSpeed(0),startDay(0),startMonth(0),startYear(0),description(""),multiplayerName(false),willOverwrite(false),dataPopulated(false){}
+    ScenarioData():startTime(0),sunRise(0),sunSet(0),weather(0),rainIntensity(0),visibilityRange(0),windDirection(0),windSpeed(0),startDay(0),startMonth(0),startYear(0),radarSeed(0),description(""),multiplayerName(false),willOverwrite(false),dataPopulated(false){}
 
     std::string serialise(bool withSpaces);
     void deserialise(std::string data);
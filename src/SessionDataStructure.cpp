@@ -0,0 +1,288 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "SessionDataStructure.hpp"
+
+#include <cstring> //For memcpy
+
+namespace SessionData {
+
+    void writeU32(std::string& data, irr::u32 value)
+    {
+        while (value >= 0x80) {
+            data.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        data.push_back((char)value);
+    }
+
+    void writeF32(std::string& data, irr::f32 value)
+    {
+        irr::u32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (irr::u32 i = 0; i < 4; i++) {
+            data.push_back((char)((bits >> (8*i)) & 0xFF));
+        }
+    }
+
+    bool readU32(const std::string& data, size_t& position, irr::u32& value)
+    {
+        value = 0;
+        for (irr::u32 shift = 0; shift < 35; shift += 7) {
+            if (position >= data.size()) {
+                return false;
+            }
+            irr::u8 byte = (irr::u8)data[position];
+            position++;
+            value |= (irr::u32)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false; //Too long to be valid
+    }
+
+    bool readF32(const std::string& data, size_t& position, irr::f32& value)
+    {
+        if (position + 4 > data.size()) {
+            return false;
+        }
+        irr::u32 bits = 0;
+        for (irr::u32 i = 0; i < 4; i++) {
+            bits |= (irr::u32)(irr::u8)data[position + i] << (8*i);
+        }
+        position += 4;
+        memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+}
+
+SessionControls::SessionControls()
+{
+    for (irr::u32 i = 0; i < E_SESSION_CONTROL_NUMBER; i++) {
+        values[i] = 0;
+    }
+}
+
+std::string SessionControls::serialise(const SessionControls& previous, bool allValues) const
+{
+    irr::u32 changed = 0;
+    for (irr::u32 i = 0; i < E_SESSION_CONTROL_NUMBER; i++) {
+        if (allValues || values[i] != previous.values[i]) {
+            changed |= (1u << i);
+        }
+    }
+
+    std::string serialised;
+    if (changed == 0) {
+        return serialised;
+    }
+
+    SessionData::writeU32(serialised, changed);
+    for (irr::u32 i = 0; i < E_SESSION_CONTROL_NUMBER; i++) {
+        if (changed & (1u << i)) {
+            SessionData::writeF32(serialised, values[i]);
+        }
+    }
+    return serialised;
+}
+
+irr::u32 SessionControls::deserialise(const std::string& data)
+{
+    size_t position = 0;
+    irr::u32 changed = 0;
+    if (!SessionData::readU32(data, position, changed)) {
+        return 0;
+    }
+
+    irr::u32 applied = 0;
+    for (irr::u32 i = 0; i < E_SESSION_CONTROL_NUMBER; i++) {
+        if (changed & (1u << i)) {
+            if (!SessionData::readF32(data, position, values[i])) {
+                break;
+            }
+            applied |= (1u << i);
+        }
+    }
+    return applied;
+}
+
+std::string SessionKeyframe::serialise() const
+{
+    std::string serialised;
+
+    SessionData::writeF32(serialised, scenarioTime);
+
+    SessionData::writeF32(serialised, ownShip.posX);
+    SessionData::writeF32(serialised, ownShip.posZ);
+    SessionData::writeF32(serialised, ownShip.heading);
+    SessionData::writeF32(serialised, ownShip.speed);
+    SessionData::writeF32(serialised, ownShipLateralSpeed);
+    SessionData::writeF32(serialised, ownShipRateOfTurn);
+    SessionData::writeF32(serialised, ownShipRudder);
+    SessionData::writeF32(serialised, ownShipPortEngine);
+    SessionData::writeF32(serialised, ownShipStbdEngine);
+    SessionData::writeF32(serialised, ownShipPortAzimuthAngle);
+    SessionData::writeF32(serialised, ownShipStbdAzimuthAngle);
+    SessionData::writeF32(serialised, ownShipPitch);
+    SessionData::writeF32(serialised, ownShipRoll);
+    SessionData::writeF32(serialised, ownShipWaveHeightFiltered);
+
+    SessionData::writeU32(serialised, otherShips.size());
+    for (std::vector<SessionShipState>::size_type i = 0; i < otherShips.size(); i++) {
+        const SessionShipState& otherShip = otherShips.at(i);
+        SessionData::writeF32(serialised, otherShip.posX);
+        SessionData::writeF32(serialised, otherShip.posZ);
+        SessionData::writeF32(serialised, otherShip.heading);
+        SessionData::writeF32(serialised, otherShip.speed);
+        SessionData::writeF32(serialised, otherShip.rateOfTurn);
+        SessionData::writeU32(serialised, otherShip.legs.size());
+        for (std::vector<Leg>::size_type j = 0; j < otherShip.legs.size(); j++) {
+            SessionData::writeF32(serialised, otherShip.legs.at(j).bearing);
+            SessionData::writeF32(serialised, otherShip.legs.at(j).speed);
+            SessionData::writeF32(serialised, otherShip.legs.at(j).startTime);
+            SessionData::writeF32(serialised, otherShip.legs.at(j).distance);
+        }
+    }
+
+    SessionData::writeU32(serialised, streamOverride ? 1 : 0);
+    SessionData::writeF32(serialised, streamOverrideDirection);
+    SessionData::writeF32(serialised, streamOverrideSpeed);
+
+    SessionData::writeU32(serialised, manOverboardVisible ? 1 : 0);
+    SessionData::writeF32(serialised, manOverboardPosX);
+    SessionData::writeF32(serialised, manOverboardPosZ);
+
+    SessionData::writeU32(serialised, lines.size());
+    for (std::vector<SessionLineState>::size_type i = 0; i < lines.size(); i++) {
+        const SessionLineState& line = lines.at(i);
+        SessionData::writeU32(serialised, line.startType);
+        SessionData::writeU32(serialised, line.startID);
+        SessionData::writeU32(serialised, line.endType);
+        SessionData::writeU32(serialised, line.endID);
+        SessionData::writeF32(serialised, line.startX);
+        SessionData::writeF32(serialised, line.startY);
+        SessionData::writeF32(serialised, line.startZ);
+        SessionData::writeF32(serialised, line.endX);
+        SessionData::writeF32(serialised, line.endY);
+        SessionData::writeF32(serialised, line.endZ);
+        SessionData::writeF32(serialised, line.nominalLength);
+        SessionData::writeF32(serialised, line.breakingTension);
+        SessionData::writeF32(serialised, line.breakingStrain);
+        SessionData::writeF32(serialised, line.nominalShipMass);
+        SessionData::writeU32(serialised, (line.keepSlack ? 1 : 0) | (line.heaveIn ? 2 : 0));
+    }
+
+    return serialised;
+}
+
+bool SessionKeyframe::deserialise(const std::string& data)
+{
+    size_t position = 0;
+    irr::u32 number = 0;
+    irr::u32 flags = 0;
+    irr::u32 value[4];
+
+    if (!(SessionData::readF32(data, position, scenarioTime) &&
+          SessionData::readF32(data, position, ownShip.posX) &&
+          SessionData::readF32(data, position, ownShip.posZ) &&
+          SessionData::readF32(data, position, ownShip.heading) &&
+          SessionData::readF32(data, position, ownShip.speed) &&
+          SessionData::readF32(data, position, ownShipLateralSpeed) &&
+          SessionData::readF32(data, position, ownShipRateOfTurn) &&
+          SessionData::readF32(data, position, ownShipRudder) &&
+          SessionData::readF32(data, position, ownShipPortEngine) &&
+          SessionData::readF32(data, position, ownShipStbdEngine) &&
+          SessionData::readF32(data, position, ownShipPortAzimuthAngle) &&
+          SessionData::readF32(data, position, ownShipStbdAzimuthAngle) &&
+          SessionData::readF32(data, position, ownShipPitch) &&
+          SessionData::readF32(data, position, ownShipRoll) &&
+          SessionData::readF32(data, position, ownShipWaveHeightFiltered) &&
+          SessionData::readU32(data, position, number))) {
+        return false;
+    }
+
+    otherShips.clear();
+    for (irr::u32 i = 0; i < number; i++) {
+        SessionShipState otherShip;
+        if (!(SessionData::readF32(data, position, otherShip.posX) &&
+              SessionData::readF32(data, position, otherShip.posZ) &&
+              SessionData::readF32(data, position, otherShip.heading) &&
+              SessionData::readF32(data, position, otherShip.speed) &&
+              SessionData::readF32(data, position, otherShip.rateOfTurn) &&
+              SessionData::readU32(data, position, value[0]))) {
+            return false;
+        }
+        for (irr::u32 j = 0; j < value[0]; j++) {
+            Leg leg;
+            if (!(SessionData::readF32(data, position, leg.bearing) &&
+                  SessionData::readF32(data, position, leg.speed) &&
+                  SessionData::readF32(data, position, leg.startTime) &&
+                  SessionData::readF32(data, position, leg.distance))) {
+                return false;
+            }
+            otherShip.legs.push_back(leg);
+        }
+        otherShips.push_back(otherShip);
+    }
+
+    if (!(SessionData::readU32(data, position, flags) &&
+          SessionData::readF32(data, position, streamOverrideDirection) &&
+          SessionData::readF32(data, position, streamOverrideSpeed))) {
+        return false;
+    }
+    streamOverride = (flags == 1);
+
+    if (!(SessionData::readU32(data, position, flags) &&
+          SessionData::readF32(data, position, manOverboardPosX) &&
+          SessionData::readF32(data, position, manOverboardPosZ) &&
+          SessionData::readU32(data, position, number))) {
+        return false;
+    }
+    manOverboardVisible = (flags == 1);
+
+    lines.clear();
+    for (irr::u32 i = 0; i < number; i++) {
+        SessionLineState line;
+        if (!(SessionData::readU32(data, position, value[0]) &&
+              SessionData::readU32(data, position, value[1]) &&
+              SessionData::readU32(data, position, value[2]) &&
+              SessionData::readU32(data, position, value[3]) &&
+              SessionData::readF32(data, position, line.startX) &&
+              SessionData::readF32(data, position, line.startY) &&
+              SessionData::readF32(data, position, line.startZ) &&
+              SessionData::readF32(data, position, line.endX) &&
+              SessionData::readF32(data, position, line.endY) &&
+              SessionData::readF32(data, position, line.endZ) &&
+              SessionData::readF32(data, position, line.nominalLength) &&
+              SessionData::readF32(data, position, line.breakingTension) &&
+              SessionData::readF32(data, position, line.breakingStrain) &&
+              SessionData::readF32(data, position, line.nominalShipMass) &&
+              SessionData::readU32(data, position, flags))) {
+            return false;
+        }
+        line.startType = value[0];
+        line.startID = value[1];
+        line.endType = value[2];
+        line.endID = value[3];
+        line.keepSlack = (flags & 1) != 0;
+        line.heaveIn = (flags & 2) != 0;
+        lines.push_back(line);
+    }
+
+    return true;
+}
@@ -0,0 +1,122 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __SESSIONDATASTRUCTURE_HPP_INCLUDED__
+#define __SESSIONDATASTRUCTURE_HPP_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "irrlicht.h"
+#include "Leg.hpp"
+
+//These classes are used as structures to hold the state stored in a recorded session, and therefore have all members as public.
+//Methods for binary serialisation and deserialisation are included for utility
+
+//A session file starts with SESSION_FILE_MAGIC, a version byte, the radar noise seed, and the serialised scenario.
+//It is followed by records, each of which is: type (1 byte), number of simulation steps since the previous record, payload length, payload.
+//All numbers except floats are stored as variable length unsigned integers (7 bits per byte, low bits first).
+const std::string SESSION_FILE_MAGIC = "BCSESSION";
+const irr::u8 SESSION_FILE_VERSION = 3;
+
+enum eSessionRecord {
+    E_SESSION_RECORD_STEP_TIME = 1, //Length of this and following simulation steps
+    E_SESSION_RECORD_CONTROLS = 2,  //Control inputs that have changed since the previous controls record
+    E_SESSION_RECORD_NETWORK = 3,   //Raw network message, as received
+    E_SESSION_RECORD_KEYFRAME = 4,  //Full simulation state, used to resynchronise and to seek
+    E_SESSION_RECORD_END = 5        //Total number of simulation steps recorded
+};
+
+//Index of each value in SessionControls
+enum eSessionControl {
+    E_SESSION_CONTROL_WHEEL = 0,
+    E_SESSION_CONTROL_PORT_ENGINE,
+    E_SESSION_CONTROL_STBD_ENGINE,
+    E_SESSION_CONTROL_BOW_THRUSTER,
+    E_SESSION_CONTROL_STERN_THRUSTER,
+    E_SESSION_CONTROL_PORT_SCHOTTEL,
+    E_SESSION_CONTROL_STBD_SCHOTTEL,
+    E_SESSION_CONTROL_PORT_THRUST_LEVER,
+    E_SESSION_CONTROL_STBD_THRUST_LEVER,
+    E_SESSION_CONTROL_WEATHER,
+    E_SESSION_CONTROL_RAIN,
+    E_SESSION_CONTROL_VISIBILITY,
+    E_SESSION_CONTROL_WIND_DIRECTION,
+    E_SESSION_CONTROL_WIND_SPEED,
+    E_SESSION_CONTROL_RUDDER_PUMP_1, //1 if working, 0 if not
+    E_SESSION_CONTROL_RUDDER_PUMP_2,
+    E_SESSION_CONTROL_FOLLOW_UP_RUDDER,
+    E_SESSION_CONTROL_MAN_OVERBOARD, //1 if released, 0 if not
+    E_SESSION_CONTROL_NUMBER //Number of controls, keep last
+};
+
+namespace SessionData {
+    void writeU32(std::string& data, irr::u32 value); //Variable length
+    void writeF32(std::string& data, irr::f32 value); //4 bytes, little endian
+    bool readU32(const std::string& data, size_t& position, irr::u32& value); //Returns false if past the end of the data
+    bool readF32(const std::string& data, size_t& position, irr::f32& value);
+}
+
+class SessionControls {
+    public:
+    irr::f32 values[E_SESSION_CONTROL_NUMBER];
+
+    SessionControls();
+
+    //Only values which differ from previous are stored. Returns an empty string if none have changed, unless allValues is set.
+    std::string serialise(const SessionControls& previous, bool allValues) const;
+    irr::u32 deserialise(const std::string& data); //Updates the values stored in data, and returns a bit mask of which these were
+};
+
+class SessionShipState {
+    public:
+    irr::f32 posX, posZ, heading, speed; //Position in absolute coordinates, speed in m/s
+    irr::f32 rateOfTurn; //Other ships only, used without legs (e.g. in multiplayer)
+    std::vector<Leg> legs; //Other ships only, as these can be changed during the session
+
+    SessionShipState():posX(0),posZ(0),heading(0),speed(0),rateOfTurn(0){}
+};
+
+class SessionLineState {
+    public:
+    int startType, startID, endType, endID; //As in Lines::getLineStartType, 0 if not attached yet
+    irr::f32 startX, startY, startZ, endX, endY, endZ; //Relative to the object attached to
+    irr::f32 nominalLength, breakingTension, breakingStrain, nominalShipMass;
+    bool keepSlack, heaveIn;
+
+    SessionLineState():startType(0),startID(0),endType(0),endID(0),startX(0),startY(0),startZ(0),endX(0),endY(0),endZ(0),nominalLength(0),breakingTension(0),breakingStrain(0),nominalShipMass(0),keepSlack(false),heaveIn(false){}
+};
+
+class SessionKeyframe {
+    public:
+    irr::f32 scenarioTime;
+    SessionShipState ownShip;
+    irr::f32 ownShipLateralSpeed, ownShipRateOfTurn;
+    irr::f32 ownShipRudder, ownShipPortEngine, ownShipStbdEngine, ownShipPortAzimuthAngle, ownShipStbdAzimuthAngle; //Actual values, which lag the controls
+    irr::f32 ownShipPitch, ownShipRoll, ownShipWaveHeightFiltered;
+    std::vector<SessionShipState> otherShips;
+    bool streamOverride;
+    irr::f32 streamOverrideDirection, streamOverrideSpeed;
+    bool manOverboardVisible;
+    irr::f32 manOverboardPosX, manOverboardPosZ;
+    std::vector<SessionLineState> lines;
+
+    SessionKeyframe():scenarioTime(0),ownShipLateralSpeed(0),ownShipRateOfTurn(0),ownShipRudder(0),ownShipPortEngine(0),ownShipStbdEngine(0),ownShipPortAzimuthAngle(0),ownShipStbdAzimuthAngle(0),ownShipPitch(0),ownShipRoll(0),ownShipWaveHeightFiltered(0),streamOverride(false),streamOverrideDirection(0),streamOverrideSpeed(0),manOverboardVisible(false),manOverboardPosX(0),manOverboardPosZ(0){}
+
+    std::string serialise() const;
+    bool deserialise(const std::string& data); //Returns false if the data is incomplete
+};
+
+#endif
@@ -0,0 +1,226 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "SessionPlayer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+SessionPlayer::SessionPlayer()
+{
+    loaded = false;
+    radarSeed = 0;
+    numberOfSteps = 0;
+    nextRecord = 0;
+}
+
+bool SessionPlayer::load(const std::string& filename)
+{
+    loaded = false;
+    records.clear();
+    stepTimes.clear();
+    keyframes.clear();
+    numberOfSteps = 0;
+    nextRecord = 0;
+
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not open session file " << filename << std::endl;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    //Header
+    size_t position = SESSION_FILE_MAGIC.size();
+    if (data.compare(0, SESSION_FILE_MAGIC.size(), SESSION_FILE_MAGIC) != 0 || position >= data.size()) {
+        std::cerr << filename << " is not a session file" << std::endl;
+        return false;
+    }
+    if ((irr::u8)data[position] != SESSION_FILE_VERSION) {
+        std::cerr << filename << " was recorded with an unsupported version" << std::endl;
+        return false;
+    }
+    position++;
+    irr::u32 scenarioLength = 0;
+    if (!SessionData::readU32(data, position, radarSeed) ||
+        !SessionData::readU32(data, position, scenarioLength) || position + scenarioLength > data.size()) {
+        std::cerr << filename << " is incomplete" << std::endl;
+        return false;
+    }
+    serialisedScenario = data.substr(position, scenarioLength);
+    position += scenarioLength;
+
+    //Index the records. A file cut short (e.g. if the recording program stopped unexpectedly) is used up to the last complete record.
+    irr::u32 step = 0;
+    while (position < data.size()) {
+        size_t recordStart = position;
+        irr::u8 type = (irr::u8)data[position];
+        position++;
+        irr::u32 stepDelta = 0;
+        irr::u32 payloadLength = 0;
+        if (!SessionData::readU32(data, position, stepDelta) ||
+            !SessionData::readU32(data, position, payloadLength) ||
+            position + payloadLength > data.size()) {
+            break;
+        }
+        step += stepDelta;
+
+        RecordIndex recordIndex;
+        recordIndex.step = step;
+        recordIndex.position = recordStart;
+
+        if (type == E_SESSION_RECORD_STEP_TIME) {
+            StepTimeIndex stepTimeIndex;
+            stepTimeIndex.step = step;
+            size_t payloadPosition = position;
+            if (SessionData::readF32(data, payloadPosition, stepTimeIndex.stepTime)) {
+                stepTimes.push_back(stepTimeIndex);
+            }
+        } else if (type == E_SESSION_RECORD_KEYFRAME) {
+            KeyframeIndex keyframeIndex;
+            keyframeIndex.step = step;
+            keyframeIndex.position = recordStart;
+            size_t payloadPosition = position;
+            //Scenario time is at the start of the keyframe
+            if (SessionData::readF32(data, payloadPosition, keyframeIndex.scenarioTime)) {
+                keyframes.push_back(keyframeIndex);
+            }
+        }
+
+        if (type == E_SESSION_RECORD_END) {
+            numberOfSteps = step;
+        } else {
+            records.push_back(recordIndex);
+            numberOfSteps = std::max(numberOfSteps, step + 1);
+        }
+
+        position += payloadLength;
+    }
+
+    loaded = true;
+    return true;
+}
+
+bool SessionPlayer::isLoaded() const
+{
+    return loaded;
+}
+
+std::string SessionPlayer::getSerialisedScenario() const
+{
+    return serialisedScenario;
+}
+
+irr::u32 SessionPlayer::getRadarSeed() const
+{
+    return radarSeed;
+}
+
+irr::u32 SessionPlayer::getNumberOfSteps() const
+{
+    return numberOfSteps;
+}
+
+irr::f32 SessionPlayer::getStepTime(irr::u32 step) const
+{
+    //Find the last step time change at or before this step
+    std::vector<StepTimeIndex>::const_iterator it = std::upper_bound(stepTimes.begin(), stepTimes.end(), step, laterStep);
+    if (it == stepTimes.begin()) {
+        return 0;
+    }
+    --it;
+    return it->stepTime;
+}
+
+irr::u32 SessionPlayer::getStepsDue(irr::u32 step, irr::f32 availableTime, irr::u32 maxSteps, irr::f32& usedTime) const
+{
+    irr::u32 steps = 0;
+    usedTime = 0;
+    while (steps < maxSteps && step + steps < numberOfSteps) {
+        irr::f32 stepTime = getStepTime(step + steps);
+        if (usedTime + stepTime > availableTime) {
+            break;
+        }
+        usedTime += stepTime;
+        steps++;
+    }
+    return steps;
+}
+
+bool SessionPlayer::readRecord(irr::u32 step, eSessionRecord& type, std::string& payload)
+{
+    while (nextRecord < records.size() && records.at(nextRecord).step <= step) {
+        std::vector<RecordIndex>::size_type thisRecord = nextRecord;
+        nextRecord++;
+        if (records.at(thisRecord).step < step) {
+            continue; //Shouldn't happen, as each step is read in turn
+        }
+        if (readRecordAt(records.at(thisRecord).position, type, payload) && type != E_SESSION_RECORD_STEP_TIME) {
+            return true;
+        }
+    }
+    return false;
+}
+
+irr::u32 SessionPlayer::seek(irr::f32 scenarioTime)
+{
+    if (keyframes.empty()) {
+        return 0;
+    }
+
+    std::vector<KeyframeIndex>::size_type chosen = 0;
+    for (std::vector<KeyframeIndex>::size_type i = 0; i < keyframes.size(); i++) {
+        if (keyframes.at(i).scenarioTime <= scenarioTime) {
+            chosen = i;
+        } else {
+            break;
+        }
+    }
+
+    //Point at the keyframe record, so it's the next one read
+    for (std::vector<RecordIndex>::size_type i = 0; i < records.size(); i++) {
+        if (records.at(i).position == keyframes.at(chosen).position) {
+            nextRecord = i;
+            break;
+        }
+    }
+    return keyframes.at(chosen).step;
+}
+
+bool SessionPlayer::readRecordAt(size_t position, eSessionRecord& type, std::string& payload) const
+{
+    if (position >= data.size()) {
+        return false;
+    }
+    type = (eSessionRecord)(irr::u8)data[position];
+    position++;
+    irr::u32 stepDelta = 0;
+    irr::u32 payloadLength = 0;
+    if (!SessionData::readU32(data, position, stepDelta) ||
+        !SessionData::readU32(data, position, payloadLength) ||
+        position + payloadLength > data.size()) {
+        return false;
+    }
+    payload = data.substr(position, payloadLength);
+    return true;
+}
+
+bool SessionPlayer::laterStep(irr::u32 step, const StepTimeIndex& stepTimeIndex)
+{
+    return step < stepTimeIndex.step;
+}
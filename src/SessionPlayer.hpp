@@ -0,0 +1,73 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __SESSIONPLAYER_HPP_INCLUDED__
+#define __SESSIONPLAYER_HPP_INCLUDED__
+
+#include "irrlicht.h"
+#include "SessionDataStructure.hpp"
+
+#include <string>
+#include <vector>
+
+//Reads back a session file written by SessionRecorder.
+//The whole file is held in memory, and indexed on loading so the step lengths are known in advance, and so replay can seek to any keyframe.
+class SessionPlayer
+{
+    public:
+        SessionPlayer();
+        bool load(const std::string& filename); //Returns false if the file can't be read, or isn't a session file
+        bool isLoaded() const;
+        std::string getSerialisedScenario() const;
+        irr::u32 getRadarSeed() const;
+
+        irr::u32 getNumberOfSteps() const;
+        irr::f32 getStepTime(irr::u32 step) const;
+        irr::u32 getStepsDue(irr::u32 step, irr::f32 availableTime, irr::u32 maxSteps, irr::f32& usedTime) const; //How many steps, starting from step, fit in availableTime
+
+        bool readRecord(irr::u32 step, eSessionRecord& type, std::string& payload); //Get the next record, if it is for this step. Step time records are skipped, as these are already indexed.
+        irr::u32 seek(irr::f32 scenarioTime); //Move to the last keyframe at or before scenarioTime (or the first keyframe), and return its step
+
+    private:
+        struct RecordIndex {
+            irr::u32 step;
+            size_t position; //Start of the record in data
+        };
+        struct StepTimeIndex {
+            irr::u32 step; //First step of this length
+            irr::f32 stepTime;
+        };
+        struct KeyframeIndex {
+            irr::u32 step;
+            size_t position;
+            irr::f32 scenarioTime;
+        };
+
+        bool loaded;
+        std::string data;
+        std::string serialisedScenario;
+        irr::u32 radarSeed;
+        std::vector<RecordIndex> records; //All records, in file order
+        std::vector<StepTimeIndex> stepTimes;
+        std::vector<KeyframeIndex> keyframes;
+        irr::u32 numberOfSteps;
+        std::vector<RecordIndex>::size_type nextRecord;
+
+        bool readRecordAt(size_t position, eSessionRecord& type, std::string& payload) const;
+        static bool laterStep(irr::u32 step, const StepTimeIndex& stepTimeIndex);
+};
+
+#endif // __SESSIONPLAYER_HPP_INCLUDED__
@@ -0,0 +1,119 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "SessionRecorder.hpp"
+
+SessionRecorder::SessionRecorder()
+{
+    lastStep = 0;
+    lastStepTime = 0;
+    stepTimeRecorded = false;
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    if (file.is_open()) {
+        close(lastStep);
+    }
+}
+
+bool SessionRecorder::open(const std::string& filename, const std::string& serialisedScenario, irr::u32 radarSeed)
+{
+    file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string header = SESSION_FILE_MAGIC;
+    header.push_back((char)SESSION_FILE_VERSION);
+    SessionData::writeU32(header, radarSeed);
+    SessionData::writeU32(header, serialisedScenario.size());
+    header.append(serialisedScenario);
+    file.write(header.data(), header.size());
+
+    lastStep = 0;
+    lastStepTime = 0;
+    stepTimeRecorded = false;
+    lastControls = SessionControls();
+
+    return file.good();
+}
+
+bool SessionRecorder::isOpen() const
+{
+    return file.is_open();
+}
+
+void SessionRecorder::close(irr::u32 step)
+{
+    if (!file.is_open()) {
+        return;
+    }
+    writeRecord(E_SESSION_RECORD_END, step, "");
+    file.close();
+}
+
+void SessionRecorder::recordStepTime(irr::u32 step, irr::f32 stepTime)
+{
+    if (stepTimeRecorded && stepTime == lastStepTime) {
+        return;
+    }
+    std::string payload;
+    SessionData::writeF32(payload, stepTime);
+    writeRecord(E_SESSION_RECORD_STEP_TIME, step, payload);
+    lastStepTime = stepTime;
+    stepTimeRecorded = true;
+}
+
+void SessionRecorder::recordControls(irr::u32 step, const SessionControls& controls)
+{
+    std::string payload = controls.serialise(lastControls, false);
+    if (!payload.empty()) {
+        writeRecord(E_SESSION_RECORD_CONTROLS, step, payload);
+        lastControls = controls;
+    }
+}
+
+void SessionRecorder::recordNetworkMessage(irr::u32 step, const std::string& message)
+{
+    writeRecord(E_SESSION_RECORD_NETWORK, step, message);
+}
+
+void SessionRecorder::recordKeyframe(irr::u32 step, const SessionKeyframe& keyframe, const SessionControls& controls)
+{
+    writeRecord(E_SESSION_RECORD_KEYFRAME, step, keyframe.serialise());
+    writeRecord(E_SESSION_RECORD_CONTROLS, step, controls.serialise(lastControls, true));
+    lastControls = controls;
+
+    //Keep what has been recorded so far if the program stops unexpectedly
+    file.flush();
+}
+
+void SessionRecorder::writeRecord(eSessionRecord type, irr::u32 step, const std::string& payload)
+{
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string record;
+    record.push_back((char)type);
+    SessionData::writeU32(record, step - lastStep);
+    SessionData::writeU32(record, payload.size());
+    record.append(payload);
+    file.write(record.data(), record.size());
+
+    lastStep = step;
+}
@@ -0,0 +1,52 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __SESSIONRECORDER_HPP_INCLUDED__
+#define __SESSIONRECORDER_HPP_INCLUDED__
+
+#include "irrlicht.h"
+#include "SessionDataStructure.hpp"
+
+#include <fstream>
+#include <string>
+
+//Writes a session file (format described in SessionDataStructure.hpp).
+//Records are labelled with the simulation step they apply before, so they can be fed back at the same point in replay.
+class SessionRecorder
+{
+    public:
+        SessionRecorder();
+        ~SessionRecorder();
+        bool open(const std::string& filename, const std::string& serialisedScenario, irr::u32 radarSeed); //Returns false if the file can't be written
+        bool isOpen() const;
+        void close(irr::u32 step); //Record the total number of steps, and close the file
+
+        void recordStepTime(irr::u32 step, irr::f32 stepTime); //Only recorded if changed from the last step time
+        void recordControls(irr::u32 step, const SessionControls& controls); //Only the changes since the last call are recorded
+        void recordNetworkMessage(irr::u32 step, const std::string& message);
+        void recordKeyframe(irr::u32 step, const SessionKeyframe& keyframe, const SessionControls& controls); //Also records all controls, so replay can start from here
+
+    private:
+        std::ofstream file;
+        irr::u32 lastStep; //Step of the last record written
+        irr::f32 lastStepTime;
+        bool stepTimeRecorded;
+        SessionControls lastControls;
+
+        void writeRecord(eSessionRecord type, irr::u32 step, const std::string& payload);
+};
+
+#endif // __SESSIONRECORDER_HPP_INCLUDED__
@@ -28,6 +28,8 @@ Ship::Ship()
     //Default to run on defined spd and hdg
     controlMode = MODE_AUTO;
     positionManuallyUpdated = false; //Used to track if position has been manually updated, and shouldn't have position update applied this loop
+    nodeInterpolated = false;
+    previousNodeStateStored = false;
     mmsi = 0;
 }
 
@@ -120,6 +122,54 @@ void Ship::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
     yPos += deltaY;
     zPos += deltaZ;
     ship->setPosition(irr::core::vector3df(xPos,yPos,zPos));
+
+    //Keep the stored states in the same frame of reference
+    irr::core::vector3df delta(deltaX,deltaY,deltaZ);
+    previousNodePosition += delta;
+    simulatedNodePosition += delta;
+    if (nodeInterpolated) {
+        //Node has been moved to the simulated state
+        nodeInterpolated = false;
+        ship->setRotation(simulatedNodeRotation);
+    }
+}
+
+void Ship::beginSimulationStep()
+{
+    if (nodeInterpolated) {
+        ship->setPosition(simulatedNodePosition);
+        ship->setRotation(simulatedNodeRotation);
+        nodeInterpolated = false;
+    }
+    previousNodePosition = ship->getPosition();
+    previousNodeRotation = ship->getRotation();
+    previousNodeStateStored = true;
+}
+
+void Ship::interpolateNode(irr::f32 fraction)
+{
+    if (!previousNodeStateStored) {
+        return;
+    }
+    if (!nodeInterpolated) {
+        simulatedNodePosition = ship->getPosition();
+        simulatedNodeRotation = ship->getRotation();
+        nodeInterpolated = true;
+    }
+
+    if (fraction < 0) {fraction = 0;}
+    if (fraction > 1) {fraction = 1;}
+
+    //Rotation via quaternions, to avoid problems with wrap around of Euler angles
+    irr::core::quaternion previousRotation(previousNodeRotation*irr::core::DEGTORAD);
+    irr::core::quaternion simulatedRotation(simulatedNodeRotation*irr::core::DEGTORAD);
+    irr::core::quaternion interpolatedRotation;
+    interpolatedRotation.slerp(previousRotation, simulatedRotation, fraction);
+    irr::core::vector3df interpolatedAngles;
+    interpolatedRotation.toEuler(interpolatedAngles);
+
+    ship->setPosition(previousNodePosition + (simulatedNodePosition - previousNodePosition)*fraction);
+    ship->setRotation(interpolatedAngles*irr::core::RADTODEG);
 }
 
 
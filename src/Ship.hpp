@@ -47,6 +47,10 @@ class Ship
         irr::u32 getMMSI() const;
         void setMMSI(irr::u32 mmsi);
 
+        //Smoothing of the displayed position between fixed length simulation steps
+        void beginSimulationStep(); //Return the scene node to the simulated state, and store this as the previous state. Call before each simulation step.
+        void interpolateNode(irr::f32 fraction); //Place the scene node between the previous (0) and latest (1) simulated states, for rendering
+
     protected:
 
         irr::scene::IAnimatedMeshSceneNode* ship; //The scene node for the own ship.
@@ -67,6 +71,12 @@ class Ship
 // DEE_DEC22
 	int controlMode;
         bool positionManuallyUpdated; //If position has been updated, and shouldn't be updated again this loop
+        bool nodeInterpolated; //If the scene node is currently showing an interpolated state
+        bool previousNodeStateStored;
+        irr::core::vector3df previousNodePosition; //Scene node state before the latest simulation step
+        irr::core::vector3df previousNodeRotation;
+        irr::core::vector3df simulatedNodePosition; //Scene node state after the latest simulation step, kept while the node is interpolated
+        irr::core::vector3df simulatedNodeRotation;
         irr::u32 mmsi;
         enum CONTROL_MODE
         {
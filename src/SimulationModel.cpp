@@ -27,6 +27,7 @@
 #include "Constants.hpp"
 #include "Utilities.hpp"
 #include "MessageMisc.hpp"
+#include "SessionPlayer.hpp"
 
 #include <cmath>
 #include <fstream>
@@ -150,7 +151,7 @@ SimulationModel::SimulationModel(irr::IrrlichtDevice* dev,
         if (modelParameters.vrMode == true) {
             waterReflection = false;
         }
-        water.load(smgr,ownShip.getSceneNode(),weather,modelParameters.disableShaders,waterReflection,modelParameters.waterSegments);
+        water.load(smgr,ownShip.getSceneNode(),weather,modelParameters.disableShaders,waterReflection,modelParameters.waterThreaded,modelParameters.waterSegments);
 
         /* To be replaced by getting information and passing into gui load method.
         //Tell gui to hide the second engine scroll bar if we have a single engine
@@ -171,6 +172,10 @@ SimulationModel::SimulationModel(irr::IrrlichtDevice* dev,
 
         //Load the radar with config parameters
         radarCalculation.load(ownShip.getRadarConfigFile(),device);
+        if (scenarioData.radarSeed != 0) {
+            //The scenario's own seed, so its radar picture is the same wherever it is run
+            radarCalculation.setRandomSeed(scenarioData.radarSeed);
+        }
 
         //set camera zoom to 1
         zoom = 1.0;
@@ -259,6 +264,24 @@ SimulationModel::SimulationModel(irr::IrrlichtDevice* dev,
         //store time
         previousTime = device->getTimer()->getTime();
 
+        //Ship motion, lines and collisions are simulated in fixed length steps, so they don't depend on the frame rate
+        fixedTimeStep = 0;
+        if (modelParameters.simulationStepRate > 0) {
+            fixedTimeStep = 1.0/modelParameters.simulationStepRate;
+        }
+        maxStepsPerFrame = modelParameters.maxSimulationSteps;
+        if (maxStepsPerFrame < 1) {
+            maxStepsPerFrame = 1;
+        }
+        timeAccumulator = 0;
+        ownShipCollided = false;
+
+        //Not recording or replaying until started
+        sessionPlayer = 0;
+        sessionStep = 0;
+        sessionKeyframeInterval = 0;
+        lastKeyframeTime = 0;
+
         guiData = new GUIData;
 
         // Initialise as paused to start with
@@ -268,6 +291,8 @@ SimulationModel::SimulationModel(irr::IrrlichtDevice* dev,
 
 SimulationModel::~SimulationModel()
 {
+    sessionRecorder.close(sessionStep);
+
     radarImage->drop(); //We created this with 'create', so drop it when we're finished
     radarImageOverlaid->drop(); //We created this with 'create', so drop it when we're finished
     radarImageLarge->drop(); //We created this with 'create', so drop it when we're finished
@@ -334,6 +359,10 @@ SimulationModel::~SimulationModel()
         return water.getLocalNormals(relPosX,relPosZ);
     }
 
+    void SimulationModel::getWaveData(const irr::f32* posXs, const irr::f32* posZs, irr::f32* heights, irr::f32* normalXs, irr::f32* normalZs, irr::u32 n) const {
+        water.getWaveData(posXs,posZs,heights,normalXs,normalZs,n);
+    }
+
     irr::core::vector2df SimulationModel::getTidalStream(irr::f32 longitude, irr::f32 latitude, uint64_t requestTime) const {
         
         if (streamOverride) {
@@ -1393,6 +1422,11 @@ SimulationModel::~SimulationModel()
         return loopNumber;
     }
 
+    bool SimulationModel::getCollided() const
+    {
+        return ownShipCollided;
+    }
+
     std::string SimulationModel::getSerialisedScenario() const
     {
         return serialisedScenarioData;
@@ -1765,7 +1799,8 @@ SimulationModel::~SimulationModel()
 		std::vector<irr::f32> headings;
 		std::vector<irr::f32> speeds;
         bool paused;
-        bool collided;
+        irr::u32 stepsThisFrame;
+        irr::f32 stepTime;
 
         { IPROF("Increment time");
 
@@ -1774,12 +1809,42 @@ SimulationModel::~SimulationModel()
         //get delta time
         currentTime = device->getTimer()->getTime();
         deltaTime = (currentTime - previousTime)/1000.f;
-        //deltaTime = (currentTime - previousTime)/1000.f;
         previousTime = currentTime;
 
-        //add this to the scenario time
-        scenarioTime += deltaTime;
-        absoluteTime = Utilities::round(scenarioTime) + scenarioOffsetTime;
+        //Find the number of simulation steps to take this frame
+        timeAccumulator += deltaTime;
+        if (sessionPlayer) {
+            //Replaying: Take as many of the recorded steps as fit in the time available. Their lengths are set in the step loop.
+            irr::f32 replayedTime;
+            stepsThisFrame = sessionPlayer->getStepsDue(sessionStep, timeAccumulator, maxStepsPerFrame, replayedTime);
+            stepTime = 0;
+            timeAccumulator -= replayedTime;
+            if (sessionStep + stepsThisFrame >= sessionPlayer->getNumberOfSteps()) {
+                timeAccumulator = 0; //End of the recording, so hold here
+            }
+        } else if (deltaTime == 0) {
+            //Paused: Still run a zero length step, so any changes (e.g. position set) are applied
+            stepsThisFrame = 1;
+            stepTime = 0;
+        } else if (fixedTimeStep > 0) {
+            stepsThisFrame = (irr::u32)(timeAccumulator/fixedTimeStep);
+            stepTime = fixedTimeStep;
+            if (stepsThisFrame > maxStepsPerFrame) {
+                //Can't keep up at this step length (e.g. high time acceleration), so lengthen the steps rather than letting scenario time fall behind
+                stepsThisFrame = maxStepsPerFrame;
+                stepTime = timeAccumulator/maxStepsPerFrame;
+            }
+        } else {
+            //One step per frame
+            stepsThisFrame = 1;
+            stepTime = timeAccumulator;
+        }
+        if (!sessionPlayer) {
+            timeAccumulator -= stepsThisFrame*stepTime;
+        }
+        if (timeAccumulator < 0) {
+            timeAccumulator = 0;
+        }
 
         //increment loop number
         loopNumber++;
@@ -1791,12 +1856,6 @@ SimulationModel::~SimulationModel()
         //Ensure we have the right radar screen resolution
         setRadarDisplayRadius(guiMain->getRadarPixelRadius());
 
-        }{ IPROF("Update tide");
-
-        //Update tide height and tidal stream here.
-        tide.update(absoluteTime);
-        tideHeight = tide.getTideHeight();
-
         }{ IPROF("Update lighting");
 
         //update ambient lighting
@@ -1810,34 +1869,63 @@ SimulationModel::~SimulationModel()
         //rain.setIntensity(rainIntensity);
         rain.update(ownShip.getPosition().X, ownShip.getPosition().Y, ownShip.getPosition().Z, getRain());
 
-        }{ IPROF("Update other ships");
-        //update other ship positions etc
-        otherShips.update(deltaTime,scenarioTime,tideHeight,lightLevel,ownShip.getPosition(),ownShip.getLength()); //Update other ship motion (based on leg information), and light visibility.
+        }
+        for (irr::u32 step = 0; step < stepsThisFrame; step++) {
+            { IPROF("Increment step time");
+
+            //Ships are shown interpolated between steps, so return them to their simulated state first
+            ownShip.beginSimulationStep();
+            otherShips.beginSimulationStep();
+
+            //Record the inputs for this step, or apply the recorded ones
+            if (sessionPlayer) {
+                stepTime = sessionPlayer->getStepTime(sessionStep);
+                replaySessionStep();
+            } else if (sessionRecorder.isOpen()) {
+                recordSessionStep(stepTime);
+            }
+            sessionStep++;
+
+            //add this to the scenario time
+            scenarioTime += stepTime;
+            absoluteTime = Utilities::round(scenarioTime) + scenarioOffsetTime;
 
-        }{ IPROF("Update buoys");
-        //update buoys (for lights, floating, and if collision detection is turned on)
-        buoys.update(deltaTime,scenarioTime,tideHeight,lightLevel,ownShip.getPosition(),ownShip.getLength());
+            }{ IPROF("Update tide");
 
-        }{ IPROF("Update land lights");
-        //Update land lights
-        landLights.update(deltaTime,scenarioTime,lightLevel);
+            //Update tide height and tidal stream here.
+            tide.update(absoluteTime);
+            tideHeight = tide.getTideHeight();
 
-        } { IPROF("Update lines");
-        //update all lines, ready to be used for own ship force
-        lines.update(deltaTime);
-        }{ IPROF("Update own ship");
-        //update own ship
-        ownShip.update(deltaTime, scenarioTime, tideHeight, weather, lines.getOverallForceLocal(), lines.getOverallTorqueLocal());
+            }{ IPROF("Update other ships");
+            //update other ship positions etc
+            otherShips.update(stepTime,scenarioTime,tideHeight,lightLevel,ownShip.getPosition(),ownShip.getLength(),spatialIndex); //Update other ship motion (based on leg information), and light visibility.
 
-        }{ IPROF("Update MOB");
-        //update man overboard
-        manOverboard.update(deltaTime, tideHeight);
+            }{ IPROF("Update buoys");
+            //update buoys (for lights, floating, and if collision detection is turned on)
+            buoys.update(stepTime,scenarioTime,tideHeight,lightLevel,ownShip.getPosition(),ownShip.getLength(),spatialIndex);
 
-        }{ IPROF("Check for collisions");
-        //Check for collisions
-        collided = checkOwnShipCollision();
+            }{ IPROF("Update land lights");
+            //Update land lights
+            landLights.update(stepTime,scenarioTime,lightLevel);
 
-        }{ IPROF("Update water pos");
+            } { IPROF("Update lines");
+            //update all lines, ready to be used for own ship force
+            lines.update(stepTime, ownShip.getShipMass(), ownShip.getShipInertia());
+            }{ IPROF("Update own ship");
+            //update own ship
+            ownShip.update(stepTime, scenarioTime, tideHeight, weather, lines.getOverallForceLocal(), lines.getOverallTorqueLocal());
+
+            }{ IPROF("Update MOB");
+            //update man overboard
+            manOverboard.update(stepTime, tideHeight);
+
+            }{ IPROF("Check for collisions");
+            //Check for collisions
+            ownShipCollided = checkOwnShipCollision();
+            }
+        }
+
+        { IPROF("Update water pos");
         //update water position
         water.update(tideHeight,camera.getPosition(),light.getLightLevel(), weather);
 
@@ -1852,14 +1940,17 @@ SimulationModel::~SimulationModel()
             deltaX = 500.0*Utilities::round(deltaX/500.0);
             deltaZ = 500.0*Utilities::round(deltaZ/500.0);
 
-            //Move all objects
+            //Move all objects. The radar worker reads the terrain, so must wait while it moves.
+            radarCalculation.pauseWorker();
             ownShip.moveNode(deltaX,0,deltaZ);
             terrain.moveNode(deltaX,0,deltaZ); //SLOW!
             otherShips.moveNode(deltaX,0,deltaZ);
             buoys.moveNode(deltaX,0,deltaZ);
+            spatialIndex.moveAll(deltaX,deltaZ);
             landObjects.moveNode(deltaX,0,deltaZ);
             landLights.moveNode(deltaX,0,deltaZ);
             manOverboard.moveNode(deltaX,0,deltaZ);
+            radarCalculation.resumeWorker();
 
             // Also move camera if in 'frozen' mode
             camera.applyOffset(deltaX,0,deltaZ);
@@ -1878,6 +1969,16 @@ SimulationModel::~SimulationModel()
             //std::cout << normalisedLogMessage << std::endl;
 
         }
+        }{ IPROF("Interpolate ships");
+
+        //Show ships part way between the last two simulated states, by the proportion of a step not yet simulated
+        irr::f32 interpolationFraction = 1;
+        if (fixedTimeStep > 0) {
+            interpolationFraction = timeAccumulator/fixedTimeStep;
+        }
+        ownShip.interpolateNode(interpolationFraction);
+        otherShips.interpolateNodes(interpolationFraction);
+
         }{ IPROF("Update camera pos");
 
         //update the camera position
@@ -1907,9 +2008,9 @@ SimulationModel::~SimulationModel()
                 radarImageChosen = radarImage;
                 radarImageOverlaidChosen = radarImageOverlaid;
             }
-            radarCalculation.update(radarImageChosen,radarImageOverlaidChosen,offsetPosition,terrain,ownShip,buoys,otherShips,weather,rainIntensity,tideHeight,deltaTime,absoluteTime,cursorPositionRadar,isMouseDown);
+            radarCalculation.update(radarImageChosen,radarImageOverlaidChosen,offsetPosition,terrain,ownShip,buoys,otherShips,spatialIndex,weather,rainIntensity,tideHeight,deltaTime,absoluteTime,cursorPositionRadar,isMouseDown);
             }{ IPROF("Update radar screen");
-            radarScreen.update(radarImageOverlaidChosen);
+            radarScreen.update(radarImageOverlaidChosen, radarCalculation.getChangedRegion());
             }{ IPROF("Update radar camera");
             radarCamera.update();
             }
@@ -1971,7 +2072,7 @@ SimulationModel::~SimulationModel()
         guiData->guiRadarCursorRangeNm = radarCalculation.getCursorRangeNm();
         guiData->currentTime = Utilities::timestampToString(absoluteTime);
         guiData->paused = paused;
-        guiData->collided = collided;
+        guiData->collided = ownShipCollided;
         guiData->headUp = radarCalculation.getHeadUp();
         guiData->radarOn = radarCalculation.isRadarOn();
         guiData->pump1On = ownShip.getRudderPumpState(1);
@@ -2210,73 +2311,9 @@ void SimulationModel::updateFromNetwork(eCmdMsg aMsgType, void* aDataCmd)
 		    if((dataMasterCmds->lines.lineStartType > 0) &&
 		       (dataMasterCmds->lines.lineEndType > 0))
 		      {
-			irr::scene::ISceneNode* startParent = 0;
-			irr::scene::ISceneNode* endParent = 0;
-			if(dataMasterCmds->lines.lineStartType == 1)
-			  {
-			    // Own ship
-			    startParent = getOwnShipSceneNode();
-			  }
-			else if(dataMasterCmds->lines.lineStartType == 2)
-			  {
-			    // Other ship
-			    startParent = getOtherShipSceneNode(dataMasterCmds->lines.lineStartID);
-			  }
-			else if(dataMasterCmds->lines.lineStartType == 3)
-			  {
-			    // Buoy
-			    startParent = getBuoySceneNode(dataMasterCmds->lines.lineStartID);
-			  }
-			else if(dataMasterCmds->lines.lineStartType == 4)
-			  {
-			    // Land object
-			    startParent = getLandObjectSceneNode(dataMasterCmds->lines.lineStartID);
-			  }
-			
-			if(dataMasterCmds->lines.lineEndType == 1)
-			  {
-			    // Own ship
-			    endParent = getOwnShipSceneNode();
-			  }
-			else if(dataMasterCmds->lines.lineEndType == 2)
-			  {
-			    // Other ship
-			    endParent = getOtherShipSceneNode(dataMasterCmds->lines.lineEndID);
-			  }
-			else if(dataMasterCmds->lines.lineEndType == 3)
-			  {
-			    // Buoy
-			    endParent = getBuoySceneNode(dataMasterCmds->lines.lineEndID);
-			  }
-			else if(dataMasterCmds->lines.lineEndType == 4)
-			  {
-			    // Land object
-			    endParent = getLandObjectSceneNode(dataMasterCmds->lines.lineEndID);
-			  }
-
-			// Make child sphere nodes based on these (in the right position), then pass in to create the lines
-			irr::core::vector3df sphereScale = irr::core::vector3df(1.0, 1.0, 1.0);
-			if(startParent && startParent->getScale().X > 0)
-			  {
-			    sphereScale = irr::core::vector3df(1.0f/startParent->getScale().X,
-							       1.0f/startParent->getScale().X,
-							       1.0f/startParent->getScale().X);
-			  }
-			irr::scene::ISceneNode* startNode = device->getSceneManager()->addSphereSceneNode(0.25f,16,startParent,-1,irr::core::vector3df(dataMasterCmds->lines.lineStartX, dataMasterCmds->lines.lineStartY, dataMasterCmds->lines.lineStartZ),irr::core::vector3df(0, 0, 0),sphereScale);
-			sphereScale = irr::core::vector3df(1.0, 1.0, 1.0);
-			if(endParent && endParent->getScale().X > 0)
-			  {
-			    sphereScale = irr::core::vector3df(1.0f/endParent->getScale().X,1.0f/endParent->getScale().X,1.0f/endParent->getScale().X);
-			  }
-			irr::scene::ISceneNode* endNode = device->getSceneManager()->addSphereSceneNode(0.25f,16,endParent,-1,irr::core::vector3df(dataMasterCmds->lines.lineEndX, dataMasterCmds->lines.lineEndY, dataMasterCmds->lines.lineEndZ),irr::core::vector3df(0, 0, 0),sphereScale);
-
-			// Set name to match parent for convenience
-			if (startParent && startNode) {
-			  startNode->setName(startParent->getName());
-			}
-			if (endParent && endNode) {
-			  endNode->setName(endParent->getName());
-			}
+			// Make child sphere nodes on the right parents (in the right position), then pass in to create the lines
+			irr::scene::ISceneNode* startNode = addLineAttachmentNode(dataMasterCmds->lines.lineStartType, dataMasterCmds->lines.lineStartID, irr::core::vector3df(dataMasterCmds->lines.lineStartX, dataMasterCmds->lines.lineStartY, dataMasterCmds->lines.lineStartZ));
+			irr::scene::ISceneNode* endNode = addLineAttachmentNode(dataMasterCmds->lines.lineEndType, dataMasterCmds->lines.lineEndID, irr::core::vector3df(dataMasterCmds->lines.lineEndX, dataMasterCmds->lines.lineEndY, dataMasterCmds->lines.lineEndZ));
 
 			// Create the lines
 			getLines()->setLineStart(startNode, dataMasterCmds->lines.lineStartType, dataMasterCmds->lines.lineStartID, true, i);
@@ -2392,6 +2429,320 @@ void SimulationModel::updateFromNetwork(eCmdMsg aMsgType, void* aDataCmd)
     }
 }
 
+irr::scene::ISceneNode* SimulationModel::addLineAttachmentNode(int nodeType, int id, irr::core::vector3df position)
+{
+    irr::scene::ISceneNode* parent = 0;
+    if (nodeType == 1) {
+        // Own ship
+        parent = getOwnShipSceneNode();
+    } else if (nodeType == 2) {
+        // Other ship
+        parent = getOtherShipSceneNode(id);
+    } else if (nodeType == 3) {
+        // Buoy
+        parent = getBuoySceneNode(id);
+    } else if (nodeType == 4) {
+        // Land object
+        parent = getLandObjectSceneNode(id);
+    }
+
+    // Scale so the sphere is the same size whatever the parent's scale
+    irr::core::vector3df sphereScale = irr::core::vector3df(1.0, 1.0, 1.0);
+    if (parent && parent->getScale().X > 0) {
+        sphereScale = irr::core::vector3df(1.0f/parent->getScale().X, 1.0f/parent->getScale().X, 1.0f/parent->getScale().X);
+    }
+    irr::scene::ISceneNode* node = device->getSceneManager()->addSphereSceneNode(0.25f,16,parent,-1,position,irr::core::vector3df(0, 0, 0),sphereScale);
+
+    // Set name to match parent for convenience
+    if (parent && node) {
+        node->setName(parent->getName());
+    }
+    return node;
+}
+
+bool SimulationModel::startSessionRecording(std::string filename, irr::f32 keyframeInterval)
+{
+    if (!sessionRecorder.open(filename, serialisedScenarioData, radarCalculation.getRandomSeed())) {
+        return false;
+    }
+    sessionStep = 0;
+    sessionKeyframeInterval = keyframeInterval;
+    lastKeyframeTime = scenarioTime;
+
+    //The ship motion depends on the wave heights, which are only evaluated for the exact time of each frame if not done in advance on the worker thread
+    water.setThreadedWaves(false);
+
+    //Start with a keyframe, so the replay begins from the same state even if changes have been made before recording started
+    sessionRecorder.recordKeyframe(sessionStep, getSessionKeyframe(), getSessionControls());
+    return true;
+}
+
+void SimulationModel::startSessionReplay(SessionPlayer* player)
+{
+    sessionPlayer = player;
+    sessionStep = 0;
+    timeAccumulator = 0;
+
+    //As when recording, don't let the waves depend on the worker thread's timing
+    water.setThreadedWaves(false);
+
+    //Same radar noise as when recorded
+    radarCalculation.setRandomSeed(player->getRadarSeed());
+}
+
+bool SimulationModel::isReplayingSession() const
+{
+    return sessionPlayer != 0;
+}
+
+void SimulationModel::seekSession(irr::f32 seconds)
+{
+    if (!sessionPlayer) {
+        return;
+    }
+    //The keyframe found is applied at the start of the next step
+    sessionStep = sessionPlayer->seek(scenarioTime + seconds);
+    timeAccumulator = 0;
+}
+
+void SimulationModel::recordNetworkMessage(const std::string& message)
+{
+    if (sessionRecorder.isOpen()) {
+        //Applied before the next simulation step
+        sessionRecorder.recordNetworkMessage(sessionStep, message);
+    }
+}
+
+SessionControls SimulationModel::getSessionControls()
+{
+    SessionControls controls;
+    controls.values[E_SESSION_CONTROL_WHEEL] = getWheel();
+    controls.values[E_SESSION_CONTROL_PORT_ENGINE] = getPortEngine();
+    controls.values[E_SESSION_CONTROL_STBD_ENGINE] = getStbdEngine();
+    controls.values[E_SESSION_CONTROL_BOW_THRUSTER] = getBowThruster();
+    controls.values[E_SESSION_CONTROL_STERN_THRUSTER] = getSternThruster();
+    controls.values[E_SESSION_CONTROL_PORT_SCHOTTEL] = getPortSchottel();
+    controls.values[E_SESSION_CONTROL_STBD_SCHOTTEL] = getStbdSchottel();
+    controls.values[E_SESSION_CONTROL_PORT_THRUST_LEVER] = getPortAzimuthThrustLever();
+    controls.values[E_SESSION_CONTROL_STBD_THRUST_LEVER] = getStbdAzimuthThrustLever();
+    controls.values[E_SESSION_CONTROL_WEATHER] = weather;
+    controls.values[E_SESSION_CONTROL_RAIN] = rainIntensity;
+    controls.values[E_SESSION_CONTROL_VISIBILITY] = visibilityRange;
+    controls.values[E_SESSION_CONTROL_WIND_DIRECTION] = windDirection;
+    controls.values[E_SESSION_CONTROL_WIND_SPEED] = windSpeed;
+    controls.values[E_SESSION_CONTROL_RUDDER_PUMP_1] = getRudderPumpState(1) ? 1 : 0;
+    controls.values[E_SESSION_CONTROL_RUDDER_PUMP_2] = getRudderPumpState(2) ? 1 : 0;
+    controls.values[E_SESSION_CONTROL_FOLLOW_UP_RUDDER] = ownShip.getFollowUpRudderWorking() ? 1 : 0;
+    controls.values[E_SESSION_CONTROL_MAN_OVERBOARD] = getManOverboardVisible() ? 1 : 0;
+    return controls;
+}
+
+void SimulationModel::applySessionControls(const SessionControls& controls, irr::u32 changed)
+{
+    const irr::f32* values = controls.values;
+    if (changed & (1u << E_SESSION_CONTROL_WHEEL)) {setWheel(values[E_SESSION_CONTROL_WHEEL], true);}
+    if (changed & (1u << E_SESSION_CONTROL_PORT_ENGINE)) {setPortEngine(values[E_SESSION_CONTROL_PORT_ENGINE]);}
+    if (changed & (1u << E_SESSION_CONTROL_STBD_ENGINE)) {setStbdEngine(values[E_SESSION_CONTROL_STBD_ENGINE]);}
+    if (changed & (1u << E_SESSION_CONTROL_BOW_THRUSTER)) {setBowThruster(values[E_SESSION_CONTROL_BOW_THRUSTER]);}
+    if (changed & (1u << E_SESSION_CONTROL_STERN_THRUSTER)) {setSternThruster(values[E_SESSION_CONTROL_STERN_THRUSTER]);}
+    if (changed & (1u << E_SESSION_CONTROL_PORT_SCHOTTEL)) {setPortSchottel(values[E_SESSION_CONTROL_PORT_SCHOTTEL]);}
+    if (changed & (1u << E_SESSION_CONTROL_STBD_SCHOTTEL)) {setStbdSchottel(values[E_SESSION_CONTROL_STBD_SCHOTTEL]);}
+    if (changed & (1u << E_SESSION_CONTROL_PORT_THRUST_LEVER)) {setPortAzimuthThrustLever(values[E_SESSION_CONTROL_PORT_THRUST_LEVER]);}
+    if (changed & (1u << E_SESSION_CONTROL_STBD_THRUST_LEVER)) {setStbdAzimuthThrustLever(values[E_SESSION_CONTROL_STBD_THRUST_LEVER]);}
+    if (changed & (1u << E_SESSION_CONTROL_WEATHER)) {setWeather(values[E_SESSION_CONTROL_WEATHER]);}
+    if (changed & (1u << E_SESSION_CONTROL_RAIN)) {setRain(values[E_SESSION_CONTROL_RAIN]);}
+    if (changed & (1u << E_SESSION_CONTROL_VISIBILITY)) {setVisibility(values[E_SESSION_CONTROL_VISIBILITY]);}
+    if (changed & (1u << E_SESSION_CONTROL_WIND_DIRECTION)) {setWindDirection(values[E_SESSION_CONTROL_WIND_DIRECTION]);}
+    if (changed & (1u << E_SESSION_CONTROL_WIND_SPEED)) {setWindSpeed(values[E_SESSION_CONTROL_WIND_SPEED]);}
+    if (changed & (1u << E_SESSION_CONTROL_RUDDER_PUMP_1)) {setRudderPumpState(1, values[E_SESSION_CONTROL_RUDDER_PUMP_1] > 0);}
+    if (changed & (1u << E_SESSION_CONTROL_RUDDER_PUMP_2)) {setRudderPumpState(2, values[E_SESSION_CONTROL_RUDDER_PUMP_2] > 0);}
+    if (changed & (1u << E_SESSION_CONTROL_FOLLOW_UP_RUDDER)) {setFollowUpRudderWorking(values[E_SESSION_CONTROL_FOLLOW_UP_RUDDER] > 0);}
+    if (changed & (1u << E_SESSION_CONTROL_MAN_OVERBOARD)) {
+        //Release or retrieve as the user did. The exact position is restored at the next keyframe.
+        if (values[E_SESSION_CONTROL_MAN_OVERBOARD] > 0) {
+            releaseManOverboard();
+        } else if (getManOverboardVisible()) {
+            retrieveManOverboard();
+        }
+    }
+}
+
+SessionKeyframe SimulationModel::getSessionKeyframe()
+{
+    SessionKeyframe keyframe;
+    keyframe.scenarioTime = scenarioTime;
+
+    keyframe.ownShip.posX = getPosX();
+    keyframe.ownShip.posZ = getPosZ();
+    keyframe.ownShip.heading = ownShip.getHeading();
+    keyframe.ownShip.speed = ownShip.getSpeed();
+    keyframe.ownShipLateralSpeed = ownShip.getLateralSpeed();
+    keyframe.ownShipRateOfTurn = ownShip.getRateOfTurn();
+    keyframe.ownShipRudder = ownShip.getRudder();
+    keyframe.ownShipPortEngine = ownShip.getPortEngine();
+    keyframe.ownShipStbdEngine = ownShip.getStbdEngine();
+    keyframe.ownShipPortAzimuthAngle = ownShip.getPortAzimuthAngle();
+    keyframe.ownShipStbdAzimuthAngle = ownShip.getStbdAzimuthAngle();
+    keyframe.ownShipPitch = ownShip.getPitch();
+    keyframe.ownShipRoll = ownShip.getRoll();
+    keyframe.ownShipWaveHeightFiltered = ownShip.getWaveHeightFiltered();
+
+    for (irr::u32 i = 0; i < getNumberOfOtherShips(); i++) {
+        SessionShipState otherShip;
+        otherShip.posX = getOtherShipPosX(i);
+        otherShip.posZ = getOtherShipPosZ(i);
+        otherShip.heading = getOtherShipHeading(i);
+        otherShip.speed = getOtherShipSpeed(i);
+        otherShip.rateOfTurn = otherShips.getRateOfTurn(i);
+        otherShip.legs = getOtherShipLegs(i);
+        keyframe.otherShips.push_back(otherShip);
+    }
+
+    keyframe.streamOverride = streamOverride;
+    keyframe.streamOverrideDirection = streamOverrideDirection;
+    keyframe.streamOverrideSpeed = streamOverrideSpeed;
+
+    keyframe.manOverboardVisible = getManOverboardVisible();
+    keyframe.manOverboardPosX = getManOverboardPosX();
+    keyframe.manOverboardPosZ = getManOverboardPosZ();
+
+    for (int i = 0; i < lines.getNumberOfLines(); i++) {
+        SessionLineState line;
+        line.startType = lines.getLineStartType(i);
+        line.startID = lines.getLineStartID(i);
+        line.endType = lines.getLineEndType(i);
+        line.endID = lines.getLineEndID(i);
+        line.startX = lines.getLineStartX(i);
+        line.startY = lines.getLineStartY(i);
+        line.startZ = lines.getLineStartZ(i);
+        line.endX = lines.getLineEndX(i);
+        line.endY = lines.getLineEndY(i);
+        line.endZ = lines.getLineEndZ(i);
+        line.nominalLength = lines.getLineNominalLength(i);
+        line.breakingTension = lines.getLineBreakingTension(i);
+        line.breakingStrain = lines.getLineBreakingStrain(i);
+        line.nominalShipMass = lines.getLineNominalShipMass(i);
+        line.keepSlack = lines.getKeepSlack(i);
+        line.heaveIn = lines.getHeaveIn(i);
+        keyframe.lines.push_back(line);
+    }
+
+    return keyframe;
+}
+
+void SimulationModel::applySessionKeyframe(const SessionKeyframe& keyframe)
+{
+    scenarioTime = keyframe.scenarioTime;
+
+    setPos(keyframe.ownShip.posX, keyframe.ownShip.posZ);
+    ownShip.setMotionState(keyframe.ownShip.heading, keyframe.ownShip.speed, keyframe.ownShipLateralSpeed, keyframe.ownShipRateOfTurn);
+    ownShip.setActuatorState(keyframe.ownShipRudder, keyframe.ownShipPortEngine, keyframe.ownShipStbdEngine, keyframe.ownShipPortAzimuthAngle, keyframe.ownShipStbdAzimuthAngle);
+    ownShip.setAttitudeState(keyframe.ownShipPitch, keyframe.ownShipRoll, keyframe.ownShipWaveHeightFiltered);
+
+    for (irr::u32 i = 0; i < keyframe.otherShips.size() && i < getNumberOfOtherShips(); i++) {
+        const SessionShipState& otherShip = keyframe.otherShips.at(i);
+        //Legs first, as these are changed by network messages during the session
+        otherShips.setLegs(i, otherShip.legs);
+        setOtherShipPos(i, otherShip.posX, otherShip.posZ);
+        setOtherShipHeading(i, otherShip.heading);
+        setOtherShipSpeed(i, otherShip.speed);
+        setOtherShipRateOfTurn(i, otherShip.rateOfTurn);
+    }
+
+    setStreamOverride(keyframe.streamOverride);
+    setStreamOverrideDirection(keyframe.streamOverrideDirection);
+    setStreamOverrideSpeed(keyframe.streamOverrideSpeed);
+
+    setManOverboardVisible(keyframe.manOverboardVisible);
+    if (keyframe.manOverboardVisible) {
+        setManOverboardPos(keyframe.manOverboardPosX, keyframe.manOverboardPosZ);
+    }
+
+    //Keep the lines which are attached as in the keyframe. From the first which differs, remove the rest (e.g. lines added after the keyframe, when seeking back), and attach them again.
+    int firstChanged = 0;
+    while (firstChanged < lines.getNumberOfLines() && firstChanged < (int)keyframe.lines.size()) {
+        const SessionLineState& line = keyframe.lines.at(firstChanged);
+        if (lines.getLineStartType(firstChanged) != line.startType ||
+            lines.getLineStartID(firstChanged) != line.startID ||
+            lines.getLineEndType(firstChanged) != line.endType ||
+            lines.getLineEndID(firstChanged) != line.endID ||
+            lines.getLineStartX(firstChanged) != line.startX ||
+            lines.getLineStartY(firstChanged) != line.startY ||
+            lines.getLineStartZ(firstChanged) != line.startZ ||
+            lines.getLineEndX(firstChanged) != line.endX ||
+            lines.getLineEndY(firstChanged) != line.endY ||
+            lines.getLineEndZ(firstChanged) != line.endZ) {
+            break;
+        }
+        firstChanged++;
+    }
+    while (lines.getNumberOfLines() > firstChanged) {
+        lines.removeLine(lines.getNumberOfLines() - 1);
+    }
+    for (int i = firstChanged; i < (int)keyframe.lines.size(); i++) {
+        const SessionLineState& line = keyframe.lines.at(i);
+        lines.addLine(this);
+        //A line may only have its start attached, if it was being created at the keyframe
+        if (line.startType > 0) {
+            irr::scene::ISceneNode* startNode = addLineAttachmentNode(line.startType, line.startID, irr::core::vector3df(line.startX, line.startY, line.startZ));
+            lines.setLineStart(startNode, line.startType, line.startID, false, i);
+        }
+        if (line.endType > 0) {
+            irr::scene::ISceneNode* endNode = addLineAttachmentNode(line.endType, line.endID, irr::core::vector3df(line.endX, line.endY, line.endZ));
+            lines.setLineEnd(endNode, line.nominalShipMass, line.endType, line.endID, false, i);
+        }
+    }
+
+    for (irr::u32 i = 0; i < keyframe.lines.size(); i++) {
+        const SessionLineState& line = keyframe.lines.at(i);
+        lines.setLineNominalLength(i, line.nominalLength);
+        lines.setLineBreakingTension(i, line.breakingTension);
+        lines.setLineBreakingStrain(i, line.breakingStrain);
+        lines.setLineNominalShipMass(i, line.nominalShipMass);
+        lines.setKeepSlack(i, line.keepSlack);
+        lines.setHeaveIn(i, line.heaveIn);
+    }
+}
+
+void SimulationModel::recordSessionStep(irr::f32 stepTime)
+{
+    sessionRecorder.recordStepTime(sessionStep, stepTime);
+    if (sessionKeyframeInterval > 0 && fabs(scenarioTime - lastKeyframeTime) >= sessionKeyframeInterval) {
+        sessionRecorder.recordKeyframe(sessionStep, getSessionKeyframe(), getSessionControls());
+        lastKeyframeTime = scenarioTime;
+    } else {
+        sessionRecorder.recordControls(sessionStep, getSessionControls());
+    }
+}
+
+void SimulationModel::replaySessionStep()
+{
+    eSessionRecord type;
+    std::string payload;
+    SessionControls controls = getSessionControls();
+    SessionKeyframe keyframe;
+    bool keyframeRead = false;
+    while (sessionPlayer->readRecord(sessionStep, type, payload)) {
+        if (type == E_SESSION_RECORD_CONTROLS) {
+            irr::u32 changed = controls.deserialise(payload);
+            applySessionControls(controls, changed);
+        } else if (type == E_SESSION_RECORD_NETWORK) {
+            //Parse and apply as if just received. The model is needed for some messages (e.g. time adjustment), and the message isn't re-recorded as recording is never open while replaying.
+            Message message(this);
+            eCmdMsg msgType = E_CMD_MESSAGE_UNKNOWN;
+            void* dataCmd = NULL;
+            msgType = message.Parse(payload.c_str(), payload.size(), &dataCmd);
+            updateFromNetwork(msgType, dataCmd);
+        } else if (type == E_SESSION_RECORD_KEYFRAME) {
+            keyframeRead = keyframe.deserialise(payload);
+        }
+    }
+    //The keyframe holds the state after all of this step's inputs, and the controls recorded with it would otherwise overwrite the actual rudder and engine states
+    if (keyframeRead) {
+        applySessionKeyframe(keyframe);
+    }
+}
+
 bool SimulationModel::checkOwnShipCollision()
 {
 
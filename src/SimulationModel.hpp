@@ -29,6 +29,7 @@ class ScenarioData;
 class GUIMain;
 class GUIData;
 class Sound;
+class SessionPlayer;
 
 #include "Terrain.hpp"
 #include "Light.hpp"
@@ -48,6 +49,8 @@ class Sound;
 #include "Lines.hpp"
 #include "OperatingModeEnum.hpp"
 #include "Network.hpp"
+#include "SessionRecorder.hpp"
+#include "SpatialIndex.hpp"
 
 class SimulationModel //Start of the 'Model' part of MVC
 {
@@ -63,6 +66,7 @@ public:
         irr::f32 cameraMaxDistance;
         irr::u32 disableShaders;
         irr::u32 waterSegments;
+        bool waterThreaded; //Evaluate the waves for the next frame on a worker thread
         irr::core::vector3di numberOfContactPoints;
         irr::f32 minContactPointSpacing;
         irr::f32 contactStiffnessFactor;
@@ -72,6 +76,8 @@ public:
         irr::f32 frictionCoefficient;
         irr::f32 tanhFrictionFactor;
         irr::u32 limitTerrainResolution;
+        irr::f32 simulationStepRate; //Fixed simulation steps per second of scenario time, or 0 for one step per frame
+        irr::u32 maxSimulationSteps; //Maximum simulation steps per frame
         bool secondaryControlWheel;
         bool secondaryControlPortEngine;
         bool secondaryControlStbdEngine;
@@ -175,6 +181,7 @@ public:
     irr::f32 getOwnShipSpeedThroughWater(void);
     irr::f32 getWaveHeight(irr::f32 posX, irr::f32 posZ) const; //Return wave height (not tide) at the world position specified
     irr::core::vector2df getLocalNormals(irr::f32 relPosX, irr::f32 relPosZ) const;
+    void getWaveData(const irr::f32* posXs, const irr::f32* posZs, irr::f32* heights, irr::f32* normalXs, irr::f32* normalZs, irr::u32 n) const; //Wave height and normals for n positions together, faster than separate calls. Outputs not needed can be 0.
 
     irr::core::vector2df getTidalStream(irr::f32 longitude, irr::f32 latitude, uint64_t requestTime) const; //Tidal stream in m/s for the specified absolute position
 
@@ -295,6 +302,7 @@ public:
     void setZoom(bool zoomOn);
     void setViewAngle(irr::f32 viewAngle);
     irr::u32 getLoopNumber() const;
+    bool getCollided() const; //If the own ship was in contact with anything in the latest simulation step
     std::string getSerialisedScenario() const;
     std::string getScenarioName() const;
     std::string getWorldName() const;
@@ -358,6 +366,13 @@ public:
 
   void update();
   void updateFromNetwork(eCmdMsg aMsgType, void* aDataCmd);  
+
+    //Session recording and replay, for debriefing
+    bool startSessionRecording(std::string filename, irr::f32 keyframeInterval); //Record from the next simulation step, with a full keyframe every keyframeInterval seconds. Returns false if the file can't be written
+    void startSessionReplay(SessionPlayer* player); //Replay a loaded session, which must have been recorded with the scenario this model was loaded from
+    bool isReplayingSession() const;
+    void seekSession(irr::f32 seconds); //When replaying, jump to the keyframe at or before the current time plus seconds (-ve to go back)
+    void recordNetworkMessage(const std::string& message); //Called with each network message received, before it is applied
 private:
     irr::IrrlichtDevice* device;
     irr::video::IVideoDriver* driver;
@@ -388,6 +403,7 @@ private:
     OwnShip ownShip;
     OtherShips otherShips;
     Buoys buoys;
+    SpatialIndex spatialIndex; //Positions of other ships and buoys, for finding those near a point
     LandObjects landObjects;
     LandLights landLights;
     Camera camera;
@@ -412,7 +428,11 @@ private:
     //Simulation time handling
     irr::u32 currentTime; //Computer clock time
     irr::u32 previousTime; //Computer clock time
-    irr::f32 deltaTime;
+    irr::f32 deltaTime; //Scenario time elapsed since the last frame
+    irr::f32 fixedTimeStep; //Length of each simulation step (s), or 0 for one step per frame
+    irr::u32 maxStepsPerFrame;
+    irr::f32 timeAccumulator; //Scenario time elapsed but not yet simulated (s)
+    bool ownShipCollided; //Result of collision check in the latest simulation step
     irr::f32 scenarioTime; //Simulation internal time, starting at zero at 0000h on start day of simulation
     uint64_t scenarioOffsetTime; //Simulation day's start time from unix epoch (1 Jan 1970)
     uint64_t absoluteTime; //Unix timestamp for current time, including start day. Calculated from scenarioTime and scenarioOffsetTime
@@ -420,6 +440,22 @@ private:
     //utility function to check for collision
     bool checkOwnShipCollision();
 
+    //Add a sphere node as a child of the object a line is attached to, at position relative to it. nodeType as in Lines::getLineStartType
+    irr::scene::ISceneNode* addLineAttachmentNode(int nodeType, int id, irr::core::vector3df position);
+
+    //Session recording and replay
+    SessionRecorder sessionRecorder;
+    SessionPlayer* sessionPlayer; //0 unless replaying
+    irr::u32 sessionStep; //Simulation steps since recording or replay started
+    irr::f32 sessionKeyframeInterval; //Scenario time between keyframes (s)
+    irr::f32 lastKeyframeTime;
+    SessionControls getSessionControls();
+    void applySessionControls(const SessionControls& controls, irr::u32 changed); //changed is a bit mask of which controls to apply
+    SessionKeyframe getSessionKeyframe();
+    void applySessionKeyframe(const SessionKeyframe& keyframe);
+    void recordSessionStep(irr::f32 stepTime); //Called at the start of each simulation step
+    void replaySessionStep(); //Called at the start of each simulation step
+
     //Offset position handling
     irr::core::vector3d<int64_t> offsetPosition;
 
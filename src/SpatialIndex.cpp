@@ -0,0 +1,189 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "SpatialIndex.hpp"
+
+#include "Constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialIndex::SpatialIndex()
+{
+    //Cells of one nautical mile, so a typical query (own ship's surroundings, or the visual range) covers a few to a few hundred cells
+    cellSize = M_IN_NM;
+    maxRadius = 0;
+}
+
+void SpatialIndex::setPosition(eSpatialObject type, irr::u32 number, irr::f32 positionX, irr::f32 positionZ, irr::f32 radius)
+{
+    std::vector<Entry>& typeEntries = entries[type];
+    if (number >= typeEntries.size()) {
+        Entry newEntry;
+        newEntry.positionX = 0;
+        newEntry.positionZ = 0;
+        newEntry.radius = 0;
+        newEntry.cell = 0;
+        newEntry.slot = 0;
+        newEntry.inGrid = false;
+        typeEntries.resize(number + 1, newEntry);
+    }
+
+    Entry& entry = typeEntries.at(number);
+    entry.positionX = positionX;
+    entry.positionZ = positionZ;
+    entry.radius = radius;
+    maxRadius = std::max(maxRadius, radius);
+
+    //Only change the grid if the object has moved into a different cell
+    int64_t cell = getCell(positionX, positionZ);
+    if (!entry.inGrid || cell != entry.cell) {
+        if (entry.inGrid) {
+            removeFromCell(type, number);
+        }
+        entry.cell = cell;
+        addToCell(type, number);
+    }
+}
+
+void SpatialIndex::moveAll(irr::f32 deltaX, irr::f32 deltaZ)
+{
+    //Most objects change cell, so rebuild the grid
+    cells.clear();
+    for (irr::u32 type = 0; type < E_SPATIAL_OBJECT_TYPES; type++) {
+        std::vector<Entry>& typeEntries = entries[type];
+        for (irr::u32 number = 0; number < typeEntries.size(); number++) {
+            Entry& entry = typeEntries.at(number);
+            if (entry.inGrid) {
+                entry.positionX += deltaX;
+                entry.positionZ += deltaZ;
+                entry.cell = getCell(entry.positionX, entry.positionZ);
+                addToCell((eSpatialObject)type, number);
+            }
+        }
+    }
+}
+
+irr::u32 SpatialIndex::getNumber(eSpatialObject type) const
+{
+    return entries[type].size();
+}
+
+void SpatialIndex::findInRange(irr::f32 positionX, irr::f32 positionZ, irr::f32 range, std::vector<Object>& found) const
+{
+    found.clear();
+    if (range < 0) {
+        return;
+    }
+
+    //Cells that may hold an object in range
+    irr::f32 searchRange = range + maxRadius;
+    irr::s32 minCellX = getCellCoordinate(positionX - searchRange);
+    irr::s32 maxCellX = getCellCoordinate(positionX + searchRange);
+    irr::s32 minCellZ = getCellCoordinate(positionZ - searchRange);
+    irr::s32 maxCellZ = getCellCoordinate(positionZ + searchRange);
+    irr::f32 cellsInRange = ((irr::f32)maxCellX - minCellX + 1) * ((irr::f32)maxCellZ - minCellZ + 1);
+
+    if (cellsInRange <= cells.size()) {
+        //Look up each cell in range
+        for (irr::s32 cellX = minCellX; cellX <= maxCellX; cellX++) {
+            for (irr::s32 cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
+                std::unordered_map<int64_t, std::vector<Object>>::const_iterator cell = cells.find(getCell(cellX, cellZ));
+                if (cell != cells.end()) {
+                    for (std::vector<Object>::size_type i = 0; i < cell->second.size(); i++) {
+                        addIfInRange(cell->second.at(i), positionX, positionZ, range, found);
+                    }
+                }
+            }
+        }
+    } else {
+        //Large range compared to the number of occupied cells (e.g. a long radar range), so check each occupied cell instead
+        for (std::unordered_map<int64_t, std::vector<Object>>::const_iterator cell = cells.begin(); cell != cells.end(); ++cell) {
+            for (std::vector<Object>::size_type i = 0; i < cell->second.size(); i++) {
+                addIfInRange(cell->second.at(i), positionX, positionZ, range, found);
+            }
+        }
+    }
+
+    //Return in a consistent order, independent of the grid
+    std::sort(found.begin(), found.end(), objectLess);
+}
+
+int64_t SpatialIndex::getCell(irr::f32 positionX, irr::f32 positionZ) const
+{
+    return getCell(getCellCoordinate(positionX), getCellCoordinate(positionZ));
+}
+
+int64_t SpatialIndex::getCell(irr::s32 cellX, irr::s32 cellZ) const
+{
+    return ((int64_t)cellX << 32) | (uint32_t)cellZ;
+}
+
+irr::s32 SpatialIndex::getCellCoordinate(irr::f32 position) const
+{
+    return (irr::s32)std::floor(position/cellSize);
+}
+
+void SpatialIndex::addToCell(eSpatialObject type, irr::u32 number)
+{
+    Entry& entry = entries[type].at(number);
+    std::vector<Object>& cellObjects = cells[entry.cell];
+    Object object;
+    object.type = type;
+    object.number = number;
+    entry.slot = cellObjects.size();
+    entry.inGrid = true;
+    cellObjects.push_back(object);
+}
+
+void SpatialIndex::removeFromCell(eSpatialObject type, irr::u32 number)
+{
+    Entry& entry = entries[type].at(number);
+    std::unordered_map<int64_t, std::vector<Object>>::iterator cell = cells.find(entry.cell);
+    if (cell == cells.end()) {
+        return;
+    }
+
+    //Move the last object in the cell into this one's slot
+    std::vector<Object>& cellObjects = cell->second;
+    const Object& last = cellObjects.back();
+    entries[last.type].at(last.number).slot = entry.slot;
+    cellObjects.at(entry.slot) = last;
+    cellObjects.pop_back();
+    if (cellObjects.empty()) {
+        cells.erase(cell);
+    }
+    entry.inGrid = false;
+}
+
+void SpatialIndex::addIfInRange(const Object& object, irr::f32 positionX, irr::f32 positionZ, irr::f32 range, std::vector<Object>& found) const
+{
+    const Entry& entry = entries[object.type][object.number];
+    irr::f32 deltaX = entry.positionX - positionX;
+    irr::f32 deltaZ = entry.positionZ - positionZ;
+    irr::f32 maxDistance = range + entry.radius;
+    if (deltaX*deltaX + deltaZ*deltaZ <= maxDistance*maxDistance) {
+        found.push_back(object);
+    }
+}
+
+bool SpatialIndex::objectLess(const Object& first, const Object& second)
+{
+    if (first.type != second.type) {
+        return first.type < second.type;
+    }
+    return first.number < second.number;
+}
@@ -0,0 +1,74 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __SPATIALINDEX_HPP_INCLUDED__
+#define __SPATIALINDEX_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+enum eSpatialObject {
+    E_SPATIAL_OTHER_SHIP = 0,
+    E_SPATIAL_BUOY,
+    E_SPATIAL_OBJECT_TYPES //Number of types, not a type itself
+};
+
+//Uniform grid over the horizontal (X,Z) plane, holding other ships and buoys, so objects near a point can be found without checking every object.
+//Objects are identified by their type and number (as used by OtherShips and Buoys), and each has a radius, so large objects are found if any part is in range.
+//Moving an object only changes the grid if it moves into a different cell. Only occupied cells are stored.
+class SpatialIndex
+{
+    public:
+        struct Object {
+            eSpatialObject type;
+            irr::u32 number;
+        };
+
+        SpatialIndex();
+        void setPosition(eSpatialObject type, irr::u32 number, irr::f32 positionX, irr::f32 positionZ, irr::f32 radius); //Add the object if not already present
+        void moveAll(irr::f32 deltaX, irr::f32 deltaZ); //For when the origin is moved
+        irr::u32 getNumber(eSpatialObject type) const;
+        //Find objects with any part (within their radius) closer than range to the point. found is cleared, then filled in order of type, then number.
+        void findInRange(irr::f32 positionX, irr::f32 positionZ, irr::f32 range, std::vector<Object>& found) const;
+
+    private:
+        struct Entry {
+            irr::f32 positionX;
+            irr::f32 positionZ;
+            irr::f32 radius;
+            int64_t cell;
+            irr::u32 slot; //Position in the cell's list
+            bool inGrid;
+        };
+
+        irr::f32 cellSize;
+        std::vector<Entry> entries[E_SPATIAL_OBJECT_TYPES]; //By type, then number
+        irr::f32 maxRadius; //Largest radius of any object, so queries can include objects centred just outside the range
+        std::unordered_map<int64_t, std::vector<Object>> cells;
+
+        int64_t getCell(irr::f32 positionX, irr::f32 positionZ) const;
+        int64_t getCell(irr::s32 cellX, irr::s32 cellZ) const;
+        irr::s32 getCellCoordinate(irr::f32 position) const;
+        void addToCell(eSpatialObject type, irr::u32 number);
+        void removeFromCell(eSpatialObject type, irr::u32 number);
+        void addIfInRange(const Object& object, irr::f32 positionX, irr::f32 positionZ, irr::f32 range, std::vector<Object>& found) const;
+        static bool objectLess(const Object& first, const Object& second);
+};
+
+#endif // __SPATIALINDEX_HPP_INCLUDED__
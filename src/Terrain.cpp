@@ -30,9 +30,17 @@
 
 //using namespace irr;
 
+//Maximum number of cells along each side of the terrain coverage grid
+const irr::u32 TERRAIN_COVERAGE_CELLS = 64;
+
 Terrain::Terrain()
 {
-
+    coverageCellsX = 0;
+    coverageCellsZ = 0;
+    coverageX = 0;
+    coverageZ = 0;
+    coverageCellWidthX = 1;
+    coverageCellWidthZ = 1;
 }
 
 Terrain::~Terrain()
@@ -353,6 +361,7 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
         }
 
         terrains.push_back(terrain);
+        addHeightfield(terrain);
 
     }
 
@@ -497,6 +506,7 @@ void Terrain::addRadarReflectingTerrain(std::vector<std::vector<irr::f32>> heigh
     terrain->setVisible(false);
 
     terrains.push_back(terrain);
+    addHeightfield(terrain);
 }
 
 std::vector<std::vector<irr::f32>> Terrain::transposeHeightMapVector(std::vector<std::vector<irr::f32>> inVector){
@@ -572,18 +582,146 @@ std::vector<std::vector<irr::f32>> Terrain::limitSize(std::vector<std::vector<ir
 
 irr::f32 Terrain::getHeight(irr::f32 x, irr::f32 z) const //Get height from global coordinates
 {
-    //Fallback minimum value
-    irr::f32 terrainHeight = -FLT_MAX;
-    
-    //Check down list, find highest return value
-    for (int i=(int)terrains.size()-1; i>=0; i--) {
-        irr::f32 thisHeight = terrains.at(i)->getHeight(x,z);
-        if (thisHeight > terrainHeight) {
-            terrainHeight = thisHeight;
+    irr::f32 terrainHeight;
+    getHeights(&x, &z, &terrainHeight, 1);
+    return terrainHeight;
+}
+
+void Terrain::getHeights(const irr::f32* xs, const irr::f32* zs, irr::f32* heights, irr::u32 n) const //Get heights from global coordinates
+{
+    //Same interpolation as BCTerrainSceneNode::getHeight, taking the highest of any terrains at each point.
+    for (irr::u32 i = 0; i < n; i++) {
+        //Fallback minimum value
+        irr::f32 terrainHeight = -FLT_MAX;
+
+        irr::f32 cellX = (xs[i] - coverageX) / coverageCellWidthX;
+        irr::f32 cellZ = (zs[i] - coverageZ) / coverageCellWidthZ;
+        if (cellX >= 0 && cellX < coverageCellsX && cellZ >= 0 && cellZ < coverageCellsZ) {
+            const std::vector<irr::u32>& covering = coverage[(irr::u32)cellX * coverageCellsZ + (irr::u32)cellZ];
+            for (std::vector<irr::u32>::size_type j = 0; j < covering.size(); j++) {
+                const Heightfield& heightfield = heightfields[covering[j]];
+
+                irr::f32 posX = (xs[i] - heightfield.positionX) / heightfield.scaleX;
+                irr::f32 posZ = (zs[i] - heightfield.positionZ) / heightfield.scaleZ;
+                irr::s32 X = irr::core::floor32(posX);
+                irr::s32 Z = irr::core::floor32(posZ);
+                if (X < 0 || X >= heightfield.size-1 || Z < 0 || Z >= heightfield.size-1) {
+                    continue;
+                }
+
+                const irr::f32* row = &heightfield.heights[X * heightfield.size + Z];
+                irr::f32 a = row[0];
+                irr::f32 b = row[heightfield.size];
+                irr::f32 c = row[1];
+                irr::f32 d = row[heightfield.size + 1];
+
+                //Offset from integer position, and which triangle of the cell the point is in
+                irr::f32 dx = posX - X;
+                irr::f32 dz = posZ - Z;
+                bool upperTriangle = dx > dz;
+                irr::f32 thisHeight = a + (upperTriangle ? (d - b)*dz + (b - a)*dx : (d - c)*dx + (c - a)*dz);
+                thisHeight = thisHeight * heightfield.scaleY + heightfield.positionY;
+
+                terrainHeight = std::max(terrainHeight, thisHeight);
+            }
         }
+
+        heights[i] = terrainHeight;
     }
+}
 
-    return terrainHeight;
+void Terrain::addHeightfield(irr::scene::ITerrainSceneNode* terrain)
+{
+    Heightfield heightfield;
+    heightfield.size = 0;
+
+    irr::scene::IMesh* mesh = terrain->getMesh();
+    if (mesh && mesh->getMeshBufferCount() > 0) {
+        //Terrain vertices are a square grid
+        irr::scene::IMeshBuffer* meshBuffer = mesh->getMeshBuffer(0);
+        irr::u32 vertexCount = meshBuffer->getVertexCount();
+        heightfield.size = (irr::s32)sqrt((double)vertexCount);
+        if ((irr::u32)(heightfield.size * heightfield.size) != vertexCount) {
+            heightfield.size = 0;
+        }
+        heightfield.heights.resize(heightfield.size * heightfield.size);
+        for (irr::u32 i = 0; i < heightfield.heights.size(); i++) {
+            heightfield.heights.at(i) = meshBuffer->getPosition(i).Y;
+        }
+    }
+
+    heightfield.positionX = terrain->getPosition().X;
+    heightfield.positionY = terrain->getPosition().Y;
+    heightfield.positionZ = terrain->getPosition().Z;
+    heightfield.scaleX = terrain->getScale().X;
+    heightfield.scaleY = terrain->getScale().Y;
+    heightfield.scaleZ = terrain->getScale().Z;
+
+    heightfields.push_back(heightfield);
+    updateCoverage();
+}
+
+void Terrain::updateCoverage()
+{
+    coverage.clear();
+    coverageCellsX = 0;
+    coverageCellsZ = 0;
+
+    //Find the area covered by all terrains
+    irr::core::rectf area;
+    bool foundArea = false;
+    std::vector<irr::core::rectf> terrainAreas;
+    for (std::vector<Heightfield>::size_type i = 0; i < heightfields.size(); i++) {
+        const Heightfield& heightfield = heightfields.at(i);
+        irr::core::rectf terrainArea(heightfield.positionX, heightfield.positionZ,
+                                     heightfield.positionX + (heightfield.size - 1) * heightfield.scaleX,
+                                     heightfield.positionZ + (heightfield.size - 1) * heightfield.scaleZ);
+        terrainArea.repair();
+        terrainAreas.push_back(terrainArea);
+        if (heightfield.size < 2) {
+            continue;
+        }
+        if (foundArea) {
+            area.addInternalPoint(terrainArea.UpperLeftCorner);
+            area.addInternalPoint(terrainArea.LowerRightCorner);
+        } else {
+            area = terrainArea;
+            foundArea = true;
+        }
+    }
+    if (!foundArea || area.getWidth() <= 0 || area.getHeight() <= 0) {
+        return;
+    }
+    //Margin so rounding can't exclude a point on the edge of a terrain
+    irr::f32 marginX = area.getWidth() * 0.001f;
+    irr::f32 marginZ = area.getHeight() * 0.001f;
+    area.UpperLeftCorner -= irr::core::vector2df(marginX, marginZ);
+    area.LowerRightCorner += irr::core::vector2df(marginX, marginZ);
+
+    coverageCellsX = TERRAIN_COVERAGE_CELLS;
+    coverageCellsZ = TERRAIN_COVERAGE_CELLS;
+    coverageX = area.UpperLeftCorner.X;
+    coverageZ = area.UpperLeftCorner.Y;
+    coverageCellWidthX = area.getWidth() / coverageCellsX;
+    coverageCellWidthZ = area.getHeight() / coverageCellsZ;
+    coverage.resize(coverageCellsX * coverageCellsZ);
+
+    //List each terrain in every cell it overlaps, and one cell further, again so rounding can't exclude any points
+    for (std::vector<Heightfield>::size_type i = 0; i < heightfields.size(); i++) {
+        if (heightfields.at(i).size < 2) {
+            continue;
+        }
+        const irr::core::rectf& terrainArea = terrainAreas.at(i);
+        irr::s32 firstX = irr::core::clamp(irr::core::floor32((terrainArea.UpperLeftCorner.X - coverageX) / coverageCellWidthX) - 1, 0, (irr::s32)coverageCellsX - 1);
+        irr::s32 lastX = irr::core::clamp(irr::core::floor32((terrainArea.LowerRightCorner.X - coverageX) / coverageCellWidthX) + 1, 0, (irr::s32)coverageCellsX - 1);
+        irr::s32 firstZ = irr::core::clamp(irr::core::floor32((terrainArea.UpperLeftCorner.Y - coverageZ) / coverageCellWidthZ) - 1, 0, (irr::s32)coverageCellsZ - 1);
+        irr::s32 lastZ = irr::core::clamp(irr::core::floor32((terrainArea.LowerRightCorner.Y - coverageZ) / coverageCellWidthZ) + 1, 0, (irr::s32)coverageCellsZ - 1);
+        for (irr::s32 cellX = firstX; cellX <= lastX; cellX++) {
+            for (irr::s32 cellZ = firstZ; cellZ <= lastZ; cellZ++) {
+                coverage.at(cellX * coverageCellsZ + cellZ).push_back(i);
+            }
+        }
+    }
 }
 
 irr::f32 Terrain::longToX(irr::f32 longitude) const
@@ -613,4 +751,13 @@ void Terrain::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
         irr::f32 newPosZ = currentPos.Z + deltaZ;
         terrains.at(i)->setPosition(irr::core::vector3df(newPosX,newPosY,newPosZ));
     }
+
+    //Terrains all move together, so the heightfields and coverage grid just need to be offset
+    for (std::vector<Heightfield>::size_type i = 0; i < heightfields.size(); i++) {
+        heightfields.at(i).positionX += deltaX;
+        heightfields.at(i).positionY += deltaY;
+        heightfields.at(i).positionZ += deltaZ;
+    }
+    coverageX += deltaX;
+    coverageZ += deltaZ;
 }
@@ -33,11 +33,27 @@ class Terrain
         irr::f32 xToLong(irr::f32 x) const;
         irr::f32 zToLat(irr::f32 z) const;
         irr::f32 getHeight(irr::f32 x, irr::f32 z) const;
+        void getHeights(const irr::f32* xs, const irr::f32* zs, irr::f32* heights, irr::u32 n) const; //As getHeight for n points at once, which is faster than separate calls
         void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
         void addRadarReflectingTerrain(std::vector<std::vector<irr::f32>> heightVector, irr::f32 positionX, irr::f32 positionZ, irr::f32 widthX, irr::f32 widthZ);
 
     private:
-        
+
+        //Copy of a terrain's heights, so they can be read without going through the scene node's mesh buffer
+        struct Heightfield {
+            std::vector<irr::f32> heights; //Unscaled, indexed as the terrain vertices [X*size + Z]
+            irr::s32 size;
+            irr::f32 positionX;
+            irr::f32 positionY;
+            irr::f32 positionZ;
+            irr::f32 scaleX;
+            irr::f32 scaleY;
+            irr::f32 scaleZ;
+        };
+
+        void addHeightfield(irr::scene::ITerrainSceneNode* terrain);
+        void updateCoverage();
+
         std::vector<std::vector<irr::f32>> heightMapImageToVector(irr::io::IReadFile* heightMapFile, bool usesRGBEncoding, bool normaliseSize, irr::scene::ISceneManager* smgr);
         std::vector<std::vector<irr::f32>> heightMapBinaryToVector(irr::io::IReadFile* heightMapFile, irr::u32 binaryWidth, irr::u32 binaryHeight, bool floatingPoint);
         
@@ -53,6 +69,16 @@ class Terrain
         irr::f32 primeTerrainLat;
         irr::f32 primeTerrainZWidth;
         irr::f32 primeTerrainLatExtent;
+
+        std::vector<Heightfield> heightfields; //Matching terrains
+        //Coarse grid over all terrains, listing which heightfields cover each cell, so each point only checks the terrains it may be on
+        std::vector<std::vector<irr::u32>> coverage; //Indexed [cellX*coverageCellsZ + cellZ]
+        irr::u32 coverageCellsX;
+        irr::u32 coverageCellsZ;
+        irr::f32 coverageX; //SW corner of the grid
+        irr::f32 coverageZ;
+        irr::f32 coverageCellWidthX;
+        irr::f32 coverageCellWidthZ;
 };
 
 #endif
@@ -252,6 +252,7 @@ namespace Utilities
 
         scenarioData.windDirection      = IniFile::iniFileTof32(environmentIniFilename,"WindDirection");
         scenarioData.windSpeed          = IniFile::iniFileTof32(environmentIniFilename,"WindSpeed");
+        scenarioData.radarSeed          = IniFile::iniFileTou32(environmentIniFilename,"RadarSeed"); //Optional, overrides RADAR_Seed in bc5.ini
         
         std::string scenarioOwnShipFilename = scenarioPath;
         scenarioOwnShipFilename.append("/ownship.ini");
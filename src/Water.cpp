@@ -35,7 +35,7 @@ Water::~Water()
     //dtor
 }
 
-void Water::load(irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* ownShip, irr::f32 weather, irr::u32 disableShaders, bool withReflection, irr::u32 segments)
+void Water::load(irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* ownShip, irr::f32 weather, irr::u32 disableShaders, bool withReflection, bool threadedWaves, irr::u32 segments)
 {
 
     irr::video::IVideoDriver* driver = smgr->getVideoDriver();
@@ -44,7 +44,7 @@ void Water::load(irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* ownShi
     //FIXME: Hardcoded or defined in multiple places
     tileWidth = 100; //Width in metres - Note this is used in Simulation model normalisation as 1000, so visible jumps in water are minimised
 
-    waterNode = new irr::scene::MovingWaterSceneNode(smgr->getRootSceneNode(),smgr,ownShip,0,disableShaders,withReflection,segments);
+    waterNode = new irr::scene::MovingWaterSceneNode(smgr->getRootSceneNode(),smgr,ownShip,0,disableShaders,withReflection,threadedWaves,segments);
     waterNode->setPosition(irr::core::vector3df(0,-0.25,0));
     smgr->getRootSceneNode()->addChild(waterNode);
     waterNode->setMaterialTexture(0, driver->getTexture("media/water.jpg"));
@@ -74,6 +74,11 @@ irr::core::vector2df Water::getLocalNormals(irr::f32 relPosX, irr::f32 relPosZ)
   return waterNode->getLocalNormals(relPosX,relPosZ);
 }
 
+void Water::getWaveData(const irr::f32* relPosXs, const irr::f32* relPosZs, irr::f32* heights, irr::f32* normalXs, irr::f32* normalZs, irr::u32 n) const
+{
+  waterNode->getWaveData(relPosXs,relPosZs,heights,normalXs,normalZs,n);
+}
+
 
 irr::core::vector3df Water::getPosition() const
 {
@@ -84,3 +89,8 @@ void Water::setVisible(bool visible)
 {
     waterNode->setVisible(visible);
 }
+
+void Water::setThreadedWaves(bool threadedWaves)
+{
+    waterNode->setThreadedWaves(threadedWaves);
+}
@@ -26,12 +26,14 @@ class Water
     public:
         Water();
         virtual ~Water();
-        void load(irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* ownShip, irr::f32 weather, irr::u32 disableShaders, bool withReflection, irr::u32 segments);
+        void load(irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* ownShip, irr::f32 weather, irr::u32 disableShaders, bool withReflection, bool threadedWaves, irr::u32 segments);
         void update(irr::f32 tideHeight, irr::core::vector3df viewPosition, irr::u32 lightLevel, irr::f32 weather);
         irr::f32 getWaveHeight(irr::f32 relPosX, irr::f32 relPosZ) const;
         irr::core::vector2df getLocalNormals(irr::f32 relPosX, irr::f32 relPosZ) const;
+        void getWaveData(const irr::f32* relPosXs, const irr::f32* relPosZs, irr::f32* heights, irr::f32* normalXs, irr::f32* normalZs, irr::u32 n) const;
         irr::core::vector3df getPosition() const;
         void setVisible(bool visible);
+        void setThreadedWaves(bool threadedWaves);
 
     private:
         irr::f32 tileWidth;
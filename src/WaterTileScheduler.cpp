@@ -0,0 +1,272 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "WaterTileScheduler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+//Tiles drawn each side of the centre tile
+const irr::s32 WATER_TILE_RINGS = 10;
+//Furthest ring of tiles drawn at each per tile level of detail. Rings beyond the last are drawn as merged blocks.
+const irr::s32 WATER_LEVEL_RINGS[] = {1, 3, 7};
+const irr::u32 WATER_TILE_LEVELS = sizeof(WATER_LEVEL_RINGS)/sizeof(WATER_LEVEL_RINGS[0]);
+//Tiles across each merged block. (2*WATER_TILE_RINGS + 1) must be a multiple of this, and the merged blocks must cover the rings beyond the last per tile level.
+const irr::s32 WATER_BLOCK_TILES = 3;
+//Minimum depth of the skirts (m)
+const irr::f32 WATER_MIN_SKIRT_DEPTH = 0.1;
+
+WaterTileScheduler::WaterTileScheduler()
+{
+    fullDetail = 0;
+    segments = 0;
+    tileWidth = 0;
+}
+
+WaterTileScheduler::~WaterTileScheduler()
+{
+    for (std::vector<Level>::size_type i = 0; i < levels.size(); i++) {
+        levels.at(i).buffer->drop();
+    }
+}
+
+void WaterTileScheduler::load(irr::scene::IMeshBuffer* fullDetail, irr::u32 segments, irr::f32 tileWidth)
+{
+    if (!fullDetail || fullDetail->getVertexType() != irr::video::EVT_STANDARD || fullDetail->getVertexCount() != (segments+1)*(segments+1) || segments < 2) {
+        return;
+    }
+    this->fullDetail = fullDetail;
+    this->segments = segments;
+    this->tileWidth = tileWidth;
+
+    //Halve the detail at each level, keeping at least two segments across each tile. The merged level uses the next halving.
+    irr::u32 stride = 1;
+    for (irr::u32 i = 0; i <= WATER_TILE_LEVELS; i++) {
+        Level level;
+        level.buffer = new irr::scene::SMeshBuffer();
+        level.tilesAcross = 1;
+        level.skirtOnly = (i < WATER_TILE_LEVELS && stride == 1);
+        if (i < WATER_TILE_LEVELS) {
+            addTile(level, stride, irr::core::vector3df(0,0,0), level.skirtOnly);
+        } else {
+            level.tilesAcross = WATER_BLOCK_TILES;
+            for (irr::s32 j = 0; j < WATER_BLOCK_TILES; j++) {
+                for (irr::s32 k = 0; k < WATER_BLOCK_TILES; k++) {
+                    irr::core::vector3df offset((j - WATER_BLOCK_TILES/2)*tileWidth, 0, (k - WATER_BLOCK_TILES/2)*tileWidth);
+                    addTile(level, stride, offset, false);
+                }
+            }
+        }
+        //The vertices change every frame, but the indices never do
+        level.buffer->setHardwareMappingHint(irr::scene::EHM_STREAM, irr::scene::EBT_VERTEX);
+        level.buffer->setHardwareMappingHint(irr::scene::EHM_STATIC, irr::scene::EBT_INDEX);
+        levels.push_back(level);
+
+        if (segments/(stride*2) >= 2) {
+            stride *= 2;
+        }
+    }
+
+    update();
+}
+
+bool WaterTileScheduler::isLoaded() const
+{
+    return !levels.empty();
+}
+
+void WaterTileScheduler::update()
+{
+    if (levels.empty()) {
+        return;
+    }
+
+    const irr::video::S3DVertex* fullVertices = static_cast<const irr::video::S3DVertex*>(fullDetail->getVertices());
+    const irr::u32 fullVertexCount = fullDetail->getVertexCount();
+
+    //The skirts need to reach down at least as far as the difference between the surfaces at different levels of detail
+    tileBox.reset(fullVertices[0].Pos);
+    for (irr::u32 i = 1; i < fullVertexCount; i++) {
+        tileBox.addInternalPoint(fullVertices[i].Pos);
+    }
+    irr::f32 skirtDepth = std::max(tileBox.MaxEdge.Y - tileBox.MinEdge.Y, WATER_MIN_SKIRT_DEPTH);
+    tileBox.MinEdge.Y -= skirtDepth;
+
+    for (std::vector<Level>::size_type i = 0; i < levels.size(); i++) {
+        Level& level = levels.at(i);
+        irr::core::array<irr::video::S3DVertex>& vertices = level.buffer->Vertices;
+        for (irr::u32 v = 0; v < vertices.size(); v++) {
+            const SourceVertex& source = level.sources[v];
+            vertices[v] = fullVertices[source.index];
+            vertices[v].Pos += source.offset;
+            if (source.skirt) {
+                vertices[v].Pos.Y -= skirtDepth;
+            }
+        }
+        level.buffer->setDirty(irr::scene::EBT_VERTEX);
+    }
+}
+
+void WaterTileScheduler::render(irr::video::IVideoDriver* driver, const irr::scene::ICameraSceneNode* camera, irr::core::matrix4 transformation) const
+{
+    if (levels.empty()) {
+        return;
+    }
+
+    const irr::scene::SViewFrustum* frustum = camera ? camera->getViewFrustum() : 0;
+    const irr::core::vector3df basicPosition = transformation.getTranslation();
+
+    //Single tiles, out to the last per tile level
+    const irr::s32 tileRings = WATER_LEVEL_RINGS[WATER_TILE_LEVELS-1];
+    for (irr::s32 j = -tileRings; j <= tileRings; j++) {
+        for (irr::s32 k = -tileRings; k <= tileRings; k++) {
+            irr::core::vector3df position = basicPosition + irr::core::vector3df(j*tileWidth,0,k*tileWidth);
+            irr::core::aabbox3df box(tileBox.MinEdge + position, tileBox.MaxEdge + position);
+            if (isCulled(frustum, box)) {
+                continue;
+            }
+            transformation.setTranslation(position);
+            driver->setTransform(irr::video::ETS_WORLD, transformation);
+            const Level& level = levels.at(getTileLevel(std::max(abs(j), abs(k))));
+            if (level.skirtOnly) {
+                driver->drawMeshBuffer(fullDetail);
+            }
+            driver->drawMeshBuffer(level.buffer);
+        }
+    }
+
+    //Merged blocks for the remaining rings
+    const Level& merged = levels.back();
+    const irr::s32 blockRings = WATER_TILE_RINGS/WATER_BLOCK_TILES;
+    const irr::s32 firstBlockRing = (tileRings + WATER_BLOCK_TILES/2 + 1)/WATER_BLOCK_TILES;
+    const irr::core::vector3df blockExtent((WATER_BLOCK_TILES/2)*tileWidth, 0, (WATER_BLOCK_TILES/2)*tileWidth);
+    for (irr::s32 j = -blockRings; j <= blockRings; j++) {
+        for (irr::s32 k = -blockRings; k <= blockRings; k++) {
+            if (std::max(abs(j), abs(k)) < firstBlockRing) {
+                continue;
+            }
+            irr::core::vector3df position = basicPosition + irr::core::vector3df(j*merged.tilesAcross*tileWidth,0,k*merged.tilesAcross*tileWidth);
+            irr::core::aabbox3df box(tileBox.MinEdge + position - blockExtent, tileBox.MaxEdge + position + blockExtent);
+            if (isCulled(frustum, box)) {
+                continue;
+            }
+            transformation.setTranslation(position);
+            driver->setTransform(irr::video::ETS_WORLD, transformation);
+            driver->drawMeshBuffer(merged.buffer);
+        }
+    }
+}
+
+void WaterTileScheduler::addTile(Level& level, irr::u32 stride, const irr::core::vector3df& offset, bool skirtOnly)
+{
+    //Grid vertices from every stride'th full detail vertex, with the same triangle order as addHillPlaneMesh, then a skirt vertex below each edge vertex.
+    //If skirtOnly, the grid itself is left out, and the skirt is joined to copies of the edge vertices instead.
+    const irr::u32 fullRowLength = segments + 1;
+    const irr::u32 tileSegments = segments/stride;
+    const irr::u32 rowLength = tileSegments + 1;
+    const irr::u32 first = level.sources.size();
+
+    irr::core::array<irr::u16>& indices = level.buffer->Indices;
+    if (!skirtOnly) {
+        for (irr::u32 x = 0; x < rowLength; x++) {
+            for (irr::u32 y = 0; y < rowLength; y++) {
+                SourceVertex source;
+                source.index = x*stride*fullRowLength + y*stride;
+                source.offset = offset;
+                source.skirt = false;
+                level.sources.push_back(source);
+            }
+        }
+
+        for (irr::u32 x = 0; x < tileSegments; x++) {
+            for (irr::u32 y = 0; y < tileSegments; y++) {
+                const irr::u32 current = first + x*rowLength + y;
+                indices.push_back(current);
+                indices.push_back(current + 1);
+                indices.push_back(current + rowLength);
+
+                indices.push_back(current + 1);
+                indices.push_back(current + 1 + rowLength);
+                indices.push_back(current + rowLength);
+            }
+        }
+    }
+
+    //Edge vertices in order round the tile, as grid positions (x*rowLength + y)
+    std::vector<irr::u32> edge;
+    for (irr::u32 y = 0; y < tileSegments; y++) {edge.push_back(y);}
+    for (irr::u32 x = 0; x < tileSegments; x++) {edge.push_back(x*rowLength + tileSegments);}
+    for (irr::u32 y = tileSegments; y > 0; y--) {edge.push_back(tileSegments*rowLength + y);}
+    for (irr::u32 x = tileSegments; x > 0; x--) {edge.push_back(x*rowLength);}
+
+    //Then as vertices in this buffer
+    for (irr::u32 i = 0; i < edge.size(); i++) {
+        if (skirtOnly) {
+            SourceVertex source;
+            source.index = (edge[i]/rowLength)*stride*fullRowLength + (edge[i]%rowLength)*stride;
+            source.offset = offset;
+            source.skirt = false;
+            level.sources.push_back(source);
+            edge[i] = level.sources.size() - 1;
+        } else {
+            edge[i] += first;
+        }
+    }
+
+    const irr::u32 firstSkirt = level.sources.size();
+    for (irr::u32 i = 0; i < edge.size(); i++) {
+        SourceVertex source = level.sources[edge[i]];
+        source.skirt = true;
+        level.sources.push_back(source);
+    }
+
+    //Skirt faces both ways, so they show from either side whatever the culling
+    for (irr::u32 i = 0; i < edge.size(); i++) {
+        const irr::u32 next = (i + 1) % edge.size();
+        const irr::u16 top0 = edge[i], top1 = edge[next];
+        const irr::u16 bottom0 = firstSkirt + i, bottom1 = firstSkirt + next;
+        indices.push_back(top0); indices.push_back(top1); indices.push_back(bottom1);
+        indices.push_back(top0); indices.push_back(bottom1); indices.push_back(bottom0);
+        indices.push_back(top0); indices.push_back(bottom1); indices.push_back(top1);
+        indices.push_back(top0); indices.push_back(bottom0); indices.push_back(bottom1);
+    }
+
+    level.buffer->Vertices.set_used(level.sources.size());
+}
+
+irr::u32 WaterTileScheduler::getTileLevel(irr::s32 ring) const
+{
+    for (irr::u32 i = 0; i < WATER_TILE_LEVELS; i++) {
+        if (ring <= WATER_LEVEL_RINGS[i]) {
+            return i;
+        }
+    }
+    return WATER_TILE_LEVELS - 1;
+}
+
+bool WaterTileScheduler::isCulled(const irr::scene::SViewFrustum* frustum, const irr::core::aabbox3df& box)
+{
+    //Culled if entirely outside any plane of the view frustum
+    if (!frustum) {
+        return false;
+    }
+    for (irr::u32 i = 0; i < irr::scene::SViewFrustum::VF_PLANE_COUNT; i++) {
+        if (box.classifyPlaneRelation(frustum->planes[i]) == irr::core::ISREL3D_FRONT) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __WATERTILESCHEDULER_HPP_INCLUDED__
+#define __WATERTILESCHEDULER_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <vector>
+
+//Chooses which copies of the tileable water mesh to draw, and at what detail, for each render pass.
+//Tiles outside the active camera's view are skipped. Further rings of tiles use copies of the mesh with fewer vertices,
+//and the outermost rings use a single low detail mesh covering a block of tiles, to reduce the number of draw calls.
+//Each copy has a skirt hanging down from its edges, to hide gaps where tiles of different detail meet.
+//The nearest rings are drawn from the full detail buffer itself, so only their skirt is copied.
+class WaterTileScheduler
+{
+    public:
+        WaterTileScheduler();
+        ~WaterTileScheduler();
+        //Set up from the full detail water mesh buffer, which must be a grid of (segments+1)^2 standard vertices, as from addHillPlaneMesh
+        void load(irr::scene::IMeshBuffer* fullDetail, irr::u32 segments, irr::f32 tileWidth);
+        bool isLoaded() const;
+        //Copy the latest full detail vertices into the lower levels of detail and the skirts. Call when the full detail buffer has changed.
+        void update();
+        //Draw the tiles around the centre position visible to the camera (0 to draw all). The water material must already be set.
+        void render(irr::video::IVideoDriver* driver, const irr::scene::ICameraSceneNode* camera, irr::core::matrix4 transformation) const;
+
+    private:
+        struct SourceVertex {
+            irr::u32 index; //In the full detail buffer
+            irr::core::vector3df offset; //Position of the tile within a block
+            bool skirt;
+        };
+        struct Level {
+            irr::scene::SMeshBuffer* buffer;
+            std::vector<SourceVertex> sources; //For each vertex in buffer
+            irr::s32 tilesAcross; //1, or the block width for the merged level
+            bool skirtOnly; //If the grid is drawn from the full detail buffer, and buffer only holds the skirt
+        };
+
+        irr::scene::IMeshBuffer* fullDetail;
+        irr::u32 segments;
+        irr::f32 tileWidth;
+        std::vector<Level> levels; //Per tile levels from full detail down, then the merged block level last
+        irr::core::aabbox3df tileBox; //Bounds of one tile including its skirt, relative to its centre
+
+        void addTile(Level& level, irr::u32 stride, const irr::core::vector3df& offset, bool skirtOnly);
+        irr::u32 getTileLevel(irr::s32 ring) const;
+        static bool isCulled(const irr::scene::SViewFrustum* frustum, const irr::core::aabbox3df& box);
+};
+
+#endif // __WATERTILESCHEDULER_HPP_INCLUDED__
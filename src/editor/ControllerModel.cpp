@@ -626,6 +626,9 @@ void ControllerModel::save()
     envFile << "WindDirection=" << scenarioData->windDirection << std::endl;
     envFile << "WindSpeed=" << scenarioData->windSpeed << std::endl;
     envFile << "Rain=" << scenarioData->rainIntensity << std::endl;
+    if (scenarioData->radarSeed != 0) {
+        envFile << "RadarSeed=" << scenarioData->radarSeed << std::endl;
+    }
     
     envFile.close();
     if (!envFile.good()) {successOfFar=false;}
@@ -653,6 +653,9 @@ int main (int argc, char ** argv)
             // Load wind information
             scenarioData.windDirection = IniFile::iniFileTof32(environmentIniFilename,"WindDirection");
             scenarioData.windSpeed = IniFile::iniFileTof32(environmentIniFilename,"WindSpeed");
+
+            //Not edited, but kept when the scenario is saved
+            scenarioData.radarSeed = IniFile::iniFileTou32(environmentIniFilename,"RadarSeed");
             
             //Load own ship information
             scenarioData.ownShipData.initialX = controller.longToX(IniFile::iniFileTof32(ownShipIniFilename,"InitialLong"));
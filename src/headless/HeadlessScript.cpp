@@ -0,0 +1,173 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "HeadlessScript.hpp"
+
+#include "../SimulationModel.hpp"
+#include "../Utilities.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+HeadlessScript::HeadlessScript()
+{
+    nextCommand = 0;
+    endFound = false;
+    endTime = 0;
+}
+
+bool HeadlessScript::load(const std::string& filename)
+{
+    std::ifstream file(filename.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Could not open script file " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    irr::u32 lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        //Remove comments
+        size_t commentStart = line.find('#');
+        if (commentStart != std::string::npos) {
+            line.erase(commentStart);
+        }
+        Utilities::trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        ScriptCommand scriptCommand;
+        scriptCommand.value = 0;
+        std::istringstream lineStream(line);
+        if (!(lineStream >> scriptCommand.time >> scriptCommand.command)) {
+            std::cerr << "Script line " << lineNumber << " not understood: " << line << std::endl;
+            continue;
+        }
+        Utilities::to_lower(scriptCommand.command);
+
+        if (scriptCommand.command == "end") {
+            if (!endFound || scriptCommand.time < endTime) {
+                endTime = scriptCommand.time;
+            }
+            endFound = true;
+            continue;
+        }
+
+        if (!isKnownCommand(scriptCommand.command)) {
+            std::cerr << "Script line " << lineNumber << " has unknown command: " << scriptCommand.command << std::endl;
+            continue;
+        }
+        if (!(lineStream >> scriptCommand.value)) {
+            std::cerr << "Script line " << lineNumber << " needs a value: " << line << std::endl;
+            continue;
+        }
+
+        commands.push_back(scriptCommand);
+    }
+
+    //Keep the file order for commands at the same time
+    std::stable_sort(commands.begin(), commands.end(), earlierCommand);
+
+    if (!endFound && !commands.empty()) {
+        endTime = commands.back().time;
+    }
+    nextCommand = 0;
+
+    return true;
+}
+
+void HeadlessScript::apply(irr::f32 runTime, SimulationModel* model)
+{
+    while (nextCommand < commands.size() && commands.at(nextCommand).time <= runTime) {
+        applyCommand(commands.at(nextCommand), model);
+        nextCommand++;
+    }
+}
+
+bool HeadlessScript::hasEnd() const
+{
+    return endFound;
+}
+
+irr::f32 HeadlessScript::getEndTime() const
+{
+    return endTime;
+}
+
+bool HeadlessScript::isKnownCommand(const std::string& command)
+{
+    return (command == "engine" ||
+            command == "portengine" ||
+            command == "stbdengine" ||
+            command == "wheel" ||
+            command == "rudder" ||
+            command == "bowthruster" ||
+            command == "sternthruster" ||
+            command == "weather" ||
+            command == "rain" ||
+            command == "visibility" ||
+            command == "winddirection" ||
+            command == "windspeed" ||
+            command == "arpa");
+}
+
+bool HeadlessScript::earlierCommand(const ScriptCommand& first, const ScriptCommand& second)
+{
+    return first.time < second.time;
+}
+
+void HeadlessScript::applyCommand(const ScriptCommand& scriptCommand, SimulationModel* model) const
+{
+    const std::string& command = scriptCommand.command;
+    irr::f32 value = scriptCommand.value;
+
+    if (command == "engine") {
+        //Both engines, range +-1
+        model->setPortEngine(value);
+        model->setStbdEngine(value);
+    } else if (command == "portengine") {
+        model->setPortEngine(value);
+    } else if (command == "stbdengine") {
+        model->setStbdEngine(value);
+    } else if (command == "wheel") {
+        //Degrees, -ve is port
+        model->setWheel(value);
+    } else if (command == "rudder") {
+        model->setRudder(value);
+    } else if (command == "bowthruster") {
+        model->setBowThruster(value);
+    } else if (command == "sternthruster") {
+        model->setSternThruster(value);
+    } else if (command == "weather") {
+        model->setWeather(value);
+    } else if (command == "rain") {
+        model->setRain(value);
+    } else if (command == "visibility") {
+        model->setVisibility(value);
+    } else if (command == "winddirection") {
+        model->setWindDirection(value);
+    } else if (command == "windspeed") {
+        model->setWindSpeed(value);
+    } else if (command == "arpa") {
+        // 0: Off/Manual, 1: MARPA, 2: ARPA
+        model->setArpaMode((int)value);
+    }
+}
@@ -0,0 +1,57 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __HEADLESSSCRIPT_HPP_INCLUDED__
+#define __HEADLESSSCRIPT_HPP_INCLUDED__
+
+#include "irrlicht.h"
+
+#include <string>
+#include <vector>
+
+//Forward declarations
+class SimulationModel;
+
+//Timed control inputs for a headless run, read from a text file.
+//Each line is 'time command value', with time in seconds from the start of the run, for example '120 wheel -15'.
+//Blank lines, and anything after a #, are ignored. The command 'end' stops the run.
+class HeadlessScript
+{
+    public:
+        HeadlessScript();
+        bool load(const std::string& filename); //Returns false if the file can't be read. Lines that can't be used are reported and skipped.
+        void apply(irr::f32 runTime, SimulationModel* model); //Apply all commands due at or before runTime, which haven't already been applied
+        bool hasEnd() const; //If the script includes an 'end' command
+        irr::f32 getEndTime() const; //Time of the 'end' command, or of the last command if there isn't one
+
+    private:
+        struct ScriptCommand {
+            irr::f32 time;
+            std::string command; //Lower case
+            irr::f32 value;
+        };
+
+        std::vector<ScriptCommand> commands; //In time order
+        irr::u32 nextCommand;
+        bool endFound;
+        irr::f32 endTime;
+
+        static bool isKnownCommand(const std::string& command);
+        static bool earlierCommand(const ScriptCommand& first, const ScriptCommand& second);
+        void applyCommand(const ScriptCommand& scriptCommand, SimulationModel* model) const;
+};
+
+#endif // __HEADLESSSCRIPT_HPP_INCLUDED__
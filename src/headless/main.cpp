@@ -0,0 +1,376 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+//Runs a scenario without a window, as fast as possible, for batch evaluation and testing.
+//Control inputs are read from a script (see HeadlessScript.hpp), and the own ship state,
+//CPA/TCPA to each other ship and collision events are written out as a time series.
+
+#include "irrlicht.h"
+
+#include "../DefaultEventReceiver.hpp"
+#include "../GUIMain.hpp"
+#include "../ScenarioDataStructure.hpp"
+#include "../SimulationModel.hpp"
+#include "../IniFile.hpp"
+#include "../Constants.hpp"
+#include "../Lang.hpp"
+#include "../Sound.hpp"
+#include "../Utilities.hpp"
+#include "../OperatingModeEnum.hpp"
+#include "HeadlessScript.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#include <unistd.h>
+#endif
+
+static void printUsage()
+{
+    std::cout << "Usage: bridgecommand-headless -s scenarioName [options]" << std::endl;
+    std::cout << "  -c iniFile       Use a different ini file to bc5.ini" << std::endl;
+    std::cout << "  -i scriptFile    Timed control inputs, one 'time command value' per line" << std::endl;
+    std::cout << "  -o outputFile    Time series output, CSV (default headless.csv)" << std::endl;
+    std::cout << "  -d duration      Scenario time to run (s). Defaults to the end of the script, or 3600" << std::endl;
+    std::cout << "  -r interval      Scenario time between output rows (s, default 1)" << std::endl;
+    std::cout << "  -f frameTime     Scenario time per model update (s, default 0.1)" << std::endl;
+    std::cout << "  -radar           Keep the radar running (needed for ARPA, but slower)" << std::endl;
+}
+
+//Closest point of approach, from relative position (m) and relative velocity (m/s). Returns CPA in Nm and TCPA in minutes, negative if the CPA has passed.
+static void calculateCPA(irr::f32 relX, irr::f32 relZ, irr::f32 relVX, irr::f32 relVZ, irr::f32& cpaNm, irr::f32& tcpaMins)
+{
+    irr::f32 relSpeedSquared = relVX*relVX + relVZ*relVZ;
+    irr::f32 tcpa = 0;
+    if (relSpeedSquared > 0.000001) {
+        tcpa = -1*(relX*relVX + relZ*relVZ)/relSpeedSquared;
+    }
+    irr::f32 cpaX = relX + relVX*tcpa;
+    irr::f32 cpaZ = relZ + relVZ*tcpa;
+    cpaNm = std::sqrt(cpaX*cpaX + cpaZ*cpaZ)/M_IN_NM;
+    tcpaMins = tcpa/60.0;
+}
+
+int main(int argc, char ** argv)
+{
+    //Mac OS:
+	#ifdef __APPLE__
+    //Find starting folder, as for the main program
+    char exePath[1024];
+    uint32_t pathSize = sizeof(exePath);
+    std::string exeFolderPath = "";
+    if (_NSGetExecutablePath(exePath, &pathSize) == 0) {
+        std::string exePathString(exePath);
+        size_t pos = exePathString.find_last_of("\\/");
+        if (std::string::npos != pos) {
+            exeFolderPath = exePathString.substr(0, pos);
+        }
+    }
+    exeFolderPath.append("/../../../../Resources");
+    chdir(exeFolderPath.c_str());
+	#endif
+
+    //User read/write location - look in here first and the exe folder second for files
+    std::string userFolder = Utilities::getUserDir();
+
+    std::string iniFilename = "bc5.ini";
+    //Use local ini file if it exists
+    if (Utilities::pathExists(userFolder + iniFilename)) {
+        iniFilename = userFolder + iniFilename;
+    }
+
+    //Command line options
+    std::string scenarioName = "";
+    std::string scriptFilename = "";
+    std::string outputFilename = "headless.csv";
+    irr::f32 duration = 0;
+    irr::f32 outputInterval = 1;
+    irr::f32 frameTime = 0.1;
+    bool keepRadar = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (strcmp(argv[i],"-c")==0 && hasValue) {
+            iniFilename = std::string(argv[++i]);
+        } else if (strcmp(argv[i],"-s")==0 && hasValue) {
+            scenarioName = std::string(argv[++i]);
+        } else if (strcmp(argv[i],"-i")==0 && hasValue) {
+            scriptFilename = std::string(argv[++i]);
+        } else if (strcmp(argv[i],"-o")==0 && hasValue) {
+            outputFilename = std::string(argv[++i]);
+        } else if (strcmp(argv[i],"-d")==0 && hasValue) {
+            duration = atof(argv[++i]);
+        } else if (strcmp(argv[i],"-r")==0 && hasValue) {
+            outputInterval = atof(argv[++i]);
+        } else if (strcmp(argv[i],"-f")==0 && hasValue) {
+            frameTime = atof(argv[++i]);
+        } else if (strcmp(argv[i],"-radar")==0) {
+            keepRadar = true;
+        } else {
+            printUsage();
+            return(EXIT_FAILURE);
+        }
+    }
+    if (scenarioName.empty() || frameTime <= 0 || outputInterval <= 0) {
+        printUsage();
+        return(EXIT_FAILURE);
+    }
+
+    HeadlessScript script;
+    if (!scriptFilename.empty()) {
+        if (!script.load(scriptFilename)) {
+            return(EXIT_FAILURE);
+        }
+    }
+    if (duration <= 0) {
+        if (script.getEndTime() > 0) {
+            duration = script.getEndTime();
+        } else {
+            duration = 3600;
+        }
+    }
+
+    //Model settings, read as in the main program. Shaders aren't used, so there's no water reflection.
+    irr::u32 waterSegments = IniFile::iniFileTou32(iniFilename, "water_segments"); // power of 2
+	if (waterSegments == 0) {
+		waterSegments = 32;
+	}
+    irr::u32 numberOfContactPointsX = IniFile::iniFileTou32(iniFilename, "contact_points_X");
+	if (numberOfContactPointsX == 0) {
+		numberOfContactPointsX = 10;
+	}
+    irr::u32 numberOfContactPointsY = IniFile::iniFileTou32(iniFilename, "contact_points_Y");
+	if (numberOfContactPointsY == 0) {
+		numberOfContactPointsY = 30;
+	}
+    irr::u32 numberOfContactPointsZ = IniFile::iniFileTou32(iniFilename, "contact_points_Z");
+	if (numberOfContactPointsZ == 0) {
+		numberOfContactPointsZ = 30;
+	}
+
+    SimulationModel::ModelParameters modelParameters;
+    modelParameters.mode = OperatingMode::Normal;
+    modelParameters.vrMode = false;
+    modelParameters.viewAngle = 90;
+    modelParameters.lookAngle = 0;
+    modelParameters.cameraMinDistance = 1;
+    modelParameters.cameraMaxDistance = 6*M_IN_NM;
+    modelParameters.disableShaders = 1;
+    modelParameters.waterSegments = waterSegments;
+    modelParameters.waterThreaded = false;
+    modelParameters.numberOfContactPoints = irr::core::vector3di(numberOfContactPointsX,numberOfContactPointsY,numberOfContactPointsZ);
+    modelParameters.minContactPointSpacing = IniFile::iniFileTof32(iniFilename, "contact_points_minSpacing", 100);
+    modelParameters.contactStiffnessFactor = IniFile::iniFileTof32(iniFilename, "contactStiffness_perArea");
+    modelParameters.contactDampingFactor = IniFile::iniFileTof32(iniFilename, "contactDamping_factor");
+    modelParameters.frictionCoefficient = IniFile::iniFileTof32(iniFilename, "contactFriction_coefficient", 0.5);
+    modelParameters.tanhFrictionFactor = IniFile::iniFileTof32(iniFilename, "contactFriction_tanhFactor", 1);
+    modelParameters.lineStiffnessFactor = IniFile::iniFileTof32(iniFilename, "lineStiffness_factor", 1.0);
+    modelParameters.lineDampingFactor = IniFile::iniFileTof32(iniFilename, "lineDamping_factor", 1.0);
+    modelParameters.limitTerrainResolution = IniFile::iniFileTou32(iniFilename, "max_terrain_resolution");
+    modelParameters.simulationStepRate = IniFile::iniFileTof32(iniFilename, "simulation_stepRate", 50);
+    modelParameters.maxSimulationSteps = IniFile::iniFileTou32(iniFilename, "simulation_maxSteps", 50);
+    modelParameters.secondaryControlWheel = false;
+    modelParameters.secondaryControlPortEngine = false;
+    modelParameters.secondaryControlStbdEngine = false;
+    modelParameters.secondaryControlPortSchottel = false;
+    modelParameters.secondaryControlStbdSchottel = false;
+    modelParameters.secondaryControlPortThrustLever = false;
+    modelParameters.secondaryControlStbdThrustLever = false;
+    modelParameters.secondaryControlBowThruster = false;
+    modelParameters.secondaryControlSternThruster = false;
+    modelParameters.debugMode = false;
+    if (modelParameters.frictionCoefficient < 0) {modelParameters.frictionCoefficient = 0;}
+    if (modelParameters.frictionCoefficient > 1) {modelParameters.frictionCoefficient = 1;}
+    if (modelParameters.tanhFrictionFactor < 0) {modelParameters.tanhFrictionFactor = 0;}
+    if (modelParameters.simulationStepRate < 0) {modelParameters.simulationStepRate = 0;}
+
+    //load language
+    std::string modifier = IniFile::iniFileToString(iniFilename, "lang");
+    if (modifier.length()==0) {
+        modifier = "en"; //Default
+    }
+    std::string languageFile = "language-";
+    languageFile.append(modifier);
+    languageFile.append(".txt");
+    if (Utilities::pathExists(userFolder + languageFile)) {
+        languageFile = userFolder + languageFile;
+    }
+    Lang language(languageFile);
+
+    //Null driver, so nothing is drawn and no window is needed
+    irr::SIrrlichtCreationParameters deviceParameters;
+    deviceParameters.DriverType = irr::video::EDT_NULL;
+    deviceParameters.WindowSize = irr::core::dimension2d<irr::u32>(1200,900);
+    irr::IrrlichtDevice* device = irr::createDeviceEx(deviceParameters);
+	if (device == 0) {
+		std::cerr << "Could not create null device." << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+    #ifdef __APPLE__
+    device->getFileSystem()->changeWorkingDirectoryTo(exeFolderPath.c_str());
+    #endif
+
+    std::vector<std::string> logMessages;
+    DefaultEventReceiver defReceiver(&logMessages, device);
+    device->setEventReceiver(&defReceiver);
+    IniFile::irrlichtLogger = device->getLogger();
+
+    //Scenario time is set directly below, so the run doesn't depend on the computer clock
+    device->getTimer()->stop();
+    device->getTimer()->setTime(0);
+
+    //Scenario path - default to user dir if it exists
+    std::string scenarioPath = "Scenarios/";
+    if (Utilities::pathExists(userFolder + scenarioPath)) {
+        scenarioPath = userFolder + scenarioPath;
+    }
+    if (!Utilities::pathExists(scenarioPath + scenarioName)) {
+        std::cerr << "Scenario not found: " << scenarioPath + scenarioName << std::endl;
+        device->drop();
+        return(EXIT_FAILURE);
+    }
+    ScenarioData scenarioData = Utilities::getScenarioDataFromFile(scenarioPath + scenarioName, scenarioName);
+
+    //No sound is played, but the model expects a sound object
+    Sound sound;
+    GUIMain guiMain;
+
+    SimulationModel model(device,
+        device->getSceneManager(),
+        &guiMain,
+        &sound,
+        scenarioData,
+        modelParameters);
+
+    //The GUI isn't drawn, but the model sends its data to the GUI each update
+    guiMain.load(device, &language, &logMessages, &model, model.isSingleEngine(), model.isAzimuthDrive(), false, model.hasDepthSounder(), model.getMaxSounderDepth(), model.hasGPS(), false, model.hasBowThruster(), model.hasSternThruster(), model.hasTurnIndicator(), true, false);
+
+    //The radar picture isn't seen, so only calculate it if needed (e.g. for ARPA)
+    if (!keepRadar && model.isRadarOn()) {
+        model.toggleRadarOn();
+    }
+
+    std::ofstream outputFile(outputFilename.c_str());
+    if (!outputFile.is_open()) {
+        std::cerr << "Could not open output file " << outputFilename << std::endl;
+        device->drop();
+        return(EXIT_FAILURE);
+    }
+
+    irr::u32 numberOfOtherShips = model.getNumberOfOtherShips();
+    outputFile << "time_s,timestamp,lat,long,heading_deg,cog_deg,sog_kts,stw_kts,rudder_deg,port_engine,stbd_engine,depth_m,collided";
+    for (irr::u32 i = 0; i < numberOfOtherShips; i++) {
+        outputFile << ",ship" << i+1 << "_range_nm,ship" << i+1 << "_cpa_nm,ship" << i+1 << "_tcpa_min";
+    }
+    outputFile << std::endl;
+
+    std::vector<irr::f32> minimumRangeNm(numberOfOtherShips, -1);
+    irr::u32 collisions = 0;
+    bool previouslyCollided = false;
+
+    irr::u32 frameMs = Utilities::round(frameTime*1000);
+    if (frameMs < 1) {
+        frameMs = 1;
+    }
+    irr::u32 durationMs = Utilities::round(duration*1000);
+    irr::u32 outputIntervalMs = Utilities::round(outputInterval*1000);
+    irr::u32 nextOutputMs = 0;
+    irr::u32 runMs = 0;
+
+    irr::u32 realStartTime = device->getTimer()->getRealTime();
+
+    //main loop
+    while (runMs < durationMs) {
+        script.apply(runMs/1000.0, &model);
+        if (script.hasEnd() && runMs >= script.getEndTime()*1000) {
+            break;
+        }
+
+        runMs += frameMs;
+        device->getTimer()->setTime(runMs);
+        //Nothing is drawn, so animate the scene as drawAll() would, before the model update as in the main loop. This moves the waves the ship responds to.
+        device->getSceneManager()->getRootSceneNode()->OnAnimate(runMs);
+        model.update();
+
+        irr::f32 runTime = runMs/1000.0;
+
+        //Collision events
+        bool collided = model.getCollided();
+        if (collided && !previouslyCollided) {
+            collisions++;
+            std::cout << "Collision at " << runTime << " s (" << Utilities::timestampToString(model.getTimestamp()) << ")" << std::endl;
+        }
+        previouslyCollided = collided;
+
+        //Own ship velocity over the ground
+        irr::f32 ownSOG = model.getSOG();
+        irr::f32 ownVX = ownSOG*sin(model.getCOG()*irr::core::DEGTORAD);
+        irr::f32 ownVZ = ownSOG*cos(model.getCOG()*irr::core::DEGTORAD);
+
+        bool writeRow = (runMs >= nextOutputMs);
+        if (writeRow) {
+            nextOutputMs += outputIntervalMs;
+            outputFile << runTime << "," << model.getTimestamp() << ","
+                       << model.getLat() << "," << model.getLong() << ","
+                       << model.getHeading() << "," << model.getCOG() << ","
+                       << ownSOG*MPS_TO_KTS << "," << model.getOwnShipSpeedThroughWater()*MPS_TO_KTS << ","
+                       << model.getRudder() << "," << model.getPortEngine() << "," << model.getStbdEngine() << ","
+                       << model.getDepth() << "," << (collided ? 1 : 0);
+        }
+
+        for (irr::u32 i = 0; i < numberOfOtherShips; i++) {
+            irr::f32 relX = model.getOtherShipPosX(i) - model.getPosX();
+            irr::f32 relZ = model.getOtherShipPosZ(i) - model.getPosZ();
+            irr::f32 rangeNm = std::sqrt(relX*relX + relZ*relZ)/M_IN_NM;
+            if (minimumRangeNm.at(i) < 0 || rangeNm < minimumRangeNm.at(i)) {
+                minimumRangeNm.at(i) = rangeNm;
+            }
+            if (writeRow) {
+                irr::f32 otherSpeed = model.getOtherShipSpeed(i);
+                irr::f32 relVX = otherSpeed*sin(model.getOtherShipHeading(i)*irr::core::DEGTORAD) - ownVX;
+                irr::f32 relVZ = otherSpeed*cos(model.getOtherShipHeading(i)*irr::core::DEGTORAD) - ownVZ;
+                irr::f32 cpaNm;
+                irr::f32 tcpaMins;
+                calculateCPA(relX, relZ, relVX, relVZ, cpaNm, tcpaMins);
+                outputFile << "," << rangeNm << "," << cpaNm << "," << tcpaMins;
+            }
+        }
+        if (writeRow) {
+            outputFile << std::endl;
+        }
+    }
+
+    outputFile.close();
+
+    //Summary
+    irr::f32 realTime = (device->getTimer()->getRealTime() - realStartTime)/1000.0;
+    std::cout << "Ran " << runMs/1000.0 << " s of scenario time in " << realTime << " s" << std::endl;
+    std::cout << "Collisions: " << collisions << std::endl;
+    for (irr::u32 i = 0; i < numberOfOtherShips; i++) {
+        std::cout << "Minimum range to ship " << i+1 << " (" << model.getOtherShipName(i) << "): " << minimumRangeNm.at(i) << " Nm" << std::endl;
+    }
+
+    device->drop();
+
+    //End
+    return(0);
+}
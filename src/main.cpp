@@ -39,6 +39,7 @@
 #include "Utilities.hpp"
 #include "OperatingModeEnum.hpp"
 #include "Update.hpp"
+#include "SessionPlayer.hpp"
 
 #include <cstdlib> //For rand(), srand()
 #include <vector>
@@ -410,6 +411,14 @@ int main(int argc, char ** argv)
         std::cout << "Using Ini file >" << iniFilename << "<" << std::endl;
     }
 
+    //Replay a recorded session instead of choosing a scenario, with -replay filename
+    std::string sessionReplayFile = "";
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i],"-replay")==0) {
+            sessionReplayFile = std::string(argv[i+1]);
+        }
+    }
+
     std::string scriptToExe = IniFile::iniFileToString(iniFilename, "script_start_BC");
 
     if (!scriptToExe.empty()) {
@@ -475,6 +484,7 @@ int main(int argc, char ** argv)
 	if (waterSegments == 0) {
 		waterSegments = 32;
 	}
+	bool waterThreaded = (IniFile::iniFileTou32(iniFilename, "water_threaded") == 1);
     irr::u32 numberOfContactPointsX = IniFile::iniFileTou32(iniFilename, "contact_points_X");
 	if (numberOfContactPointsX == 0) {
 		numberOfContactPointsX = 10;
@@ -508,6 +518,14 @@ int main(int argc, char ** argv)
     if (frictionCoefficient > 1) {frictionCoefficient = 1;}
     if (tanhFrictionFactor < 0) {tanhFrictionFactor = 0;}
 
+    irr::f32 simulationStepRate = IniFile::iniFileTof32(iniFilename, "simulation_stepRate", 50); //Simulation steps per second, or 0 for one per frame
+    irr::u32 maxSimulationSteps = IniFile::iniFileTou32(iniFilename, "simulation_maxSteps", 50); //Maximum simulation steps per frame
+    if (simulationStepRate < 0) {simulationStepRate = 0;}
+
+    //Session recording, for debrief
+    bool sessionRecord = (IniFile::iniFileTou32(iniFilename, "session_record") == 1);
+    irr::f32 sessionKeyframeInterval = IniFile::iniFileTof32(iniFilename, "session_keyframeInterval", 10); //Scenario time (s) between full state keyframes
+
 
     //Initial view configuration
     irr::f32 viewAngle = IniFile::iniFileTof32(iniFilename, "view_angle"); //Horizontal field of view
@@ -544,7 +562,7 @@ int main(int argc, char ** argv)
     }
 
     OperatingMode::Mode mode = OperatingMode::Normal;
-    if (IniFile::iniFileTou32(iniFilename, "secondary_mode")==1) {
+    if (IniFile::iniFileTou32(iniFilename, "secondary_mode")==1 && sessionReplayFile.empty()) {
         mode = OperatingMode::Secondary;
     }
     
@@ -816,7 +834,17 @@ int main(int argc, char ** argv)
 	//Start sound
 	Sound sound;
     
-    if (mode == OperatingMode::Normal) {
+    //Load the session to replay, if any, which includes the scenario to use
+    SessionPlayer sessionPlayer;
+    if (!sessionReplayFile.empty()) {
+        if (sessionPlayer.load(sessionReplayFile)) {
+            std::cout << "Replaying session " << sessionReplayFile << std::endl;
+        } else {
+            std::cerr << "Could not replay session " << sessionReplayFile << std::endl;
+        }
+    }
+
+    if (mode == OperatingMode::Normal && !sessionPlayer.isLoaded()) {
         ScenarioChoice scenarioChoice(device,&language);
         scenarioChoice.chooseScenario(scenarioName, mode, scenarioPath);
     }
@@ -928,6 +956,7 @@ int main(int argc, char ** argv)
     modelParameters.cameraMaxDistance = cameraMaxDistance;
     modelParameters.disableShaders = disableShaders; 
     modelParameters.waterSegments = waterSegments; 
+    modelParameters.waterThreaded = waterThreaded;
     modelParameters.numberOfContactPoints = numberOfContactPoints; 
     modelParameters.minContactPointSpacing = minContactPointSpacing; 
     modelParameters.contactStiffnessFactor = contactStiffnessFactor; 
@@ -937,6 +966,8 @@ int main(int argc, char ** argv)
     modelParameters.lineStiffnessFactor = lineStiffnessFactor;
     modelParameters.lineDampingFactor = lineDampingFactor; 
     modelParameters.limitTerrainResolution = limitTerrainResolution;
+    modelParameters.simulationStepRate = simulationStepRate;
+    modelParameters.maxSimulationSteps = maxSimulationSteps;
     modelParameters.secondaryControlWheel = secondaryControlWheel;
     modelParameters.secondaryControlPortEngine = secondaryControlPortEngine;
     modelParameters.secondaryControlStbdEngine = secondaryControlStbdEngine;
@@ -951,7 +982,11 @@ int main(int argc, char ** argv)
     
     ScenarioData scenarioData;
      
-    if(mode == OperatingMode::Normal)
+    if(sessionPlayer.isLoaded())
+      {
+        scenarioData.deserialise(sessionPlayer.getSerialisedScenario());
+      }
+    else if(mode == OperatingMode::Normal)
       {
         scenarioData = Utilities::getScenarioDataFromFile(scenarioPath + scenarioName, scenarioName);
       }
@@ -1003,6 +1038,26 @@ int main(int argc, char ** argv)
         network.SendMessage(msgScn);
     }
 
+    //Start replaying, or recording into the user directory (Sessions/scenario_date_time.bcs)
+    if (sessionPlayer.isLoaded()) {
+        model.startSessionReplay(&sessionPlayer);
+    } else if (sessionRecord && mode == OperatingMode::Normal) {
+        std::string sessionFolder = userFolder + "Sessions";
+        if (!Utilities::pathExists(sessionFolder)) {
+            #ifdef _WIN32
+            _mkdir(sessionFolder.c_str());
+            #else
+            mkdir(sessionFolder.c_str(),0755);
+            #endif // _WIN32
+        }
+        std::string sessionFile = sessionFolder + "/" + model.getScenarioName() + "_" + Utilities::timestampToString(time(NULL), "%Y%m%d_%H%M%S") + ".bcs";
+        if (model.startSessionRecording(sessionFile, sessionKeyframeInterval)) {
+            device->getLogger()->log(("Recording session to " + sessionFile).c_str());
+        } else {
+            device->getLogger()->log(("Could not record session to " + sessionFile).c_str());
+        }
+    }
+
     // Set up the VR interface
     VRInterface vrInterface(device, device->getSceneManager(), device->getVideoDriver(), su, sh);
 